@@ -23,6 +23,8 @@ typedef struct lcui_settings {
         int frame_rate_cap;
         int parallel_rendering_threads;
         bool paint_flashing;
+        bool pipelined_rendering;
+        bool tiled_rendering;
 } lcui_settings_t;
 
 /* Initialize settings with the current global settings. */
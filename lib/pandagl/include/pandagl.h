@@ -12,9 +12,12 @@
 #include "pandagl/common.h"
 #include "pandagl/types.h"
 #include "pandagl/rect.h"
+#include "pandagl/region.h"
 #include "pandagl/color.h"
 #include "pandagl/pixel.h"
 #include "pandagl/canvas.h"
+#include "pandagl/canvas_pool.h"
+#include "pandagl/image_cache.h"
 #include "pandagl/context.h"
 #include "pandagl/line.h"
 #include "pandagl/background.h"
@@ -17,6 +17,17 @@
 
 PD_BEGIN_DECLS
 
+/**
+ * Enable the cache of corner masks, so that the anti-aliased corners with the
+ * same radius and border widths are rasterized only once. Without it, every
+ * paint rasterizes the corners again.
+ * @param max_memory maximum memory of the cached masks, 0 means using the
+ * default value
+ */
+PD_PUBLIC void pd_border_cache_init(size_t max_memory);
+
+PD_PUBLIC void pd_border_cache_destroy(void);
+
 PD_PUBLIC int pd_crop_border_content(pd_context_t *ctx,
 				    const pd_border_t *border,
 				    const pd_rect_t *box);
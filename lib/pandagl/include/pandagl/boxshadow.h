@@ -21,6 +21,17 @@ PD_PUBLIC void pd_get_boxshadow_canvas_rect(const pd_boxshadow_t *shadow,
 					   const pd_rect_t *box_rect,
 					   pd_rect_t *canvas_rect);
 
+/**
+ * Enable the cache of shadow masks, so that shadows with the same blur,
+ * spread and radii are rasterized only once and then stretched to the size
+ * of each box. Without it, every paint rasterizes the shadow again.
+ * @param max_memory maximum memory of the cached masks, 0 means using the
+ * default value
+ */
+PD_PUBLIC void pd_boxshadow_cache_init(size_t max_memory);
+
+PD_PUBLIC void pd_boxshadow_cache_destroy(void);
+
 PD_PUBLIC int pd_paint_boxshadow(pd_context_t *ctx, const pd_boxshadow_t *shadow,
 				const pd_rect_t *box, int content_width,
 				int content_height);
@@ -14,6 +14,7 @@
 
 #include "common.h"
 #include "types.h"
+#include "pixel.h"
 
 PD_BEGIN_DECLS
 
@@ -24,15 +25,25 @@ PD_INLINE void *pd_canvas_pixel_at(const pd_canvas_t *canvas, unsigned x,
 	       (x % canvas->width) * canvas->bytes_per_pixel;
 }
 
+/** The pixels of the premultiplied canvas are read and written as they are */
 PD_INLINE pd_color_t pd_canvas_get_pixel(const pd_canvas_t *canvas, unsigned x,
 				      unsigned y)
 {
 	pd_color_t color;
 	unsigned char *p = pd_canvas_pixel_at(canvas, x, y);
 
-	if (canvas->color_type == PD_COLOR_TYPE_ARGB) {
+	if (canvas->color_type == PD_COLOR_TYPE_ARGB ||
+	    canvas->color_type == PD_COLOR_TYPE_PARGB) {
 		return *(pd_color_t *)p;
 	}
+	if (canvas->color_type == PD_COLOR_TYPE_A8) {
+		color.value = 0;
+		color.a = p[0];
+		return color;
+	}
+	if (canvas->color_type == PD_COLOR_TYPE_RGB565) {
+		return pd_rgb565_to_color(*(uint16_t *)p);
+	}
 	color.b = p[0];
 	color.g = p[1];
 	color.r = p[2];
@@ -45,8 +56,13 @@ PD_INLINE void pd_canvas_set_pixel(pd_canvas_t *canvas, unsigned x, unsigned y,
 {
 	unsigned char *p = pd_canvas_pixel_at(canvas, x, y);
 
-	if (canvas->color_type == PD_COLOR_TYPE_ARGB) {
+	if (canvas->color_type == PD_COLOR_TYPE_ARGB ||
+	    canvas->color_type == PD_COLOR_TYPE_PARGB) {
 		*(pd_color_t *)p = pixel;
+	} else if (canvas->color_type == PD_COLOR_TYPE_A8) {
+		p[0] = pixel.a;
+	} else if (canvas->color_type == PD_COLOR_TYPE_RGB565) {
+		*(uint16_t *)p = pd_color_to_rgb565(pixel);
 	} else {
 		p[0] = pixel.b;
 		p[1] = pixel.g;
@@ -80,19 +96,56 @@ PD_PUBLIC void pd_canvas_destroy(pd_canvas_t *canvas);
 PD_PUBLIC int pd_canvas_create(pd_canvas_t *canvas, unsigned width,
 			      unsigned height);
 
+/**
+ * Create the canvas with each row padded to a multiple of the alignment, so
+ * every row starts on an aligned address. The alignment must be a power of
+ * two up to 64, 0 means the default 4-byte alignment. The rows are not
+ * contiguous when padded, pixels should be located with bytes_per_row.
+ */
+PD_PUBLIC int pd_canvas_create_aligned(pd_canvas_t *canvas, unsigned width,
+				      unsigned height, unsigned alignment);
+
 PD_PUBLIC int pd_canvas_replace(pd_canvas_t *back, const pd_canvas_t *fore,
 			       int left, int top);
 
 PD_PUBLIC int pd_canvas_set_color_type(pd_canvas_t *canvas, int color_type);
 
+/**
+ * Convert the pixels of an ARGB canvas to premultiplied alpha in place, the
+ * color type of the canvas becomes PD_COLOR_TYPE_PARGB.
+ */
+PD_PUBLIC int pd_canvas_premultiply(pd_canvas_t *canvas);
+
 PD_PUBLIC int pd_canvas_cut(const pd_canvas_t *canvas, pd_rect_t rect,
 			   pd_canvas_t *out_canvas);
 
 PD_PUBLIC void pd_canvas_copy(pd_canvas_t *des, const pd_canvas_t *src);
 
+/**
+ * Move the pixels in the rectangle by the offset, the pixels moved out of the
+ * rectangle are discarded and the exposed area keeps its old pixels.
+ * @returns number of bytes moved
+ */
+PD_PUBLIC size_t pd_canvas_scroll(pd_canvas_t *canvas, const pd_rect_t *rect,
+				 int dx, int dy);
+
+/**
+ * Mix the fore canvas into the back canvas. The premultiplied canvases are
+ * always mixed with the over operator, the with_alpha flag is only used when
+ * both canvases are in straight alpha. An RGB565 back canvas has no alpha
+ * channel, it is blended like an RGB888 canvas.
+ */
 PD_PUBLIC int pd_canvas_mix(pd_canvas_t *back, const pd_canvas_t *fore, int left,
 			   int top, bool with_alpha);
 
+/**
+ * Paint the color through an A8 mask canvas, the alpha of the color is
+ * multiplied by the mask and the opacity of the mask canvas. The back canvas
+ * can be RGB, ARGB, premultiplied ARGB or A8.
+ */
+PD_PUBLIC int pd_canvas_mix_mask(pd_canvas_t *back, const pd_canvas_t *mask,
+				 pd_color_t color, int left, int top);
+
 PD_PUBLIC int pd_canvas_fill_rect(pd_canvas_t *canvas, pd_color_t color,
 				 pd_rect_t rect);
 
@@ -116,6 +169,23 @@ PD_PUBLIC int pd_canvas_zoom_bilinear(const pd_canvas_t *canvas,
 				     pd_canvas_t *buff, bool keep_scale,
 				     int width, int height);
 
+/**
+ * Resample the canvas to the size of width x height with a separable filter.
+ * The output canvas is created with the color type of the input canvas. The
+ * straight alpha pixels are filtered as they are, use a premultiplied canvas
+ * to keep the colors of the transparent pixels out of the result.
+ */
+PD_PUBLIC int pd_canvas_resample(const pd_canvas_t *canvas, pd_canvas_t *buff,
+				int width, int height,
+				pd_resample_quality_t quality);
+
+/**
+ * Set the maximum number of threads used by pd_canvas_resample(). The
+ * threads are started here and kept until it is set to 1, which is the
+ * default. It must not be called while images are being resampled.
+ */
+PD_PUBLIC void pd_set_resample_threads(unsigned n);
+
 PD_END_DECLS
 
 #endif
@@ -0,0 +1,47 @@
+﻿/*
+ * lib/pandagl/include/pandagl/canvas_pool.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifndef LIB_PANDAGL_INCLUDE_PANDAGL_CANVAS_POOL_H
+#define LIB_PANDAGL_INCLUDE_PANDAGL_CANVAS_POOL_H
+
+#include "common.h"
+#include "types.h"
+
+PD_BEGIN_DECLS
+
+/**
+ * @param max_free_memory maximum memory of cached free buffers, 0 means
+ * using the default value
+ */
+PD_PUBLIC pd_canvas_pool_t *pd_canvas_pool_create(size_t max_free_memory);
+
+PD_PUBLIC void pd_canvas_pool_destroy(pd_canvas_pool_t *pool);
+
+/**
+ * Create a zero-filled canvas with a buffer from the pool, it works like
+ * pd_canvas_create(). The canvas must be released by pd_canvas_pool_free()
+ * and must not be resized by pd_canvas_create() to a larger size.
+ */
+PD_PUBLIC int pd_canvas_pool_alloc(pd_canvas_pool_t *pool, pd_canvas_t *canvas,
+				   unsigned width, unsigned height);
+
+PD_PUBLIC void pd_canvas_pool_free(pd_canvas_pool_t *pool,
+				   pd_canvas_t *canvas);
+
+/** Release all cached free buffers */
+PD_PUBLIC void pd_canvas_pool_trim(pd_canvas_pool_t *pool);
+
+PD_PUBLIC void pd_canvas_pool_get_stats(pd_canvas_pool_t *pool,
+					pd_canvas_pool_stats_t *stats);
+
+PD_END_DECLS
+
+#endif
@@ -49,6 +49,29 @@ typedef struct pd_font_bitmap {
         } metrics;
 } pd_font_bitmap_t;
 
+typedef struct pd_font_cache_stats {
+        /** Number of bitmaps found in the cache */
+        size_t hits;
+
+        /** Number of bitmaps not found in the cache */
+        size_t misses;
+
+        /** Number of bitmaps dropped to keep the memory under the limit */
+        size_t evictions;
+
+        /** Number of cached bitmaps */
+        size_t entries;
+
+        /** Number of atlas pages holding the pixels of the cached bitmaps */
+        size_t pages;
+
+        /** Memory of the cached bitmaps */
+        size_t memory;
+
+        /** Maximum memory of the cached bitmaps */
+        size_t max_memory;
+} pd_font_cache_stats_t;
+
 typedef struct font_engine font_engine_t;
 
 typedef struct pd_font {
@@ -159,8 +182,10 @@ PD_PUBLIC bool pd_font_library_set_font_family_alias(const char *alias,
  * @param[out] bmp 要添加的字体位图
  * @warning 此函数仅仅是将 bmp 复制进缓存中，并未重新分配新的空间储存位图数
  * 据，因此，请勿在调用此函数后手动释放 bmp。
+ * @returns a reference to the cached bitmap, it must be released by
+ * pd_font_library_release_bitmap()
  */
-PD_PUBLIC pd_font_bitmap_t *pd_font_library_add_bitmap(
+PD_PUBLIC const pd_font_bitmap_t *pd_font_library_add_bitmap(
     wchar_t ch, int font_id, int size, const pd_font_bitmap_t *bmp);
 
 /**
@@ -171,10 +196,24 @@ PD_PUBLIC pd_font_bitmap_t *pd_font_library_add_bitmap(
  * @param[out] bmp 输出的字体位图的引用
  * @warning 请勿释放 bmp，bmp 仅仅是引用缓存中的字体位图，并未建分配新
  * 空间存储字体位图的拷贝。
+ * @note A bitmap is referenced whenever bmp is not NULL, including the
+ * placeholder returned for a missing glyph. It must be released by
+ * pd_font_library_release_bitmap() so that it can be evicted.
  */
 PD_PUBLIC int pd_font_library_get_bitmap(unsigned ch, int font_id, int size,
                                          const pd_font_bitmap_t **bmp);
 
+PD_PUBLIC void pd_font_library_release_bitmap(const pd_font_bitmap_t *bmp);
+
+/**
+ * Set the maximum memory of the cached bitmaps, the unused bitmaps are
+ * evicted in LRU order when it is exceeded.
+ * @param max_memory 0 means using the default value
+ */
+PD_PUBLIC void pd_font_library_set_cache_max_memory(size_t max_memory);
+
+PD_PUBLIC void pd_font_library_get_cache_stats(pd_font_cache_stats_t *stats);
+
 /** 载入字体至数据库中 */
 PD_PUBLIC int pd_font_library_load_file(const char *filepath);
 
@@ -0,0 +1,59 @@
+﻿/*
+ * lib/pandagl/include/pandagl/image_cache.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifndef LIB_PANDAGL_INCLUDE_PANDAGL_IMAGE_CACHE_H
+#define LIB_PANDAGL_INCLUDE_PANDAGL_IMAGE_CACHE_H
+
+#include "common.h"
+#include "types.h"
+
+PD_BEGIN_DECLS
+
+/**
+ * @param max_memory maximum memory of the cached images, 0 means using the
+ * default value
+ */
+PD_PUBLIC pd_image_cache_t *pd_image_cache_create(size_t max_memory);
+
+/** All images returned by pd_image_cache_get() must be released before */
+PD_PUBLIC void pd_image_cache_destroy(pd_image_cache_t *cache);
+
+/**
+ * Get the image resampled to the given size, resample and cache it if it is
+ * not in the cache. The returned canvas is read-only and stays valid until
+ * it is released by pd_image_cache_release().
+ * @returns NULL if the image cannot be resampled or is larger than the
+ * maximum memory of the cache
+ */
+PD_PUBLIC pd_canvas_t *pd_image_cache_get(pd_image_cache_t *cache,
+					  const pd_canvas_t *image,
+					  unsigned width, unsigned height,
+					  pd_resample_quality_t quality);
+
+PD_PUBLIC void pd_image_cache_release(pd_image_cache_t *cache,
+				      pd_canvas_t *scaled);
+
+/**
+ * Drop all scaled copies of the image, it should be called before the image
+ * is destroyed or its pixels are changed
+ */
+PD_PUBLIC void pd_image_cache_remove(pd_image_cache_t *cache,
+				     const pd_canvas_t *image);
+
+PD_PUBLIC void pd_image_cache_set_max_memory(pd_image_cache_t *cache,
+					     size_t max_memory);
+
+PD_PUBLIC void pd_image_cache_get_stats(pd_image_cache_t *cache,
+					pd_image_cache_stats_t *stats);
+
+PD_END_DECLS
+
+#endif
@@ -30,6 +30,9 @@
 		pd_alpha_blend((px1)->b, (px2)->b, a); \
 	}
 
+/** x / 255 rounded to the nearest integer, x must be in [0, 255 * 255] */
+#define pd_div255(x) (((unsigned)(x) + 128) * 257 >> 16)
+
 PD_BEGIN_DECLS
 
 PD_PUBLIC unsigned pd_get_pixel_size(pd_color_type_t color_type);
@@ -42,6 +45,23 @@ PD_PUBLIC int pd_format_pixels(const uint8_t *in_pixels,
 				   pd_color_type_t out_color_type,
 				   size_t count);
 
+/**
+ * The blending functions used by pd_canvas_mix() are selected by the CPU
+ * features at runtime, the scalar implementation is the reference.
+ */
+PD_PUBLIC bool pd_blend_impl_is_supported(pd_blend_impl_t impl);
+
+/**
+ * Select the fastest implementation supported by the CPU. The scalar
+ * implementation is used until then. Like pd_set_blend_impl(), it must not
+ * be called while other threads are blending.
+ */
+PD_PUBLIC void pd_blend_init(void);
+
+PD_PUBLIC int pd_set_blend_impl(pd_blend_impl_t impl);
+
+PD_PUBLIC pd_blend_impl_t pd_get_blend_impl(void);
+
 /*
  * Pixel over operator with alpha channel
  * See more: https://en.wikipedia.org/wiki/Alpha_compositing
@@ -79,15 +99,82 @@ PD_INLINE void pd_over_pixel(pd_color_t *dst, const pd_color_t *src, double opac
 	dst->b = (unsigned char)(src->b * src_a + dst->b * a);
 	dst->a = (unsigned char)(255.0 * out_a);
 
-	/* If it is assumed that all color values are premultiplied by their
-	 * alpha values, we can rewrite the equation for output color as:
+	/* If the color values are premultiplied by their alpha values, the
+	 * division is gone, see pd_over_premultiplied_pixel() */
+}
+
+/** Expand the RGB565 pixel, the high bits of the channels fill the low bits */
+PD_INLINE pd_color_t pd_rgb565_to_color(uint16_t px)
+{
+	pd_color_t color;
+	unsigned r = px >> 11, g = (px >> 5) & 0x3f, b = px & 0x1f;
+
+	color.r = (uint8_t)(r << 3 | r >> 2);
+	color.g = (uint8_t)(g << 2 | g >> 4);
+	color.b = (uint8_t)(b << 3 | b >> 2);
+	color.a = 255;
+	return color;
+}
+
+/**
+ * Convert the color to RGB565, the channels are rounded to the nearest value
+ * so that blending in 16-bit pixels does not get darker over time
+ */
+PD_INLINE uint16_t pd_color_to_rgb565(pd_color_t color)
+{
+	return (uint16_t)(((color.r * 249u + 1014) >> 11) << 11 |
+			  ((color.g * 253u + 505) >> 10) << 5 |
+			  ((color.b * 249u + 1014) >> 11));
+}
+
+PD_INLINE void pd_premultiply_pixel(pd_color_t *px)
+{
+	px->r = (uint8_t)pd_div255(px->r * px->a);
+	px->g = (uint8_t)pd_div255(px->g * px->a);
+	px->b = (uint8_t)pd_div255(px->b * px->a);
+}
+
+PD_INLINE void pd_unpremultiply_pixel(pd_color_t *px)
+{
+	unsigned a = px->a;
 
-		const double a = 1.0 - src->a / 255.0;
-		dst->r = src->r + (unsigned char)(dst->r * a);
-		dst->g = src->g + (unsigned char)(dst->g * a);
-		dst->b = src->b + (unsigned char)(dst->b * a);
-		dst->a = src->a + (unsigned char)(dst->a * a);
-	*/
+	if (a == 255) {
+		return;
+	}
+	if (a == 0) {
+		px->value = 0;
+		return;
+	}
+	px->r = px->r >= a ? 255 : (uint8_t)((px->r * 255 + a / 2) / a);
+	px->g = px->g >= a ? 255 : (uint8_t)((px->g * 255 + a / 2) / a);
+	px->b = px->b >= a ? 255 : (uint8_t)((px->b * 255 + a / 2) / a);
+}
+
+/**
+ * Pixel over operator with premultiplied alpha, all in integer arithmetic:
+ *   Co = Ca + Cb * (1 - aa)
+ *   ao = aa + ab * (1 - aa)
+ *
+ * @param alpha The opacity of the source pixel, in the range [0, 256]
+ */
+PD_INLINE void pd_over_premultiplied_pixel(pd_color_t *dst,
+					   const pd_color_t *src,
+					   unsigned alpha)
+{
+	pd_color_t s = *src;
+	unsigned inv;
+
+	if (alpha < 256) {
+		s.r = (uint8_t)(s.r * alpha >> 8);
+		s.g = (uint8_t)(s.g * alpha >> 8);
+		s.b = (uint8_t)(s.b * alpha >> 8);
+		s.a = (uint8_t)(s.a * alpha >> 8);
+	}
+	inv = 255 - s.a;
+	dst->r = (uint8_t)(s.r + pd_div255(dst->r * inv));
+	dst->g = (uint8_t)(s.g + pd_div255(dst->g * inv));
+	dst->b = (uint8_t)(s.b + pd_div255(dst->b * inv));
+	dst->a = (uint8_t)(s.a + pd_div255(dst->a * inv));
 }
 
 PD_END_DECLS
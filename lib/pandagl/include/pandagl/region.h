@@ -0,0 +1,75 @@
+﻿/*
+ * lib/pandagl/include/pandagl/region.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifndef LIB_PANDAGL_INCLUDE_PANDAGL_REGION_H
+#define LIB_PANDAGL_INCLUDE_PANDAGL_REGION_H
+
+#include "common.h"
+#include "types.h"
+
+PD_BEGIN_DECLS
+
+PD_INLINE bool pd_region_is_empty(const pd_region_t *region)
+{
+	return region->length == 0;
+}
+
+PD_PUBLIC void pd_region_init(pd_region_t *region);
+
+PD_PUBLIC void pd_region_destroy(pd_region_t *region);
+
+/** Remove all rectangles but keep the allocated memory */
+PD_PUBLIC void pd_region_clear(pd_region_t *region);
+
+PD_PUBLIC int pd_region_copy(pd_region_t *dest, const pd_region_t *src);
+
+PD_PUBLIC int pd_region_set_rect(pd_region_t *region, const pd_rect_t *rect);
+
+PD_PUBLIC size_t pd_region_get_area(const pd_region_t *region);
+
+PD_PUBLIC void pd_region_translate(pd_region_t *region, int x, int y);
+
+/**
+ * Region operations, the output region can be the same as an input region
+ * @returns 0 on success, -1 if memory allocation failed
+ */
+PD_PUBLIC int pd_region_union(pd_region_t *out, const pd_region_t *a,
+			      const pd_region_t *b);
+
+PD_PUBLIC int pd_region_intersect(pd_region_t *out, const pd_region_t *a,
+				  const pd_region_t *b);
+
+/** Get the pixels of region a which are not in region b */
+PD_PUBLIC int pd_region_subtract(pd_region_t *out, const pd_region_t *a,
+				 const pd_region_t *b);
+
+PD_PUBLIC int pd_region_union_rect(pd_region_t *region, const pd_rect_t *rect);
+
+PD_PUBLIC int pd_region_intersect_rect(pd_region_t *region,
+				       const pd_rect_t *rect);
+
+PD_PUBLIC int pd_region_subtract_rect(pd_region_t *region,
+				      const pd_rect_t *rect);
+
+/**
+ * Merge rectangles to reduce their number. The result is still made of
+ * non-overlapping rectangles and covers all pixels of the original region.
+ * Rectangles are merged while the number of rectangles is greater than
+ * max_rects, or while the extra pixels covered by a merge cost less than the
+ * rectangles it saves.
+ * @param rect_cost cost of a rectangle, in pixels
+ */
+PD_PUBLIC int pd_region_simplify(pd_region_t *region, unsigned max_rects,
+				 size_t rect_cost);
+
+PD_END_DECLS
+
+#endif
@@ -45,6 +45,7 @@ typedef enum pd_text_align_t {
 
 typedef struct pd_char {
 	wchar_t code;                   /**< 字符码 */
+	int advance;                    /**< 水平跨距，无字体位图时为 0 */
 	pd_text_style_t *style;         /**< 该字符使用的样式数据 */
 	const pd_font_bitmap_t *bitmap; /**< 字体位图数据(只读) */
 } pd_char_t;
@@ -69,7 +70,8 @@ typedef struct pd_text_line {
 	int width;          /**< 宽度 */
 	int height;         /**< 高度 */
 	int length;         /**< 该行文本长度 */
-	pd_char_t **string; /**< 该行文本的数据 */
+	int capacity;       /**< 该行文本数据的容量 */
+	pd_char_t *string;  /**< 该行文本的数据，连续存放 */
 	pd_text_eol_t eol;  /**< 行尾结束类型 */
 } pd_text_line_t;
 
@@ -26,10 +26,35 @@ typedef enum pd_color_type_t {
 	PD_COLOR_TYPE_RGB565,   /**< RGB565 */
 	PD_COLOR_TYPE_RGB888,   /**< RGB888 */
 	PD_COLOR_TYPE_ARGB8888,  /**< RGB8888 */
+	PD_COLOR_TYPE_PARGB8888, /**< ARGB8888, premultiplied alpha */
+	PD_COLOR_TYPE_A8,        /**< 8-bit alpha, used as a coverage mask */
 } pd_color_type_t;
 
 #define PD_COLOR_TYPE_RGB PD_COLOR_TYPE_RGB888
 #define PD_COLOR_TYPE_ARGB PD_COLOR_TYPE_ARGB8888
+#define PD_COLOR_TYPE_PARGB PD_COLOR_TYPE_PARGB8888
+
+/** Implementations of the pixel blending functions */
+typedef enum pd_blend_impl {
+	PD_BLEND_IMPL_SCALAR,
+	PD_BLEND_IMPL_SSE2,
+	PD_BLEND_IMPL_AVX2,
+	PD_BLEND_IMPL_NEON
+} pd_blend_impl_t;
+
+/** Filters used by pd_canvas_resample() */
+typedef enum pd_resample_quality {
+	/** Nearest neighbour, no filtering */
+	PD_RESAMPLE_NEAREST,
+
+	/** Average of the covered pixels, suits strong downscaling */
+	PD_RESAMPLE_BOX,
+
+	PD_RESAMPLE_BILINEAR,
+
+	/** Sharpest, and the slowest */
+	PD_RESAMPLE_LANCZOS3
+} pd_resample_quality_t;
 
 typedef union pd_color_t {
 	uint32_t value;
@@ -80,6 +105,18 @@ struct pd_canvas {
 	size_t mem_size;
 };
 
+/**
+ * A set of pixels stored as non-overlapping rectangles. The rectangles are
+ * sorted by y then x and grouped into bands, the rectangles in a band have
+ * the same y and height, and adjacent bands with the same spans are merged.
+ */
+typedef struct pd_region {
+	pd_rect_t extents;
+	pd_rect_t *rects;
+	unsigned length;
+	unsigned capacity;
+} pd_region_t;
+
 /** 进行绘制时所需的上下文 */
 typedef struct pd_context {
 	pd_rect_t rect;    /**< 需要绘制的区域 */
@@ -87,6 +124,53 @@ typedef struct pd_context {
 	bool with_alpha; /**< 绘制时是否需要处理 alpha 通道 */
 } pd_context_t;
 
+/**
+ * A size-bucketed pool of pixel buffers for short-lived canvases.
+ * The pool is not thread-safe, each rendering thread should use its own.
+ */
+typedef struct pd_canvas_pool pd_canvas_pool_t;
+
+typedef struct pd_canvas_pool_stats {
+	/** Memory allocated by the pool, including cached free buffers */
+	size_t memory;
+
+	/** Peak value of memory */
+	size_t peak_memory;
+
+	/** Memory of buffers currently in use */
+	size_t used_memory;
+
+	/** Number of allocations */
+	size_t allocs;
+
+	/** Number of allocations served by cached free buffers */
+	size_t reuses;
+} pd_canvas_pool_stats_t;
+
+/**
+ * A thread-safe LRU cache of resampled images, it keeps scaled copies of
+ * images that are drawn at a size other than their own, such as
+ * backgrounds, so that repaints do not resample them again.
+ */
+typedef struct pd_image_cache pd_image_cache_t;
+
+typedef struct pd_image_cache_stats {
+	/** Memory of the cached images */
+	size_t memory;
+
+	/** Maximum memory of the cached images */
+	size_t max_memory;
+
+	/** Number of cached images */
+	size_t entries;
+
+	size_t hits;
+	size_t misses;
+
+	/** Number of cached images dropped to stay within max_memory */
+	size_t evictions;
+} pd_image_cache_stats_t;
+
 typedef struct pd_background {
 	pd_canvas_t *image;
 	pd_color_t color;
@@ -0,0 +1,389 @@
+﻿/*
+ * lib/pandagl/src/blend.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <pandagl.h>
+#include "blend.h"
+
+static pd_blend_kernels_t pd_blend_kernels = {
+	pd_mix_argb_row,         pd_mix_argb_with_alpha_row,
+	pd_mix_argb2rgb_row,     pd_mix_pargb_row,
+	pd_mix_argb2pargb_row,   pd_mix_pargb2argb_row,
+	pd_mix_pargb2rgb_row,    pd_mix_argb2rgb565_row,
+	pd_mix_pargb2rgb565_row, pd_mask_argb_row,
+	pd_mask_pargb_row,       pd_mix_mask_argb_row,
+	pd_mix_mask_pargb_row,   pd_mix_mask_rgb_row,
+	pd_mix_mask_a8_row,      pd_mix_mask_rgb565_row,
+	pd_format_pixels_argb2rgb,    pd_format_pixels_rgb2argb,
+	pd_format_pixels_argb2pargb,  pd_format_pixels_argb2rgb565,
+	pd_format_pixels_rgb5652argb, pd_fill_argb_row,
+	pd_fill_rgb_row,              pd_fill_rgb565_row
+};
+
+static pd_blend_impl_t pd_blend_impl = PD_BLEND_IMPL_SCALAR;
+
+void pd_mix_argb_row(pd_color_t *dst, const pd_color_t *src, int count,
+		     float opacity)
+{
+	int x;
+	uint8_t a;
+
+	if (opacity < 1.0) {
+		for (x = 0; x < count; ++x) {
+			a = (uint8_t)(src[x].a * opacity);
+			pd_blend_pixel(&dst[x], &src[x], a);
+		}
+		return;
+	}
+	for (x = 0; x < count; ++x) {
+		pd_blend_pixel(&dst[x], &src[x], src[x].a);
+	}
+}
+
+void pd_mix_argb_with_alpha_row(pd_color_t *dst, const pd_color_t *src,
+				int count, float opacity)
+{
+	int x;
+
+	for (x = 0; x < count; ++x) {
+		pd_over_pixel(&dst[x], &src[x], opacity);
+	}
+}
+
+void pd_mix_argb2rgb_row(uint8_t *dst, const pd_color_t *src, int count,
+			 float opacity)
+{
+	int x;
+	uint8_t a;
+
+	for (x = 0; x < count; ++x, dst += 3) {
+		if (opacity < 1.0) {
+			a = (uint8_t)(src[x].a * opacity);
+		} else {
+			a = src[x].a;
+		}
+		dst[0] = _pd_alpha_blend(dst[0], src[x].b, a);
+		dst[1] = _pd_alpha_blend(dst[1], src[x].g, a);
+		dst[2] = _pd_alpha_blend(dst[2], src[x].r, a);
+	}
+}
+
+void pd_mix_pargb_row(pd_color_t *dst, const pd_color_t *src, int count,
+		      float opacity)
+{
+	int x;
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x < count; ++x) {
+		pd_over_premultiplied_pixel(&dst[x], &src[x], alpha);
+	}
+}
+
+void pd_mix_argb2pargb_row(pd_color_t *dst, const pd_color_t *src, int count,
+			   float opacity)
+{
+	int x;
+	pd_color_t s;
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x < count; ++x) {
+		s = src[x];
+		s.a = (uint8_t)(s.a * alpha >> 8);
+		pd_premultiply_pixel(&s);
+		pd_over_premultiplied_pixel(&dst[x], &s, 256);
+	}
+}
+
+void pd_mix_pargb2argb_row(pd_color_t *dst, const pd_color_t *src, int count,
+			   float opacity)
+{
+	int x;
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x < count; ++x) {
+		if (src[x].a == 0) {
+			continue;
+		}
+		pd_premultiply_pixel(&dst[x]);
+		pd_over_premultiplied_pixel(&dst[x], &src[x], alpha);
+		pd_unpremultiply_pixel(&dst[x]);
+	}
+}
+
+void pd_mix_pargb2rgb_row(uint8_t *dst, const pd_color_t *src, int count,
+			  float opacity)
+{
+	int x;
+	pd_color_t s;
+	unsigned inv, alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x < count; ++x, dst += 3) {
+		s = src[x];
+		if (alpha < 256) {
+			s.r = (uint8_t)(s.r * alpha >> 8);
+			s.g = (uint8_t)(s.g * alpha >> 8);
+			s.b = (uint8_t)(s.b * alpha >> 8);
+			s.a = (uint8_t)(s.a * alpha >> 8);
+		}
+		inv = 255 - s.a;
+		dst[0] = (uint8_t)(s.b + pd_div255(dst[0] * inv));
+		dst[1] = (uint8_t)(s.g + pd_div255(dst[1] * inv));
+		dst[2] = (uint8_t)(s.r + pd_div255(dst[2] * inv));
+	}
+}
+
+/*
+ * The RGB565 kernels expand the destination pixels, blend them in the same
+ * way as the RGB888 kernels and round them back to 16 bits
+ */
+
+void pd_mix_argb2rgb565_row(uint16_t *dst, const pd_color_t *src, int count,
+			    float opacity)
+{
+	int x;
+	uint8_t a;
+	pd_color_t d;
+
+	for (x = 0; x < count; ++x) {
+		if (opacity < 1.0) {
+			a = (uint8_t)(src[x].a * opacity);
+		} else {
+			a = src[x].a;
+		}
+		if (a == 0) {
+			continue;
+		}
+		d = pd_rgb565_to_color(dst[x]);
+		d.b = _pd_alpha_blend(d.b, src[x].b, a);
+		d.g = _pd_alpha_blend(d.g, src[x].g, a);
+		d.r = _pd_alpha_blend(d.r, src[x].r, a);
+		dst[x] = pd_color_to_rgb565(d);
+	}
+}
+
+void pd_mix_pargb2rgb565_row(uint16_t *dst, const pd_color_t *src, int count,
+			     float opacity)
+{
+	int x;
+	pd_color_t s, d;
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x < count; ++x) {
+		s = src[x];
+		if (alpha < 256) {
+			s.r = (uint8_t)(s.r * alpha >> 8);
+			s.g = (uint8_t)(s.g * alpha >> 8);
+			s.b = (uint8_t)(s.b * alpha >> 8);
+			s.a = (uint8_t)(s.a * alpha >> 8);
+		}
+		if (s.a == 0 && (s.value & 0xffffff) == 0) {
+			continue;
+		}
+		d = pd_rgb565_to_color(dst[x]);
+		pd_over_premultiplied_pixel(&d, &s, 256);
+		dst[x] = pd_color_to_rgb565(d);
+	}
+}
+
+void pd_mask_argb_row(pd_color_t *dst, const uint8_t *mask, int count)
+{
+	int x;
+
+	for (x = 0; x < count; ++x) {
+		dst[x].a = (uint8_t)pd_div255(dst[x].a * mask[x]);
+	}
+}
+
+void pd_mask_pargb_row(pd_color_t *dst, const uint8_t *mask, int count)
+{
+	int x;
+
+	for (x = 0; x < count; ++x) {
+		dst[x].r = (uint8_t)pd_div255(dst[x].r * mask[x]);
+		dst[x].g = (uint8_t)pd_div255(dst[x].g * mask[x]);
+		dst[x].b = (uint8_t)pd_div255(dst[x].b * mask[x]);
+		dst[x].a = (uint8_t)pd_div255(dst[x].a * mask[x]);
+	}
+}
+
+void pd_mix_mask_argb_row(void *dst, const uint8_t *mask, int count,
+			  pd_color_t color)
+{
+	int x;
+	pd_color_t c = color;
+	pd_color_t *px = dst;
+
+	for (x = 0; x < count; ++x) {
+		if (mask[x] == 0) {
+			continue;
+		}
+		c.a = (uint8_t)pd_div255(mask[x] * color.a);
+		if (c.a == 255) {
+			px[x] = c;
+		} else {
+			pd_over_pixel(&px[x], &c, 1.0);
+		}
+	}
+}
+
+void pd_mix_mask_pargb_row(void *dst, const uint8_t *mask, int count,
+			   pd_color_t color)
+{
+	int x;
+	pd_color_t s;
+	pd_color_t *px = dst;
+
+	pd_premultiply_pixel(&color);
+	for (x = 0; x < count; ++x) {
+		if (mask[x] == 0) {
+			continue;
+		}
+		s.r = (uint8_t)pd_div255(color.r * mask[x]);
+		s.g = (uint8_t)pd_div255(color.g * mask[x]);
+		s.b = (uint8_t)pd_div255(color.b * mask[x]);
+		s.a = (uint8_t)pd_div255(color.a * mask[x]);
+		pd_over_premultiplied_pixel(&px[x], &s, 256);
+	}
+}
+
+void pd_mix_mask_rgb_row(void *dst, const uint8_t *mask, int count,
+			 pd_color_t color)
+{
+	int x;
+	uint8_t a;
+	uint8_t *p = dst;
+
+	for (x = 0; x < count; ++x, p += 3) {
+		a = (uint8_t)pd_div255(mask[x] * color.a);
+		p[0] = _pd_alpha_blend(p[0], color.b, a);
+		p[1] = _pd_alpha_blend(p[1], color.g, a);
+		p[2] = _pd_alpha_blend(p[2], color.r, a);
+	}
+}
+
+void pd_mix_mask_a8_row(void *dst, const uint8_t *mask, int count,
+			pd_color_t color)
+{
+	int x;
+	unsigned a;
+	uint8_t *p = dst;
+
+	for (x = 0; x < count; ++x) {
+		a = pd_div255(mask[x] * color.a);
+		p[x] = (uint8_t)(a + pd_div255(p[x] * (255 - a)));
+	}
+}
+
+void pd_mix_mask_rgb565_row(void *dst, const uint8_t *mask, int count,
+			    pd_color_t color)
+{
+	int x;
+	uint8_t a;
+	pd_color_t d;
+	uint16_t *p = dst;
+	uint16_t solid = pd_color_to_rgb565(color);
+
+	for (x = 0; x < count; ++x) {
+		a = (uint8_t)pd_div255(mask[x] * color.a);
+		if (a == 0) {
+			continue;
+		}
+		if (a == 255) {
+			p[x] = solid;
+			continue;
+		}
+		d = pd_rgb565_to_color(p[x]);
+		d.b = _pd_alpha_blend(d.b, color.b, a);
+		d.g = _pd_alpha_blend(d.g, color.g, a);
+		d.r = _pd_alpha_blend(d.r, color.r, a);
+		p[x] = pd_color_to_rgb565(d);
+	}
+}
+
+static bool pd_blend_load(pd_blend_impl_t impl, pd_blend_kernels_t *kernels)
+{
+	kernels->mix_argb = pd_mix_argb_row;
+	kernels->mix_argb_with_alpha = pd_mix_argb_with_alpha_row;
+	kernels->mix_argb2rgb = pd_mix_argb2rgb_row;
+	kernels->mix_pargb = pd_mix_pargb_row;
+	kernels->mix_argb2pargb = pd_mix_argb2pargb_row;
+	kernels->mix_pargb2argb = pd_mix_pargb2argb_row;
+	kernels->mix_pargb2rgb = pd_mix_pargb2rgb_row;
+	kernels->mix_argb2rgb565 = pd_mix_argb2rgb565_row;
+	kernels->mix_pargb2rgb565 = pd_mix_pargb2rgb565_row;
+	kernels->mask_argb = pd_mask_argb_row;
+	kernels->mask_pargb = pd_mask_pargb_row;
+	kernels->mix_mask_argb = pd_mix_mask_argb_row;
+	kernels->mix_mask_pargb = pd_mix_mask_pargb_row;
+	kernels->mix_mask_rgb = pd_mix_mask_rgb_row;
+	kernels->mix_mask_a8 = pd_mix_mask_a8_row;
+	kernels->mix_mask_rgb565 = pd_mix_mask_rgb565_row;
+	kernels->argb2rgb = pd_format_pixels_argb2rgb;
+	kernels->rgb2argb = pd_format_pixels_rgb2argb;
+	kernels->argb2pargb = pd_format_pixels_argb2pargb;
+	kernels->argb2rgb565 = pd_format_pixels_argb2rgb565;
+	kernels->rgb5652argb = pd_format_pixels_rgb5652argb;
+	kernels->fill_argb = pd_fill_argb_row;
+	kernels->fill_rgb = pd_fill_rgb_row;
+	kernels->fill_rgb565 = pd_fill_rgb565_row;
+	switch (impl) {
+	case PD_BLEND_IMPL_SCALAR:
+		return true;
+	case PD_BLEND_IMPL_SSE2:
+		return pd_blend_init_sse2(kernels);
+	case PD_BLEND_IMPL_AVX2:
+		/* The AVX2 kernels do not cover all of the SSE2 kernels */
+		return pd_blend_init_sse2(kernels) &&
+		       pd_blend_init_avx2(kernels);
+	case PD_BLEND_IMPL_NEON:
+		return pd_blend_init_neon(kernels);
+	default:
+		break;
+	}
+	return false;
+}
+
+bool pd_blend_impl_is_supported(pd_blend_impl_t impl)
+{
+	pd_blend_kernels_t kernels;
+
+	return pd_blend_load(impl, &kernels);
+}
+
+int pd_set_blend_impl(pd_blend_impl_t impl)
+{
+	pd_blend_kernels_t kernels;
+
+	if (!pd_blend_load(impl, &kernels)) {
+		return -1;
+	}
+	pd_blend_kernels = kernels;
+	pd_blend_impl = impl;
+	return 0;
+}
+
+void pd_blend_init(void)
+{
+	if (pd_set_blend_impl(PD_BLEND_IMPL_AVX2) != 0 &&
+	    pd_set_blend_impl(PD_BLEND_IMPL_SSE2) != 0 &&
+	    pd_set_blend_impl(PD_BLEND_IMPL_NEON) != 0) {
+		pd_set_blend_impl(PD_BLEND_IMPL_SCALAR);
+	}
+}
+
+pd_blend_impl_t pd_get_blend_impl(void)
+{
+	return pd_blend_impl;
+}
+
+const pd_blend_kernels_t *pd_get_blend_kernels(void)
+{
+	return &pd_blend_kernels;
+}
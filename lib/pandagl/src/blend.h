@@ -0,0 +1,207 @@
+﻿/*
+ * lib/pandagl/src/blend.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifndef LIB_PANDAGL_SRC_BLEND_H
+#define LIB_PANDAGL_SRC_BLEND_H
+
+#include <pandagl/common.h>
+#include <pandagl/types.h>
+
+/**
+ * Blend a row of ARGB pixels into a row of ARGB pixels. The opacity is the
+ * opacity of the source canvas.
+ */
+typedef void (*pd_blend_argb_row_func_t)(pd_color_t *dst,
+					  const pd_color_t *src, int count,
+					  float opacity);
+
+/** Blend a row of ARGB pixels into a row of RGB888 pixels */
+typedef void (*pd_blend_argb2rgb_row_func_t)(uint8_t *dst,
+					      const pd_color_t *src, int count,
+					      float opacity);
+
+/** Blend a row of ARGB pixels into a row of RGB565 pixels */
+typedef void (*pd_blend_argb2rgb565_row_func_t)(uint16_t *dst,
+						 const pd_color_t *src,
+						 int count, float opacity);
+
+/** Multiply a row of pixels by a row of coverage values */
+typedef void (*pd_blend_mask_row_func_t)(pd_color_t *dst, const uint8_t *mask,
+					  int count);
+
+/**
+ * Paint the color through a row of coverage values, the alpha of the color
+ * is multiplied by the coverage
+ */
+typedef void (*pd_blend_mask_color_row_func_t)(void *dst, const uint8_t *mask,
+						int count, pd_color_t color);
+
+/** Convert a row of pixels to another color type, see pd_format_pixels() */
+typedef void (*pd_convert_row_func_t)(const uint8_t *in_pixels,
+				      uint8_t *out_pixels, size_t count);
+
+/**
+ * Fill a row of pixels with the color, the color is converted to the color
+ * type of the row by the kernel
+ */
+typedef void (*pd_fill_row_func_t)(uint8_t *dst, pd_color_t color,
+				   size_t count);
+
+typedef struct pd_blend_kernels {
+	/* blend the color channels, the alpha of the destination is kept */
+	pd_blend_argb_row_func_t mix_argb;
+
+	/* over operator, see pd_over_pixel() */
+	pd_blend_argb_row_func_t mix_argb_with_alpha;
+
+	pd_blend_argb2rgb_row_func_t mix_argb2rgb;
+
+	/* over operator of premultiplied pixels, see
+	 * pd_over_premultiplied_pixel() */
+	pd_blend_argb_row_func_t mix_pargb;
+
+	/* straight alpha pixels over premultiplied pixels */
+	pd_blend_argb_row_func_t mix_argb2pargb;
+
+	/* premultiplied pixels over straight alpha pixels */
+	pd_blend_argb_row_func_t mix_pargb2argb;
+
+	pd_blend_argb2rgb_row_func_t mix_pargb2rgb;
+
+	/* the same as mix_argb2rgb and mix_pargb2rgb, in 16-bit pixels */
+	pd_blend_argb2rgb565_row_func_t mix_argb2rgb565;
+	pd_blend_argb2rgb565_row_func_t mix_pargb2rgb565;
+
+	/* scale the alpha of straight alpha pixels by the coverage */
+	pd_blend_mask_row_func_t mask_argb;
+
+	/* scale all channels of premultiplied pixels by the coverage */
+	pd_blend_mask_row_func_t mask_pargb;
+
+	/* paint the color through the coverage, see pd_canvas_mix_mask() */
+	pd_blend_mask_color_row_func_t mix_mask_argb;
+	pd_blend_mask_color_row_func_t mix_mask_pargb;
+	pd_blend_mask_color_row_func_t mix_mask_rgb;
+	pd_blend_mask_color_row_func_t mix_mask_a8;
+	pd_blend_mask_color_row_func_t mix_mask_rgb565;
+
+	/* pixel format conversion, the alpha is dropped when it is converted
+	 * to a color type without alpha */
+	pd_convert_row_func_t argb2rgb;
+	pd_convert_row_func_t rgb2argb;
+	pd_convert_row_func_t argb2pargb;
+	pd_convert_row_func_t argb2rgb565;
+	pd_convert_row_func_t rgb5652argb;
+
+	pd_fill_row_func_t fill_argb;
+	pd_fill_row_func_t fill_rgb;
+	pd_fill_row_func_t fill_rgb565;
+} pd_blend_kernels_t;
+
+/** Convert the opacity to the alpha used by the premultiplied kernels */
+PD_INLINE unsigned pd_blend_opacity_to_alpha(float opacity)
+{
+	if (opacity >= 1.0) {
+		return 256;
+	}
+	if (opacity <= 0) {
+		return 0;
+	}
+	return (unsigned)(opacity * 256.0f + 0.5f);
+}
+
+/*
+ * The scalar kernels are the reference implementation. The SIMD kernels use
+ * them for the pixels at the end of the rows.
+ */
+
+void pd_mix_argb_row(pd_color_t *dst, const pd_color_t *src, int count,
+		     float opacity);
+
+void pd_mix_argb_with_alpha_row(pd_color_t *dst, const pd_color_t *src,
+				int count, float opacity);
+
+void pd_mix_argb2rgb_row(uint8_t *dst, const pd_color_t *src, int count,
+			 float opacity);
+
+void pd_mix_pargb_row(pd_color_t *dst, const pd_color_t *src, int count,
+		      float opacity);
+
+void pd_mix_argb2pargb_row(pd_color_t *dst, const pd_color_t *src, int count,
+			   float opacity);
+
+void pd_mix_pargb2argb_row(pd_color_t *dst, const pd_color_t *src, int count,
+			   float opacity);
+
+void pd_mix_pargb2rgb_row(uint8_t *dst, const pd_color_t *src, int count,
+			  float opacity);
+
+void pd_mix_argb2rgb565_row(uint16_t *dst, const pd_color_t *src, int count,
+			    float opacity);
+
+void pd_mix_pargb2rgb565_row(uint16_t *dst, const pd_color_t *src, int count,
+			     float opacity);
+
+void pd_mask_argb_row(pd_color_t *dst, const uint8_t *mask, int count);
+
+void pd_mask_pargb_row(pd_color_t *dst, const uint8_t *mask, int count);
+
+void pd_mix_mask_argb_row(void *dst, const uint8_t *mask, int count,
+			  pd_color_t color);
+
+void pd_mix_mask_pargb_row(void *dst, const uint8_t *mask, int count,
+			   pd_color_t color);
+
+void pd_mix_mask_rgb_row(void *dst, const uint8_t *mask, int count,
+			 pd_color_t color);
+
+void pd_mix_mask_a8_row(void *dst, const uint8_t *mask, int count,
+			pd_color_t color);
+
+void pd_mix_mask_rgb565_row(void *dst, const uint8_t *mask, int count,
+			    pd_color_t color);
+
+void pd_format_pixels_argb2rgb(const uint8_t *in_pixels, uint8_t *out_pixels,
+			       size_t count);
+
+void pd_format_pixels_rgb2argb(const uint8_t *in_pixels, uint8_t *out_pixels,
+			       size_t count);
+
+void pd_format_pixels_argb2pargb(const uint8_t *in_pixels, uint8_t *out_pixels,
+				 size_t count);
+
+void pd_format_pixels_argb2rgb565(const uint8_t *in_pixels,
+				  uint8_t *out_pixels, size_t count);
+
+void pd_format_pixels_rgb5652argb(const uint8_t *in_pixels,
+				  uint8_t *out_pixels, size_t count);
+
+void pd_fill_argb_row(uint8_t *dst, pd_color_t color, size_t count);
+
+void pd_fill_rgb_row(uint8_t *dst, pd_color_t color, size_t count);
+
+void pd_fill_rgb565_row(uint8_t *dst, pd_color_t color, size_t count);
+
+/*
+ * Replace the kernels with the ones of the instruction set. Return false if
+ * the instruction set is not supported by the build or the CPU.
+ */
+
+bool pd_blend_init_sse2(pd_blend_kernels_t *kernels);
+
+bool pd_blend_init_avx2(pd_blend_kernels_t *kernels);
+
+bool pd_blend_init_neon(pd_blend_kernels_t *kernels);
+
+/** Get the kernels of the current implementation */
+const pd_blend_kernels_t *pd_get_blend_kernels(void);
+
+#endif
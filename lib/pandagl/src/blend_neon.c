@@ -0,0 +1,337 @@
+﻿/*
+ * lib/pandagl/src/blend_neon.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <pandagl.h>
+#include "blend.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define PD_BLEND_HAS_NEON
+#endif
+
+#ifdef PD_BLEND_HAS_NEON
+
+#include <arm_neon.h>
+#if defined(__arm__) && defined(__linux__)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+static bool pd_cpu_has_neon(void)
+{
+#if defined(__arm__) && defined(__linux__)
+	return (getauxval(AT_HWCAP) & HWCAP_NEON) != 0;
+#else
+	/* NEON is a mandatory part of AArch64 */
+	return true;
+#endif
+}
+
+static uint8x8_t pd_scale_alpha8_neon(uint8x8_t a, float32x4_t opacity)
+{
+	uint16x8_t a16 = vmovl_u8(a);
+	uint32x4_t lo = vmovl_u16(vget_low_u16(a16));
+	uint32x4_t hi = vmovl_u16(vget_high_u16(a16));
+
+	lo = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(lo), opacity));
+	hi = vcvtq_u32_f32(vmulq_f32(vcvtq_f32_u32(hi), opacity));
+	return vmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+}
+
+/** Multiply the alpha by the opacity like (uint8_t)(a * opacity) */
+static uint8x16_t pd_scale_alpha_neon(uint8x16_t a, float opacity)
+{
+	float32x4_t k;
+
+	if (opacity >= 1.0) {
+		return a;
+	}
+	k = vdupq_n_f32(opacity);
+	return vcombine_u8(pd_scale_alpha8_neon(vget_low_u8(a), k),
+			   pd_scale_alpha8_neon(vget_high_u8(a), k));
+}
+
+/**
+ * Blend a channel of 16 pixels like _pd_alpha_blend(), it is computed as
+ * (fore * a + back * (255 - a) + back) >> 8 which never exceeds 16 bits.
+ */
+static uint8x16_t pd_blend_neon(uint8x16_t back, uint8x16_t fore,
+				uint8x16_t a)
+{
+	uint8x16_t inv = vmvnq_u8(a);
+	uint16x8_t lo = vmull_u8(vget_low_u8(fore), vget_low_u8(a));
+	uint16x8_t hi = vmull_u8(vget_high_u8(fore), vget_high_u8(a));
+
+	lo = vmlal_u8(lo, vget_low_u8(back), vget_low_u8(inv));
+	hi = vmlal_u8(hi, vget_high_u8(back), vget_high_u8(inv));
+	lo = vaddw_u8(lo, vget_low_u8(back));
+	hi = vaddw_u8(hi, vget_high_u8(back));
+	return vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8));
+}
+
+static void pd_mix_argb_row_neon(pd_color_t *dst, const pd_color_t *src,
+				 int count, float opacity)
+{
+	int x;
+	uint8x16_t a;
+	uint8x16x4_t s, d;
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		s = vld4q_u8((const uint8_t *)(src + x));
+		d = vld4q_u8((const uint8_t *)(dst + x));
+		a = pd_scale_alpha_neon(s.val[3], opacity);
+		d.val[0] = pd_blend_neon(d.val[0], s.val[0], a);
+		d.val[1] = pd_blend_neon(d.val[1], s.val[1], a);
+		d.val[2] = pd_blend_neon(d.val[2], s.val[2], a);
+		vst4q_u8((uint8_t *)(dst + x), d);
+	}
+	pd_mix_argb_row(dst + x, src + x, count - x, opacity);
+}
+
+static void pd_mix_argb2rgb_row_neon(uint8_t *dst, const pd_color_t *src,
+				     int count, float opacity)
+{
+	int x;
+	uint8x16_t a;
+	uint8x16x4_t s;
+	uint8x16x3_t d;
+
+	for (x = 0; x + 16 <= count; x += 16, dst += 48) {
+		s = vld4q_u8((const uint8_t *)(src + x));
+		d = vld3q_u8(dst);
+		a = pd_scale_alpha_neon(s.val[3], opacity);
+		d.val[0] = pd_blend_neon(d.val[0], s.val[0], a);
+		d.val[1] = pd_blend_neon(d.val[1], s.val[1], a);
+		d.val[2] = pd_blend_neon(d.val[2], s.val[2], a);
+		vst3q_u8(dst, d);
+	}
+	pd_mix_argb2rgb_row(dst, src + x, count - x, opacity);
+}
+
+/** x / 255 for 8 lanes like pd_div255(), narrowed to 8 bits */
+static uint8x8_t pd_div255_neon(uint16x8_t x)
+{
+	x = vaddq_u16(x, vdupq_n_u16(128));
+	return vaddhn_u16(x, vshrq_n_u16(x, 8));
+}
+
+/** Multiply a channel of 16 pixels by the alpha like (c * alpha) >> 8 */
+static uint8x16_t pd_scale_channel_neon(uint8x16_t c, unsigned alpha)
+{
+	uint8x8_t k;
+
+	if (alpha >= 256) {
+		return c;
+	}
+	k = vdup_n_u8((uint8_t)alpha);
+	return vcombine_u8(vshrn_n_u16(vmull_u8(vget_low_u8(c), k), 8),
+			   vshrn_n_u16(vmull_u8(vget_high_u8(c), k), 8));
+}
+
+/** Multiply a channel of 16 pixels by their alpha like pd_div255(c * a) */
+static uint8x16_t pd_mul_channel_neon(uint8x16_t c, uint8x16_t a)
+{
+	return vcombine_u8(
+	    pd_div255_neon(vmull_u8(vget_low_u8(c), vget_low_u8(a))),
+	    pd_div255_neon(vmull_u8(vget_high_u8(c), vget_high_u8(a))));
+}
+
+/** Over operator for 16 premultiplied pixels */
+static uint8x16x4_t pd_over_premultiplied_neon(uint8x16x4_t back,
+					       uint8x16x4_t fore)
+{
+	int i;
+	uint8x16_t inv = vmvnq_u8(fore.val[3]);
+
+	for (i = 0; i < 4; ++i) {
+		back.val[i] = vaddq_u8(fore.val[i],
+				       pd_mul_channel_neon(back.val[i], inv));
+	}
+	return back;
+}
+
+static void pd_mix_pargb_row_neon(pd_color_t *dst, const pd_color_t *src,
+				  int count, float opacity)
+{
+	int x, i;
+	uint8x16x4_t s, d;
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		s = vld4q_u8((const uint8_t *)(src + x));
+		d = vld4q_u8((const uint8_t *)(dst + x));
+		for (i = 0; i < 4; ++i) {
+			s.val[i] = pd_scale_channel_neon(s.val[i], alpha);
+		}
+		vst4q_u8((uint8_t *)(dst + x), pd_over_premultiplied_neon(d, s));
+	}
+	pd_mix_pargb_row(dst + x, src + x, count - x, opacity);
+}
+
+static void pd_mix_argb2pargb_row_neon(pd_color_t *dst, const pd_color_t *src,
+				       int count, float opacity)
+{
+	int x, i;
+	uint8x16x4_t s, d;
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		s = vld4q_u8((const uint8_t *)(src + x));
+		d = vld4q_u8((const uint8_t *)(dst + x));
+		s.val[3] = pd_scale_channel_neon(s.val[3], alpha);
+		for (i = 0; i < 3; ++i) {
+			s.val[i] = pd_mul_channel_neon(s.val[i], s.val[3]);
+		}
+		vst4q_u8((uint8_t *)(dst + x), pd_over_premultiplied_neon(d, s));
+	}
+	pd_mix_argb2pargb_row(dst + x, src + x, count - x, opacity);
+}
+
+static void pd_mask_argb_row_neon(pd_color_t *dst, const uint8_t *mask,
+				  int count)
+{
+	int x;
+	uint8x16x4_t d;
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		d = vld4q_u8((const uint8_t *)(dst + x));
+		d.val[3] = pd_mul_channel_neon(d.val[3], vld1q_u8(mask + x));
+		vst4q_u8((uint8_t *)(dst + x), d);
+	}
+	pd_mask_argb_row(dst + x, mask + x, count - x);
+}
+
+static void pd_mask_pargb_row_neon(pd_color_t *dst, const uint8_t *mask,
+				   int count)
+{
+	int x, i;
+	uint8x16_t m;
+	uint8x16x4_t d;
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		d = vld4q_u8((const uint8_t *)(dst + x));
+		m = vld1q_u8(mask + x);
+		for (i = 0; i < 4; ++i) {
+			d.val[i] = pd_mul_channel_neon(d.val[i], m);
+		}
+		vst4q_u8((uint8_t *)(dst + x), d);
+	}
+	pd_mask_pargb_row(dst + x, mask + x, count - x);
+}
+
+static void pd_mix_mask_pargb_row_neon(void *dst, const uint8_t *mask,
+				       int count, pd_color_t color)
+{
+	int x;
+	uint8x16_t m;
+	uint8x16x4_t d, s;
+	pd_color_t pc = color;
+	pd_color_t *px = dst;
+
+	pd_premultiply_pixel(&pc);
+	for (x = 0; x + 16 <= count; x += 16) {
+		d = vld4q_u8((const uint8_t *)(px + x));
+		m = vld1q_u8(mask + x);
+		s.val[0] = pd_mul_channel_neon(vdupq_n_u8(pc.b), m);
+		s.val[1] = pd_mul_channel_neon(vdupq_n_u8(pc.g), m);
+		s.val[2] = pd_mul_channel_neon(vdupq_n_u8(pc.r), m);
+		s.val[3] = pd_mul_channel_neon(vdupq_n_u8(pc.a), m);
+		vst4q_u8((uint8_t *)(px + x), pd_over_premultiplied_neon(d, s));
+	}
+	pd_mix_mask_pargb_row(px + x, mask + x, count - x, color);
+}
+
+#ifdef __aarch64__
+
+static float64x2_t pd_channel_f64_neon(uint32x2_t px, int shift)
+{
+	uint32x2_t c = vand_u32(vshl_u32(px, vdup_n_s32(-shift)),
+				vdup_n_u32(0xff));
+
+	return vcvtq_f64_u64(vmovl_u32(c));
+}
+
+static uint32x2_t pd_channel_u32_neon(float64x2_t c, int shift)
+{
+	return vshl_u32(vmovn_u64(vcvtq_u64_f64(c)), vdup_n_s32(shift));
+}
+
+/** Over operator for 2 pixels in double precision, see pd_over_pixel() */
+static uint32x2_t pd_over_neon(uint32x2_t back, uint32x2_t fore,
+			       float64x2_t opacity)
+{
+	int shift;
+	const float64x2_t k255 = vdupq_n_f64(255.0);
+	float64x2_t src_a, a, out_a, c;
+	uint64x2_t mask;
+	uint32x2_t out;
+
+	src_a = vdivq_f64(vmulq_f64(pd_channel_f64_neon(fore, 24), opacity),
+			  k255);
+	a = vdivq_f64(vmulq_f64(vsubq_f64(vdupq_n_f64(1.0), src_a),
+				pd_channel_f64_neon(back, 24)),
+		      k255);
+	out_a = vaddq_f64(src_a, a);
+	mask = vcgtq_f64(out_a, vdupq_n_f64(0));
+	src_a = vbslq_f64(mask, vdivq_f64(src_a, out_a), src_a);
+	a = vbslq_f64(mask, vdivq_f64(a, out_a), a);
+	out = pd_channel_u32_neon(vmulq_f64(k255, out_a), 24);
+	for (shift = 0; shift < 24; shift += 8) {
+		/* Multiply and add separately like the scalar code does */
+		c = vaddq_f64(vmulq_f64(pd_channel_f64_neon(fore, shift), src_a),
+			      vmulq_f64(pd_channel_f64_neon(back, shift), a));
+		out = vorr_u32(out, pd_channel_u32_neon(c, shift));
+	}
+	return out;
+}
+
+static void pd_mix_argb_with_alpha_row_neon(pd_color_t *dst,
+					    const pd_color_t *src, int count,
+					    float opacity)
+{
+	int x;
+	const float64x2_t k = vdupq_n_f64(opacity);
+
+	for (x = 0; x + 2 <= count; x += 2) {
+		vst1_u32(&dst[x].value,
+			 pd_over_neon(vld1_u32(&dst[x].value),
+				      vld1_u32(&src[x].value), k));
+	}
+	pd_mix_argb_with_alpha_row(dst + x, src + x, count - x, opacity);
+}
+
+#endif
+
+bool pd_blend_init_neon(pd_blend_kernels_t *kernels)
+{
+	if (!pd_cpu_has_neon()) {
+		return false;
+	}
+	kernels->mix_argb = pd_mix_argb_row_neon;
+	kernels->mix_argb2rgb = pd_mix_argb2rgb_row_neon;
+	kernels->mix_pargb = pd_mix_pargb_row_neon;
+	kernels->mix_argb2pargb = pd_mix_argb2pargb_row_neon;
+	kernels->mask_argb = pd_mask_argb_row_neon;
+	kernels->mask_pargb = pd_mask_pargb_row_neon;
+	kernels->mix_mask_pargb = pd_mix_mask_pargb_row_neon;
+#ifdef __aarch64__
+	kernels->mix_argb_with_alpha = pd_mix_argb_with_alpha_row_neon;
+#endif
+	return true;
+}
+
+#else
+
+bool pd_blend_init_neon(pd_blend_kernels_t *kernels)
+{
+	return false;
+}
+
+#endif
@@ -0,0 +1,1121 @@
+﻿/*
+ * lib/pandagl/src/blend_x86.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <pandagl.h>
+#include "blend.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+    defined(_M_IX86)
+#define PD_BLEND_HAS_X86
+#endif
+
+#ifdef PD_BLEND_HAS_X86
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PD_TARGET_SSE2 __attribute__((target("sse2")))
+#define PD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PD_TARGET_SSE2
+#define PD_TARGET_AVX2
+#endif
+
+static bool pd_cpu_has_sse2(void)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+	return true;
+#elif defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 1);
+	return (info[3] >> 26) & 1;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+static bool pd_cpu_has_avx2(void)
+{
+#if defined(_MSC_VER)
+	int info[4];
+
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	/* The OS must save the YMM registers */
+	__cpuid(info, 1);
+	if (!((info[2] >> 27) & 1) || (_xgetbv(0) & 6) != 6) {
+		return false;
+	}
+	__cpuidex(info, 7, 0);
+	return (info[1] >> 5) & 1;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+/*
+ * The kernels give the same result as the scalar kernels:
+ *
+ * - _pd_alpha_blend() is computed as (fore * a + back * (256 - a)) >> 8,
+ *   which is equal to it and never exceeds 16 bits.
+ * - The alpha multiplied by the opacity is computed in single precision and
+ *   the over operator in double precision, in the same order as the scalar
+ *   code, and converted to integers by truncation.
+ */
+
+PD_TARGET_SSE2
+static inline __m128i pd_scale_alpha_sse2(__m128i a, float opacity)
+{
+	if (opacity < 1.0) {
+		a = _mm_cvttps_epi32(
+		    _mm_mul_ps(_mm_cvtepi32_ps(a), _mm_set1_ps(opacity)));
+	}
+	return a;
+}
+
+/** Blend the color channels of 4 pixels, alpha is 32 bits per pixel */
+PD_TARGET_SSE2
+static inline __m128i pd_blend_sse2(__m128i back, __m128i fore, __m128i a)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i k256 = _mm_set1_epi16(256);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+	__m128i a_lo, a_hi, lo, hi;
+
+	/* Repeat the alpha in the 16-bit lanes of the channels of its pixel */
+	a = _mm_or_si128(a, _mm_slli_epi32(a, 16));
+	a_lo = _mm_unpacklo_epi32(a, a);
+	a_hi = _mm_unpackhi_epi32(a, a);
+	lo = _mm_add_epi16(
+	    _mm_mullo_epi16(_mm_unpacklo_epi8(fore, zero), a_lo),
+	    _mm_mullo_epi16(_mm_unpacklo_epi8(back, zero),
+			    _mm_sub_epi16(k256, a_lo)));
+	hi = _mm_add_epi16(
+	    _mm_mullo_epi16(_mm_unpackhi_epi8(fore, zero), a_hi),
+	    _mm_mullo_epi16(_mm_unpackhi_epi8(back, zero),
+			    _mm_sub_epi16(k256, a_hi)));
+	lo = _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8));
+	return _mm_or_si128(_mm_andnot_si128(alpha_mask, lo),
+			    _mm_and_si128(alpha_mask, back));
+}
+
+PD_TARGET_SSE2
+static void pd_mix_argb_row_sse2(pd_color_t *dst, const pd_color_t *src,
+				 int count, float opacity)
+{
+	int x;
+	__m128i s, d, a;
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + x));
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		a = pd_scale_alpha_sse2(_mm_srli_epi32(s, 24), opacity);
+		_mm_storeu_si128((__m128i *)(dst + x), pd_blend_sse2(d, s, a));
+	}
+	pd_mix_argb_row(dst + x, src + x, count - x, opacity);
+}
+
+PD_TARGET_SSE2
+static __m128d pd_select_pd_sse2(__m128d mask, __m128d a, __m128d b)
+{
+	return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+PD_TARGET_SSE2
+static __m128d pd_channel_pd_sse2(__m128i px, int shift)
+{
+	return _mm_cvtepi32_pd(_mm_and_si128(
+	    _mm_srl_epi32(px, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xff)));
+}
+
+/** Over operator for the 2 pixels in the low 64 bits */
+PD_TARGET_SSE2
+static __m128i pd_over_sse2(__m128i back, __m128i fore, __m128d opacity)
+{
+	int shift;
+	const __m128d zero = _mm_setzero_pd();
+	const __m128d k255 = _mm_set1_pd(255.0);
+	__m128d src_a, a, out_a, mask, c;
+	__m128i out;
+
+	src_a = _mm_div_pd(_mm_mul_pd(pd_channel_pd_sse2(fore, 24), opacity),
+			   k255);
+	a = _mm_div_pd(_mm_mul_pd(_mm_sub_pd(_mm_set1_pd(1.0), src_a),
+				  pd_channel_pd_sse2(back, 24)),
+		       k255);
+	out_a = _mm_add_pd(src_a, a);
+	mask = _mm_cmpgt_pd(out_a, zero);
+	src_a = pd_select_pd_sse2(mask, _mm_div_pd(src_a, out_a), src_a);
+	a = pd_select_pd_sse2(mask, _mm_div_pd(a, out_a), a);
+	out = _mm_slli_epi32(_mm_cvttpd_epi32(_mm_mul_pd(k255, out_a)), 24);
+	for (shift = 0; shift < 24; shift += 8) {
+		c = _mm_add_pd(
+		    _mm_mul_pd(pd_channel_pd_sse2(fore, shift), src_a),
+		    _mm_mul_pd(pd_channel_pd_sse2(back, shift), a));
+		out = _mm_or_si128(
+		    out, _mm_sll_epi32(_mm_cvttpd_epi32(c),
+				       _mm_cvtsi32_si128(shift)));
+	}
+	return out;
+}
+
+PD_TARGET_SSE2
+static void pd_mix_argb_with_alpha_row_sse2(pd_color_t *dst,
+					    const pd_color_t *src, int count,
+					    float opacity)
+{
+	int x;
+	__m128i s, d;
+	const __m128d k = _mm_set1_pd(opacity);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + x));
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + x),
+		    _mm_unpacklo_epi64(
+			pd_over_sse2(d, s, k),
+			pd_over_sse2(_mm_srli_si128(d, 8),
+				     _mm_srli_si128(s, 8), k)));
+	}
+	pd_mix_argb_with_alpha_row(dst + x, src + x, count - x, opacity);
+}
+
+PD_TARGET_AVX2
+static __m256i pd_blend_avx2(__m256i back, __m256i fore, __m256i a)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i k256 = _mm256_set1_epi16(256);
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+	__m256i a_lo, a_hi, lo, hi;
+
+	a = _mm256_or_si256(a, _mm256_slli_epi32(a, 16));
+	a_lo = _mm256_unpacklo_epi32(a, a);
+	a_hi = _mm256_unpackhi_epi32(a, a);
+	lo = _mm256_add_epi16(
+	    _mm256_mullo_epi16(_mm256_unpacklo_epi8(fore, zero), a_lo),
+	    _mm256_mullo_epi16(_mm256_unpacklo_epi8(back, zero),
+			       _mm256_sub_epi16(k256, a_lo)));
+	hi = _mm256_add_epi16(
+	    _mm256_mullo_epi16(_mm256_unpackhi_epi8(fore, zero), a_hi),
+	    _mm256_mullo_epi16(_mm256_unpackhi_epi8(back, zero),
+			       _mm256_sub_epi16(k256, a_hi)));
+	lo = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8),
+				 _mm256_srli_epi16(hi, 8));
+	return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, lo),
+			       _mm256_and_si256(alpha_mask, back));
+}
+
+PD_TARGET_AVX2
+static void pd_mix_argb_row_avx2(pd_color_t *dst, const pd_color_t *src,
+				 int count, float opacity)
+{
+	int x;
+	__m256i s, d, a;
+	const __m256 k = _mm256_set1_ps(opacity);
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(src + x));
+		d = _mm256_loadu_si256((const __m256i *)(dst + x));
+		a = _mm256_srli_epi32(s, 24);
+		if (opacity < 1.0) {
+			a = _mm256_cvttps_epi32(
+			    _mm256_mul_ps(_mm256_cvtepi32_ps(a), k));
+		}
+		_mm256_storeu_si256((__m256i *)(dst + x),
+				    pd_blend_avx2(d, s, a));
+	}
+	pd_mix_argb_row(dst + x, src + x, count - x, opacity);
+}
+
+PD_TARGET_AVX2
+static __m256d pd_channel_pd_avx2(__m128i px, int shift)
+{
+	return _mm256_cvtepi32_pd(_mm_and_si128(
+	    _mm_srl_epi32(px, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xff)));
+}
+
+/** Over operator for 4 pixels */
+PD_TARGET_AVX2
+static __m128i pd_over_avx2(__m128i back, __m128i fore, __m256d opacity)
+{
+	int shift;
+	const __m256d zero = _mm256_setzero_pd();
+	const __m256d k255 = _mm256_set1_pd(255.0);
+	__m256d src_a, a, out_a, mask, c;
+	__m128i out;
+
+	src_a = _mm256_div_pd(
+	    _mm256_mul_pd(pd_channel_pd_avx2(fore, 24), opacity), k255);
+	a = _mm256_div_pd(_mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), src_a),
+					pd_channel_pd_avx2(back, 24)),
+			  k255);
+	out_a = _mm256_add_pd(src_a, a);
+	mask = _mm256_cmp_pd(out_a, zero, _CMP_GT_OQ);
+	src_a = _mm256_blendv_pd(src_a, _mm256_div_pd(src_a, out_a), mask);
+	a = _mm256_blendv_pd(a, _mm256_div_pd(a, out_a), mask);
+	out = _mm_slli_epi32(_mm256_cvttpd_epi32(_mm256_mul_pd(k255, out_a)),
+			     24);
+	for (shift = 0; shift < 24; shift += 8) {
+		c = _mm256_add_pd(
+		    _mm256_mul_pd(pd_channel_pd_avx2(fore, shift), src_a),
+		    _mm256_mul_pd(pd_channel_pd_avx2(back, shift), a));
+		out = _mm_or_si128(out,
+				   _mm_sll_epi32(_mm256_cvttpd_epi32(c),
+						 _mm_cvtsi32_si128(shift)));
+	}
+	return out;
+}
+
+PD_TARGET_AVX2
+static void pd_mix_argb_with_alpha_row_avx2(pd_color_t *dst,
+					    const pd_color_t *src, int count,
+					    float opacity)
+{
+	int x;
+	__m128i s, d;
+	const __m256d k = _mm256_set1_pd(opacity);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + x));
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		_mm_storeu_si128((__m128i *)(dst + x), pd_over_avx2(d, s, k));
+	}
+	pd_mix_argb_with_alpha_row(dst + x, src + x, count - x, opacity);
+}
+
+/** Blend 4 pixels into the RGB pixels in the low 12 bytes */
+PD_TARGET_AVX2
+static __m128i pd_blend_rgb_avx2(__m128i rgb, const pd_color_t *src,
+				 float opacity)
+{
+	const __m128i expand = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8,
+					     -1, 9, 10, 11, -1);
+	const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13,
+					   14, -1, -1, -1, -1);
+	__m128i s = _mm_loadu_si128((const __m128i *)src);
+	__m128i a = pd_scale_alpha_sse2(_mm_srli_epi32(s, 24), opacity);
+
+	return _mm_shuffle_epi8(
+	    pd_blend_sse2(_mm_shuffle_epi8(rgb, expand), s, a), pack);
+}
+
+/**
+ * Blend 16 pixels at a time, their 48 bytes are loaded and stored as three
+ * vectors, so that no bytes out of the row are touched.
+ */
+PD_TARGET_AVX2
+static void pd_mix_argb2rgb_row_avx2(uint8_t *dst, const pd_color_t *src,
+				     int count, float opacity)
+{
+	int x;
+	__m128i v0, v1, v2, p0, p1, p2, p3;
+
+	for (x = 0; x + 16 <= count; x += 16, dst += 48) {
+		v0 = _mm_loadu_si128((const __m128i *)dst);
+		v1 = _mm_loadu_si128((const __m128i *)(dst + 16));
+		v2 = _mm_loadu_si128((const __m128i *)(dst + 32));
+		p0 = pd_blend_rgb_avx2(v0, src + x, opacity);
+		p1 = pd_blend_rgb_avx2(_mm_alignr_epi8(v1, v0, 12),
+				       src + x + 4, opacity);
+		p2 = pd_blend_rgb_avx2(_mm_alignr_epi8(v2, v1, 8),
+				       src + x + 8, opacity);
+		p3 = pd_blend_rgb_avx2(_mm_srli_si128(v2, 4), src + x + 12,
+				       opacity);
+		_mm_storeu_si128((__m128i *)dst,
+				 _mm_or_si128(p0, _mm_slli_si128(p1, 12)));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + 16),
+		    _mm_or_si128(_mm_srli_si128(p1, 4), _mm_slli_si128(p2, 8)));
+		_mm_storeu_si128(
+		    (__m128i *)(dst + 32),
+		    _mm_or_si128(_mm_srli_si128(p2, 8), _mm_slli_si128(p3, 4)));
+	}
+	pd_mix_argb2rgb_row(dst, src + x, count - x, opacity);
+}
+
+/*
+ * The premultiplied kernels compute all of the four channels in 16-bit lanes,
+ * x / 255 is computed as ((x + 128) * 257) >> 16 like pd_div255().
+ */
+
+PD_TARGET_SSE2
+static inline __m128i pd_div255_sse2(__m128i x)
+{
+	return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)),
+			       _mm_set1_epi16(257));
+}
+
+/** Repeat the alpha of the 2 pixels in the 16-bit lanes of their channels */
+PD_TARGET_SSE2
+static inline __m128i pd_repeat_alpha_sse2(__m128i px)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, 0xff), 0xff);
+}
+
+PD_TARGET_SSE2
+static inline __m128i pd_scale_pixels_sse2(__m128i px, unsigned alpha)
+{
+	if (alpha < 256) {
+		px = _mm_srli_epi16(
+		    _mm_mullo_epi16(px, _mm_set1_epi16((short)alpha)), 8);
+	}
+	return px;
+}
+
+/** Premultiply the 2 pixels and multiply their alpha by the opacity */
+PD_TARGET_SSE2
+static inline __m128i pd_premultiply_sse2(__m128i px, unsigned alpha)
+{
+	const __m128i alpha_mask = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	__m128i a = pd_scale_pixels_sse2(pd_repeat_alpha_sse2(px), alpha);
+
+	px = pd_div255_sse2(_mm_mullo_epi16(px, a));
+	return _mm_or_si128(_mm_andnot_si128(alpha_mask, px),
+			    _mm_and_si128(alpha_mask, a));
+}
+
+/** Over operator for the 2 premultiplied pixels */
+PD_TARGET_SSE2
+static inline __m128i pd_over_premultiplied_sse2(__m128i back, __m128i fore)
+{
+	__m128i inv =
+	    _mm_sub_epi16(_mm_set1_epi16(255), pd_repeat_alpha_sse2(fore));
+
+	return _mm_add_epi16(fore, pd_div255_sse2(_mm_mullo_epi16(back, inv)));
+}
+
+PD_TARGET_SSE2
+static void pd_mix_pargb_row_sse2(pd_color_t *dst, const pd_color_t *src,
+				  int count, float opacity)
+{
+	int x;
+	__m128i s, d, lo, hi;
+	const __m128i zero = _mm_setzero_si128();
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + x));
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		lo = pd_scale_pixels_sse2(_mm_unpacklo_epi8(s, zero), alpha);
+		hi = pd_scale_pixels_sse2(_mm_unpackhi_epi8(s, zero), alpha);
+		lo = pd_over_premultiplied_sse2(_mm_unpacklo_epi8(d, zero), lo);
+		hi = pd_over_premultiplied_sse2(_mm_unpackhi_epi8(d, zero), hi);
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+	}
+	pd_mix_pargb_row(dst + x, src + x, count - x, opacity);
+}
+
+PD_TARGET_SSE2
+static void pd_mix_argb2pargb_row_sse2(pd_color_t *dst, const pd_color_t *src,
+				       int count, float opacity)
+{
+	int x;
+	__m128i s, d, lo, hi;
+	const __m128i zero = _mm_setzero_si128();
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		s = _mm_loadu_si128((const __m128i *)(src + x));
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		lo = pd_premultiply_sse2(_mm_unpacklo_epi8(s, zero), alpha);
+		hi = pd_premultiply_sse2(_mm_unpackhi_epi8(s, zero), alpha);
+		lo = pd_over_premultiplied_sse2(_mm_unpacklo_epi8(d, zero), lo);
+		hi = pd_over_premultiplied_sse2(_mm_unpackhi_epi8(d, zero), hi);
+		_mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+	}
+	pd_mix_argb2pargb_row(dst + x, src + x, count - x, opacity);
+}
+
+/**
+ * Load the coverage of 4 pixels, the channels to be kept get 255. The
+ * alpha_only argument is a constant so the branch is folded.
+ */
+PD_TARGET_SSE2
+static inline __m128i pd_load_mask_sse2(const uint8_t *mask, bool alpha_only)
+{
+	int m;
+	__m128i v;
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xff000000);
+
+	memcpy(&m, mask, sizeof(m));
+	v = _mm_cvtsi32_si128(m);
+	v = _mm_unpacklo_epi8(v, v);
+	v = _mm_unpacklo_epi16(v, v);
+	if (alpha_only) {
+		v = _mm_or_si128(_mm_and_si128(v, alpha_mask),
+				 _mm_andnot_si128(alpha_mask,
+						  _mm_set1_epi8((char)0xff)));
+	}
+	return v;
+}
+
+PD_TARGET_SSE2
+static inline __m128i pd_mask_sse2(__m128i px, __m128i m)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i lo, hi;
+
+	lo = pd_div255_sse2(_mm_mullo_epi16(_mm_unpacklo_epi8(px, zero),
+					    _mm_unpacklo_epi8(m, zero)));
+	hi = pd_div255_sse2(_mm_mullo_epi16(_mm_unpackhi_epi8(px, zero),
+					    _mm_unpackhi_epi8(m, zero)));
+	return _mm_packus_epi16(lo, hi);
+}
+
+PD_TARGET_SSE2
+static void pd_mask_argb_row_sse2(pd_color_t *dst, const uint8_t *mask,
+				  int count)
+{
+	int x;
+	__m128i d;
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		d = pd_mask_sse2(d, pd_load_mask_sse2(mask + x, true));
+		_mm_storeu_si128((__m128i *)(dst + x), d);
+	}
+	pd_mask_argb_row(dst + x, mask + x, count - x);
+}
+
+PD_TARGET_SSE2
+static void pd_mask_pargb_row_sse2(pd_color_t *dst, const uint8_t *mask,
+				   int count)
+{
+	int x;
+	__m128i d;
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		d = _mm_loadu_si128((const __m128i *)(dst + x));
+		d = pd_mask_sse2(d, pd_load_mask_sse2(mask + x, false));
+		_mm_storeu_si128((__m128i *)(dst + x), d);
+	}
+	pd_mask_pargb_row(dst + x, mask + x, count - x);
+}
+
+PD_TARGET_SSE2
+static void pd_mix_mask_pargb_row_sse2(void *dst, const uint8_t *mask,
+				       int count, pd_color_t color)
+{
+	int x;
+	__m128i c, d, m, lo, hi;
+	pd_color_t pc = color;
+	pd_color_t *px = dst;
+	const __m128i zero = _mm_setzero_si128();
+
+	pd_premultiply_pixel(&pc);
+	c = _mm_unpacklo_epi8(_mm_set1_epi32((int)pc.value), zero);
+	for (x = 0; x + 4 <= count; x += 4) {
+		m = pd_load_mask_sse2(mask + x, false);
+		d = _mm_loadu_si128((const __m128i *)(px + x));
+		lo = pd_div255_sse2(
+		    _mm_mullo_epi16(c, _mm_unpacklo_epi8(m, zero)));
+		hi = pd_div255_sse2(
+		    _mm_mullo_epi16(c, _mm_unpackhi_epi8(m, zero)));
+		lo = pd_over_premultiplied_sse2(_mm_unpacklo_epi8(d, zero), lo);
+		hi = pd_over_premultiplied_sse2(_mm_unpackhi_epi8(d, zero), hi);
+		_mm_storeu_si128((__m128i *)(px + x), _mm_packus_epi16(lo, hi));
+	}
+	pd_mix_mask_pargb_row(px + x, mask + x, count - x, color);
+}
+
+/**
+ * Build 4 pixels of the color with the alpha scaled by their coverage, the
+ * coverage is loaded by pd_load_mask_sse2()
+ */
+PD_TARGET_SSE2
+static inline __m128i pd_mask_color_sse2(__m128i m, pd_color_t color)
+{
+	__m128i a = _mm_mullo_epi16(_mm_srli_epi32(m, 24),
+				    _mm_set1_epi32(color.a));
+
+	color.a = 0;
+	return _mm_or_si128(_mm_set1_epi32((int)color.value),
+			    _mm_slli_epi32(pd_div255_sse2(a), 24));
+}
+
+/** Keep the destination pixels without coverage like the scalar kernel */
+PD_TARGET_SSE2
+static inline __m128i pd_select_covered_sse2(__m128i m, __m128i d, __m128i out)
+{
+	__m128i keep = _mm_cmpeq_epi32(m, _mm_setzero_si128());
+
+	return _mm_or_si128(_mm_and_si128(keep, d), _mm_andnot_si128(keep, out));
+}
+
+PD_TARGET_SSE2
+static void pd_mix_mask_argb_row_sse2(void *dst, const uint8_t *mask,
+				      int count, pd_color_t color)
+{
+	int x;
+	uint32_t bits;
+	__m128i s, d, m;
+	pd_color_t *px = dst;
+	const __m128d k = _mm_set1_pd(1.0);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		memcpy(&bits, mask + x, sizeof(bits));
+		if (bits == 0) {
+			continue;
+		}
+		if (bits == 0xffffffff && color.a == 255) {
+			_mm_storeu_si128((__m128i *)(px + x),
+					 _mm_set1_epi32((int)color.value));
+			continue;
+		}
+		m = pd_load_mask_sse2(mask + x, false);
+		s = pd_mask_color_sse2(m, color);
+		d = _mm_loadu_si128((const __m128i *)(px + x));
+		_mm_storeu_si128(
+		    (__m128i *)(px + x),
+		    pd_select_covered_sse2(
+			m, d,
+			_mm_unpacklo_epi64(
+			    pd_over_sse2(d, s, k),
+			    pd_over_sse2(_mm_srli_si128(d, 8),
+					 _mm_srli_si128(s, 8), k))));
+	}
+	pd_mix_mask_argb_row(px + x, mask + x, count - x, color);
+}
+
+PD_TARGET_SSE2
+static void pd_format_pixels_argb2pargb_sse2(const uint8_t *in_pixels,
+					     uint8_t *out_pixels, size_t count)
+{
+	size_t x;
+	__m128i s;
+	const __m128i zero = _mm_setzero_si128();
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		s = _mm_loadu_si128((const __m128i *)(in_pixels + x * 4));
+		s = _mm_packus_epi16(
+		    pd_premultiply_sse2(_mm_unpacklo_epi8(s, zero), 256),
+		    pd_premultiply_sse2(_mm_unpackhi_epi8(s, zero), 256));
+		_mm_storeu_si128((__m128i *)(out_pixels + x * 4), s);
+	}
+	pd_format_pixels_argb2pargb(in_pixels + x * 4, out_pixels + x * 4,
+				    count - x);
+}
+
+/**
+ * Convert the 4 pixels to RGB565 like pd_color_to_rgb565(), the result is
+ * sign extended from the low 16 bits of the lanes, so that the signed
+ * saturation of _mm_packs_epi32() keeps the bits
+ */
+PD_TARGET_SSE2
+static inline __m128i pd_to_rgb565_sse2(__m128i px)
+{
+	const __m128i mask = _mm_set1_epi32(0xff);
+	const __m128i k249 = _mm_set1_epi32(249);
+	const __m128i k1014 = _mm_set1_epi32(1014);
+	__m128i r = _mm_and_si128(_mm_srli_epi32(px, 16), mask);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(px, 8), mask);
+	__m128i b = _mm_and_si128(px, mask);
+
+	/* The products fit in the low 16 bits of the lanes */
+	r = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi16(r, k249), k1014), 11);
+	g = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi16(g, _mm_set1_epi32(253)),
+					 _mm_set1_epi32(505)),
+			   10);
+	b = _mm_srli_epi32(_mm_add_epi32(_mm_mullo_epi16(b, k249), k1014), 11);
+	px = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(r, 11), _mm_slli_epi32(g, 5)),
+			  b);
+	return _mm_srai_epi32(_mm_slli_epi32(px, 16), 16);
+}
+
+/** Expand the RGB565 pixels in the low 16 bits of the 4 lanes */
+PD_TARGET_SSE2
+static inline __m128i pd_from_rgb565_sse2(__m128i px)
+{
+	__m128i r = _mm_srli_epi32(px, 11);
+	__m128i g = _mm_and_si128(_mm_srli_epi32(px, 5), _mm_set1_epi32(0x3f));
+	__m128i b = _mm_and_si128(px, _mm_set1_epi32(0x1f));
+
+	r = _mm_or_si128(_mm_slli_epi32(r, 3), _mm_srli_epi32(r, 2));
+	g = _mm_or_si128(_mm_slli_epi32(g, 2), _mm_srli_epi32(g, 4));
+	b = _mm_or_si128(_mm_slli_epi32(b, 3), _mm_srli_epi32(b, 2));
+	return _mm_or_si128(
+	    _mm_or_si128(_mm_set1_epi32((int)0xff000000), _mm_slli_epi32(r, 16)),
+	    _mm_or_si128(_mm_slli_epi32(g, 8), b));
+}
+
+PD_TARGET_SSE2
+static void pd_format_pixels_argb2rgb565_sse2(const uint8_t *in_pixels,
+					      uint8_t *out_pixels, size_t count)
+{
+	size_t x;
+	__m128i lo, hi;
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		lo = _mm_loadu_si128((const __m128i *)(in_pixels + x * 4));
+		hi = _mm_loadu_si128((const __m128i *)(in_pixels + x * 4 + 16));
+		_mm_storeu_si128((__m128i *)(out_pixels + x * 2),
+				 _mm_packs_epi32(pd_to_rgb565_sse2(lo),
+						 pd_to_rgb565_sse2(hi)));
+	}
+	pd_format_pixels_argb2rgb565(in_pixels + x * 4, out_pixels + x * 2,
+				     count - x);
+}
+
+PD_TARGET_SSE2
+static void pd_format_pixels_rgb5652argb_sse2(const uint8_t *in_pixels,
+					      uint8_t *out_pixels, size_t count)
+{
+	size_t x;
+	__m128i s;
+	const __m128i zero = _mm_setzero_si128();
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		s = _mm_loadu_si128((const __m128i *)(in_pixels + x * 2));
+		_mm_storeu_si128(
+		    (__m128i *)(out_pixels + x * 4),
+		    pd_from_rgb565_sse2(_mm_unpacklo_epi16(s, zero)));
+		_mm_storeu_si128(
+		    (__m128i *)(out_pixels + x * 4 + 16),
+		    pd_from_rgb565_sse2(_mm_unpackhi_epi16(s, zero)));
+	}
+	pd_format_pixels_rgb5652argb(in_pixels + x * 2, out_pixels + x * 4,
+				     count - x);
+}
+
+PD_TARGET_SSE2
+static void pd_fill_argb_row_sse2(uint8_t *dst, pd_color_t color, size_t count)
+{
+	size_t x;
+	const __m128i c = _mm_set1_epi32((int)color.value);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		_mm_storeu_si128((__m128i *)(dst + x * 4), c);
+	}
+	pd_fill_argb_row(dst + x * 4, color, count - x);
+}
+
+/** The 3-byte pixels repeat every 48 bytes, which are 3 vectors */
+PD_TARGET_SSE2
+static void pd_fill_rgb_row_sse2(uint8_t *dst, pd_color_t color, size_t count)
+{
+	size_t x;
+	uint8_t pattern[48];
+	__m128i a, b, c;
+
+	pd_fill_rgb_row(pattern, color, 16);
+	a = _mm_loadu_si128((const __m128i *)pattern);
+	b = _mm_loadu_si128((const __m128i *)(pattern + 16));
+	c = _mm_loadu_si128((const __m128i *)(pattern + 32));
+	for (x = 0; x + 16 <= count; x += 16, dst += 48) {
+		_mm_storeu_si128((__m128i *)dst, a);
+		_mm_storeu_si128((__m128i *)(dst + 16), b);
+		_mm_storeu_si128((__m128i *)(dst + 32), c);
+	}
+	pd_fill_rgb_row(dst, color, count - x);
+}
+
+PD_TARGET_SSE2
+static void pd_fill_rgb565_row_sse2(uint8_t *dst, pd_color_t color,
+				    size_t count)
+{
+	size_t x;
+	const __m128i c = _mm_set1_epi16((short)pd_color_to_rgb565(color));
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		_mm_storeu_si128((__m128i *)(dst + x * 2), c);
+	}
+	pd_fill_rgb565_row(dst + x * 2, color, count - x);
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_div255_avx2(__m256i x)
+{
+	return _mm256_mulhi_epu16(_mm256_add_epi16(x, _mm256_set1_epi16(128)),
+				  _mm256_set1_epi16(257));
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_repeat_alpha_avx2(__m256i px)
+{
+	return _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, 0xff), 0xff);
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_scale_pixels_avx2(__m256i px, unsigned alpha)
+{
+	if (alpha < 256) {
+		px = _mm256_srli_epi16(
+		    _mm256_mullo_epi16(px, _mm256_set1_epi16((short)alpha)), 8);
+	}
+	return px;
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_premultiply_avx2(__m256i px, unsigned alpha)
+{
+	const __m256i alpha_mask = _mm256_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0,
+						    -1, 0, 0, 0, -1, 0, 0, 0);
+	__m256i a = pd_scale_pixels_avx2(pd_repeat_alpha_avx2(px), alpha);
+
+	px = pd_div255_avx2(_mm256_mullo_epi16(px, a));
+	return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, px),
+			       _mm256_and_si256(alpha_mask, a));
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_over_premultiplied_avx2(__m256i back, __m256i fore)
+{
+	__m256i inv = _mm256_sub_epi16(_mm256_set1_epi16(255),
+				       pd_repeat_alpha_avx2(fore));
+
+	return _mm256_add_epi16(fore,
+				pd_div255_avx2(_mm256_mullo_epi16(back, inv)));
+}
+
+PD_TARGET_AVX2
+static void pd_mix_pargb_row_avx2(pd_color_t *dst, const pd_color_t *src,
+				  int count, float opacity)
+{
+	int x;
+	__m256i s, d, lo, hi;
+	const __m256i zero = _mm256_setzero_si256();
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(src + x));
+		d = _mm256_loadu_si256((const __m256i *)(dst + x));
+		lo = pd_scale_pixels_avx2(_mm256_unpacklo_epi8(s, zero), alpha);
+		hi = pd_scale_pixels_avx2(_mm256_unpackhi_epi8(s, zero), alpha);
+		lo = pd_over_premultiplied_avx2(_mm256_unpacklo_epi8(d, zero),
+						lo);
+		hi = pd_over_premultiplied_avx2(_mm256_unpackhi_epi8(d, zero),
+						hi);
+		_mm256_storeu_si256((__m256i *)(dst + x),
+				    _mm256_packus_epi16(lo, hi));
+	}
+	pd_mix_pargb_row(dst + x, src + x, count - x, opacity);
+}
+
+PD_TARGET_AVX2
+static void pd_mix_argb2pargb_row_avx2(pd_color_t *dst, const pd_color_t *src,
+				       int count, float opacity)
+{
+	int x;
+	__m256i s, d, lo, hi;
+	const __m256i zero = _mm256_setzero_si256();
+	unsigned alpha = pd_blend_opacity_to_alpha(opacity);
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(src + x));
+		d = _mm256_loadu_si256((const __m256i *)(dst + x));
+		lo = pd_premultiply_avx2(_mm256_unpacklo_epi8(s, zero), alpha);
+		hi = pd_premultiply_avx2(_mm256_unpackhi_epi8(s, zero), alpha);
+		lo = pd_over_premultiplied_avx2(_mm256_unpacklo_epi8(d, zero),
+						lo);
+		hi = pd_over_premultiplied_avx2(_mm256_unpackhi_epi8(d, zero),
+						hi);
+		_mm256_storeu_si256((__m256i *)(dst + x),
+				    _mm256_packus_epi16(lo, hi));
+	}
+	pd_mix_argb2pargb_row(dst + x, src + x, count - x, opacity);
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_load_mask_avx2(const uint8_t *mask, bool alpha_only)
+{
+	__m128i v;
+	__m256i m;
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xff000000);
+
+	v = _mm_loadl_epi64((const __m128i *)mask);
+	v = _mm_unpacklo_epi8(v, v);
+	m = _mm256_inserti128_si256(
+	    _mm256_castsi128_si256(_mm_unpacklo_epi16(v, v)),
+	    _mm_unpackhi_epi16(v, v), 1);
+	if (alpha_only) {
+		m = _mm256_or_si256(
+		    _mm256_and_si256(m, alpha_mask),
+		    _mm256_andnot_si256(alpha_mask,
+					_mm256_set1_epi8((char)0xff)));
+	}
+	return m;
+}
+
+PD_TARGET_AVX2
+static inline __m256i pd_mask_avx2(__m256i px, __m256i m)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i lo, hi;
+
+	lo = pd_div255_avx2(_mm256_mullo_epi16(_mm256_unpacklo_epi8(px, zero),
+					       _mm256_unpacklo_epi8(m, zero)));
+	hi = pd_div255_avx2(_mm256_mullo_epi16(_mm256_unpackhi_epi8(px, zero),
+					       _mm256_unpackhi_epi8(m, zero)));
+	return _mm256_packus_epi16(lo, hi);
+}
+
+PD_TARGET_AVX2
+static void pd_mask_argb_row_avx2(pd_color_t *dst, const uint8_t *mask,
+				  int count)
+{
+	int x;
+	__m256i d;
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		d = _mm256_loadu_si256((const __m256i *)(dst + x));
+		d = pd_mask_avx2(d, pd_load_mask_avx2(mask + x, true));
+		_mm256_storeu_si256((__m256i *)(dst + x), d);
+	}
+	pd_mask_argb_row(dst + x, mask + x, count - x);
+}
+
+PD_TARGET_AVX2
+static void pd_mask_pargb_row_avx2(pd_color_t *dst, const uint8_t *mask,
+				   int count)
+{
+	int x;
+	__m256i d;
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		d = _mm256_loadu_si256((const __m256i *)(dst + x));
+		d = pd_mask_avx2(d, pd_load_mask_avx2(mask + x, false));
+		_mm256_storeu_si256((__m256i *)(dst + x), d);
+	}
+	pd_mask_pargb_row(dst + x, mask + x, count - x);
+}
+
+PD_TARGET_AVX2
+static void pd_mix_mask_pargb_row_avx2(void *dst, const uint8_t *mask,
+				       int count, pd_color_t color)
+{
+	int x;
+	__m256i c, d, m, lo, hi;
+	pd_color_t pc = color;
+	pd_color_t *px = dst;
+	const __m256i zero = _mm256_setzero_si256();
+
+	pd_premultiply_pixel(&pc);
+	c = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)pc.value), zero);
+	for (x = 0; x + 8 <= count; x += 8) {
+		m = pd_load_mask_avx2(mask + x, false);
+		d = _mm256_loadu_si256((const __m256i *)(px + x));
+		lo = pd_div255_avx2(
+		    _mm256_mullo_epi16(c, _mm256_unpacklo_epi8(m, zero)));
+		hi = pd_div255_avx2(
+		    _mm256_mullo_epi16(c, _mm256_unpackhi_epi8(m, zero)));
+		lo = pd_over_premultiplied_avx2(_mm256_unpacklo_epi8(d, zero),
+						lo);
+		hi = pd_over_premultiplied_avx2(_mm256_unpackhi_epi8(d, zero),
+						hi);
+		_mm256_storeu_si256((__m256i *)(px + x),
+				    _mm256_packus_epi16(lo, hi));
+	}
+	pd_mix_mask_pargb_row(px + x, mask + x, count - x, color);
+}
+
+PD_TARGET_AVX2
+static void pd_mix_mask_argb_row_avx2(void *dst, const uint8_t *mask,
+				      int count, pd_color_t color)
+{
+	int x;
+	uint32_t bits;
+	__m128i s, d, m;
+	pd_color_t *px = dst;
+	const __m256d k = _mm256_set1_pd(1.0);
+
+	for (x = 0; x + 4 <= count; x += 4) {
+		memcpy(&bits, mask + x, sizeof(bits));
+		if (bits == 0) {
+			continue;
+		}
+		if (bits == 0xffffffff && color.a == 255) {
+			_mm_storeu_si128((__m128i *)(px + x),
+					 _mm_set1_epi32((int)color.value));
+			continue;
+		}
+		m = pd_load_mask_sse2(mask + x, false);
+		s = pd_mask_color_sse2(m, color);
+		d = _mm_loadu_si128((const __m128i *)(px + x));
+		_mm_storeu_si128((__m128i *)(px + x),
+				 pd_select_covered_sse2(m, d,
+							pd_over_avx2(d, s, k)));
+	}
+	pd_mix_mask_argb_row(px + x, mask + x, count - x, color);
+}
+
+/*
+ * The pixels are reordered by _mm_shuffle_epi8(), which is an SSSE3
+ * instruction, 16 pixels are converted at a time so that the bytes out of
+ * the rows are never touched.
+ */
+
+PD_TARGET_AVX2
+static void pd_format_pixels_argb2rgb_avx2(const uint8_t *in_pixels,
+					   uint8_t *out_pixels, size_t count)
+{
+	size_t x;
+	__m128i a, b, c, d;
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13,
+					      14, -1, -1, -1, -1);
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		a = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in_pixels + x * 4)),
+		    shuffle);
+		b = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in_pixels + x * 4 + 16)),
+		    shuffle);
+		c = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in_pixels + x * 4 + 32)),
+		    shuffle);
+		d = _mm_shuffle_epi8(
+		    _mm_loadu_si128((const __m128i *)(in_pixels + x * 4 + 48)),
+		    shuffle);
+		_mm_storeu_si128((__m128i *)(out_pixels + x * 3),
+				 _mm_or_si128(a, _mm_slli_si128(b, 12)));
+		_mm_storeu_si128((__m128i *)(out_pixels + x * 3 + 16),
+				 _mm_or_si128(_mm_srli_si128(b, 4),
+					      _mm_slli_si128(c, 8)));
+		_mm_storeu_si128((__m128i *)(out_pixels + x * 3 + 32),
+				 _mm_or_si128(_mm_srli_si128(c, 8),
+					      _mm_slli_si128(d, 4)));
+	}
+	pd_format_pixels_argb2rgb(in_pixels + x * 4, out_pixels + x * 3,
+				  count - x);
+}
+
+PD_TARGET_AVX2
+static void pd_format_pixels_rgb2argb_avx2(const uint8_t *in_pixels,
+					   uint8_t *out_pixels, size_t count)
+{
+	size_t x;
+	__m128i a, b, c;
+	const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8,
+					      -1, 9, 10, 11, -1);
+
+	for (x = 0; x + 16 <= count; x += 16) {
+		a = _mm_loadu_si128((const __m128i *)(in_pixels + x * 3));
+		b = _mm_loadu_si128((const __m128i *)(in_pixels + x * 3 + 16));
+		c = _mm_loadu_si128((const __m128i *)(in_pixels + x * 3 + 32));
+		_mm_storeu_si128(
+		    (__m128i *)(out_pixels + x * 4),
+		    _mm_or_si128(_mm_shuffle_epi8(a, shuffle), alpha));
+		_mm_storeu_si128(
+		    (__m128i *)(out_pixels + x * 4 + 16),
+		    _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12),
+						  shuffle),
+				 alpha));
+		_mm_storeu_si128(
+		    (__m128i *)(out_pixels + x * 4 + 32),
+		    _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8),
+						  shuffle),
+				 alpha));
+		_mm_storeu_si128(
+		    (__m128i *)(out_pixels + x * 4 + 48),
+		    _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle),
+				 alpha));
+	}
+	pd_format_pixels_rgb2argb(in_pixels + x * 3, out_pixels + x * 4,
+				  count - x);
+}
+
+PD_TARGET_AVX2
+static void pd_format_pixels_argb2pargb_avx2(const uint8_t *in_pixels,
+					     uint8_t *out_pixels, size_t count)
+{
+	size_t x;
+	__m256i s;
+	const __m256i zero = _mm256_setzero_si256();
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		s = _mm256_loadu_si256((const __m256i *)(in_pixels + x * 4));
+		s = _mm256_packus_epi16(
+		    pd_premultiply_avx2(_mm256_unpacklo_epi8(s, zero), 256),
+		    pd_premultiply_avx2(_mm256_unpackhi_epi8(s, zero), 256));
+		_mm256_storeu_si256((__m256i *)(out_pixels + x * 4), s);
+	}
+	pd_format_pixels_argb2pargb(in_pixels + x * 4, out_pixels + x * 4,
+				    count - x);
+}
+
+PD_TARGET_AVX2
+static void pd_fill_argb_row_avx2(uint8_t *dst, pd_color_t color, size_t count)
+{
+	size_t x;
+	const __m256i c = _mm256_set1_epi32((int)color.value);
+
+	for (x = 0; x + 8 <= count; x += 8) {
+		_mm256_storeu_si256((__m256i *)(dst + x * 4), c);
+	}
+	pd_fill_argb_row(dst + x * 4, color, count - x);
+}
+
+bool pd_blend_init_sse2(pd_blend_kernels_t *kernels)
+{
+	if (!pd_cpu_has_sse2()) {
+		return false;
+	}
+	kernels->mix_argb = pd_mix_argb_row_sse2;
+	kernels->mix_argb_with_alpha = pd_mix_argb_with_alpha_row_sse2;
+	kernels->mix_pargb = pd_mix_pargb_row_sse2;
+	kernels->mix_argb2pargb = pd_mix_argb2pargb_row_sse2;
+	kernels->mask_argb = pd_mask_argb_row_sse2;
+	kernels->mask_pargb = pd_mask_pargb_row_sse2;
+	kernels->mix_mask_argb = pd_mix_mask_argb_row_sse2;
+	kernels->mix_mask_pargb = pd_mix_mask_pargb_row_sse2;
+	kernels->argb2pargb = pd_format_pixels_argb2pargb_sse2;
+	kernels->argb2rgb565 = pd_format_pixels_argb2rgb565_sse2;
+	kernels->rgb5652argb = pd_format_pixels_rgb5652argb_sse2;
+	kernels->fill_argb = pd_fill_argb_row_sse2;
+	kernels->fill_rgb = pd_fill_rgb_row_sse2;
+	kernels->fill_rgb565 = pd_fill_rgb565_row_sse2;
+	return true;
+}
+
+bool pd_blend_init_avx2(pd_blend_kernels_t *kernels)
+{
+	if (!pd_cpu_has_avx2()) {
+		return false;
+	}
+	kernels->mix_argb = pd_mix_argb_row_avx2;
+	kernels->mix_argb_with_alpha = pd_mix_argb_with_alpha_row_avx2;
+	kernels->mix_argb2rgb = pd_mix_argb2rgb_row_avx2;
+	kernels->mix_pargb = pd_mix_pargb_row_avx2;
+	kernels->mix_argb2pargb = pd_mix_argb2pargb_row_avx2;
+	kernels->mask_argb = pd_mask_argb_row_avx2;
+	kernels->mask_pargb = pd_mask_pargb_row_avx2;
+	kernels->mix_mask_argb = pd_mix_mask_argb_row_avx2;
+	kernels->mix_mask_pargb = pd_mix_mask_pargb_row_avx2;
+	kernels->argb2rgb = pd_format_pixels_argb2rgb_avx2;
+	kernels->rgb2argb = pd_format_pixels_rgb2argb_avx2;
+	kernels->argb2pargb = pd_format_pixels_argb2pargb_avx2;
+	kernels->fill_argb = pd_fill_argb_row_avx2;
+	return true;
+}
+
+#else
+
+bool pd_blend_init_sse2(pd_blend_kernels_t *kernels)
+{
+	return false;
+}
+
+bool pd_blend_init_avx2(pd_blend_kernels_t *kernels)
+{
+	return false;
+}
+
+#endif
@@ -9,743 +9,537 @@
  * LICENSE.TXT file in the root directory of this source tree.
  */
 
-#include <math.h>
+#include <stdlib.h>
 #include <yutil.h>
+#include <thread.h>
 #include <pandagl.h>
+#include "blend.h"
 
-#define POW2(X) ((X) * (X))
-#define CIRCLE_R(R) (R - 0.5)
-
-/*  Convert screen Y coordinate to geometric Y coordinate */
-#define ToGeoY(Y, CENTER_Y) ((CENTER_Y)-Y)
-
-/*  Convert screen X coordinate to geometric X coordinate */
-#define ToGeoX(X, CENTER_X) (X - (CENTER_X))
-
-#define smooth_left_pixel(PX, X) (uint8_t)((PX)->a * (1.0 - (X - 1.0 * (int)X)))
-#define smooth_right_pixel(PX, X) (uint8_t)((PX)->a * (X - 1.0 * (int)X))
-
-#define BorderRenderContext()                               \
-	int x, y;                                           \
-	int right;                                          \
-	double circle_x, circle_y;                          \
-	int outer_xi, inner_xi;                             \
-	double outer_x, split_x, inner_x;                   \
-	double outer_d, inner_d;                            \
-                                                            \
-	const double r = CIRCLE_R(radius);                  \
-	const double radius_x = y_max(0, r - yline->width); \
-	const double radius_y = y_max(0, r - xline->width); \
-	const int width = y_max(radius, yline->width);      \
-                                                            \
-	pd_rect_t rect;                                     \
-	pd_color_t *p;                                      \
-	pd_color_t color;
-
-static double ellipse_x(double radius_x, double radius_y, double y)
+/* Number of samples per pixel in each direction */
+#define MASK_SAMPLES 8
+#define DEFAULT_CACHE_MAX_MEMORY (1024 * 1024)
+
+enum pd_border_corner {
+	PD_BORDER_TOP_LEFT,
+	PD_BORDER_TOP_RIGHT,
+	PD_BORDER_BOTTOM_LEFT,
+	PD_BORDER_BOTTOM_RIGHT
+};
+
+#define is_right_corner(C) \
+	((C) == PD_BORDER_TOP_RIGHT || (C) == PD_BORDER_BOTTOM_RIGHT)
+#define is_bottom_corner(C) \
+	((C) == PD_BORDER_BOTTOM_LEFT || (C) == PD_BORDER_BOTTOM_RIGHT)
+
+typedef struct pd_border_mask_key {
+	int radius;
+
+	/** Width of the horizontal border line, it is the height of the inner
+	 * ellipse subtracted from the radius */
+	int xline_width;
+
+	/** Width of the vertical border line */
+	int yline_width;
+} pd_border_mask_key_t;
+
+/**
+ * The anti-aliased coverage of a corner of the border box (outer) and of the
+ * padding box (inner). The planes are in the orientation of the top left
+ * corner, the mirrored planes are used by the right corners, and the bottom
+ * corners read the rows from bottom to top.
+ */
+typedef struct pd_border_mask {
+	pd_border_mask_key_t key;
+	int width, height;
+	uint8_t *outer;
+	uint8_t *inner;
+	uint8_t *mirrored_outer;
+	uint8_t *mirrored_inner;
+
+	/** Number of users of the mask, a used mask is never freed */
+	unsigned refs;
+
+	/** The mask was evicted from the cache while it was still used */
+	bool detached;
+
+	list_node_t node;
+} pd_border_mask_t;
+
+/** A thread-safe LRU cache of corner masks */
+static struct pd_border_cache {
+	bool active;
+	size_t memory;
+	size_t max_memory;
+	thread_mutex_t mutex;
+
+	/** list_t<pd_border_mask_t*>, most recently used first */
+	list_t masks;
+} pd_border_cache;
+
+/** Check whether the point is inside the border box or the padding box */
+static bool pd_border_mask_contains(const pd_border_mask_key_t *key,
+				    bool inner, double u, double v)
 {
-	double value;
-	if (radius_x == radius_y) {
-		value = radius_x * radius_x - y * y;
-	} else {
-		value = (1.0 - 1.0 * (y * y) / (radius_y * radius_y)) *
-			radius_x * radius_x;
+	double dx, dy;
+	const double r = key->radius;
+
+	if (!inner) {
+		return u >= r || v >= r ||
+		       (r - u) * (r - u) + (r - v) * (r - v) <= r * r;
+	}
+	if (u < key->yline_width || v < key->xline_width) {
+		return false;
 	}
-	if (value < 0) {
-		value = -value;
+	if (u >= r || v >= r) {
+		return true;
 	}
-	return sqrt(value);
+	/* Here the point is inside the border, so the radii of the inner
+	 * ellipse are greater than 0 */
+	dx = (r - u) / (r - key->yline_width);
+	dy = (r - v) / (r - key->xline_width);
+	return dx * dx + dy * dy <= 1.0;
 }
 
 /**
- * FIXME: Improve the rounded border drawing code
- * Merge the four functions of DrawBorder* into one function and make it simple.
+ * Get the coverage of the pixel. The shapes are convex, so the pixel is
+ * fully inside or outside if all its corners are, only the pixels on the
+ * edge are supersampled.
  */
-
-/** Draw border top left corner */
-static int draw_border_top_left(pd_canvas_t *dst, int bound_left, int bound_top,
-				const pd_border_line_t *xline,
-				const pd_border_line_t *yline,
-				unsigned int radius)
+static uint8_t pd_border_mask_coverage(const pd_border_mask_key_t *key,
+				       bool inner, int x, int y)
 {
-	BorderRenderContext();
-
-	double cirlce_center_x = bound_left + r;
-	double circle_center_y = bound_top + r;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + 1.0 * yline->width;
-	double split_center_y = bound_top + 1.0 * xline->width;
-	int inner_ellipse_top = (int)split_center_y;
-
-	/* Get the actual rectangle that can be drawn */
-	pd_canvas_get_quote_rect(dst, &rect);
-	dst = pd_canvas_get_quote_source(dst);
-	if (!pd_canvas_is_valid(dst)) {
-		return -1;
+	int sx, sy;
+	unsigned count;
+	const unsigned samples = MASK_SAMPLES * MASK_SAMPLES;
+
+	count = pd_border_mask_contains(key, inner, x, y) +
+		pd_border_mask_contains(key, inner, x + 1, y) +
+		pd_border_mask_contains(key, inner, x, y + 1) +
+		pd_border_mask_contains(key, inner, x + 1, y + 1);
+	if (count == 0 || count == 4) {
+		return count ? 255 : 0;
 	}
-	right = y_min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = 0;
-		split_x = 0;
-		inner_x = width;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y >= 0) {
-			outer_x = r - ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y >= inner_ellipse_top) {
-				inner_x =
-				    r - ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x -
-				  ToGeoY(y, split_center_y) * split_k;
+	count = 0;
+	for (sy = 0; sy < MASK_SAMPLES; ++sy) {
+		for (sx = 0; sx < MASK_SAMPLES; ++sx) {
+			count += pd_border_mask_contains(
+			    key, inner, x + (sx + 0.5) / MASK_SAMPLES,
+			    y + (sy + 0.5) / MASK_SAMPLES);
 		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		/* Limit coordinates into the current drawing region */
-		outer_x = y_max(0, y_min(right, outer_x));
-		inner_x = y_max(0, y_min(right, inner_x));
-		outer_xi = y_max(0, (int)outer_x - (int)radius / 2);
-		inner_xi = y_min(right, (int)inner_x + (int)radius / 2);
-		p = pd_canvas_pixel_at(dst, rect.x, rect.y + y);
-		/* Clear the outer pixels */
-		for (x = 0; x < outer_xi; ++x, ++p) {
-			p->alpha = 0;
-		}
-		for (; x < inner_xi; ++x, ++p) {
-			outer_d = -1;
-			inner_d = inner_x - 1.0 * x;
-			circle_x = ToGeoX(x, cirlce_center_x);
-			/* If in the circle */
-			if (r > 0 && circle_y >= 0 && circle_x <= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				/* If the inside is a circle is not an ellipse,
-				 * Use the same anti-aliasing method
-				 */
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y >= inner_ellipse_top) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				p->alpha = 0;
-				continue;
-			}
-			if (x < split_x) {
-				color = yline->color;
-			} else {
-				color = xline->color;
-			}
-			if (outer_d >= 0) {
-				/* Fill the border color if the border width is
-				 * valid */
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = smooth_left_pixel(p, outer_d);
-			} else if (inner_d >= 1.0) {
-				pd_over_pixel(p, &color, 1.0);
-			} else if (inner_d >= 0) {
-				color.a = smooth_right_pixel(&color, inner_d);
-				pd_over_pixel(p, &color, 1.0);
-			} else {
-				break;
-			}
+	}
+	return (uint8_t)((count * 255 + samples / 2) / samples);
+}
+
+static void pd_border_mask_fill(pd_border_mask_t *mask)
+{
+	int x, y, i;
+
+	for (y = 0; y < mask->height; ++y) {
+		for (x = 0; x < mask->width; ++x) {
+			i = y * mask->width + x;
+			mask->outer[i] =
+			    pd_border_mask_coverage(&mask->key, false, x, y);
+			mask->inner[i] =
+			    pd_border_mask_coverage(&mask->key, true, x, y);
+			mask->mirrored_outer[i + mask->width - 1 - 2 * x] =
+			    mask->outer[i];
+			mask->mirrored_inner[i + mask->width - 1 - 2 * x] =
+			    mask->inner[i];
 		}
 	}
-	return 0;
 }
 
-static int draw_border_top_right(pd_canvas_t *dst, int bound_left,
-				 int bound_top, const pd_border_line_t *xline,
-				 const pd_border_line_t *yline,
-				 unsigned int radius)
+static size_t pd_border_mask_size(pd_border_mask_t *mask)
 {
-	BorderRenderContext();
+	return sizeof(pd_border_mask_t) + (size_t)mask->width * mask->height * 4;
+}
 
-	double circle_center_y = bound_top + r;
-	double circle_center_x = bound_left + width - 1.0 * radius - 0.5;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + width - 1.0 * yline->width;
-	double split_center_y = bound_top + 1.0 * xline->width;
-	double inner_ellipse_top = split_center_y;
+static pd_border_mask_t *pd_border_mask_create(const pd_border_mask_key_t *key)
+{
+	size_t size;
+	pd_border_mask_t *mask;
+	int width = y_max(key->radius, key->yline_width);
+	int height = y_max(key->radius, key->xline_width);
 
-	/* Get the actual rectangle that can be drawn */
-	pd_canvas_get_quote_rect(dst, &rect);
-	dst = pd_canvas_get_quote_source(dst);
-	if (!pd_canvas_is_valid(dst)) {
-		return -1;
+	if (width < 1 || height < 1) {
+		return NULL;
 	}
-	right = y_min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = width;
-		split_x = 0;
-		inner_x = -1.0;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y >= 0) {
-			outer_x = width - radius + ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y >= inner_ellipse_top) {
-				inner_x =
-				    width - radius - 0.5 +
-				    ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x +
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		/* Limit coordinates into the current drawing region */
-		outer_x = y_max(0, y_min(right, outer_x));
-		inner_x = y_max(-1.0, y_min(outer_x, inner_x));
-		inner_xi = y_max(0, (int)inner_x - (int)radius / 2);
-		outer_xi = y_min(right, (int)outer_x + (int)radius / 2);
-		p = pd_canvas_pixel_at(dst, rect.x + inner_xi, rect.y + y);
-		for (x = inner_xi; x < outer_xi; ++x, ++p) {
-			outer_d = -1.0;
-			inner_d = x - inner_x;
-			circle_x = ToGeoX(x, circle_center_x);
-			if (r > 0 && circle_y >= 0 && circle_x >= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y >= inner_ellipse_top) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				break;
-			}
-			if (x < split_x) {
-				color = xline->color;
-			} else {
-				color = yline->color;
-			}
-			if (outer_d >= 0) {
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = smooth_left_pixel(p, outer_d);
-			} else if (inner_d >= 0.5) {
-				pd_over_pixel(p, &color, 1.0);
-			} else if (inner_d >= 0) {
-				color.a = smooth_right_pixel(&color, inner_d);
-				pd_over_pixel(p, &color, 1.0);
-			}
+	size = (size_t)width * height;
+	mask = malloc(sizeof(pd_border_mask_t) + size * 4);
+	if (!mask) {
+		return NULL;
+	}
+	mask->key = *key;
+	mask->width = width;
+	mask->height = height;
+	mask->outer = (uint8_t *)(mask + 1);
+	mask->inner = mask->outer + size;
+	mask->mirrored_outer = mask->inner + size;
+	mask->mirrored_inner = mask->mirrored_outer + size;
+	mask->refs = 0;
+	mask->detached = false;
+	mask->node.data = mask;
+	pd_border_mask_fill(mask);
+	return mask;
+}
+
+static void pd_border_cache_unlink(pd_border_mask_t *mask)
+{
+	list_unlink(&pd_border_cache.masks, &mask->node);
+	pd_border_cache.memory -= pd_border_mask_size(mask);
+	if (mask->refs > 0) {
+		mask->detached = true;
+	} else {
+		free(mask);
+	}
+}
+
+static void pd_border_cache_evict(void)
+{
+	list_node_t *node, *prev;
+
+	for (node = list_get_last_node(&pd_border_cache.masks);
+	     node && node != &pd_border_cache.masks.head &&
+	     pd_border_cache.memory > pd_border_cache.max_memory;
+	     node = prev) {
+		prev = node->prev;
+		if (((pd_border_mask_t *)node->data)->refs == 0) {
+			pd_border_cache_unlink(node->data);
 		}
-		/* Clear the outer pixels */
-		for (; x < right; ++x, ++p) {
-			p->alpha = 0;
+	}
+}
+
+static pd_border_mask_t *pd_border_cache_find(const pd_border_mask_key_t *key)
+{
+	list_node_t *node;
+	pd_border_mask_t *mask;
+
+	for (list_each(node, &pd_border_cache.masks)) {
+		mask = node->data;
+		if (mask->key.radius == key->radius &&
+		    mask->key.xline_width == key->xline_width &&
+		    mask->key.yline_width == key->yline_width) {
+			return mask;
 		}
 	}
-	return 0;
+	return NULL;
 }
 
-static int draw_border_bottom_left(pd_canvas_t *dst, int bound_left,
-				   int bound_top, const pd_border_line_t *xline,
-				   const pd_border_line_t *yline,
-				   unsigned int radius)
+void pd_border_cache_init(size_t max_memory)
 {
-	BorderRenderContext();
+	if (pd_border_cache.active) {
+		return;
+	}
+	if (max_memory == 0) {
+		max_memory = DEFAULT_CACHE_MAX_MEMORY;
+	}
+	pd_border_cache.memory = 0;
+	pd_border_cache.max_memory = max_memory;
+	list_create(&pd_border_cache.masks);
+	thread_mutex_init(&pd_border_cache.mutex);
+	pd_border_cache.active = true;
+}
 
-	int height = y_max(radius, xline->width);
-	double cirlce_center_x = bound_left + r;
-	double circle_center_y = bound_top + height - 1.0 * radius - 0.5;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + 1.0 * yline->width;
-	double split_center_y = bound_top + height - 1.0 * xline->width;
-	double inner_ellipse_bottom = circle_center_y + radius_y;
+void pd_border_cache_destroy(void)
+{
+	list_node_t *node;
 
-	/* Get the actual rectangle that can be drawn */
-	pd_canvas_get_quote_rect(dst, &rect);
-	dst = pd_canvas_get_quote_source(dst);
-	if (!pd_canvas_is_valid(dst)) {
-		return -1;
+	if (!pd_border_cache.active) {
+		return;
 	}
-	right = y_min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = 0;
-		split_x = 0;
-		inner_x = width;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y <= 0) {
-			outer_x = r - ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y <= inner_ellipse_bottom) {
-				inner_x =
-				    r - ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x +
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		/* Limit coordinates into the current drawing region */
-		outer_x = y_max(0, y_min(right, outer_x));
-		inner_x = y_max(0, y_min(right, inner_x));
-		outer_xi = y_max(0, (int)outer_x - (int)radius / 2);
-		inner_xi = y_min(right, (int)inner_x + (int)radius / 2);
-		p = pd_canvas_pixel_at(dst, rect.x, rect.y + y);
-		for (x = 0; x < outer_xi; ++x, ++p) {
-			p->alpha = 0;
-		}
-		for (; x < inner_xi; ++x, ++p) {
-			outer_d = -1;
-			inner_d = inner_x - 1.0 * x;
-			circle_x = ToGeoX(x, cirlce_center_x);
-			if (r > 0 && circle_y <= 0 && circle_x <= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y <= inner_ellipse_bottom) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				p->alpha = 0;
-				continue;
-			}
-			if (x < split_x) {
-				color = yline->color;
-			} else {
-				color = xline->color;
-			}
-			if (outer_d >= 0) {
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = smooth_left_pixel(p, outer_d);
-			} else if (inner_d >= 1.0) {
-				pd_over_pixel(p, &color, 1.0);
-			} else if (inner_d >= 0) {
-				color.a = smooth_right_pixel(&color, inner_d);
-				pd_over_pixel(p, &color, 1.0);
-			} else {
-				break;
-			}
-		}
+	while ((node = list_get_first_node(&pd_border_cache.masks))) {
+		list_unlink(&pd_border_cache.masks, node);
+		free(node->data);
 	}
-	return 0;
+	thread_mutex_destroy(&pd_border_cache.mutex);
+	pd_border_cache.memory = 0;
+	pd_border_cache.active = false;
 }
 
-static int draw_border_bottom_right(pd_canvas_t *dst, int bound_left,
-				    int bound_top,
-				    const pd_border_line_t *xline,
-				    const pd_border_line_t *yline,
-				    unsigned int radius)
+static pd_border_mask_t *pd_border_get_mask(int radius, int xline_width,
+					    int yline_width)
 {
-	BorderRenderContext();
-
-	int height = y_max(radius, xline->width);
-	double circle_center_y = bound_top + height - 1.0 * radius - 0.5;
-	double circle_center_x = bound_left + width - 1.0 * radius - 0.5;
-	double split_k = 1.0 * yline->width / xline->width;
-	double split_center_x = bound_left + width - 1.0 * yline->width;
-	double split_center_y = bound_top + height - 1.0 * xline->width;
-	double inner_ellipse_bottom = circle_center_y + radius_y;
+	pd_border_mask_t *mask, *found;
+	pd_border_mask_key_t key;
+
+	key.radius = radius;
+	key.xline_width = xline_width;
+	key.yline_width = yline_width;
+	if (!pd_border_cache.active) {
+		return pd_border_mask_create(&key);
+	}
+	thread_mutex_lock(&pd_border_cache.mutex);
+	mask = pd_border_cache_find(&key);
+	if (mask) {
+		list_unlink(&pd_border_cache.masks, &mask->node);
+		list_insert_node(&pd_border_cache.masks, 0, &mask->node);
+		mask->refs++;
+		thread_mutex_unlock(&pd_border_cache.mutex);
+		return mask;
+	}
+	thread_mutex_unlock(&pd_border_cache.mutex);
+	mask = pd_border_mask_create(&key);
+	if (!mask) {
+		return NULL;
+	}
+	thread_mutex_lock(&pd_border_cache.mutex);
+	found = pd_border_cache_find(&key);
+	if (found) {
+		found->refs++;
+		thread_mutex_unlock(&pd_border_cache.mutex);
+		free(mask);
+		return found;
+	}
+	mask->refs = 1;
+	list_insert_node(&pd_border_cache.masks, 0, &mask->node);
+	pd_border_cache.memory += pd_border_mask_size(mask);
+	pd_border_cache_evict();
+	thread_mutex_unlock(&pd_border_cache.mutex);
+	return mask;
+}
 
-	/* Get the actual rectangle that can be drawn */
-	pd_canvas_get_quote_rect(dst, &rect);
-	dst = pd_canvas_get_quote_source(dst);
-	if (!pd_canvas_is_valid(dst)) {
-		return -1;
+static void pd_border_release_mask(pd_border_mask_t *mask)
+{
+	if (!pd_border_cache.active) {
+		free(mask);
+		return;
 	}
-	right = y_min(rect.width, bound_left + width);
-	for (y = 0; y < rect.height; ++y) {
-		outer_x = width;
-		split_x = 0;
-		inner_x = -1.0;
-		circle_y = ToGeoY(y, circle_center_y);
-		if (r > 0 && circle_y <= 0) {
-			outer_x = width - r + ellipse_x(r, r, circle_y);
-			if (radius_y > 0 && y <= inner_ellipse_bottom &&
-			    y >= circle_center_y) {
-				inner_x =
-				    width - radius - 0.5 +
-				    ellipse_x(radius_x, radius_y, circle_y);
-			}
-		}
-		if (xline->width > 0) {
-			split_x = split_center_x -
-				  ToGeoY(y, split_center_y) * split_k;
-		}
-		outer_x = bound_left + outer_x;
-		inner_x = bound_left + inner_x;
-		outer_x = y_max(0, y_min(right, outer_x));
-		inner_x = y_max(-1.0, y_min(outer_x, inner_x));
-		inner_xi = y_max(0, (int)inner_x - (int)radius / 2);
-		outer_xi = y_min(right, (int)outer_x + (int)radius / 2);
-		p = pd_canvas_pixel_at(dst, rect.x + inner_xi, rect.y + y);
-		for (x = inner_xi; x < outer_xi; ++x, ++p) {
-			outer_d = -1.0;
-			inner_d = 1.0 * x - inner_x;
-			circle_x = ToGeoX(x, circle_center_x);
-			if (r > 0 && circle_y <= 0 && circle_x >= 0) {
-				outer_d =
-				    sqrt(POW2(circle_x) + POW2(circle_y)) - r;
-				if (radius_x == radius_y && radius_y > 0 &&
-				    y <= inner_ellipse_bottom) {
-					inner_d = outer_d + r - radius_x;
-				}
-			}
-			if (outer_d >= 1.0) {
-				break;
-			}
-			if (x < split_x) {
-				color = xline->color;
-			} else {
-				color = yline->color;
-			}
-			if (outer_d >= 0) {
-				if (inner_d - outer_d >= 0.5) {
-					*p = color;
-				}
-				p->a = smooth_left_pixel(p, outer_d);
-			} else if (inner_d >= 0.5) {
-				pd_over_pixel(p, &color, 1.0);
-			} else if (inner_d >= 0) {
-				color.a = smooth_right_pixel(&color, inner_d);
-				pd_over_pixel(p, &color, 1.0);
-			}
-		}
-		/* Clear the outer pixels */
-		for (; x < right; ++x, ++p) {
-			p->alpha = 0;
+	thread_mutex_lock(&pd_border_cache.mutex);
+	mask->refs--;
+	if (mask->refs == 0) {
+		if (mask->detached) {
+			free(mask);
+		} else {
+			pd_border_cache_evict();
 		}
 	}
-	return 0;
+	thread_mutex_unlock(&pd_border_cache.mutex);
 }
 
 /**
- * FIXME: Improve the content cropping code
- * Merge the four functions of CropContent* into one function and make it
- * simple.
+ * Paint the border color over the pixel, the pixel is clipped by the outer
+ * edge and the color covers the area between the outer and inner edges
  */
-
-/** Crop the top left corner of the content area */
-static int crop_content_top_left(pd_canvas_t *dst, int bound_left,
-				 int bound_top, double radius_x,
-				 double radius_y)
+static void pd_border_mix_pixel(pd_color_t *p, const pd_color_t *color,
+				unsigned outer, unsigned inner,
+				bool premultiplied)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
-
-	pd_rect_t rect;
-	pd_color_t *p;
+	pd_color_t c = *color;
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left + radius_x;
-	center_y = bound_top + radius_y;
-	pd_canvas_get_quote_rect(dst, &rect);
-	dst = pd_canvas_get_quote_source(dst);
-	if (!pd_canvas_is_valid(dst)) {
-		return -1;
+	if (outer == 0) {
+		p->value = 0;
+		return;
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(radius_x + 1.0, radius_y + 1.0, y);
-		outer_xi = (int)(center_x - x);
-		outer_xi = y_max(0, y_min(outer_xi, rect.width));
-		p = pd_canvas_pixel_at(dst, rect.x, rect.y + yi);
-		for (xi = 0; xi < outer_xi; ++xi, ++p) {
-			p->alpha = 0;
-		}
-		/* If inner ellipse is circle */
-		if (radius_x == radius_y) {
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				} else {
-					break;
-				}
-			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				} else {
-					break;
-				}
-			}
-		}
+	if (!premultiplied) {
+		pd_premultiply_pixel(p);
+	}
+	pd_premultiply_pixel(&c);
+	inner = y_min(inner, outer);
+	pd_over_premultiplied_pixel(p, &c,
+				    ((outer - inner) * 256 + outer / 2) / outer);
+	if (outer < 255) {
+		p->r = (uint8_t)pd_div255(p->r * outer);
+		p->g = (uint8_t)pd_div255(p->g * outer);
+		p->b = (uint8_t)pd_div255(p->b * outer);
+		p->a = (uint8_t)pd_div255(p->a * outer);
+	}
+	if (!premultiplied) {
+		pd_unpremultiply_pixel(p);
 	}
-	return 0;
 }
 
-static int crop_content_top_right(pd_canvas_t *dst, int bound_left,
-				  int bound_top, double radius_x,
-				  double radius_y)
+/**
+ * Draw a corner of the border
+ * @param corner_left, corner_top position of the corner relative to the
+ * canvas, the size of the corner is the size of its mask
+ */
+static int draw_border_corner(pd_canvas_t *dst, int corner_left,
+			      int corner_top, const pd_border_line_t *xline,
+			      const pd_border_line_t *yline,
+			      unsigned int radius, int corner)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
-
-	pd_rect_t rect;
+	int x, y, u, v;
+	int x0, x1, y0, y1;
+	bool premultiplied;
+	const uint8_t *outer, *inner;
+	const pd_color_t *color;
+	pd_border_mask_t *mask;
 	pd_color_t *p;
+	pd_rect_t rect;
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left;
-	center_y = bound_top + radius_y;
 	pd_canvas_get_quote_rect(dst, &rect);
 	dst = pd_canvas_get_quote_source(dst);
 	if (!pd_canvas_is_valid(dst)) {
 		return -1;
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(y_max(0, radius_x - 1), y_max(0, radius_y - 1),
-			      y);
-		outer_xi = (int)(center_x + x);
-		outer_xi = y_max(0, outer_xi);
-		p = pd_canvas_pixel_at(dst, rect.x + outer_xi, rect.y + yi);
-		if (radius_x == radius_y) {
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				}
-			}
+	mask = pd_border_get_mask(radius, xline->width, yline->width);
+	if (!mask) {
+		return -2;
+	}
+	premultiplied = dst->color_type == PD_COLOR_TYPE_PARGB;
+	x0 = y_max(0, corner_left);
+	x1 = y_min(rect.width, corner_left + mask->width);
+	y0 = y_max(0, corner_top);
+	y1 = y_min(rect.height, corner_top + mask->height);
+	for (y = y0; y < y1; ++y) {
+		v = y - corner_top;
+		if (is_bottom_corner(corner)) {
+			v = mask->height - 1 - v;
+		}
+		if (is_right_corner(corner)) {
+			outer = mask->mirrored_outer + v * mask->width;
+			inner = mask->mirrored_inner + v * mask->width;
 		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				}
-			}
+			outer = mask->outer + v * mask->width;
+			inner = mask->inner + v * mask->width;
 		}
-		for (; xi < rect.width; ++xi, ++p) {
-			p->alpha = 0;
+		p = pd_canvas_pixel_at(dst, rect.x + x0, rect.y + y);
+		for (x = x0; x < x1; ++x, ++p) {
+			u = x - corner_left;
+			if (outer[u] == 255 && inner[u] == 255) {
+				continue;
+			}
+			/* The diagonal of the corner splits the two colors */
+			if (is_right_corner(corner)) {
+				u = mask->width - 1 - u;
+			}
+			if ((2 * u + 1) * xline->width <
+			    (2 * v + 1) * yline->width) {
+				color = &yline->color;
+			} else {
+				color = &xline->color;
+			}
+			u = x - corner_left;
+			pd_border_mix_pixel(p, color, outer[u], inner[u],
+					    premultiplied);
 		}
 	}
+	pd_border_release_mask(mask);
 	return 0;
 }
 
-static int crop_content_bottom_left(pd_canvas_t *dst, int bound_left,
-				    int bound_top, double radius_x,
-				    double radius_y)
+/**
+ * Clip the content by the inner edge of a corner, the pixels are multiplied
+ * by the coverage of the padding box
+ * @param corner_left, corner_top position of the corner relative to the
+ * canvas
+ */
+static int crop_content_corner(pd_canvas_t *dst, int corner_left,
+			       int corner_top, const pd_border_mask_t *mask,
+			       int corner)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
-
+	int y, v;
+	int x0, x1, y0, y1;
+	const uint8_t *inner;
 	pd_rect_t rect;
-	pd_color_t *p;
+	pd_blend_mask_row_func_t mask_row;
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left + radius_x;
-	center_y = bound_top;
 	pd_canvas_get_quote_rect(dst, &rect);
 	dst = pd_canvas_get_quote_source(dst);
 	if (!pd_canvas_is_valid(dst)) {
 		return -1;
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(radius_x + 1.0, radius_y + 1.0, y);
-		outer_xi = (int)(center_x - x);
-		outer_xi = y_max(0, y_min(outer_xi, rect.width));
-		p = pd_canvas_pixel_at(dst, rect.x, rect.y + yi);
-		for (xi = 0; xi < outer_xi; ++xi, ++p) {
-			p->alpha = 0;
-		}
-		if (radius_x == radius_y) {
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				} else {
-					break;
-				}
-			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					p->alpha = 0;
-				} else if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				} else {
-					break;
-				}
-			}
+	if (dst->color_type == PD_COLOR_TYPE_PARGB) {
+		mask_row = pd_get_blend_kernels()->mask_pargb;
+	} else {
+		mask_row = pd_get_blend_kernels()->mask_argb;
+	}
+	x0 = y_max(0, corner_left);
+	x1 = y_min(rect.width, corner_left + mask->width);
+	y0 = y_max(0, corner_top);
+	y1 = y_min(rect.height, corner_top + mask->height);
+	if (x1 <= x0) {
+		return 0;
+	}
+	for (y = y0; y < y1; ++y) {
+		v = y - corner_top;
+		if (is_bottom_corner(corner)) {
+			v = mask->height - 1 - v;
 		}
+		inner = is_right_corner(corner) ? mask->mirrored_inner
+						: mask->inner;
+		mask_row(pd_canvas_pixel_at(dst, rect.x + x0, rect.y + y),
+			 inner + v * mask->width + x0 - corner_left, x1 - x0);
 	}
 	return 0;
 }
 
-static int crop_content_bottom_right(pd_canvas_t *dst, int bound_left,
-				     int bound_top, double radius_x,
-				     double radius_y)
+/**
+ * Crop the content in the rectangle of a corner
+ * @param bound the area of the padding box inside the corner, it relative
+ * to the border box
+ */
+static void pd_crop_border_content_corner(pd_context_t *ctx,
+					  const pd_rect_t *bound,
+					  int corner_left, int corner_top,
+					  const pd_border_line_t *xline,
+					  const pd_border_line_t *yline,
+					  int radius, int corner)
 {
-	int xi, yi;
-	int outer_xi;
-	double x, y, d;
-	double outer_x;
-	double center_x, center_y;
-
+	pd_canvas_t canvas;
 	pd_rect_t rect;
-	pd_color_t *p;
+	pd_border_mask_t *mask;
 
-	radius_x -= 0.5;
-	radius_y -= 0.5;
-	center_x = bound_left;
-	center_y = bound_top;
-	pd_canvas_get_quote_rect(dst, &rect);
-	dst = pd_canvas_get_quote_source(dst);
-	if (!pd_canvas_is_valid(dst)) {
-		return -1;
+	if (bound->width < 1 || bound->height < 1 ||
+	    !pd_rect_overlap(bound, &ctx->rect, &rect)) {
+		return;
 	}
-	for (yi = 0; yi < rect.height; ++yi) {
-		y = ToGeoY(yi, center_y);
-		x = ellipse_x(y_max(0, radius_x - 1), y_max(0, radius_y - 1),
-			      y);
-		outer_xi = (int)(center_x + x);
-		outer_xi = y_max(0, outer_xi);
-		p = pd_canvas_pixel_at(dst, rect.x + outer_xi, rect.y + yi);
-		if (radius_x == radius_y) {
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = sqrt(x * x + y * y) - radius_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				}
-			}
-		} else {
-			outer_x =
-			    ToGeoX(ellipse_x(radius_x, radius_y, y), center_x);
-			for (xi = outer_xi; xi < rect.width; ++xi, ++p) {
-				x = ToGeoX(xi, center_x);
-				d = x - outer_x;
-				if (d >= 1.0) {
-					break;
-				}
-				if (d >= 0) {
-					p->alpha = smooth_left_pixel(p, d);
-				}
-			}
-		}
-		for (; xi < rect.width; ++xi, ++p) {
-			p->alpha = 0;
-		}
+	mask = pd_border_get_mask(radius, xline->width, yline->width);
+	if (!mask) {
+		return;
 	}
-	return 0;
+	corner_left -= rect.x;
+	corner_top -= rect.y;
+	rect.x -= ctx->rect.x;
+	rect.y -= ctx->rect.y;
+	pd_canvas_quote(&canvas, &ctx->canvas, &rect);
+	crop_content_corner(&canvas, corner_left, corner_top, mask, corner);
+	pd_border_release_mask(mask);
 }
 
 int pd_crop_border_content(pd_context_t *ctx, const pd_border_t *border,
 			   const pd_rect_t *box)
 {
-	pd_canvas_t canvas;
-	pd_rect_t bound, rect;
-
 	int radius;
-	int bound_top, bound_left;
+	pd_rect_t bound;
 
 	radius = border->top_left_radius;
 	bound.x = box->x + border->left.width;
 	bound.y = box->y + border->top.width;
 	bound.width = radius - border->left.width;
 	bound.height = radius - border->top.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    pd_rect_overlap(&bound, &ctx->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= ctx->rect.x;
-		rect.y -= ctx->rect.y;
-		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		crop_content_top_left(&canvas, bound_left, bound_top,
-				      bound.width, bound.height);
-	}
+	pd_crop_border_content_corner(ctx, &bound, box->x, box->y, &border->top,
+				      &border->left, radius,
+				      PD_BORDER_TOP_LEFT);
 
 	radius = border->top_right_radius;
 	bound.x = box->x + box->width - radius;
 	bound.y = box->y + border->top.width;
 	bound.width = radius - border->right.width;
 	bound.height = radius - border->top.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    pd_rect_overlap(&bound, &ctx->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= ctx->rect.x;
-		rect.y -= ctx->rect.y;
-		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		crop_content_top_right(&canvas, bound_left, bound_top,
-				       bound.width, bound.height);
-	}
+	pd_crop_border_content_corner(ctx, &bound, box->x + box->width - radius,
+				      box->y, &border->top, &border->right,
+				      radius, PD_BORDER_TOP_RIGHT);
 
 	radius = border->bottom_left_radius;
 	bound.x = box->x + border->left.width;
 	bound.y = box->y + box->height - radius;
 	bound.width = radius - border->left.width;
 	bound.height = radius - border->bottom.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    pd_rect_overlap(&bound, &ctx->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= ctx->rect.x;
-		rect.y -= ctx->rect.y;
-		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		crop_content_bottom_left(&canvas, bound_left, bound_top,
-					 bound.width, bound.height);
-	}
+	pd_crop_border_content_corner(ctx, &bound, box->x,
+				      box->y + box->height - radius,
+				      &border->bottom, &border->left, radius,
+				      PD_BORDER_BOTTOM_LEFT);
 
 	radius = border->bottom_right_radius;
 	bound.x = box->x + box->width - radius;
 	bound.y = box->y + box->height - radius;
-	;
 	bound.width = radius - border->right.width;
 	bound.height = radius - border->bottom.width;
-	if (bound.width > 0 && bound.height > 0 &&
-	    pd_rect_overlap(&bound, &ctx->rect, &rect)) {
-		bound_left = bound.x - rect.x;
-		bound_top = bound.y - rect.y;
-		rect.x -= ctx->rect.x;
-		rect.y -= ctx->rect.y;
-		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		crop_content_bottom_right(&canvas, bound_left, bound_top,
-					  bound.width, bound.height);
-	}
+	pd_crop_border_content_corner(
+	    ctx, &bound, box->x + box->width - radius,
+	    box->y + box->height - radius, &border->bottom, &border->right,
+	    radius, PD_BORDER_BOTTOM_RIGHT);
 	return 0;
 }
 
@@ -780,9 +574,9 @@ int pd_paint_border(pd_context_t *ctx, const pd_border_t *border,
 		rect.x -= ctx->rect.x;
 		rect.y -= ctx->rect.y;
 		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		draw_border_top_left(&canvas, bound_left, bound_top,
-				     &border->top, &border->left,
-				     border->top_left_radius);
+		draw_border_corner(&canvas, bound_left, bound_top,
+				   &border->top, &border->left,
+				   border->top_left_radius, PD_BORDER_TOP_LEFT);
 	}
 	/* Draw border top right angle */
 	bound.y = box->y;
@@ -795,9 +589,10 @@ int pd_paint_border(pd_context_t *ctx, const pd_border_t *border,
 		rect.x -= ctx->rect.x;
 		rect.y -= ctx->rect.y;
 		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		draw_border_top_right(&canvas, bound_left, bound_top,
-				      &border->top, &border->right,
-				      border->top_right_radius);
+		draw_border_corner(&canvas, bound_left, bound_top,
+				   &border->top, &border->right,
+				   border->top_right_radius,
+				   PD_BORDER_TOP_RIGHT);
 	}
 	/* Draw border bottom left angle */
 	bound.x = box->x;
@@ -810,9 +605,10 @@ int pd_paint_border(pd_context_t *ctx, const pd_border_t *border,
 		rect.x -= ctx->rect.x;
 		rect.y -= ctx->rect.y;
 		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		draw_border_bottom_left(&canvas, bound_left, bound_top,
-					&border->bottom, &border->left,
-					border->bottom_left_radius);
+		draw_border_corner(&canvas, bound_left, bound_top,
+				   &border->bottom, &border->left,
+				   border->bottom_left_radius,
+				   PD_BORDER_BOTTOM_LEFT);
 	}
 	/* Draw border bottom right angle */
 	bound.width = br_width;
@@ -825,9 +621,10 @@ int pd_paint_border(pd_context_t *ctx, const pd_border_t *border,
 		rect.x -= ctx->rect.x;
 		rect.y -= ctx->rect.y;
 		pd_canvas_quote(&canvas, &ctx->canvas, &rect);
-		draw_border_bottom_right(&canvas, bound_left, bound_top,
-					 &border->bottom, &border->right,
-					 border->bottom_right_radius);
+		draw_border_corner(&canvas, bound_left, bound_top,
+				   &border->bottom, &border->right,
+				   border->bottom_right_radius,
+				   PD_BORDER_BOTTOM_RIGHT);
 	}
 	/* Draw top border line */
 	bound.x = box->x + tl_width;
@@ -16,15 +16,13 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <yutil.h>
+#include <thread.h>
 #include <pandagl.h>
 
-#define BLUR_N 1.5
-#define BLUR_WIDTH(sd) (int)(sd->blur * BLUR_N)
-#define FULL_SHADOW_WIDTH(CTX)                                    \
-	SHADOW_WIDTH((CTX)->shadow) + BLUR_WIDTH((CTX)->shadow) - \
-	    (CTX)->shadow->blur
-
 #define SHADOW_WIDTH(sd) (sd->blur + sd->spread)
+#define DEFAULT_CACHE_MAX_MEMORY (4 * 1024 * 1024)
 
 #define POW2(X) ((X) * (X))
 #define CIRCLE_R(R) (R - 0.5)
@@ -35,11 +33,9 @@
 /*  Convert screen X coordinate to geometric X coordinate */
 #define ToGeoX(X, CENTER_X) (X - (CENTER_X))
 
-#define smooth_left_pixel(PX, X) (uint8_t)((PX)->a * (1.0 - (X - 1.0 * (int)X)))
-#define smooth_right_pixel(PX, X) (uint8_t)((PX)->a * (X - 1.0 * (int)X))
+#define smooth_right_pixel(PX, X) (uint8_t)(*(PX) * (X - 1.0 * (int)X))
 
 typedef struct pd_boxshadow_context {
-	int max_radius;
 	const pd_boxshadow_t *shadow;
 	const pd_rect_t *box;
 	pd_rect_t shadow_box;
@@ -47,30 +43,49 @@ typedef struct pd_boxshadow_context {
 	pd_context_t *paint;
 } pd_boxshadow_context_t;
 
-typedef struct gradient {
-	int s;
-	double v;
-	double a;
-} gradient_t;
+typedef struct pd_boxshadow_mask_key {
+	int blur;
+	int spread;
+	int top_left_radius;
+	int top_right_radius;
+	int bottom_left_radius;
+	int bottom_right_radius;
 
-/** 初始化渐变生成器 */
-static void gradient_init(gradient_t *g, double t)
-{
-	/**
-	 * s = vt - at²/2
-	 * a = 2x(vt - s)/t²
-	 */
-	g->s = 255;
-	g->v = 512.0f / t;
-	g->a = 2 * (g->v * t - g->s) / (t * t);
-}
+	/** Size of the shadow box, or 0 if the mask is a nine-patch */
+	int width;
+	int height;
+} pd_boxshadow_mask_key_t;
 
-/** 计算渐变后的值 */
-static uint8_t gradient_compute(gradient_t *g, double t, int val)
-{
-	val *= g->s - (int)(g->v * t - (g->a * t * t) / 2.0);
-	return (uint8_t)(val >> 8);
-}
+/**
+ * The alpha mask of a shadow. A nine-patch mask only contains the corners
+ * and one row and column of each edge, the column at x = left and the row
+ * at y = top are repeated to stretch it to the size of the shadow box.
+ */
+typedef struct pd_boxshadow_mask {
+	pd_boxshadow_mask_key_t key;
+	int left, right, top, bottom;
+	int width, height;
+	uint8_t *data;
+
+	/** Number of users of the mask, a used mask is never freed */
+	unsigned refs;
+
+	/** The mask was evicted from the cache while it was still used */
+	bool detached;
+
+	list_node_t node;
+} pd_boxshadow_mask_t;
+
+/** A thread-safe LRU cache of shadow masks */
+static struct pd_boxshadow_cache {
+	bool active;
+	size_t memory;
+	size_t max_memory;
+	thread_mutex_t mutex;
+
+	/** list_t<pd_boxshadow_mask_t*>, most recently used first */
+	list_t masks;
+} pd_boxshadow_cache;
 
 PD_INLINE int get_boxshadow_width(const pd_boxshadow_t *shadow, int content_width)
 {
@@ -140,296 +155,393 @@ void pd_get_boxshadow_canvas_rect(const pd_boxshadow_t *shadow,
 			      canvas_rect->y;
 }
 
-static bool pd_paint_boxshadow_left_blur(pd_boxshadow_context_t *ctx)
+static void pd_boxshadow_mask_key_init(pd_boxshadow_mask_key_t *key,
+					const pd_boxshadow_t *shadow,
+					int width, int height)
 {
-	int x, y;
-	int right;
-	gradient_t g;
+	int max_radius;
 
-	pd_rect_t rect;
-	pd_rect_t paint_rect;
-	pd_canvas_t ref;
-	pd_canvas_t *canvas;
-	pd_color_t *p;
-	pd_color_t color = ctx->shadow->color;
-
-	rect.x = ctx->shadow_box.x;
-	rect.y = ctx->shadow_box.y;
-	rect.width = BLUR_WIDTH(ctx->shadow);
-	rect.height = ctx->shadow_box.height;
-	right = rect.x + rect.width;
-	gradient_init(&g, BLUR_WIDTH(ctx->shadow));
-	if (!pd_rect_overlap(&ctx->paint->rect, &rect, &rect)) {
-		return false;
-	}
-	right -= rect.x;
-	paint_rect.width = rect.width;
-	paint_rect.height = rect.height;
-	paint_rect.x = rect.x - ctx->paint->rect.x;
-	paint_rect.y = rect.y - ctx->paint->rect.y;
-	pd_canvas_quote(&ref, &ctx->paint->canvas, &paint_rect);
-	pd_canvas_get_quote_rect(&ref, &paint_rect);
-	canvas = pd_canvas_get_quote_source(&ref);
-	for (y = 0; y < paint_rect.height; ++y) {
-		p = pd_canvas_pixel_at(canvas, paint_rect.x, paint_rect.y + y);
-		for (x = 0; x < paint_rect.width; ++x, ++p) {
-			color.alpha = gradient_compute(&g, right - x,
-						       ctx->shadow->color.a);
-			*p = color;
-		}
+	/* The shape is the box grown by the spread, the blur extends it by
+	 * shadow->blur pixels on each side */
+	max_radius =
+	    y_max(0, y_min(width, height) / 2 - y_max(0, shadow->blur));
+	key->blur = y_max(0, shadow->blur);
+	key->spread = shadow->spread;
+#define SHAPE_RADIUS(R) \
+	((R) > 0 ? y_max(0, y_min(max_radius, (R) + shadow->spread)) : 0)
+	key->top_left_radius = SHAPE_RADIUS(shadow->top_left_radius);
+	key->top_right_radius = SHAPE_RADIUS(shadow->top_right_radius);
+	key->bottom_left_radius = SHAPE_RADIUS(shadow->bottom_left_radius);
+	key->bottom_right_radius = SHAPE_RADIUS(shadow->bottom_right_radius);
+#undef SHAPE_RADIUS
+	key->width = width;
+	key->height = height;
+}
+
+/**
+ * Compute the size of the nine-patch corners. The blur of a pixel reaches
+ * key->blur pixels away, so the edges are uniform beyond the rounded
+ * corners plus twice the blur.
+ */
+static void pd_boxshadow_mask_init(pd_boxshadow_mask_t *mask,
+				   const pd_boxshadow_mask_key_t *key)
+{
+	mask->key = *key;
+	mask->left = 2 * key->blur +
+		     y_max(key->top_left_radius, key->bottom_left_radius);
+	mask->right = 2 * key->blur +
+		      y_max(key->top_right_radius, key->bottom_right_radius);
+	mask->top = 2 * key->blur +
+		    y_max(key->top_left_radius, key->top_right_radius);
+	mask->bottom = 2 * key->blur +
+		       y_max(key->bottom_left_radius, key->bottom_right_radius);
+	if (key->width > mask->left + mask->right &&
+	    key->height > mask->top + mask->bottom) {
+		mask->width = mask->left + mask->right + 1;
+		mask->height = mask->top + mask->bottom + 1;
+		mask->key.width = 0;
+		mask->key.height = 0;
+	} else {
+		/* The box is too small to be stretched from a nine-patch */
+		mask->width = key->width;
+		mask->height = key->height;
+		mask->left = mask->width;
+		mask->top = mask->height;
+		mask->right = 0;
+		mask->bottom = 0;
 	}
-	return true;
+	mask->data = NULL;
+	mask->refs = 0;
+	mask->detached = false;
+	mask->node.data = mask;
 }
 
-static bool pd_paint_boxshadow_right_blur(pd_boxshadow_context_t *ctx)
+static void pd_boxshadow_mask_destroy(pd_boxshadow_mask_t *mask)
 {
-	int x, y;
-	int left;
-	gradient_t g;
+	free(mask->data);
+	free(mask);
+}
 
-	pd_rect_t rect;
-	pd_rect_t paint_rect;
-	pd_canvas_t ref;
-	pd_canvas_t *canvas;
-	pd_color_t *p;
-	pd_color_t color = ctx->shadow->color;
-
-	rect.width = BLUR_WIDTH(ctx->shadow);
-	rect.height = ctx->shadow_box.height;
-	rect.x = ctx->shadow_box.x + ctx->shadow_box.width - rect.width;
-	rect.y = ctx->shadow_box.y;
-	left = rect.x;
-	gradient_init(&g, BLUR_WIDTH(ctx->shadow));
-	if (!pd_rect_overlap(&ctx->paint->rect, &rect, &rect)) {
-		return false;
-	}
-	left -= rect.x + 1;
-	paint_rect.width = rect.width;
-	paint_rect.height = rect.height;
-	paint_rect.x = rect.x - ctx->paint->rect.x;
-	paint_rect.y = rect.y - ctx->paint->rect.y;
-	pd_canvas_quote(&ref, &ctx->paint->canvas, &paint_rect);
-	pd_canvas_get_quote_rect(&ref, &paint_rect);
-	canvas = pd_canvas_get_quote_source(&ref);
-	for (y = 0; y < paint_rect.height; ++y) {
-		p = pd_canvas_pixel_at(canvas, paint_rect.x, paint_rect.y + y);
-		for (x = 0; x < paint_rect.width; ++x, ++p) {
-			color.alpha = gradient_compute(&g, x - left,
-						       ctx->shadow->color.a);
-			*p = color;
+/**
+ * Set the coverage of the pixels in a corner square
+ * @param x, y position of the corner square
+ * @param cx, cy center of the circle
+ */
+static void pd_boxshadow_mask_round_corner(pd_boxshadow_mask_t *mask, int x,
+					   int y, double cx, double cy,
+					   int radius)
+{
+	int i, j;
+	double d;
+
+	for (j = 0; j < radius; ++j) {
+		for (i = 0; i < radius; ++i) {
+			d = sqrt(POW2(x + i + 0.5 - cx) +
+				 POW2(y + j + 0.5 - cy));
+			d = radius - d + 0.5;
+			mask->data[(y + j) * mask->width + x + i] =
+			    (uint8_t)(d <= 0 ? 0 : d >= 1 ? 255 : d * 255 + 0.5);
 		}
 	}
-	return true;
 }
 
-static bool pd_paint_boxshadow_top_blur(pd_boxshadow_context_t *ctx)
+static void pd_boxshadow_mask_fill_shape(pd_boxshadow_mask_t *mask)
 {
-	int x, y;
-	int bottom;
-	gradient_t g;
+	int y, r;
+	int b = mask->key.blur;
+	int x0 = b, y0 = b;
+	int x1 = mask->width - b, y1 = mask->height - b;
+
+	memset(mask->data, 0, (size_t)mask->width * mask->height);
+	if (x1 <= x0 || y1 <= y0) {
+		return;
+	}
+	for (y = y0; y < y1; ++y) {
+		memset(mask->data + y * mask->width + x0, 255, x1 - x0);
+	}
+	r = mask->key.top_left_radius;
+	pd_boxshadow_mask_round_corner(mask, x0, y0, x0 + r, y0 + r, r);
+	r = mask->key.top_right_radius;
+	pd_boxshadow_mask_round_corner(mask, x1 - r, y0, x1 - r, y0 + r, r);
+	r = mask->key.bottom_left_radius;
+	pd_boxshadow_mask_round_corner(mask, x0, y1 - r, x0 + r, y1 - r, r);
+	r = mask->key.bottom_right_radius;
+	pd_boxshadow_mask_round_corner(mask, x1 - r, y1 - r, x1 - r, y1 - r,
+				       r);
+}
 
-	pd_rect_t rect;
-	pd_rect_t paint_rect;
-	pd_canvas_t ref;
-	pd_canvas_t *canvas;
-	pd_color_t *p;
-	pd_color_t color = ctx->shadow->color;
-
-	rect.width = ctx->shadow_box.width;
-	rect.height = BLUR_WIDTH(ctx->shadow);
-	rect.x = ctx->shadow_box.x;
-	rect.y = ctx->shadow_box.y;
-	bottom = rect.y + rect.height;
-	gradient_init(&g, BLUR_WIDTH(ctx->shadow));
-	if (!pd_rect_overlap(&ctx->paint->rect, &rect, &rect)) {
-		return false;
-	}
-	bottom -= rect.y;
-	paint_rect.width = rect.width;
-	paint_rect.height = rect.height;
-	paint_rect.x = rect.x - ctx->paint->rect.x;
-	paint_rect.y = rect.y - ctx->paint->rect.y;
-	pd_canvas_quote(&ref, &ctx->paint->canvas, &paint_rect);
-	pd_canvas_get_quote_rect(&ref, &paint_rect);
-	canvas = pd_canvas_get_quote_source(&ref);
-	for (y = 0; y < paint_rect.height; ++y) {
-		p = pd_canvas_pixel_at(canvas, paint_rect.x, paint_rect.y + y);
-		color.alpha =
-		    gradient_compute(&g, bottom - y, ctx->shadow->color.a);
-		for (x = 0; x < paint_rect.width; ++x, ++p) {
-			*p = color;
+/**
+ * Blur the mask with a separable Gaussian kernel, the sigma is half of the
+ * blur radius as the CSS spec defines
+ */
+static int pd_boxshadow_mask_blur(pd_boxshadow_mask_t *mask)
+{
+	int i, x, y, center;
+	int b = mask->key.blur;
+	int w = mask->width, h = mask->height;
+	unsigned sum, total;
+	unsigned *kernel;
+	uint16_t *tmp;
+	uint8_t *row;
+	double sigma = b / 2.0, weight;
+
+	if (b < 1) {
+		return 0;
+	}
+	kernel = malloc(sizeof(unsigned) * (2 * b + 1));
+	tmp = malloc(sizeof(uint16_t) * w * h);
+	if (!kernel || !tmp) {
+		free(kernel);
+		free(tmp);
+		return -1;
+	}
+	for (total = 0, i = -b; i <= b; ++i) {
+		weight = exp(-POW2(i) / (2.0 * POW2(sigma)));
+		kernel[i + b] = (unsigned)(weight * (1 << 14) + 0.5);
+		total += kernel[i + b];
+	}
+	/* Normalize the weights so that they sum to 1 << 14 */
+	for (sum = 0, i = 0; i <= 2 * b; ++i) {
+		kernel[i] = (unsigned)((kernel[i] * (1 << 14) + total / 2) / total);
+		sum += kernel[i];
+	}
+	kernel[b] += (1 << 14) - sum;
+	for (y = 0; y < h; ++y) {
+		row = mask->data + y * w;
+		for (x = 0; x < w; ++x) {
+			sum = 0;
+			for (i = y_max(0, x - b); i < y_min(w, x + b + 1); ++i) {
+				sum += row[i] * kernel[i - x + b];
+			}
+			tmp[y * w + x] = (uint16_t)((sum + (1 << 5)) >> 6);
+		}
+	}
+	for (y = 0; y < h; ++y) {
+		row = mask->data + y * w;
+		center = y - b;
+		for (x = 0; x < w; ++x) {
+			sum = 0;
+			for (i = y_max(0, center); i < y_min(h, y + b + 1); ++i) {
+				sum += tmp[i * w + x] * kernel[i - center];
+			}
+			row[x] = (uint8_t)((sum + (1 << 21)) >> 22);
 		}
 	}
-	return true;
+	free(kernel);
+	free(tmp);
+	return 0;
 }
 
-static bool pd_paint_boxshadow_bottom_blur(pd_boxshadow_context_t *ctx)
+static pd_boxshadow_mask_t *pd_boxshadow_mask_create(
+    const pd_boxshadow_mask_key_t *key)
 {
-	int x, y;
-	int top;
-	gradient_t g;
+	pd_boxshadow_mask_t *mask;
 
-	pd_rect_t rect;
-	pd_rect_t paint_rect;
-	pd_canvas_t ref;
-	pd_canvas_t *canvas;
-	pd_color_t *p;
-	pd_color_t color = ctx->shadow->color;
-
-	rect.width = ctx->shadow_box.width;
-	rect.height = BLUR_WIDTH(ctx->shadow);
-	rect.x = ctx->shadow_box.x;
-	rect.y = ctx->shadow_box.y + ctx->shadow_box.height - rect.height;
-	top = rect.y;
-	gradient_init(&g, BLUR_WIDTH(ctx->shadow));
-	if (!pd_rect_overlap(&ctx->paint->rect, &rect, &rect)) {
-		return false;
-	}
-	top -= rect.y + 1;
-	paint_rect.width = rect.width;
-	paint_rect.height = rect.height;
-	paint_rect.x = rect.x - ctx->paint->rect.x;
-	paint_rect.y = rect.y - ctx->paint->rect.y;
-	pd_canvas_quote(&ref, &ctx->paint->canvas, &paint_rect);
-	pd_canvas_get_quote_rect(&ref, &paint_rect);
-	canvas = pd_canvas_get_quote_source(&ref);
-	for (y = 0; y < paint_rect.height; ++y) {
-		p = pd_canvas_pixel_at(canvas, paint_rect.x, paint_rect.y + y);
-		color.a = gradient_compute(&g, y - top, ctx->shadow->color.a);
-		for (x = 0; x < paint_rect.width; ++x, ++p) {
-			*p = color;
-		}
+	mask = malloc(sizeof(pd_boxshadow_mask_t));
+	if (!mask) {
+		return NULL;
+	}
+	pd_boxshadow_mask_init(mask, key);
+	if (mask->width < 1 || mask->height < 1) {
+		free(mask);
+		return NULL;
+	}
+	mask->data = malloc((size_t)mask->width * mask->height);
+	if (!mask->data) {
+		free(mask);
+		return NULL;
+	}
+	pd_boxshadow_mask_fill_shape(mask);
+	if (pd_boxshadow_mask_blur(mask) != 0) {
+		pd_boxshadow_mask_destroy(mask);
+		return NULL;
 	}
-	return true;
+	return mask;
 }
 
-static bool pd_paint_boxshadow_circle_blur(pd_boxshadow_context_t *ctx,
-					      const pd_rect_t *circle_rect,
-					      double center_x, double center_y,
-					      int radius)
+static size_t pd_boxshadow_mask_size(pd_boxshadow_mask_t *mask)
 {
-	double d;
-	double y2;
-	double r = y_max(0, CIRCLE_R(radius));
-	double outer_r2 = POW2(r);
-	double inner_r = y_max(0, r - BLUR_WIDTH(ctx->shadow));
-	double inner_smooth_r2 = POW2(inner_r + 1.0);
-
-	int x, y;
-	unsigned char a = ctx->shadow->color.alpha;
+	return sizeof(pd_boxshadow_mask_t) + (size_t)mask->width * mask->height;
+}
 
-	gradient_t g;
+static void pd_boxshadow_cache_unlink(pd_boxshadow_mask_t *mask)
+{
+	list_unlink(&pd_boxshadow_cache.masks, &mask->node);
+	pd_boxshadow_cache.memory -= pd_boxshadow_mask_size(mask);
+	if (mask->refs > 0) {
+		mask->detached = true;
+	} else {
+		pd_boxshadow_mask_destroy(mask);
+	}
+}
 
-	pd_rect_t rect;
-	pd_canvas_t ref;
-	pd_color_t color;
-	pd_canvas_t *canvas;
-	pd_color_t *p;
-
-	if (!pd_rect_overlap(&ctx->paint->rect, circle_rect, &rect)) {
-		return false;
-	}
-	color = ctx->shadow->color;
-	center_x = center_x + circle_rect->x - rect.x - 0.5;
-	center_y = center_y + circle_rect->y - rect.y - 0.5;
-	rect.x -= ctx->paint->rect.x;
-	rect.y -= ctx->paint->rect.y;
-	pd_canvas_quote(&ref, &ctx->paint->canvas, &rect);
-	pd_canvas_get_quote_rect(&ref, &rect);
-	canvas = pd_canvas_get_quote_source(&ref);
-	gradient_init(&g, BLUR_WIDTH(ctx->shadow));
-	for (y = 0; y < rect.height; ++y) {
-		y2 = POW2(ToGeoY(y, center_y));
-		p = pd_canvas_pixel_at(canvas, rect.x, rect.y + y);
-		for (x = 0; x < rect.width; ++x, ++p) {
-			d = y2 + POW2(ToGeoX(x, center_x));
-			if (r - inner_r < 0.1) {
-				if (d >= inner_smooth_r2) {
-					p->alpha = 0;
-					continue;
-				}
-				color.a = a;
-				d = sqrt(d) - inner_r;
-				if (d > 0) {
-					color.a = smooth_left_pixel(&color, d);
-				}
-				*p = color;
-				continue;
-			}
-			if (d >= outer_r2) {
-				p->alpha = 0;
-				continue;
-			}
-			d = sqrt(d) - inner_r;
-			if (d < 0) {
-				color.a = a;
-				*p = color;
-				continue;
-			}
-			color.a = gradient_compute(&g, d, a);
-			*p = color;
+static void pd_boxshadow_cache_evict(void)
+{
+	list_node_t *node, *prev;
+
+	for (node = list_get_last_node(&pd_boxshadow_cache.masks);
+	     node && node != &pd_boxshadow_cache.masks.head &&
+	     pd_boxshadow_cache.memory > pd_boxshadow_cache.max_memory;
+	     node = prev) {
+		prev = node->prev;
+		if (((pd_boxshadow_mask_t *)node->data)->refs == 0) {
+			pd_boxshadow_cache_unlink(node->data);
 		}
 	}
-	return true;
 }
 
-static bool pd_paint_boxshadow_top_left_blur(pd_boxshadow_context_t *ctx)
+static pd_boxshadow_mask_t *pd_boxshadow_cache_find(
+    const pd_boxshadow_mask_key_t *key)
 {
-	int radius;
-	pd_rect_t rect;
+	list_node_t *node;
+	pd_boxshadow_mask_t *mask;
+	pd_boxshadow_mask_key_t nine_patch_key = *key;
+
+	nine_patch_key.width = 0;
+	nine_patch_key.height = 0;
+	for (list_each(node, &pd_boxshadow_cache.masks)) {
+		mask = node->data;
+		if (memcmp(&mask->key, key, sizeof(*key)) == 0 ||
+		    (memcmp(&mask->key, &nine_patch_key, sizeof(*key)) == 0 &&
+		     key->width > mask->left + mask->right &&
+		     key->height > mask->top + mask->bottom)) {
+			return mask;
+		}
+	}
+	return NULL;
+}
 
-	radius = FULL_SHADOW_WIDTH(ctx) + ctx->shadow->top_left_radius;
-	radius = y_min(ctx->max_radius, radius);
-	rect.width = radius;
-	rect.height = rect.width;
-	rect.x = ctx->shadow_box.x;
-	rect.y = ctx->shadow_box.y;
-	return pd_paint_boxshadow_circle_blur(ctx, &rect, rect.width,
-					      rect.height, radius);
+void pd_boxshadow_cache_init(size_t max_memory)
+{
+	if (pd_boxshadow_cache.active) {
+		return;
+	}
+	if (max_memory == 0) {
+		max_memory = DEFAULT_CACHE_MAX_MEMORY;
+	}
+	pd_boxshadow_cache.memory = 0;
+	pd_boxshadow_cache.max_memory = max_memory;
+	list_create(&pd_boxshadow_cache.masks);
+	thread_mutex_init(&pd_boxshadow_cache.mutex);
+	pd_boxshadow_cache.active = true;
 }
 
-static bool pd_paint_boxshadow_top_right_blur(pd_boxshadow_context_t *ctx)
+void pd_boxshadow_cache_destroy(void)
 {
-	int radius;
-	pd_rect_t rect;
+	list_node_t *node;
 
-	radius = FULL_SHADOW_WIDTH(ctx) + ctx->shadow->top_right_radius;
-	radius = y_min(ctx->max_radius, radius);
-	rect.width = radius;
-	rect.height = rect.width;
-	rect.x = ctx->shadow_box.x + ctx->shadow_box.width - rect.width;
-	rect.y = ctx->shadow_box.y;
-	return pd_paint_boxshadow_circle_blur(ctx, &rect, 0, rect.height,
-					      radius);
+	if (!pd_boxshadow_cache.active) {
+		return;
+	}
+	while ((node = list_get_first_node(&pd_boxshadow_cache.masks))) {
+		list_unlink(&pd_boxshadow_cache.masks, node);
+		pd_boxshadow_mask_destroy(node->data);
+	}
+	thread_mutex_destroy(&pd_boxshadow_cache.mutex);
+	pd_boxshadow_cache.memory = 0;
+	pd_boxshadow_cache.active = false;
 }
 
-static bool pd_paint_boxshadow_bottom_left_blur(pd_boxshadow_context_t *ctx)
+static pd_boxshadow_mask_t *pd_boxshadow_get_mask(
+    const pd_boxshadow_mask_key_t *key)
 {
-	int radius;
-	pd_rect_t rect;
+	pd_boxshadow_mask_t *mask, *found;
 
-	radius = FULL_SHADOW_WIDTH(ctx) + ctx->shadow->bottom_left_radius;
-	radius = y_min(ctx->max_radius, radius);
-	rect.width = radius;
-	rect.height = rect.width;
-	rect.x = ctx->shadow_box.x;
-	rect.y = ctx->shadow_box.y + ctx->shadow_box.height - rect.height;
-	return pd_paint_boxshadow_circle_blur(ctx, &rect, rect.width, 0,
-					      radius);
+	if (!pd_boxshadow_cache.active) {
+		return pd_boxshadow_mask_create(key);
+	}
+	thread_mutex_lock(&pd_boxshadow_cache.mutex);
+	mask = pd_boxshadow_cache_find(key);
+	if (mask) {
+		list_unlink(&pd_boxshadow_cache.masks, &mask->node);
+		list_insert_node(&pd_boxshadow_cache.masks, 0, &mask->node);
+		mask->refs++;
+		thread_mutex_unlock(&pd_boxshadow_cache.mutex);
+		return mask;
+	}
+	thread_mutex_unlock(&pd_boxshadow_cache.mutex);
+	/* Rasterize without holding the lock so other threads are not
+	 * blocked */
+	mask = pd_boxshadow_mask_create(key);
+	if (!mask) {
+		return NULL;
+	}
+	thread_mutex_lock(&pd_boxshadow_cache.mutex);
+	found = pd_boxshadow_cache_find(key);
+	if (found) {
+		found->refs++;
+		thread_mutex_unlock(&pd_boxshadow_cache.mutex);
+		pd_boxshadow_mask_destroy(mask);
+		return found;
+	}
+	mask->refs = 1;
+	list_insert_node(&pd_boxshadow_cache.masks, 0, &mask->node);
+	pd_boxshadow_cache.memory += pd_boxshadow_mask_size(mask);
+	pd_boxshadow_cache_evict();
+	thread_mutex_unlock(&pd_boxshadow_cache.mutex);
+	return mask;
 }
 
-static bool pd_paint_boxshadow_bottom_right_blur(pd_boxshadow_context_t *ctx)
+static void pd_boxshadow_release_mask(pd_boxshadow_mask_t *mask)
 {
-	int radius;
+	if (!pd_boxshadow_cache.active) {
+		pd_boxshadow_mask_destroy(mask);
+		return;
+	}
+	thread_mutex_lock(&pd_boxshadow_cache.mutex);
+	mask->refs--;
+	if (mask->refs == 0) {
+		if (mask->detached) {
+			pd_boxshadow_mask_destroy(mask);
+		} else {
+			pd_boxshadow_cache_evict();
+		}
+	}
+	thread_mutex_unlock(&pd_boxshadow_cache.mutex);
+}
+
+/** Fill the shadow box by stretching the mask and tinting it */
+static void pd_paint_boxshadow_mask(pd_boxshadow_context_t *ctx,
+				    const pd_boxshadow_mask_t *mask)
+{
+	int y, sy, my;
+	int x0, x1, mid_x0, mid_x1;
+	int stretch_x, stretch_y;
+	const uint8_t *row;
+
 	pd_rect_t rect;
+	pd_canvas_t *canvas;
+	uint8_t *p;
 
-	radius = FULL_SHADOW_WIDTH(ctx) + ctx->shadow->bottom_right_radius;
-	radius = y_min(ctx->max_radius, radius);
-	rect.width = radius;
-	rect.height = rect.width;
-	rect.x = ctx->shadow_box.x + ctx->shadow_box.width - rect.width;
-	rect.y = ctx->shadow_box.y + ctx->shadow_box.height - rect.height;
-	return pd_paint_boxshadow_circle_blur(ctx, &rect, 0, 0, radius);
+	if (!pd_rect_overlap(&ctx->paint->rect, &ctx->shadow_box, &rect)) {
+		return;
+	}
+	canvas = &ctx->paint->canvas;
+	stretch_x = ctx->shadow_box.width - mask->width;
+	stretch_y = ctx->shadow_box.height - mask->height;
+	/* Columns [x0, x1) of the shadow box, split at the stretched part */
+	x0 = rect.x - ctx->shadow_box.x;
+	x1 = x0 + rect.width;
+	mid_x0 = y_max(x0, y_min(x1, mask->left));
+	mid_x1 = y_max(mid_x0, y_min(x1, ctx->shadow_box.width - mask->right));
+	for (y = 0; y < rect.height; ++y) {
+		sy = rect.y + y - ctx->shadow_box.y;
+		if (sy < mask->top) {
+			my = sy;
+		} else if (sy >= ctx->shadow_box.height - mask->bottom) {
+			my = sy - stretch_y;
+		} else {
+			my = mask->top;
+		}
+		row = mask->data + my * mask->width;
+		p = pd_canvas_pixel_at(canvas, rect.x - ctx->paint->rect.x,
+				       rect.y - ctx->paint->rect.y + y);
+		memcpy(p, row + x0, mid_x0 - x0);
+		memset(p + mid_x0 - x0,
+		       row[mask->left < mask->width ? mask->left : 0],
+		       mid_x1 - mid_x0);
+		memcpy(p + mid_x1 - x0, row + mid_x1 - stretch_x, x1 - mid_x1);
+	}
 }
 
 static int clear_pixels_of_circle(pd_canvas_t *canvas, double center_x,
@@ -443,7 +555,7 @@ static int clear_pixels_of_circle(pd_canvas_t *canvas, double center_x,
 	int xi, yi;
 
 	pd_rect_t rect;
-	pd_color_t *p;
+	uint8_t *p;
 
 	pd_canvas_get_quote_rect(canvas, &rect);
 	canvas = pd_canvas_get_quote_source(canvas);
@@ -462,28 +574,15 @@ static int clear_pixels_of_circle(pd_canvas_t *canvas, double center_x,
 			}
 			d = sqrt(d) - r;
 			if (d <= 0) {
-				p->alpha = 0;
+				*p = 0;
 			} else {
-				p->alpha = smooth_right_pixel(p, d);
+				*p = smooth_right_pixel(p, d);
 			}
 		}
 	}
 	return 0;
 }
 
-static void pd_fill_boxshadow_rect(pd_boxshadow_context_t *ctx)
-{
-	pd_rect_t rect;
-
-	rect = ctx->shadow_box;
-	if (pd_rect_overlap(&rect, &ctx->paint->rect, &rect)) {
-		rect.x -= ctx->paint->rect.x;
-		rect.y -= ctx->paint->rect.y;
-		pd_canvas_fill_rect(&ctx->paint->canvas, ctx->shadow->color,
-				    rect);
-	}
-}
-
 static void pd_clear_boxshadow_content_rect(pd_boxshadow_context_t *ctx)
 {
 	int r;
@@ -576,12 +675,44 @@ static void pd_clear_boxshadow_content_rect(pd_boxshadow_context_t *ctx)
 	pd_rects_clear(&rects);
 }
 
+/** Render the shadow in a part of the paint rect */
+static int pd_paint_boxshadow_rect(pd_context_t *ctx,
+				   pd_boxshadow_context_t *sd_ctx,
+				   const pd_boxshadow_mask_t *mask,
+				   const pd_rect_t *rect)
+{
+	pd_context_t tmp;
+
+	tmp.rect = *rect;
+	tmp.with_alpha = true;
+	pd_canvas_init(&tmp.canvas);
+	/* The shadow is a single color, so only its coverage is rendered */
+	tmp.canvas.color_type = PD_COLOR_TYPE_A8;
+	if (pd_canvas_create(&tmp.canvas, rect->width, rect->height) != 0) {
+		return -2;
+	}
+	sd_ctx->paint = &tmp;
+	pd_paint_boxshadow_mask(sd_ctx, mask);
+	/* Clear pixels that overlap the content area */
+	pd_clear_boxshadow_content_rect(sd_ctx);
+	pd_canvas_mix_mask(&ctx->canvas, &tmp.canvas, sd_ctx->shadow->color,
+			   rect->x - ctx->rect.x, rect->y - ctx->rect.y);
+	pd_canvas_destroy(&tmp.canvas);
+	return 0;
+}
+
 int pd_paint_boxshadow(pd_context_t *ctx, const pd_boxshadow_t *shadow,
 		       const pd_rect_t *box, int content_width,
 		       int content_height)
 {
-	pd_context_t tmp;
+	int ret = 0;
+	unsigned i;
+	pd_rect_t rect;
+	pd_rect_t inner_rect;
+	pd_region_t region;
 	pd_boxshadow_context_t sd_ctx;
+	pd_boxshadow_mask_key_t key;
+	pd_boxshadow_mask_t *mask;
 
 	/* 判断容器尺寸是否低于阴影占用的最小尺寸 */
 	if (box->width < get_boxshadow_width(shadow, 0) ||
@@ -595,42 +726,52 @@ int pd_paint_boxshadow(pd_context_t *ctx, const pd_boxshadow_t *shadow,
 	/* Initialize a rendering context for render shadow */
 	sd_ctx.box = box;
 	sd_ctx.shadow = shadow;
-	sd_ctx.max_radius =
-	    y_min(content_width, content_height) / 2 + SHADOW_WIDTH(shadow);
 	sd_ctx.shadow_box.x = get_boxshadow_x(shadow);
 	sd_ctx.shadow_box.y = get_boxshadow_y(shadow);
 	sd_ctx.shadow_box.width = get_boxshadow_width(shadow, content_width);
-	sd_ctx.shadow_box.height = get_boxshadow_width(shadow, content_height);
+	sd_ctx.shadow_box.height = get_boxshadow_height(shadow, content_height);
 	sd_ctx.content_box.x = get_boxshadow_box_x(shadow);
 	sd_ctx.content_box.y = get_boxshadow_box_y(shadow);
 	sd_ctx.content_box.width = content_width;
 	sd_ctx.content_box.height = content_height;
 
-	/* Create a paint context for render shadow */
-	sd_ctx.paint = &tmp;
-	pd_canvas_init(&tmp.canvas);
-	tmp.rect = ctx->rect;
-	tmp.with_alpha = true;
-	tmp.canvas.color_type = PD_COLOR_TYPE_ARGB;
-	pd_canvas_create(&sd_ctx.paint->canvas, ctx->rect.width,
-			 ctx->rect.height);
-
-	/* Render box shadow */
-	pd_fill_boxshadow_rect(&sd_ctx);
-	pd_paint_boxshadow_left_blur(&sd_ctx);
-	pd_paint_boxshadow_right_blur(&sd_ctx);
-	pd_paint_boxshadow_top_blur(&sd_ctx);
-	pd_paint_boxshadow_bottom_blur(&sd_ctx);
-	pd_paint_boxshadow_top_left_blur(&sd_ctx);
-	pd_paint_boxshadow_top_right_blur(&sd_ctx);
-	pd_paint_boxshadow_bottom_left_blur(&sd_ctx);
-	pd_paint_boxshadow_bottom_right_blur(&sd_ctx);
-	/* Clear pixels that overlap the content area */
-	pd_clear_boxshadow_content_rect(&sd_ctx);
-
-	/* Render the rendered shadow bitmap to the canvas */
-	pd_canvas_mix(&ctx->canvas, &sd_ctx.paint->canvas, 0, 0,
-		      ctx->with_alpha);
-	pd_canvas_destroy(&sd_ctx.paint->canvas);
-	return 0;
+	/* Only the part of the shadow box inside the paint rect is rendered */
+	if (!pd_rect_overlap(&ctx->rect, &sd_ctx.shadow_box, &rect)) {
+		return 0;
+	}
+	pd_boxshadow_mask_key_init(&key, shadow, sd_ctx.shadow_box.width,
+				   sd_ctx.shadow_box.height);
+	mask = pd_boxshadow_get_mask(&key);
+	if (!mask) {
+		return -2;
+	}
+	pd_region_init(&region);
+	pd_region_set_rect(&region, &rect);
+	/* The content box is cleared except its rounded corners, so skip it */
+	inner_rect = sd_ctx.content_box;
+	inner_rect.y += y_max(shadow->top_left_radius, shadow->top_right_radius);
+	inner_rect.height -=
+	    y_max(shadow->top_left_radius, shadow->top_right_radius) +
+	    y_max(shadow->bottom_left_radius, shadow->bottom_right_radius);
+	if (inner_rect.height > 0) {
+		pd_region_subtract_rect(&region, &inner_rect);
+	}
+	inner_rect = sd_ctx.content_box;
+	inner_rect.x += y_max(shadow->top_left_radius, shadow->bottom_left_radius);
+	inner_rect.width -=
+	    y_max(shadow->top_left_radius, shadow->bottom_left_radius) +
+	    y_max(shadow->top_right_radius, shadow->bottom_right_radius);
+	if (inner_rect.width > 0) {
+		pd_region_subtract_rect(&region, &inner_rect);
+	}
+	for (i = 0; i < region.length; ++i) {
+		if (pd_paint_boxshadow_rect(ctx, &sd_ctx, mask,
+					    &region.rects[i]) != 0) {
+			ret = -2;
+			break;
+		}
+	}
+	pd_region_destroy(&region);
+	pd_boxshadow_release_mask(mask);
+	return ret;
 }
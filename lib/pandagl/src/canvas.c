@@ -9,7 +9,17 @@
  * LICENSE.TXT file in the root directory of this source tree.
  */
 
+#include <stdlib.h>
+#include <string.h>
 #include <pandagl.h>
+#include "blend.h"
+#include "canvas_alloc.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
 
 void pd_canvas_init(pd_canvas_t *canvas)
 {
@@ -107,7 +117,7 @@ void pd_canvas_destroy(pd_canvas_t *canvas)
 		return;
 	}
 	if (canvas->bytes) {
-		free(canvas->bytes);
+		pd_canvas_free_bytes(canvas->bytes, canvas->mem_size);
 		canvas->bytes = NULL;
 	}
 	canvas->width = 0;
@@ -115,21 +125,88 @@ void pd_canvas_destroy(pd_canvas_t *canvas)
 	canvas->mem_size = 0;
 }
 
+size_t pd_canvas_get_row_size(pd_color_type_t color_type, unsigned width,
+			      unsigned alignment)
+{
+	size_t size = (size_t)pd_get_pixel_size(color_type) * width;
+
+	if (alignment < 4) {
+		alignment = 4;
+	}
+	return (size + alignment - 1) & ~((size_t)alignment - 1);
+}
+
+uint8_t *pd_canvas_alloc_bytes(size_t size)
+{
+	void *bytes;
+
+#ifdef __linux__
+	/* The mapped pages are already zero-filled and page-aligned */
+	if (size >= PD_CANVAS_LARGE_BUFFER_SIZE) {
+		bytes = mmap(NULL, size, PROT_READ | PROT_WRITE,
+			     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (bytes == MAP_FAILED) {
+			return NULL;
+		}
+#ifdef MADV_HUGEPAGE
+		madvise(bytes, size, MADV_HUGEPAGE);
+#endif
+		return bytes;
+	}
+#endif
+#ifdef _WIN32
+	bytes = _aligned_malloc(size, PD_CANVAS_BYTES_ALIGNMENT);
+#else
+	if (posix_memalign(&bytes, PD_CANVAS_BYTES_ALIGNMENT, size) != 0) {
+		bytes = NULL;
+	}
+#endif
+	if (bytes) {
+		memset(bytes, 0, size);
+	}
+	return bytes;
+}
+
+void pd_canvas_free_bytes(uint8_t *bytes, size_t size)
+{
+#ifdef __linux__
+	if (size >= PD_CANVAS_LARGE_BUFFER_SIZE) {
+		munmap(bytes, size);
+		return;
+	}
+#endif
+#ifdef _WIN32
+	_aligned_free(bytes);
+#else
+	free(bytes);
+#endif
+}
+
 int pd_canvas_create(pd_canvas_t *canvas, unsigned width, unsigned height)
+{
+	return pd_canvas_create_aligned(canvas, width, height, 0);
+}
+
+int pd_canvas_create_aligned(pd_canvas_t *canvas, unsigned width,
+			     unsigned height, unsigned alignment)
 {
 	size_t size;
 	if (width > 100000 || height > 100000) {
 		logger_error("canvas size is too large!");
 		abort();
 	}
+	if (alignment > PD_CANVAS_BYTES_ALIGNMENT ||
+	    (alignment & (alignment - 1)) != 0) {
+		return -1;
+	}
 	if (width < 1 || height < 1) {
 		pd_canvas_destroy(canvas);
 		return -1;
 	}
 	canvas->bytes_per_pixel = pd_get_pixel_size(canvas->color_type);
-	canvas->bytes_per_row =
-	    pd_get_pixel_row_size(canvas->color_type, width);
-	size = canvas->bytes_per_row * height;
+	canvas->bytes_per_row = (unsigned)pd_canvas_get_row_size(
+	    canvas->color_type, width, alignment);
+	size = (size_t)canvas->bytes_per_row * height;
 	if (pd_canvas_is_valid(canvas)) {
 		/* 如果现有图形尺寸大于要创建的图形的尺寸，直接改尺寸即可 */
 		if (canvas->mem_size >= size) {
@@ -140,30 +217,48 @@ int pd_canvas_create(pd_canvas_t *canvas, unsigned width, unsigned height)
 		}
 		pd_canvas_destroy(canvas);
 	}
-	canvas->mem_size = size;
-	canvas->bytes = calloc(1, size);
+	canvas->bytes = pd_canvas_alloc_bytes(size);
 	if (!canvas->bytes) {
+		canvas->mem_size = 0;
 		canvas->width = 0;
 		canvas->height = 0;
 		return -2;
 	}
+	canvas->mem_size = size;
 	canvas->width = width;
 	canvas->height = height;
 	return 0;
 }
 
+/**
+ * Check whether the rows of the columns follow each other in memory, so they
+ * can be processed as one row
+ */
+static bool pd_canvas_rows_are_contiguous(const pd_canvas_t *canvas, int x,
+					  int width)
+{
+	return x == 0 && (unsigned)width == canvas->width &&
+	       canvas->bytes_per_row == canvas->width * canvas->bytes_per_pixel;
+}
+
 static void pd_canvas_direct_replace(pd_canvas_t *des, pd_rect_t des_rect,
 				     const pd_canvas_t *src, int src_x,
 				     int src_y)
 {
-	int y;
+	int y, rows = des_rect.height;
+	size_t count = des_rect.width;
 	uint8_t *byte_row_des, *byte_row_src;
 
+	if (pd_canvas_rows_are_contiguous(des, des_rect.x, des_rect.width) &&
+	    pd_canvas_rows_are_contiguous(src, src_x, des_rect.width)) {
+		count *= rows;
+		rows = 1;
+	}
 	byte_row_src = pd_canvas_pixel_at(src, src_x, src_y);
 	byte_row_des = pd_canvas_pixel_at(des, des_rect.x, des_rect.y);
-	for (y = 0; y < des_rect.height; ++y) {
+	for (y = 0; y < rows; ++y) {
 		pd_format_pixels(byte_row_src, src->color_type, byte_row_des,
-				 des->color_type, des_rect.width);
+				 des->color_type, count);
 		byte_row_src += src->bytes_per_row;
 		byte_row_des += des->bytes_per_row;
 	}
@@ -209,9 +304,18 @@ int pd_canvas_replace(pd_canvas_t *back, const pd_canvas_t *fore, int left,
 	fore = pd_canvas_get_quote_source_readonly(fore);
 	switch (fore->color_type) {
 	case PD_COLOR_TYPE_RGB888:
+	case PD_COLOR_TYPE_RGB565:
 	case PD_COLOR_TYPE_ARGB8888:
+	case PD_COLOR_TYPE_PARGB8888:
 		pd_canvas_direct_replace(back, write_rect, fore, left, top);
 		return 0;
+	case PD_COLOR_TYPE_A8:
+		if (back->color_type == PD_COLOR_TYPE_A8) {
+			pd_canvas_direct_replace(back, write_rect, fore, left,
+						 top);
+			return 0;
+		}
+		break;
 	default:
 		break;
 	}
@@ -226,6 +330,7 @@ int pd_canvas_set_color_type(pd_canvas_t *canvas, int color_type)
 		return -1;
 	}
 	pd_canvas_init(&tmp);
+	tmp.color_type = color_type;
 	pd_canvas_create(&tmp, canvas->width, canvas->height);
 	if (pd_canvas_replace(&tmp, canvas, 0, 0) == 0) {
 		pd_canvas_destroy(canvas);
@@ -236,6 +341,25 @@ int pd_canvas_set_color_type(pd_canvas_t *canvas, int color_type)
 	return -1;
 }
 
+int pd_canvas_premultiply(pd_canvas_t *canvas)
+{
+	int x, y;
+	pd_color_t *p;
+
+	if (!pd_canvas_is_valid(canvas) || canvas->quote.is_valid ||
+	    canvas->color_type != PD_COLOR_TYPE_ARGB8888) {
+		return -1;
+	}
+	for (y = 0; y < canvas->height; ++y) {
+		p = pd_canvas_pixel_at(canvas, 0, y);
+		for (x = 0; x < canvas->width; ++x, ++p) {
+			pd_premultiply_pixel(p);
+		}
+	}
+	canvas->color_type = PD_COLOR_TYPE_PARGB8888;
+	return 0;
+}
+
 int pd_canvas_cut(const pd_canvas_t *canvas, pd_rect_t rect,
 		  pd_canvas_t *out_canvas)
 {
@@ -258,7 +382,8 @@ int pd_canvas_cut(const pd_canvas_t *canvas, pd_rect_t rect,
 	src_row = canvas->bytes + rect.y * canvas->bytes_per_row +
 		  rect.x * canvas->bytes_per_pixel;
 	for (y = 0; y < rect.height; ++y) {
-		memcpy(des_row, src_row, out_canvas->bytes_per_row);
+		memcpy(des_row, src_row,
+		       (size_t)rect.width * out_canvas->bytes_per_pixel);
 		des_row += out_canvas->bytes_per_row;
 		src_row += canvas->bytes_per_row;
 	}
@@ -280,100 +405,133 @@ void pd_canvas_copy(pd_canvas_t *des, const pd_canvas_t *src)
 	des->opacity = src->opacity;
 }
 
-/* FIXME: improve alpha blending method
- * Existing alpha blending methods are inefficient and need to be optimized
- */
+size_t pd_canvas_scroll(pd_canvas_t *canvas, const pd_rect_t *rect, int dx,
+			int dy)
+{
+	int y, step;
+	size_t row_size;
+	pd_rect_t area, dest;
+	uint8_t *src_row, *dest_row;
+
+	if (!pd_canvas_is_valid(canvas)) {
+		return 0;
+	}
+	area = *rect;
+	pd_rect_correct(&area, canvas->width, canvas->height);
+	if (canvas->quote.is_valid) {
+		area.x += canvas->quote.left;
+		area.y += canvas->quote.top;
+		canvas = canvas->quote.source;
+	}
+	dest.x = dx > 0 ? area.x + dx : area.x;
+	dest.y = dy > 0 ? area.y + dy : area.y;
+	dest.width = area.width - (dx > 0 ? dx : -dx);
+	dest.height = area.height - (dy > 0 ? dy : -dy);
+	if (dest.width <= 0 || dest.height <= 0 || (dx == 0 && dy == 0)) {
+		return 0;
+	}
+	row_size = (size_t)dest.width * canvas->bytes_per_pixel;
+	dest_row = canvas->bytes + dest.y * canvas->bytes_per_row +
+		   dest.x * canvas->bytes_per_pixel;
+	step = (int)canvas->bytes_per_row;
+	src_row = dest_row - dy * step - dx * (int)canvas->bytes_per_pixel;
+	/* Copy the rows from the bottom up if they are moved down, so the
+	 * source rows are not overwritten before they are copied */
+	if (dy > 0) {
+		dest_row += (dest.height - 1) * step;
+		src_row += (dest.height - 1) * step;
+		step = -step;
+	}
+	for (y = 0; y < dest.height; ++y) {
+		memmove(dest_row, src_row, row_size);
+		dest_row += step;
+		src_row += step;
+	}
+	return row_size * dest.height;
+}
 
 static void pd_canvas_mix_argb_with_alpha(pd_canvas_t *des, pd_rect_t des_rect,
 					  const pd_canvas_t *src, int src_x,
 					  int src_y)
 {
-	int x, y;
-	pd_color_t *px_src, *px_des;
+	int y;
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
 
 	for (y = 0; y < des_rect.height; ++y) {
-		px_src = pd_canvas_pixel_at(src, src_x, src_y + y);
-		px_des = pd_canvas_pixel_at(des, des_rect.x, des_rect.y + y);
-		for (x = 0; x < des_rect.width; ++x) {
-			pd_over_pixel(px_des, px_src, src->opacity);
-			++px_src;
-			++px_des;
-		}
+		kernels->mix_argb_with_alpha(
+		    pd_canvas_pixel_at(des, des_rect.x, des_rect.y + y),
+		    pd_canvas_pixel_at(src, src_x, src_y + y), des_rect.width,
+		    src->opacity);
 	}
 }
 
 static void pd_canvas_mix_argb(pd_canvas_t *dest, pd_rect_t des_rect,
 			       const pd_canvas_t *src, int src_x, int src_y)
 {
-	int x, y;
-	uint8_t a;
-	pd_color_t *px_src, *px_dest;
+	int y;
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
 
 	for (y = 0; y < des_rect.height; ++y) {
-		px_src = pd_canvas_pixel_at(src, src_x, src_y + y);
-		px_dest = pd_canvas_pixel_at(dest, des_rect.x, des_rect.y + y);
-		if (src->opacity < 1.0) {
-			for (x = 0; x < des_rect.width; ++x) {
-				a = (uint8_t)(px_src->a * src->opacity);
-				pd_blend_pixel(px_dest, px_src, a);
-				++px_src;
-				++px_dest;
-			}
-			continue;
-		}
-		for (x = 0; x < des_rect.width; ++x) {
-			pd_blend_pixel(px_dest, px_src, px_src->a);
-			++px_src;
-			++px_dest;
-		}
+		kernels->mix_argb(
+		    pd_canvas_pixel_at(dest, des_rect.x, des_rect.y + y),
+		    pd_canvas_pixel_at(src, src_x, src_y + y), des_rect.width,
+		    src->opacity);
 	}
 }
 
 static void pd_canvas_mix_argb2rgb(pd_canvas_t *des, pd_rect_t des_rect,
 				   const pd_canvas_t *src, int src_x, int src_y)
 {
-	int x, y;
-	uint8_t a;
-	pd_color_t *px, *px_row;
-	uint8_t *rowbytep, *bytep;
+	int y;
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
+
+	for (y = 0; y < des_rect.height; ++y) {
+		kernels->mix_argb2rgb(
+		    pd_canvas_pixel_at(des, des_rect.x, des_rect.y + y),
+		    pd_canvas_pixel_at(src, src_x, src_y + y), des_rect.width,
+		    src->opacity);
+	}
+}
+
+static void pd_canvas_mix_rows(pd_canvas_t *des, pd_rect_t des_rect,
+			       const pd_canvas_t *src, int src_x, int src_y,
+			       pd_blend_argb_row_func_t mix)
+{
+	int y;
 
-	/* 计算并保存第一行的首个像素的位置 */
-	px_row = pd_canvas_pixel_at(src, src_x, src_y);
-	rowbytep = pd_canvas_pixel_at(des, des_rect.x, des_rect.y);
-	if (src->opacity < 1.0) {
-		goto mix_with_opacity;
+	for (y = 0; y < des_rect.height; ++y) {
+		mix(pd_canvas_pixel_at(des, des_rect.x, des_rect.y + y),
+		    pd_canvas_pixel_at(src, src_x, src_y + y), des_rect.width,
+		    src->opacity);
 	}
+}
+
+static void pd_canvas_mix_rgb565_rows(pd_canvas_t *des, pd_rect_t des_rect,
+				      const pd_canvas_t *src, int src_x,
+				      int src_y,
+				      pd_blend_argb2rgb565_row_func_t mix)
+{
+	int y;
+
 	for (y = 0; y < des_rect.height; ++y) {
-		px = px_row;
-		bytep = rowbytep;
-		for (x = 0; x < des_rect.width; ++x, ++px) {
-			*bytep = _pd_alpha_blend(*bytep, px->b, px->a);
-			++bytep;
-			*bytep = _pd_alpha_blend(*bytep, px->g, px->a);
-			++bytep;
-			*bytep = _pd_alpha_blend(*bytep, px->r, px->a);
-			++bytep;
-		}
-		rowbytep += des->bytes_per_row;
-		px_row += src->width;
+		mix(pd_canvas_pixel_at(des, des_rect.x, des_rect.y + y),
+		    pd_canvas_pixel_at(src, src_x, src_y + y), des_rect.width,
+		    src->opacity);
 	}
-	return;
+}
+
+static void pd_canvas_mix_pargb2rgb(pd_canvas_t *des, pd_rect_t des_rect,
+				    const pd_canvas_t *src, int src_x,
+				    int src_y)
+{
+	int y;
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
 
-mix_with_opacity:
 	for (y = 0; y < des_rect.height; ++y) {
-		px = px_row;
-		bytep = rowbytep;
-		for (x = 0; x < des_rect.width; ++x, ++px) {
-			a = (uint8_t)(px->a * src->opacity);
-			*bytep = _pd_alpha_blend(*bytep, px->b, a);
-			++bytep;
-			*bytep = _pd_alpha_blend(*bytep, px->g, a);
-			++bytep;
-			*bytep = _pd_alpha_blend(*bytep, px->r, a);
-			++bytep;
-		}
-		rowbytep += des->bytes_per_row;
-		px_row += src->width;
+		kernels->mix_pargb2rgb(
+		    pd_canvas_pixel_at(des, des_rect.x, des_rect.y + y),
+		    pd_canvas_pixel_at(src, src_x, src_y + y), des_rect.width,
+		    src->opacity);
 	}
 }
 
@@ -410,6 +568,7 @@ int pd_canvas_mix(pd_canvas_t *back, const pd_canvas_t *fore, int left, int top,
 	back = pd_canvas_get_quote_source(back);
 	switch (fore->color_type) {
 	case PD_COLOR_TYPE_RGB888:
+	case PD_COLOR_TYPE_RGB565:
 		pd_canvas_direct_replace(back, w_rect, fore, left, top);
 		return 0;
 	case PD_COLOR_TYPE_ARGB8888:
@@ -417,39 +576,227 @@ int pd_canvas_mix(pd_canvas_t *back, const pd_canvas_t *fore, int left, int top,
 			pd_canvas_mix_argb2rgb(back, w_rect, fore, left, top);
 			return 0;
 		}
+		if (back->color_type == PD_COLOR_TYPE_RGB565) {
+			pd_canvas_mix_rgb565_rows(
+			    back, w_rect, fore, left, top,
+			    pd_get_blend_kernels()->mix_argb2rgb565);
+			return 0;
+		}
+		if (back->color_type == PD_COLOR_TYPE_PARGB8888) {
+			pd_canvas_mix_rows(back, w_rect, fore, left, top,
+					   pd_get_blend_kernels()->mix_argb2pargb);
+			return 0;
+		}
 		if (!with_alpha) {
 			pd_canvas_mix_argb(back, w_rect, fore, left, top);
 			return 0;
 		}
 		pd_canvas_mix_argb_with_alpha(back, w_rect, fore, left, top);
 		return 0;
+	case PD_COLOR_TYPE_PARGB8888:
+		switch (back->color_type) {
+		case PD_COLOR_TYPE_RGB888:
+			pd_canvas_mix_pargb2rgb(back, w_rect, fore, left, top);
+			return 0;
+		case PD_COLOR_TYPE_RGB565:
+			pd_canvas_mix_rgb565_rows(
+			    back, w_rect, fore, left, top,
+			    pd_get_blend_kernels()->mix_pargb2rgb565);
+			return 0;
+		case PD_COLOR_TYPE_ARGB8888:
+			pd_canvas_mix_rows(back, w_rect, fore, left, top,
+					   pd_get_blend_kernels()->mix_pargb2argb);
+			return 0;
+		case PD_COLOR_TYPE_PARGB8888:
+			pd_canvas_mix_rows(back, w_rect, fore, left, top,
+					   pd_get_blend_kernels()->mix_pargb);
+			return 0;
+		default:
+			break;
+		}
+		break;
 	default:
 		break;
 	}
 	return -3;
 }
 
+int pd_canvas_mix_mask(pd_canvas_t *back, const pd_canvas_t *mask,
+		       pd_color_t color, int left, int top)
+{
+	int y;
+	pd_canvas_t w_slot;
+	pd_rect_t r_rect, w_rect, m_rect;
+	pd_blend_mask_color_row_func_t mix;
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
+
+	if (!pd_canvas_is_valid(back) || !pd_canvas_is_valid(mask)) {
+		return -1;
+	}
+	w_rect.x = left;
+	w_rect.y = top;
+	w_rect.width = mask->width;
+	w_rect.height = mask->height;
+	r_rect = pd_rect_crop(&w_rect, back->width, back->height);
+	w_rect.x += r_rect.x;
+	w_rect.y += r_rect.y;
+	w_rect.width = r_rect.width;
+	w_rect.height = r_rect.height;
+	pd_canvas_quote(&w_slot, back, &w_rect);
+	pd_canvas_get_quote_rect(&w_slot, &w_rect);
+	/* The mask is read from where it is cropped, so a mask placed at a
+	 * negative position is not shifted */
+	pd_canvas_get_quote_rect(mask, &m_rect);
+	r_rect.x += m_rect.x;
+	r_rect.y += m_rect.y;
+	if (w_rect.width <= 0 || w_rect.height <= 0 || r_rect.width <= 0 ||
+	    r_rect.height <= 0) {
+		return -2;
+	}
+	if (mask->opacity < 1.0) {
+		color.a = (uint8_t)(color.a * mask->opacity);
+	}
+	mask = pd_canvas_get_quote_source_readonly(mask);
+	back = pd_canvas_get_quote_source(back);
+	if (mask->color_type != PD_COLOR_TYPE_A8) {
+		return -3;
+	}
+	switch (back->color_type) {
+	case PD_COLOR_TYPE_RGB888:
+		mix = kernels->mix_mask_rgb;
+		break;
+	case PD_COLOR_TYPE_ARGB8888:
+		mix = kernels->mix_mask_argb;
+		break;
+	case PD_COLOR_TYPE_PARGB8888:
+		mix = kernels->mix_mask_pargb;
+		break;
+	case PD_COLOR_TYPE_A8:
+		mix = kernels->mix_mask_a8;
+		break;
+	case PD_COLOR_TYPE_RGB565:
+		mix = kernels->mix_mask_rgb565;
+		break;
+	default:
+		return -3;
+	}
+	for (y = 0; y < w_rect.height; ++y) {
+		mix(pd_canvas_pixel_at(back, w_rect.x, w_rect.y + y),
+		    pd_canvas_pixel_at(mask, r_rect.x, r_rect.y + y),
+		    w_rect.width, color);
+	}
+	return 0;
+}
+
+void pd_fill_argb_row(uint8_t *dst, pd_color_t color, size_t count)
+{
+	size_t x;
+	pd_color_t *p = (pd_color_t *)dst;
+
+	for (x = 0; x < count; ++x) {
+		p[x] = color;
+	}
+}
+
+void pd_fill_rgb_row(uint8_t *dst, pd_color_t color, size_t count)
+{
+	size_t x;
+
+	for (x = 0; x < count; ++x) {
+		*dst++ = color.b;
+		*dst++ = color.g;
+		*dst++ = color.r;
+	}
+}
+
+void pd_fill_rgb565_row(uint8_t *dst, pd_color_t color, size_t count)
+{
+	size_t x;
+	uint16_t *p = (uint16_t *)dst;
+	uint16_t px = pd_color_to_rgb565(color);
+
+	for (x = 0; x < count; ++x) {
+		p[x] = px;
+	}
+}
+
+/**
+ * Check whether all bytes of the pixel of the color are the same, such as
+ * black, white and transparent, so the pixels can be filled by memset()
+ */
+static bool pd_get_fill_byte(pd_color_type_t color_type, pd_color_t color,
+			     uint8_t *byte)
+{
+	uint16_t px;
+
+	*byte = color.b;
+	switch (color_type) {
+	case PD_COLOR_TYPE_A8:
+		*byte = color.a;
+		return true;
+	case PD_COLOR_TYPE_RGB565:
+		px = pd_color_to_rgb565(color);
+		*byte = (uint8_t)px;
+		return (px >> 8) == *byte;
+	case PD_COLOR_TYPE_RGB888:
+		return color.g == color.b && color.r == color.b;
+	case PD_COLOR_TYPE_ARGB8888:
+	case PD_COLOR_TYPE_PARGB8888:
+		return color.g == color.b && color.r == color.b &&
+		       color.a == color.b;
+	default:
+		break;
+	}
+	return false;
+}
+
 int pd_canvas_fill_rect(pd_canvas_t *canvas, pd_color_t color, pd_rect_t rect)
 {
-	int x, y;
-	unsigned char *p;
+	int y, rows;
+	uint8_t byte;
+	size_t count;
+	pd_fill_row_func_t fill;
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
 
 	if (pd_canvas_begin_writing(&canvas, &rect) != 0) {
 		return -1;
 	}
-	for (y = 0; y < rect.height; ++y) {
-		p = pd_canvas_pixel_at(canvas, rect.x, rect.y + y);
-		if (canvas->color_type == PD_COLOR_TYPE_ARGB8888) {
-			for (x = 0; x < rect.width; ++x, p += 4) {
-				*(pd_color_t *)p = color;
-			}
-		} else {
-			for (x = 0; x < rect.width; ++x) {
-				*p++ = color.b;
-				*p++ = color.g;
-				*p++ = color.r;
-			}
+	switch (canvas->color_type) {
+	case PD_COLOR_TYPE_PARGB8888:
+		pd_premultiply_pixel(&color);
+		fill = kernels->fill_argb;
+		break;
+	case PD_COLOR_TYPE_ARGB8888:
+		fill = kernels->fill_argb;
+		break;
+	case PD_COLOR_TYPE_RGB888:
+		fill = kernels->fill_rgb;
+		break;
+	case PD_COLOR_TYPE_RGB565:
+		fill = kernels->fill_rgb565;
+		break;
+	case PD_COLOR_TYPE_A8:
+		fill = NULL;
+		break;
+	default:
+		return -1;
+	}
+	rows = rect.height;
+	count = rect.width;
+	if (pd_canvas_rows_are_contiguous(canvas, rect.x, rect.width)) {
+		count *= rows;
+		rows = 1;
+	}
+	if (pd_get_fill_byte(canvas->color_type, color, &byte)) {
+		for (y = 0; y < rows; ++y) {
+			memset(pd_canvas_pixel_at(canvas, rect.x, rect.y + y),
+			       byte, count * canvas->bytes_per_pixel);
 		}
+		return 0;
+	}
+	for (y = 0; y < rows; ++y) {
+		fill(pd_canvas_pixel_at(canvas, rect.x, rect.y + y), color,
+		     count);
 	}
 	return 0;
 }
@@ -0,0 +1,42 @@
+﻿/*
+ * lib/pandagl/src/canvas_alloc.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifndef LIB_PANDAGL_SRC_CANVAS_ALLOC_H
+#define LIB_PANDAGL_SRC_CANVAS_ALLOC_H
+
+#include <pandagl/common.h>
+#include <pandagl/types.h>
+
+/** Alignment of the pixel buffers, large enough for AVX2 and cache lines */
+#define PD_CANVAS_BYTES_ALIGNMENT 64
+
+/**
+ * Buffers of at least this size, such as window-sized canvases, are mapped
+ * directly and backed by large pages when the system supports them
+ */
+#define PD_CANVAS_LARGE_BUFFER_SIZE (2 * 1024 * 1024)
+
+/**
+ * Get the size of a row of pixels padded to the alignment, 0 means the
+ * default 4-byte alignment
+ */
+size_t pd_canvas_get_row_size(pd_color_type_t color_type, unsigned width,
+			      unsigned alignment);
+
+/**
+ * Allocate a zero-filled pixel buffer aligned to PD_CANVAS_BYTES_ALIGNMENT,
+ * it must be freed by pd_canvas_free_bytes() with the same size
+ */
+uint8_t *pd_canvas_alloc_bytes(size_t size);
+
+void pd_canvas_free_bytes(uint8_t *bytes, size_t size);
+
+#endif
@@ -0,0 +1,201 @@
+﻿/*
+ * lib/pandagl/src/canvas_pool.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <pandagl.h>
+#include "canvas_alloc.h"
+
+/*
+ * Buffers are grouped into size classes: one class for sizes up to
+ * 2^MIN_SHIFT bytes, then four classes per power of two, so a buffer
+ * wastes at most 25% of its size. Buffers larger than 2^MAX_SHIFT bytes
+ * are not pooled.
+ */
+#define MIN_SHIFT 12
+#define MAX_SHIFT 28
+#define SUB_CLASSES 4
+#define NUM_CLASSES (1 + (MAX_SHIFT - MIN_SHIFT) * SUB_CLASSES)
+#define DEFAULT_MAX_FREE_MEMORY (32 * 1024 * 1024)
+
+typedef struct pd_canvas_pool_block pd_canvas_pool_block_t;
+
+/** The free block header, it is stored in the first bytes of the buffer */
+struct pd_canvas_pool_block {
+	pd_canvas_pool_block_t *next;
+};
+
+struct pd_canvas_pool {
+	size_t max_free_memory;
+	size_t free_memory;
+	pd_canvas_pool_stats_t stats;
+	pd_canvas_pool_block_t *free_blocks[NUM_CLASSES];
+};
+
+static size_t pd_canvas_pool_class_size(int index)
+{
+	int shift;
+
+	if (index == 0) {
+		return (size_t)1 << MIN_SHIFT;
+	}
+	index -= 1;
+	shift = MIN_SHIFT + index / SUB_CLASSES;
+	return ((size_t)1 << shift) +
+	       ((size_t)(index % SUB_CLASSES + 1) << (shift - 2));
+}
+
+/** Get the index of the smallest size class that can hold the size */
+static int pd_canvas_pool_class_index(size_t size)
+{
+	int shift = MIN_SHIFT;
+	size_t step;
+
+	if (size <= (size_t)1 << MIN_SHIFT) {
+		return 0;
+	}
+	if (size > (size_t)1 << MAX_SHIFT) {
+		return -1;
+	}
+	while (((size_t)1 << (shift + 1)) < size) {
+		++shift;
+	}
+	step = (size_t)1 << (shift - 2);
+	return 1 + (shift - MIN_SHIFT) * SUB_CLASSES +
+	       (int)((size - ((size_t)1 << shift) + step - 1) / step) - 1;
+}
+
+pd_canvas_pool_t *pd_canvas_pool_create(size_t max_free_memory)
+{
+	pd_canvas_pool_t *pool;
+
+	pool = calloc(1, sizeof(pd_canvas_pool_t));
+	if (!pool) {
+		return NULL;
+	}
+	if (max_free_memory == 0) {
+		max_free_memory = DEFAULT_MAX_FREE_MEMORY;
+	}
+	pool->max_free_memory = max_free_memory;
+	return pool;
+}
+
+void pd_canvas_pool_trim(pd_canvas_pool_t *pool)
+{
+	int i;
+	pd_canvas_pool_block_t *block;
+
+	for (i = 0; i < NUM_CLASSES; ++i) {
+		while (pool->free_blocks[i]) {
+			block = pool->free_blocks[i];
+			pool->free_blocks[i] = block->next;
+			pd_canvas_free_bytes((uint8_t *)block,
+					     pd_canvas_pool_class_size(i));
+		}
+	}
+	pool->stats.memory -= pool->free_memory;
+	pool->free_memory = 0;
+}
+
+void pd_canvas_pool_destroy(pd_canvas_pool_t *pool)
+{
+	pd_canvas_pool_trim(pool);
+	free(pool);
+}
+
+int pd_canvas_pool_alloc(pd_canvas_pool_t *pool, pd_canvas_t *canvas,
+			 unsigned width, unsigned height)
+{
+	int index;
+	size_t size, mem_size;
+	pd_canvas_pool_block_t *block = NULL;
+
+	if (width > 100000 || height > 100000) {
+		logger_error("canvas size is too large!");
+		abort();
+	}
+	if (width < 1 || height < 1) {
+		return -1;
+	}
+	canvas->quote.is_valid = false;
+	canvas->quote.source = NULL;
+	canvas->bytes_per_pixel = pd_get_pixel_size(canvas->color_type);
+	canvas->bytes_per_row =
+	    (unsigned)pd_canvas_get_row_size(canvas->color_type, width, 0);
+	size = (size_t)canvas->bytes_per_row * height;
+	index = pd_canvas_pool_class_index(size);
+	if (index < 0) {
+		mem_size = size;
+	} else {
+		mem_size = pd_canvas_pool_class_size(index);
+		block = pool->free_blocks[index];
+	}
+	pool->stats.allocs++;
+	if (block) {
+		pool->free_blocks[index] = block->next;
+		pool->free_memory -= mem_size;
+		pool->stats.reuses++;
+		/* Only the used part needs to be cleared */
+		memset(block, 0, size);
+		canvas->bytes = (uint8_t *)block;
+	} else {
+		canvas->bytes = pd_canvas_alloc_bytes(mem_size);
+		if (!canvas->bytes) {
+			canvas->width = 0;
+			canvas->height = 0;
+			canvas->mem_size = 0;
+			return -2;
+		}
+		pool->stats.memory += mem_size;
+		if (pool->stats.memory > pool->stats.peak_memory) {
+			pool->stats.peak_memory = pool->stats.memory;
+		}
+	}
+	pool->stats.used_memory += mem_size;
+	canvas->mem_size = mem_size;
+	canvas->width = width;
+	canvas->height = height;
+	canvas->opacity = 1.0;
+	return 0;
+}
+
+void pd_canvas_pool_free(pd_canvas_pool_t *pool, pd_canvas_t *canvas)
+{
+	int index;
+	pd_canvas_pool_block_t *block;
+
+	if (canvas->quote.is_valid || !canvas->bytes) {
+		pd_canvas_destroy(canvas);
+		return;
+	}
+	index = pd_canvas_pool_class_index(canvas->mem_size);
+	pool->stats.used_memory -= canvas->mem_size;
+	if (index >= 0 && pd_canvas_pool_class_size(index) == canvas->mem_size &&
+	    pool->free_memory + canvas->mem_size <= pool->max_free_memory) {
+		block = (pd_canvas_pool_block_t *)canvas->bytes;
+		block->next = pool->free_blocks[index];
+		pool->free_blocks[index] = block;
+		pool->free_memory += canvas->mem_size;
+	} else {
+		pool->stats.memory -= canvas->mem_size;
+		pd_canvas_free_bytes(canvas->bytes, canvas->mem_size);
+	}
+	canvas->bytes = NULL;
+	canvas->width = 0;
+	canvas->height = 0;
+	canvas->mem_size = 0;
+}
+
+void pd_canvas_pool_get_stats(pd_canvas_pool_t *pool,
+			      pd_canvas_pool_stats_t *stats)
+{
+	*stats = pool->stats;
+}
@@ -14,6 +14,7 @@
 int pd_canvas_veri_flip(const pd_canvas_t *canvas, pd_canvas_t *buff)
 {
 	int y;
+	size_t row_size;
 	pd_rect_t rect;
 	uint8_t *byte_src, *byte_des;
 
@@ -27,10 +28,11 @@ int pd_canvas_veri_flip(const pd_canvas_t *canvas, pd_canvas_t *buff)
 	if (0 != pd_canvas_create(buff, rect.width, rect.height)) {
 		return -2;
 	}
+	row_size = (size_t)rect.width * buff->bytes_per_pixel;
 	byte_src = pd_canvas_pixel_at(canvas, rect.x, rect.y + rect.height - 1);
 	byte_des = buff->bytes;
 	for (y = 0; y < rect.height; ++y) {
-		memcpy(byte_des, byte_src, buff->bytes_per_row);
+		memcpy(byte_des, byte_src, row_size);
 		byte_src -= canvas->bytes_per_row;
 		byte_des += buff->bytes_per_row;
 	}
@@ -54,10 +56,10 @@ int pd_canvas_horiz_flip(const pd_canvas_t *canvas, pd_canvas_t *buff)
 		return -2;
 	}
 	for (y = 0; y < rect.height; ++y) {
-		dest = pd_canvas_pixel_at(buff, y, 0);
-		src = pd_canvas_pixel_at(canvas, rect.y + y,
-					 rect.x + rect.width - 1);
-		if (canvas->color_type == PD_COLOR_TYPE_ARGB) {
+		dest = pd_canvas_pixel_at(buff, 0, y);
+		src = pd_canvas_pixel_at(canvas, rect.x + rect.width - 1,
+					 rect.y + y);
+		if (canvas->bytes_per_pixel == 4) {
 			for (x = 0; x < rect.width; ++x) {
 				*(pd_color_t *)dest = *(pd_color_t *)src;
 				dest += canvas->bytes_per_pixel;
@@ -65,9 +67,7 @@ int pd_canvas_horiz_flip(const pd_canvas_t *canvas, pd_canvas_t *buff)
 			}
 		} else {
 			for (x = 0; x < rect.width; ++x) {
-				dest[0] = src[0];
-				dest[1] = src[1];
-				dest[2] = src[2];
+				memcpy(dest, src, canvas->bytes_per_pixel);
 				dest += canvas->bytes_per_pixel;
 				src -= canvas->bytes_per_pixel;
 			}
@@ -20,6 +20,7 @@ void pd_font_bitmap_init(pd_font_bitmap_t *bitmap)
 	bitmap->width = 0;
 	bitmap->top = 0;
 	bitmap->left = 0;
+	bitmap->pitch = 0;
 	bitmap->buffer = NULL;
 }
 
@@ -31,93 +32,25 @@ void pd_font_bitmap_destroy(pd_font_bitmap_t *bitmap)
 	pd_font_bitmap_init(bitmap);
 }
 
-static void pd_canvas_mix_font_bitmap_argb(pd_canvas_t *graph,
-					   pd_rect_t *write_rect,
-					   const pd_font_bitmap_t *bmp,
-					   pd_color_t color,
-					   pd_rect_t *read_rect)
-{
-	int x, y;
-	pd_color_t c;
-	pd_color_t *px, *px_row_des;
-	uint8_t *byte_ptr, *byte_row_ptr;
-
-	byte_row_ptr = bmp->buffer + read_rect->y * bmp->width;
-	px_row_des = graph->argb + write_rect->y * graph->width;
-	byte_row_ptr += read_rect->x;
-	px_row_des += write_rect->x;
-	for (y = 0; y < read_rect->height; ++y) {
-		px = px_row_des;
-		byte_ptr = byte_row_ptr;
-		for (x = 0; x < read_rect->width; ++x, ++byte_ptr, ++px) {
-			c = color;
-			c.alpha = (uint8_t)(*byte_ptr * color.alpha / 255.0);
-			pd_over_pixel(px, &c, 1.0);
-		}
-		px_row_des += graph->width;
-		byte_row_ptr += bmp->width;
-	}
-}
-
-static void pd_canvas_mix_font_bitmap_rgb(pd_canvas_t *graph,
-					  pd_rect_t *write_rect,
-					  const pd_font_bitmap_t *bmp,
-					  pd_color_t color,
-					  pd_rect_t *read_rect)
-{
-	int x, y;
-	uint8_t *byte_src, *byte_row_src, *byte_row_des, *byte_des, alpha;
-	byte_row_src = bmp->buffer + read_rect->y * bmp->width + read_rect->x;
-	byte_row_des = graph->bytes + write_rect->y * graph->bytes_per_row;
-	byte_row_des += write_rect->x * graph->bytes_per_pixel;
-	for (y = 0; y < read_rect->height; ++y) {
-		byte_src = byte_row_src;
-		byte_des = byte_row_des;
-		for (x = 0; x < read_rect->width; ++x) {
-			alpha = (uint8_t)(*byte_src * color.alpha / 255);
-			pd_alpha_blend(*byte_des, color.b, alpha);
-			++byte_des;
-			pd_alpha_blend(*byte_des, color.g, alpha);
-			++byte_des;
-			pd_alpha_blend(*byte_des, color.r, alpha);
-			++byte_des;
-			++byte_src;
-		}
-		byte_row_des += graph->bytes_per_row;
-		byte_row_src += bmp->width;
-	}
-}
-
 int pd_canvas_mix_font_bitmap(pd_canvas_t *graph, pd_pos_t pos,
 			      const pd_font_bitmap_t *bmp, pd_color_t color)
 {
-	pd_canvas_t write_slot;
-	pd_rect_t r_rect, w_rect;
+	pd_canvas_t mask;
 
 	if (pos.x > (int)graph->width || pos.y > (int)graph->height) {
 		return -2;
 	}
-	/* 获取写入区域 */
-	w_rect.x = pos.x;
-	w_rect.y = pos.y;
-	w_rect.width = bmp->width;
-	w_rect.height = bmp->rows;
-	/* 获取需要裁剪的区域 */
-	r_rect = pd_rect_crop(&w_rect, graph->width, graph->height);
-	w_rect.x += r_rect.x;
-	w_rect.y += r_rect.y;
-	w_rect.width = r_rect.width;
-	w_rect.height = r_rect.height;
-	pd_canvas_quote(&write_slot, graph, &w_rect);
-	pd_canvas_get_quote_rect(&write_slot, &w_rect);
-	/* 获取背景图引用的源图形 */
-	graph = pd_canvas_get_quote_source(graph);
-	if (graph->color_type == PD_COLOR_TYPE_ARGB) {
-		pd_canvas_mix_font_bitmap_argb(graph, &w_rect, bmp, color,
-					       &r_rect);
-	} else {
-		pd_canvas_mix_font_bitmap_rgb(graph, &w_rect, bmp, color,
-					      &r_rect);
+	if (!bmp->buffer || bmp->width < 1 || bmp->rows < 1) {
+		return -1;
 	}
-	return 0;
+	/* The glyph bitmap is used as an A8 canvas without copying it */
+	pd_canvas_init(&mask);
+	mask.color_type = PD_COLOR_TYPE_A8;
+	mask.bytes = bmp->buffer;
+	mask.width = bmp->width;
+	mask.height = bmp->rows;
+	mask.bytes_per_pixel = 1;
+	mask.bytes_per_row = bmp->pitch;
+	mask.mem_size = (size_t)bmp->pitch * bmp->rows;
+	return pd_canvas_mix_mask(graph, &mask, color, pos.x, pos.y);
 }
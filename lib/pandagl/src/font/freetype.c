@@ -15,33 +15,69 @@
 #ifdef PANDAGL_HAS_FREETYPE
 #include <stdlib.h>
 #include <errno.h>
+#include <thread.h>
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
-#include FT_GLYPH_H
 #include FT_OUTLINE_H
-#include FT_BITMAP_H
+#include FT_SIZES_H
 
 #define LCUI_FONT_RENDER_MODE FT_RENDER_MODE_NORMAL
 #define LCUI_FONT_LOAD_FALGS (FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT)
 
+/** Maximum number of size objects kept for each face */
+#define MAX_SIZES 16
+
+/**
+ * A size object of a face. Switching between the size objects keeps their
+ * scaled metrics and hinting state, which FT_Set_Pixel_Sizes() recomputes.
+ */
+typedef struct pd_freetype_size {
+	int pixel_size;
+	FT_Size size;
+	int ascender;
+	int max_advance;
+	int height;
+	list_node_t node;
+} pd_freetype_size_t;
+
+/**
+ * A face can only be used by one thread at a time, so the glyphs of a face
+ * are rendered one by one, while different faces are rendered in parallel
+ */
+typedef struct pd_freetype_face {
+	FT_Face face;
+	thread_mutex_t mutex;
+
+	/** list_t<pd_freetype_size_t*>, most recently used first */
+	list_t sizes;
+} pd_freetype_face_t;
+
 static struct {
 	FT_Library library;
+
+	/** Serializes the creation and destruction of faces */
+	thread_mutex_t mutex;
 } freetype;
 
 static int pd_freetype_open(const char *filepath, pd_font_t ***outfonts)
 {
 	FT_Face face;
 	pd_font_t *font, **fonts;
+	pd_freetype_face_t *data;
 	int i, err, num_faces;
 
+	thread_mutex_lock(&freetype.mutex);
 	err = FT_New_Face(freetype.library, filepath, -1, &face);
+	thread_mutex_unlock(&freetype.mutex);
 	if (err) {
 		*outfonts = NULL;
 		return -1;
 	}
 	num_faces = face->num_faces;
+	thread_mutex_lock(&freetype.mutex);
 	FT_Done_Face(face);
+	thread_mutex_unlock(&freetype.mutex);
 	if (num_faces < 1) {
 		return 0;
 	}
@@ -50,14 +86,24 @@ static int pd_freetype_open(const char *filepath, pd_font_t ***outfonts)
 		return -ENOMEM;
 	}
 	for (i = 0; i < num_faces; ++i) {
+		fonts[i] = NULL;
+		data = malloc(sizeof(pd_freetype_face_t));
+		if (!data) {
+			continue;
+		}
+		thread_mutex_lock(&freetype.mutex);
 		err = FT_New_Face(freetype.library, filepath, i, &face);
+		thread_mutex_unlock(&freetype.mutex);
 		if (err) {
-			fonts[i] = NULL;
+			free(data);
 			continue;
 		}
 		FT_Select_Charmap(face, FT_ENCODING_UNICODE);
+		data->face = face;
+		thread_mutex_init(&data->mutex);
+		list_create(&data->sizes);
 		font = pd_font_create(face->family_name, face->style_name);
-		font->data = face;
+		font->data = data;
 		fonts[i] = font;
 	}
 	*outfonts = fonts;
@@ -66,39 +112,87 @@ static int pd_freetype_open(const char *filepath, pd_font_t ***outfonts)
 
 static void pd_freetype_close(void *face)
 {
-	FT_Done_Face(face);
+	list_node_t *node;
+	pd_freetype_face_t *data = face;
+
+	/* The size objects are freed with the face */
+	while ((node = list_get_first_node(&data->sizes))) {
+		list_unlink(&data->sizes, node);
+		free(node->data);
+	}
+	thread_mutex_lock(&freetype.mutex);
+	FT_Done_Face(data->face);
+	thread_mutex_unlock(&freetype.mutex);
+	thread_mutex_destroy(&data->mutex);
+	free(data);
 }
 
-/** 转换 FT_GlyphSlot 类型数据为 pd_font_bitmap_t */
-static size_t convert_glyph(pd_font_bitmap_t *bmp, FT_GlyphSlot slot, int mode)
+/**
+ * Get the size object of the face for the pixel size and make it the active
+ * one, the least recently used size is dropped if there are too many
+ */
+static pd_freetype_size_t *pd_freetype_face_get_size(pd_freetype_face_t *data,
+						     int pixel_size)
 {
-	int error;
-	size_t size;
-	FT_BitmapGlyph bitmap_glyph;
-	FT_Glyph glyph;
-
-	/* 从字形槽中提取一个字形图像
-	 * 请注意，创建的FT_Glyph对象必须与FT_Done_Glyph成对使用 */
-	error = FT_Get_Glyph(slot, &glyph);
-	if (error) {
-		return -1;
+	FT_Size ft_size;
+	list_node_t *node;
+	pd_freetype_size_t *size;
+
+	for (list_each(node, &data->sizes)) {
+		size = node->data;
+		if (size->pixel_size != pixel_size) {
+			continue;
+		}
+		list_unlink(&data->sizes, node);
+		list_insert_node(&data->sizes, 0, node);
+		if (data->face->size != size->size) {
+			FT_Activate_Size(size->size);
+		}
+		return size;
+	}
+	if (FT_New_Size(data->face, &ft_size) != 0) {
+		return NULL;
+	}
+	FT_Activate_Size(ft_size);
+	if (FT_Set_Pixel_Sizes(data->face, 0, pixel_size) != 0) {
+		FT_Done_Size(ft_size);
+		return NULL;
 	}
-	/*---------------------- 打印字体信息 --------------------------
-	LOG(" width= %ld,  met->height= %ld\n"
-	"horiBearingX = %ld, horiBearingY = %ld, horiAdvance = %ld\n"
-	"vertBearingX = %ld, vertBearingY = %ld,  vertAdvance = %ld\n",
-	slot->metrics.width>>6, slot->metrics.height>>6,
-	slot->metrics.horiBearingX>>6, slot->metrics.horiBearingY>>6,
-	slot->metrics.horiAdvance>>6, slot->metrics.vertBearingX>>6,
-	slot->metrics.vertBearingY>>6, slot->metrics.vertAdvance>>6 );
-	------------------------------------------------------------*/
-	if (glyph->format != FT_GLYPH_FORMAT_BITMAP) {
-		error = FT_Glyph_To_Bitmap(&glyph, mode, 0, 1);
-		if (error) {
-			return -1;
+	if (data->sizes.length >= MAX_SIZES) {
+		node = list_get_last_node(&data->sizes);
+		list_unlink(&data->sizes, node);
+		size = node->data;
+		FT_Done_Size(size->size);
+	} else {
+		size = malloc(sizeof(pd_freetype_size_t));
+		if (!size) {
+			FT_Done_Size(ft_size);
+			return NULL;
 		}
+		size->node.data = size;
+	}
+	size->pixel_size = pixel_size;
+	size->size = ft_size;
+	size->ascender = ft_size->metrics.ascender >> 6;
+	size->max_advance = ft_size->metrics.max_advance >> 6;
+	size->height = ft_size->metrics.height >> 6;
+	list_insert_node(&data->sizes, 0, &size->node);
+	return size;
+}
+
+/** 转换 FT_GlyphSlot 类型数据为 pd_font_bitmap_t */
+static int convert_glyph(pd_font_bitmap_t *bmp, FT_GlyphSlot slot,
+			 const pd_freetype_size_t *size)
+{
+	int y;
+	uint8_t *row;
+	FT_Bitmap *bitmap = &slot->bitmap;
+
+	/* 字形通常已在载入时渲染，否则在字形槽中渲染，不再另外复制字形 */
+	if (slot->format != FT_GLYPH_FORMAT_BITMAP &&
+	    FT_Render_Glyph(slot, LCUI_FONT_RENDER_MODE) != 0) {
+		return -1;
 	}
-	bitmap_glyph = (FT_BitmapGlyph)glyph;
 	/*
 	 * FT_Glyph_Metrics结构体中保存字形度量，通过face->glyph->metrics结
 	 * 构访问，可得到字形的宽、高、左边界距、上边界距、水平跨距等等。
@@ -106,57 +200,49 @@ static size_t convert_glyph(pd_font_bitmap_t *bmp, FT_GlyphSlot slot, int mode)
 	 * vertBearingX，vertBearingY和vertAdvance的值是不可靠的，目前暂不考虑
 	 * 此情况的处理。
 	 * */
-	bmp->top = bitmap_glyph->top;
-	bmp->left = bitmap_glyph->left;
-	bmp->rows = bitmap_glyph->bitmap.rows;
-	bmp->width = bitmap_glyph->bitmap.width;
+	bmp->top = slot->bitmap_top;
+	bmp->left = slot->bitmap_left;
+	bmp->rows = bitmap->rows;
+	bmp->width = bitmap->width;
 	bmp->pitch = bmp->width * sizeof(uint8_t);
-	bmp->metrics.ascender = slot->face->size->metrics.ascender >> 6;
-	bmp->metrics.bbox_width = slot->face->size->metrics.max_advance >> 6;
-	bmp->metrics.bbox_height = slot->face->size->metrics.height >> 6;
+	bmp->metrics.ascender = size->ascender;
+	bmp->metrics.bbox_width = size->max_advance;
+	bmp->metrics.bbox_height = size->height;
 	bmp->metrics.hori_advance = slot->metrics.horiAdvance >> 6; /* 水平跨距 */
 	bmp->metrics.vert_advance = slot->metrics.vertAdvance >> 6; /* 垂直跨距 */
 	/* 分配内存，用于保存字体位图 */
-	size = bmp->rows * bmp->pitch;
-	bmp->buffer = (uint8_t *)malloc(size);
+	bmp->buffer = (uint8_t *)malloc((size_t)bmp->rows * bmp->pitch);
 	if (!bmp->buffer) {
-		FT_Done_Glyph(glyph);
 		return -1;
 	}
 
-	switch (bitmap_glyph->bitmap.pixel_mode) {
-		/* 8位灰度位图，直接拷贝 */
+	switch (bitmap->pixel_mode) {
+		/* 8位灰度位图，按行拷贝，源位图的行可能有填充 */
 	case FT_PIXEL_MODE_GRAY:
-		memcpy(bmp->buffer, bitmap_glyph->bitmap.buffer, size);
+		for (y = 0; y < bmp->rows; ++y) {
+			row = bitmap->buffer + y * bitmap->pitch;
+			memcpy(bmp->buffer + y * bmp->pitch, row, bmp->width);
+		}
 		break;
 		/* 单色点阵图，需要转换 */
 	case FT_PIXEL_MODE_MONO: {
-		FT_Bitmap bitmap;
-		FT_Int x, y;
-		uint8_t *bit_ptr, *byte_ptr;
-
-		FT_Bitmap_New(&bitmap);
-		/* 转换位图bitmap_glyph->bitmap至bitmap，1个像素占1个字节 */
-		FT_Bitmap_Convert(freetype.library, &bitmap_glyph->bitmap,
-				  &bitmap, 1);
-		bit_ptr = bitmap.buffer;
-		byte_ptr = bmp->buffer;
+		FT_Int x;
+
 		for (y = 0; y < bmp->rows; ++y) {
+			row = bitmap->buffer + y * bitmap->pitch;
 			for (x = 0; x < bmp->width; ++x) {
-				*byte_ptr = *bit_ptr ? 255 : 0;
-				++byte_ptr, ++bit_ptr;
+				bmp->buffer[y * bmp->pitch + x] =
+				    (row[x >> 3] & (0x80 >> (x & 7))) ? 255 : 0;
 			}
 		}
-		FT_Bitmap_Done(freetype.library, &bitmap);
 		break;
 	}
 	/* 其它像素模式的位图，暂时先直接填充255，等需要时再完善 */
 	default:
-		memset(bmp->buffer, 255, size);
+		memset(bmp->buffer, 255, (size_t)bmp->rows * bmp->pitch);
 		break;
 	}
-	FT_Done_Glyph(glyph);
-	return size;
+	return 0;
 }
 
 static int pd_freetype_render(pd_font_bitmap_t *bmp, unsigned ch,
@@ -164,19 +250,27 @@ static int pd_freetype_render(pd_font_bitmap_t *bmp, unsigned ch,
 {
 	int ret = 0;
 	FT_UInt index;
-	FT_Face ft_face = (FT_Face)font->data;
+	pd_freetype_size_t *size;
+	pd_freetype_face_t *data = font->data;
+	FT_Face ft_face = data->face;
 
-	/* 设定字体尺寸 */
-	FT_Set_Pixel_Sizes(ft_face, 0, pixel_size);
+	thread_mutex_lock(&data->mutex);
+	size = pd_freetype_face_get_size(data, pixel_size);
+	if (!size) {
+		thread_mutex_unlock(&data->mutex);
+		return -2;
+	}
 	index = FT_Get_Char_Index(ft_face, ch);
 	if (index == 0) {
 		ret = -1;
 	}
 	/* 载入该字的字形数据 */
 	if (FT_Load_Glyph(ft_face, index, LCUI_FONT_LOAD_FALGS) != 0) {
-		return -2;
+		ret = -2;
+	} else {
+		convert_glyph(bmp, ft_face->glyph, size);
 	}
-	convert_glyph(bmp, ft_face->glyph, LCUI_FONT_RENDER_MODE);
+	thread_mutex_unlock(&data->mutex);
 	return ret;
 }
 
@@ -185,6 +279,7 @@ int pd_freetype_engine_init(font_engine_t *engine)
 	if (FT_Init_FreeType(&freetype.library)) {
 		return -1;
 	}
+	thread_mutex_init(&freetype.mutex);
 	strcpy(engine->name, "FreeType");
 	engine->render = pd_freetype_render;
 	engine->open = pd_freetype_open;
@@ -195,6 +290,7 @@ int pd_freetype_engine_init(font_engine_t *engine)
 int pd_freetype_engine_destroy(void)
 {
 	FT_Done_FreeType(freetype.library);
+	thread_mutex_destroy(&freetype.mutex);
 	return 0;
 }
 
@@ -0,0 +1,534 @@
+﻿/*
+ * lib/pandagl/src/font/glyph_cache.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread.h>
+#include <pandagl.h>
+#include "bitmap.h"
+#include "glyph_cache.h"
+
+#define DEFAULT_MAX_MEMORY (8 * 1024 * 1024)
+#define MIN_CAPACITY 256
+
+/** Glyphs larger than a page get a page of their own size */
+#define PAGE_SIZE 256
+
+/**
+ * An A8 atlas page shared by the glyphs of a pixel size. The glyphs are
+ * packed into shelves from top to bottom, only the last shelf is open.
+ */
+typedef struct pd_glyph_page {
+	int size;
+	unsigned width;
+	unsigned height;
+	uint8_t *pixels;
+
+	unsigned shelf_x;
+	unsigned shelf_y;
+	unsigned shelf_height;
+
+	/** Memory of the page and its pixels */
+	size_t memory;
+
+	/** Number of entries in use, a used page is never evicted */
+	unsigned refs;
+
+	/** list_t<pd_glyph_entry_t*> */
+	list_t entries;
+
+	/** Node in the list of pages, most recently used first */
+	list_node_t node;
+} pd_glyph_page_t;
+
+typedef struct pd_glyph_entry {
+	/** The bitmap, it must be the first member */
+	pd_font_bitmap_t bitmap;
+
+	unsigned code;
+	int font_id;
+	int size;
+	unsigned hash;
+
+	/** Memory of the entry, the pixels are counted in the page */
+	size_t memory;
+
+	/** Number of users of the bitmap */
+	unsigned refs;
+
+	/** The entry was replaced while it was still used */
+	bool detached;
+
+	/** The page holding the pixels of the bitmap */
+	pd_glyph_page_t *page;
+
+	/** Node in the list of entries of the page */
+	list_node_t node;
+} pd_glyph_entry_t;
+
+struct pd_glyph_cache {
+	thread_mutex_t mutex;
+	pd_font_cache_stats_t stats;
+
+	/**
+	 * Open addressing table with linear probing, the capacity is a power
+	 * of two and the table is kept at most 3/4 full
+	 */
+	pd_glyph_entry_t **slots;
+	size_t capacity;
+
+	/** list_t<pd_glyph_page_t*>, most recently used first */
+	list_t pages;
+};
+
+static unsigned pd_glyph_hash(unsigned code, int font_id, int size)
+{
+	uint32_t h;
+
+	h = code * 0x9e3779b1u;
+	h ^= (uint32_t)font_id * 0x85ebca77u + (uint32_t)size * 0xc2b2ae3du;
+	h ^= h >> 15;
+	h *= 0x2c1b3c6du;
+	h ^= h >> 12;
+	return h;
+}
+
+static pd_glyph_page_t *pd_glyph_page_create(int size, unsigned width,
+					     unsigned height)
+{
+	pd_glyph_page_t *page;
+
+	page = calloc(1, sizeof(pd_glyph_page_t));
+	if (!page) {
+		return NULL;
+	}
+	page->pixels = malloc((size_t)width * height);
+	if (!page->pixels) {
+		free(page);
+		return NULL;
+	}
+	page->size = size;
+	page->width = width;
+	page->height = height;
+	page->memory = sizeof(pd_glyph_page_t) + (size_t)width * height;
+	page->node.data = page;
+	list_create(&page->entries);
+	return page;
+}
+
+static void pd_glyph_page_destroy(pd_glyph_page_t *page)
+{
+	list_node_t *node;
+
+	while ((node = list_get_first_node(&page->entries))) {
+		list_unlink(&page->entries, node);
+		free(node->data);
+	}
+	free(page->pixels);
+	free(page);
+}
+
+/**
+ * Reserve an area in the open shelf of the page, a new shelf is opened
+ * below it when the glyph does not fit in the rest of the row
+ */
+static bool pd_glyph_page_alloc(pd_glyph_page_t *page, unsigned width,
+				unsigned height, unsigned *x, unsigned *y)
+{
+	unsigned shelf_x = page->shelf_x;
+	unsigned shelf_y = page->shelf_y;
+	unsigned shelf_height = page->shelf_height;
+
+	if (width > page->width) {
+		return false;
+	}
+	if (shelf_x + width > page->width) {
+		shelf_y += shelf_height;
+		shelf_x = 0;
+		shelf_height = 0;
+	}
+	/* The open shelf is the last one, it can grow downwards */
+	if (height > shelf_height) {
+		shelf_height = height;
+	}
+	if (shelf_y + shelf_height > page->height) {
+		return false;
+	}
+	*x = shelf_x;
+	*y = shelf_y;
+	page->shelf_x = shelf_x + width;
+	page->shelf_y = shelf_y;
+	page->shelf_height = shelf_height;
+	return true;
+}
+
+/**
+ * Find the slot of the key
+ * @returns the index of the entry with the key, or of the empty slot where
+ * it should be inserted
+ */
+static size_t pd_glyph_cache_probe(pd_glyph_cache_t *cache, unsigned code,
+				   int font_id, int size, unsigned hash)
+{
+	size_t mask = cache->capacity - 1;
+	size_t i = hash & mask;
+	pd_glyph_entry_t *entry;
+
+	for (; (entry = cache->slots[i]); i = (i + 1) & mask) {
+		if (entry->hash == hash && entry->code == code &&
+		    entry->font_id == font_id && entry->size == size) {
+			break;
+		}
+	}
+	return i;
+}
+
+static int pd_glyph_cache_resize(pd_glyph_cache_t *cache, size_t capacity)
+{
+	size_t i, j, mask = capacity - 1;
+	pd_glyph_entry_t **slots;
+
+	slots = calloc(capacity, sizeof(pd_glyph_entry_t *));
+	if (!slots) {
+		return -ENOMEM;
+	}
+	for (i = 0; i < cache->capacity; ++i) {
+		if (!cache->slots[i]) {
+			continue;
+		}
+		for (j = cache->slots[i]->hash & mask; slots[j];
+		     j = (j + 1) & mask)
+			;
+		slots[j] = cache->slots[i];
+	}
+	free(cache->slots);
+	cache->slots = slots;
+	cache->capacity = capacity;
+	return 0;
+}
+
+/** Empty the slot and move the following entries back to fill the gap */
+static void pd_glyph_cache_remove_slot(pd_glyph_cache_t *cache, size_t i)
+{
+	size_t j, k, mask = cache->capacity - 1;
+
+	cache->slots[i] = NULL;
+	for (j = (i + 1) & mask; cache->slots[j]; j = (j + 1) & mask) {
+		k = cache->slots[j]->hash & mask;
+		/* The entry stays if its home slot is between the gap and it */
+		if (i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+			continue;
+		}
+		cache->slots[i] = cache->slots[j];
+		cache->slots[j] = NULL;
+		i = j;
+	}
+}
+
+static void pd_glyph_cache_remove_entry(pd_glyph_cache_t *cache,
+					pd_glyph_entry_t *entry)
+{
+	pd_glyph_cache_remove_slot(
+	    cache, pd_glyph_cache_probe(cache, entry->code, entry->font_id,
+					entry->size, entry->hash));
+	cache->stats.memory -= entry->memory;
+	cache->stats.entries--;
+}
+
+/**
+ * Remove the entry from the table, it is freed if no one uses it. Its area
+ * in the page is not reused until the page is evicted.
+ */
+static void pd_glyph_cache_unlink(pd_glyph_cache_t *cache,
+				  pd_glyph_entry_t *entry)
+{
+	pd_glyph_cache_remove_entry(cache, entry);
+	if (entry->refs > 0) {
+		entry->detached = true;
+		return;
+	}
+	list_unlink(&entry->page->entries, &entry->node);
+	free(entry);
+}
+
+/** Drop the page and all glyphs in it, none of them may be in use */
+static void pd_glyph_cache_drop_page(pd_glyph_cache_t *cache,
+				     pd_glyph_page_t *page)
+{
+	list_node_t *node;
+
+	for (list_each(node, &page->entries)) {
+		pd_glyph_cache_remove_entry(cache, node->data);
+		cache->stats.evictions++;
+	}
+	list_unlink(&cache->pages, &page->node);
+	cache->stats.memory -= page->memory;
+	cache->stats.pages--;
+	pd_glyph_page_destroy(page);
+}
+
+/** Drop least recently used pages until the memory fits the limit */
+static void pd_glyph_cache_evict(pd_glyph_cache_t *cache, size_t max_memory)
+{
+	list_node_t *node, *prev;
+	pd_glyph_page_t *page;
+
+	for (node = list_get_last_node(&cache->pages);
+	     node && node != &cache->pages.head &&
+	     cache->stats.memory > max_memory;
+	     node = prev) {
+		prev = node->prev;
+		page = node->data;
+		if (page->refs == 0) {
+			pd_glyph_cache_drop_page(cache, page);
+		}
+	}
+}
+
+static void pd_glyph_cache_touch_page(pd_glyph_cache_t *cache,
+				      pd_glyph_page_t *page)
+{
+	list_unlink(&cache->pages, &page->node);
+	list_insert_node(&cache->pages, 0, &page->node);
+}
+
+/**
+ * Find a page of the pixel size with room for the glyph, a new page is
+ * added if the room is not found
+ */
+static pd_glyph_page_t *pd_glyph_cache_alloc(pd_glyph_cache_t *cache,
+					     int size, unsigned width,
+					     unsigned height, unsigned *x,
+					     unsigned *y)
+{
+	list_node_t *node;
+	pd_glyph_page_t *page;
+
+	for (list_each(node, &cache->pages)) {
+		page = node->data;
+		if (page->size == size &&
+		    pd_glyph_page_alloc(page, width, height, x, y)) {
+			return page;
+		}
+	}
+	page = pd_glyph_page_create(size, y_max(width, PAGE_SIZE),
+				    y_max(height, PAGE_SIZE));
+	if (!page) {
+		return NULL;
+	}
+	pd_glyph_page_alloc(page, width, height, x, y);
+	list_insert_node(&cache->pages, 0, &page->node);
+	cache->stats.memory += page->memory;
+	cache->stats.pages++;
+	return page;
+}
+
+pd_glyph_cache_t *pd_glyph_cache_create(size_t max_memory)
+{
+	pd_glyph_cache_t *cache;
+
+	cache = calloc(1, sizeof(pd_glyph_cache_t));
+	if (!cache) {
+		return NULL;
+	}
+	cache->slots = calloc(MIN_CAPACITY, sizeof(pd_glyph_entry_t *));
+	if (!cache->slots) {
+		free(cache);
+		return NULL;
+	}
+	if (max_memory == 0) {
+		max_memory = DEFAULT_MAX_MEMORY;
+	}
+	cache->capacity = MIN_CAPACITY;
+	cache->stats.max_memory = max_memory;
+	list_create(&cache->pages);
+	thread_mutex_init(&cache->mutex);
+	return cache;
+}
+
+void pd_glyph_cache_destroy(pd_glyph_cache_t *cache)
+{
+	list_node_t *node;
+
+	while ((node = list_get_first_node(&cache->pages))) {
+		list_unlink(&cache->pages, node);
+		pd_glyph_page_destroy(node->data);
+	}
+	thread_mutex_destroy(&cache->mutex);
+	free(cache->slots);
+	free(cache);
+}
+
+/** Take a reference to the entry */
+static pd_font_bitmap_t *pd_glyph_cache_ref(pd_glyph_cache_t *cache,
+					    pd_glyph_entry_t *entry)
+{
+	if (entry->refs == 0) {
+		entry->page->refs++;
+	}
+	entry->refs++;
+	pd_glyph_cache_touch_page(cache, entry->page);
+	return &entry->bitmap;
+}
+
+const pd_font_bitmap_t *pd_glyph_cache_get(pd_glyph_cache_t *cache,
+					   unsigned code, int font_id, int size)
+{
+	pd_glyph_entry_t *entry;
+	const pd_font_bitmap_t *bmp = NULL;
+
+	thread_mutex_lock(&cache->mutex);
+	entry = cache->slots[pd_glyph_cache_probe(
+	    cache, code, font_id, size, pd_glyph_hash(code, font_id, size))];
+	if (entry) {
+		bmp = pd_glyph_cache_ref(cache, entry);
+		cache->stats.hits++;
+	} else {
+		cache->stats.misses++;
+	}
+	thread_mutex_unlock(&cache->mutex);
+	return bmp;
+}
+
+static const pd_font_bitmap_t *pd_glyph_cache_insert(
+    pd_glyph_cache_t *cache, unsigned code, int font_id, int size,
+    const pd_font_bitmap_t *bmp, bool replace)
+{
+	size_t i;
+	unsigned x = 0, y = 0, row;
+	unsigned width = 0, height = 0;
+	unsigned hash = pd_glyph_hash(code, font_id, size);
+	uint8_t *pixels;
+	pd_glyph_page_t *page;
+	pd_glyph_entry_t *entry;
+
+	i = pd_glyph_cache_probe(cache, code, font_id, size, hash);
+	if (cache->slots[i] && !replace) {
+		free(bmp->buffer);
+		return pd_glyph_cache_ref(cache, cache->slots[i]);
+	}
+	if (bmp->buffer && bmp->width > 0 && bmp->rows > 0) {
+		width = bmp->width;
+		height = bmp->rows;
+	}
+	entry = malloc(sizeof(pd_glyph_entry_t));
+	if (!entry) {
+		goto failed;
+	}
+	if ((cache->stats.entries + 1) * 4 > cache->capacity * 3 &&
+	    pd_glyph_cache_resize(cache, cache->capacity * 2) != 0) {
+		goto failed;
+	}
+	page = pd_glyph_cache_alloc(cache, size, width, height, &x, &y);
+	if (!page) {
+		goto failed;
+	}
+	i = pd_glyph_cache_probe(cache, code, font_id, size, hash);
+	if (cache->slots[i]) {
+		pd_glyph_cache_unlink(cache, cache->slots[i]);
+		i = pd_glyph_cache_probe(cache, code, font_id, size, hash);
+	}
+	entry->bitmap = *bmp;
+	entry->bitmap.pitch = page->width;
+	if (bmp->buffer) {
+		pixels = page->pixels + (size_t)y * page->width + x;
+		for (row = 0; row < height; ++row) {
+			memcpy(pixels + (size_t)row * page->width,
+			       bmp->buffer + (size_t)row * bmp->pitch, width);
+		}
+		entry->bitmap.buffer = pixels;
+		free(bmp->buffer);
+	}
+	entry->code = code;
+	entry->font_id = font_id;
+	entry->size = size;
+	entry->hash = hash;
+	entry->refs = 1;
+	entry->detached = false;
+	entry->page = page;
+	entry->node.data = entry;
+	entry->memory = sizeof(pd_glyph_entry_t);
+	list_append_node(&page->entries, &entry->node);
+	page->refs++;
+	cache->slots[i] = entry;
+	cache->stats.memory += entry->memory;
+	cache->stats.entries++;
+	pd_glyph_cache_evict(cache, cache->stats.max_memory);
+	return &entry->bitmap;
+
+failed:
+	free(entry);
+	free(bmp->buffer);
+	return NULL;
+}
+
+const pd_font_bitmap_t *pd_glyph_cache_add(pd_glyph_cache_t *cache,
+					   unsigned code, int font_id, int size,
+					   const pd_font_bitmap_t *bmp)
+{
+	const pd_font_bitmap_t *cached;
+
+	thread_mutex_lock(&cache->mutex);
+	cached = pd_glyph_cache_insert(cache, code, font_id, size, bmp, true);
+	thread_mutex_unlock(&cache->mutex);
+	return cached;
+}
+
+const pd_font_bitmap_t *pd_glyph_cache_get_or_add(pd_glyph_cache_t *cache,
+						  unsigned code, int font_id,
+						  int size,
+						  const pd_font_bitmap_t *bmp)
+{
+	const pd_font_bitmap_t *cached;
+
+	thread_mutex_lock(&cache->mutex);
+	cached = pd_glyph_cache_insert(cache, code, font_id, size, bmp, false);
+	thread_mutex_unlock(&cache->mutex);
+	return cached;
+}
+
+void pd_glyph_cache_release(pd_glyph_cache_t *cache,
+			    const pd_font_bitmap_t *bmp)
+{
+	pd_glyph_entry_t *entry = (pd_glyph_entry_t *)bmp;
+
+	thread_mutex_lock(&cache->mutex);
+	entry->refs--;
+	if (entry->refs == 0) {
+		entry->page->refs--;
+		if (entry->detached) {
+			list_unlink(&entry->page->entries, &entry->node);
+			free(entry);
+		}
+		pd_glyph_cache_evict(cache, cache->stats.max_memory);
+	}
+	thread_mutex_unlock(&cache->mutex);
+}
+
+void pd_glyph_cache_set_max_memory(pd_glyph_cache_t *cache, size_t max_memory)
+{
+	thread_mutex_lock(&cache->mutex);
+	if (max_memory == 0) {
+		max_memory = DEFAULT_MAX_MEMORY;
+	}
+	cache->stats.max_memory = max_memory;
+	pd_glyph_cache_evict(cache, max_memory);
+	thread_mutex_unlock(&cache->mutex);
+}
+
+void pd_glyph_cache_get_stats(pd_glyph_cache_t *cache,
+			      pd_font_cache_stats_t *stats)
+{
+	thread_mutex_lock(&cache->mutex);
+	*stats = cache->stats;
+	thread_mutex_unlock(&cache->mutex);
+}
@@ -0,0 +1,73 @@
+﻿/*
+ * lib/pandagl/src/font/glyph_cache.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifndef LIB_PANDAGL_SRC_FONT_GLYPH_CACHE_H
+#define LIB_PANDAGL_SRC_FONT_GLYPH_CACHE_H
+
+/**
+ * A cache of glyph bitmaps keyed by (code, font id, pixel size). The pixels
+ * of the glyphs of a pixel size are packed into shared atlas pages, so the
+ * pitch of a cached bitmap is the width of its page. Bitmaps in use are
+ * referenced, pages without used bitmaps are evicted as a whole in LRU
+ * order when the memory exceeds the limit.
+ *
+ * The cache can be used from multiple threads, the glyphs should be
+ * rendered without holding it and added with pd_glyph_cache_get_or_add().
+ */
+typedef struct pd_glyph_cache pd_glyph_cache_t;
+
+/**
+ * @param max_memory maximum memory of the cached bitmaps, 0 means using the
+ * default value
+ */
+pd_glyph_cache_t *pd_glyph_cache_create(size_t max_memory);
+
+/** All bitmaps must be released before */
+void pd_glyph_cache_destroy(pd_glyph_cache_t *cache);
+
+/**
+ * Get a referenced bitmap from the cache
+ * @returns NULL if the bitmap is not in the cache
+ */
+const pd_font_bitmap_t *pd_glyph_cache_get(pd_glyph_cache_t *cache,
+					   unsigned code, int font_id,
+					   int size);
+
+/**
+ * Add the bitmap to the cache and get a reference to it. The cache takes
+ * over the buffer of the bitmap, it is copied into an atlas page and freed.
+ * A bitmap with the same key is replaced.
+ * @returns NULL if there is not enough memory
+ */
+const pd_font_bitmap_t *pd_glyph_cache_add(pd_glyph_cache_t *cache,
+					   unsigned code, int font_id,
+					   int size,
+					   const pd_font_bitmap_t *bmp);
+
+/**
+ * Same as pd_glyph_cache_add(), except that the bitmap cached by another
+ * thread in the meantime is kept, and the given buffer is freed
+ */
+const pd_font_bitmap_t *pd_glyph_cache_get_or_add(pd_glyph_cache_t *cache,
+						  unsigned code, int font_id,
+						  int size,
+						  const pd_font_bitmap_t *bmp);
+
+void pd_glyph_cache_release(pd_glyph_cache_t *cache,
+			    const pd_font_bitmap_t *bmp);
+
+void pd_glyph_cache_set_max_memory(pd_glyph_cache_t *cache,
+				   size_t max_memory);
+
+void pd_glyph_cache_get_stats(pd_glyph_cache_t *cache,
+			      pd_font_cache_stats_t *stats);
+
+#endif
@@ -7643,6 +7643,7 @@ int pd_render_inconsolata_font_bitmap(pd_font_bitmap_t *bmp, unsigned ch, int si
 	j = *(ptr = (int*)&bmp->buffer);
 	byte_ptr = &pd_inconsolata_font_bitmap[i][j];
 	size = sizeof(unsigned char)*bmp->width*bmp->rows;
+	bmp->pitch = bmp->width;
 	bmp->metrics.bbox_height = size;
 	bmp->metrics.bbox_width = bmp->metrics.hori_advance;
 	bmp->metrics.ascender = bmp->top;
@@ -17,20 +17,13 @@
 #include "bitmap.h"
 #include "incore.h"
 #include "freetype.h"
+#include "glyph_cache.h"
 
 /* clang-format off */
 
 #define FONT_CACHE_SIZE		32
 #define FONT_CACHE_MAX_SIZE	1024
 
-/**
- * 库中缓存的字体位图是分组存放的，共有三级分组，分别为：
- * 字符->字体信息->字体大小
- * 获取字体位图时的搜索顺序为：先找到字符的记录，然后在记录中的字体数据库里找
- * 到指定字体样式标识号的字体位图库，之后在字体位图库中找到指定像素大小的字体
- * 位图。
- */
-
 typedef struct font_style_node {
 	/* 字体列表，按粗细程度存放 */
 	pd_font_t *weights[PD_FONT_WEIGHT_TOTAL_NUM];
@@ -60,8 +53,8 @@ static struct font_library_module {
 	/** dict_t<string, string> */
 	dict_t *font_family_aliases;
 
-	/** rbtree_t<wchar_t, rbtree_t<int, rbtree_t<int, pd_font_bitmap_t>>>  */
-	rbtree_t bitmap_cache;
+	/** The font bitmaps keyed by (char, font id, pixel size) */
+	pd_glyph_cache_t *glyph_cache;
 
 	font_cache_t **font_cache;
 	pd_font_t *default_font;
@@ -72,21 +65,6 @@ static struct font_library_module {
 
 /* clang-format on */
 
-PD_INLINE rbtree_t *select_char_cache(wchar_t ch)
-{
-        return rbtree_get_data_by_key(&fontlib.bitmap_cache, ch);
-}
-
-PD_INLINE rbtree_t *select_font_cache(rbtree_t *font_cache, int font_id)
-{
-        return rbtree_get_data_by_key(font_cache, font_id);
-}
-
-PD_INLINE pd_font_bitmap_t *select_bitmap_cache(rbtree_t *bmp_cache, int size)
-{
-        return rbtree_get_data_by_key(bmp_cache, size);
-}
-
 PD_INLINE font_family_node_t *select_font_family_cache(const char *family_name)
 {
         return dict_fetch_value(fontlib.font_families, family_name);
@@ -167,72 +145,24 @@ static void destroy_font_family_node(void *privdata, void *data)
         free(node);
 }
 
-static void destroy_font_bitmap(void *arg)
+const pd_font_bitmap_t *pd_font_library_add_bitmap(wchar_t ch, int font_id,
+                                                   int size,
+                                                   const pd_font_bitmap_t *bmp)
 {
-        pd_font_bitmap_destroy(arg);
-        free(arg);
-}
-
-static void destroy_tree_node(void *arg)
-{
-        rbtree_destroy(arg);
-        free(arg);
-}
-
-pd_font_bitmap_t *pd_font_library_add_bitmap(wchar_t ch, int font_id, int size,
-                                             const pd_font_bitmap_t *bmp)
-{
-        pd_font_bitmap_t *bmp_cache;
-        rbtree_t *tree_font, *tree_bmp;
-
         if (!fontlib.active) {
                 return NULL;
         }
-        /* 获取字符的字体信息集 */
-        tree_font = select_char_cache(ch);
-        if (!tree_font) {
-                tree_font = malloc(sizeof(rbtree_t));
-                if (!tree_font) {
-                        return NULL;
-                }
-                rbtree_init(tree_font);
-                rbtree_set_destroy_func(tree_font, destroy_tree_node);
-                rbtree_insert_by_key(&fontlib.bitmap_cache, ch, tree_font);
-        }
         /* 当字体ID不大于0时，使用内置字体 */
         if (font_id <= 0) {
                 font_id = fontlib.incore_font->id;
         }
-        /* 获取相应字体样式标识号的字体位图库 */
-        tree_bmp = select_font_cache(tree_font, font_id);
-        if (!tree_bmp) {
-                tree_bmp = malloc(sizeof(rbtree_t));
-                if (!tree_bmp) {
-                        return NULL;
-                }
-                rbtree_init(tree_bmp);
-                rbtree_set_destroy_func(tree_bmp, destroy_font_bitmap);
-                rbtree_insert_by_key(tree_font, font_id, tree_bmp);
-        }
-        /* 在字体位图库中获取指定像素大小的字体位图 */
-        bmp_cache = select_bitmap_cache(tree_bmp, size);
-        if (!bmp_cache) {
-                bmp_cache = malloc(sizeof(pd_font_bitmap_t));
-                if (!bmp_cache) {
-                        return NULL;
-                }
-                rbtree_insert_by_key(tree_bmp, size, bmp_cache);
-        }
-        /* 拷贝数据至该空间内 */
-        memcpy(bmp_cache, bmp, sizeof(pd_font_bitmap_t));
-        return bmp_cache;
+        return pd_glyph_cache_add(fontlib.glyph_cache, ch, font_id, size, bmp);
 }
 
 int pd_font_library_get_bitmap(unsigned ch, int font_id, int size,
                                const pd_font_bitmap_t **bmp)
 {
         int ret;
-        rbtree_t *ctx;
         pd_font_bitmap_t bmp_cache;
 
         *bmp = NULL;
@@ -246,37 +176,51 @@ int pd_font_library_get_bitmap(unsigned ch, int font_id, int size,
                         font_id = fontlib.incore_font->id;
                 }
         }
-        do {
-                if (!(ctx = select_char_cache(ch))) {
-                        break;
-                }
-                ctx = select_font_cache(ctx, font_id);
-                if (!ctx) {
-                        break;
-                }
-                *bmp = select_bitmap_cache(ctx, size);
-                if (*bmp) {
-                        return 0;
-                }
-                break;
-        } while (0);
+        *bmp = pd_glyph_cache_get(fontlib.glyph_cache, ch, font_id, size);
+        if (*bmp) {
+                return 0;
+        }
         if (ch == 0) {
                 return -1;
         }
+        /* Render without holding the cache so other threads are not blocked,
+         * the bitmap cached by another thread in the meantime is kept */
         pd_font_bitmap_init(&bmp_cache);
         ret = pd_font_library_render_bitmap(&bmp_cache, ch, font_id, size);
         if (ret == 0) {
-                *bmp =
-                    pd_font_library_add_bitmap(ch, font_id, size, &bmp_cache);
+                *bmp = pd_glyph_cache_get_or_add(fontlib.glyph_cache, ch,
+                                                 font_id, size, &bmp_cache);
                 return 0;
         }
-        ret = pd_font_library_get_bitmap(0, font_id, size, bmp);
-        if (ret != 0) {
-                *bmp = pd_font_library_add_bitmap(0, font_id, size, &bmp_cache);
-        }
+        /* The bitmap of the first missing char is the placeholder */
+        *bmp = pd_glyph_cache_get_or_add(fontlib.glyph_cache, 0, font_id, size,
+                                         &bmp_cache);
         return -1;
 }
 
+void pd_font_library_release_bitmap(const pd_font_bitmap_t *bmp)
+{
+        if (fontlib.active && bmp) {
+                pd_glyph_cache_release(fontlib.glyph_cache, bmp);
+        }
+}
+
+void pd_font_library_set_cache_max_memory(size_t max_memory)
+{
+        if (fontlib.active) {
+                pd_glyph_cache_set_max_memory(fontlib.glyph_cache, max_memory);
+        }
+}
+
+void pd_font_library_get_cache_stats(pd_font_cache_stats_t *stats)
+{
+        if (fontlib.active) {
+                pd_glyph_cache_get_stats(fontlib.glyph_cache, stats);
+        } else {
+                memset(stats, 0, sizeof(pd_font_cache_stats_t));
+        }
+}
+
 static font_cache_t *font_cache_create(void)
 {
         font_cache_t *cache;
@@ -717,7 +661,7 @@ static void pd_font_library_init_base(void)
         fontlib.font_cache_num = 1;
         fontlib.font_cache = malloc(sizeof(font_cache_t));
         fontlib.font_cache[0] = font_cache_create();
-        rbtree_init(&fontlib.bitmap_cache);
+        fontlib.glyph_cache = pd_glyph_cache_create(0);
         dict_init_string_key_type(&dict_type);
         dict_init_string_copy_key_type(&alias_dict_type);
         dict_type.val_destructor = destroy_font_family_node;
@@ -725,7 +669,6 @@ static void pd_font_library_init_base(void)
         alias_dict_type.val_dup = font_family_dict_val_dup;
         fontlib.font_families = dict_create(&dict_type, NULL);
         fontlib.font_family_aliases = dict_create(&alias_dict_type, NULL);
-        rbtree_set_destroy_func(&fontlib.bitmap_cache, destroy_tree_node);
         fontlib.active = true;
 }
 
@@ -765,7 +708,8 @@ static void pd_font_library_destroy_base(void)
         }
         dict_destroy(fontlib.font_family_aliases);
         dict_destroy(fontlib.font_families);
-        rbtree_destroy(&fontlib.bitmap_cache);
+        pd_glyph_cache_destroy(fontlib.glyph_cache);
+        fontlib.glyph_cache = NULL;
         free(fontlib.font_cache);
         fontlib.font_cache = NULL;
         fontlib.font_families = NULL;
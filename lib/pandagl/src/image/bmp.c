@@ -118,7 +118,7 @@ void pd_bmp_reader_start(pd_image_reader_t *reader)
 void pd_bmp_reader_read_row(pd_image_reader_t *reader, pd_canvas_t *graph)
 {
         unsigned char *buffer, *dest;
-        size_t n, row, bytes_per_row;
+        size_t n, row, bytes_per_row, row_size;
         pd_bmp_reader_t *bmp_reader = reader->reader_data;
         pd_bmp_info_header_t *info = &bmp_reader->info;
 
@@ -127,7 +127,8 @@ void pd_bmp_reader_read_row(pd_image_reader_t *reader, pd_canvas_t *graph)
                 return;
         }
         bytes_per_row = (info->bits * info->width + 31) / 32 * 4;
-        if (bytes_per_row < graph->bytes_per_row) {
+        row_size = (size_t)graph->width * graph->bytes_per_pixel;
+        if (bytes_per_row < row_size) {
                 return;
         }
         buffer = malloc(bytes_per_row);
@@ -139,7 +140,7 @@ void pd_bmp_reader_read_row(pd_image_reader_t *reader, pd_canvas_t *graph)
                 if (n < bytes_per_row) {
                         break;
                 }
-                memcpy(dest, buffer, graph->bytes_per_row);
+                memcpy(dest, buffer, row_size);
                 dest -= graph->bytes_per_row;
         }
         free(buffer);
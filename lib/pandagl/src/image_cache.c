@@ -0,0 +1,257 @@
+﻿/*
+ * lib/pandagl/src/image_cache.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <yutil.h>
+#include <thread.h>
+#include <pandagl.h>
+
+#define DEFAULT_MAX_MEMORY (32 * 1024 * 1024)
+
+typedef struct pd_image_cache_entry {
+	/** The scaled image, it must be the first member */
+	pd_canvas_t canvas;
+
+	/**
+	 * The key, the pixel buffer and the size of the source image are also
+	 * compared so that a recreated image is not mistaken for the old one
+	 */
+	const pd_canvas_t *image;
+	const uint8_t *image_bytes;
+	unsigned image_width;
+	unsigned image_height;
+	pd_resample_quality_t quality;
+
+	/** Number of users of the canvas, a used entry is never freed */
+	unsigned refs;
+
+	/** The entry was removed from the cache while it was still used */
+	bool detached;
+
+	list_node_t node;
+} pd_image_cache_entry_t;
+
+struct pd_image_cache {
+	thread_mutex_t mutex;
+	pd_image_cache_stats_t stats;
+
+	/** list_t<pd_image_cache_entry_t*>, most recently used first */
+	list_t entries;
+};
+
+static void pd_image_cache_entry_destroy(pd_image_cache_entry_t *entry)
+{
+	pd_canvas_destroy(&entry->canvas);
+	free(entry);
+}
+
+static bool pd_image_cache_entry_match(pd_image_cache_entry_t *entry,
+				       const pd_canvas_t *image, unsigned width,
+				       unsigned height,
+				       pd_resample_quality_t quality)
+{
+	return entry->image == image && entry->image_bytes == image->bytes &&
+	       entry->image_width == image->width &&
+	       entry->image_height == image->height &&
+	       entry->canvas.width == width && entry->canvas.height == height &&
+	       entry->quality == quality;
+}
+
+static void pd_image_cache_unlink(pd_image_cache_t *cache,
+				  pd_image_cache_entry_t *entry)
+{
+	list_unlink(&cache->entries, &entry->node);
+	cache->stats.memory -= entry->canvas.mem_size;
+	cache->stats.entries--;
+	if (entry->refs > 0) {
+		entry->detached = true;
+	} else {
+		pd_image_cache_entry_destroy(entry);
+	}
+}
+
+/** Drop least recently used entries until the memory fits the limit */
+static void pd_image_cache_evict(pd_image_cache_t *cache, size_t max_memory)
+{
+	list_node_t *node, *prev;
+	pd_image_cache_entry_t *entry;
+
+	for (node = list_get_last_node(&cache->entries);
+	     node && node != &cache->entries.head &&
+	     cache->stats.memory > max_memory;
+	     node = prev) {
+		prev = node->prev;
+		entry = node->data;
+		if (entry->refs == 0) {
+			pd_image_cache_unlink(cache, entry);
+			cache->stats.evictions++;
+		}
+	}
+}
+
+pd_image_cache_t *pd_image_cache_create(size_t max_memory)
+{
+	pd_image_cache_t *cache;
+
+	cache = calloc(1, sizeof(pd_image_cache_t));
+	if (!cache) {
+		return NULL;
+	}
+	if (max_memory == 0) {
+		max_memory = DEFAULT_MAX_MEMORY;
+	}
+	cache->stats.max_memory = max_memory;
+	list_create(&cache->entries);
+	thread_mutex_init(&cache->mutex);
+	return cache;
+}
+
+void pd_image_cache_destroy(pd_image_cache_t *cache)
+{
+	list_node_t *node;
+
+	while ((node = list_get_first_node(&cache->entries))) {
+		list_unlink(&cache->entries, node);
+		pd_image_cache_entry_destroy(node->data);
+	}
+	thread_mutex_destroy(&cache->mutex);
+	free(cache);
+}
+
+static pd_image_cache_entry_t *pd_image_cache_find(pd_image_cache_t *cache,
+						   const pd_canvas_t *image,
+						   unsigned width,
+						   unsigned height,
+						   pd_resample_quality_t quality)
+{
+	list_node_t *node;
+
+	for (list_each(node, &cache->entries)) {
+		if (pd_image_cache_entry_match(node->data, image, width, height,
+					       quality)) {
+			return node->data;
+		}
+	}
+	return NULL;
+}
+
+pd_canvas_t *pd_image_cache_get(pd_image_cache_t *cache,
+				const pd_canvas_t *image, unsigned width,
+				unsigned height, pd_resample_quality_t quality)
+{
+	size_t size;
+	pd_image_cache_entry_t *entry, *found;
+
+	if (!pd_canvas_is_valid(image) || width < 1 || height < 1) {
+		return NULL;
+	}
+	thread_mutex_lock(&cache->mutex);
+	entry = pd_image_cache_find(cache, image, width, height, quality);
+	if (entry) {
+		list_unlink(&cache->entries, &entry->node);
+		list_insert_node(&cache->entries, 0, &entry->node);
+		entry->refs++;
+		cache->stats.hits++;
+		thread_mutex_unlock(&cache->mutex);
+		return &entry->canvas;
+	}
+	cache->stats.misses++;
+	size = (size_t)pd_get_pixel_row_size(image->color_type, width) * height;
+	if (size > cache->stats.max_memory) {
+		thread_mutex_unlock(&cache->mutex);
+		return NULL;
+	}
+	thread_mutex_unlock(&cache->mutex);
+	entry = calloc(1, sizeof(pd_image_cache_entry_t));
+	if (!entry) {
+		return NULL;
+	}
+	/* Resample without holding the lock so other threads are not blocked */
+	pd_canvas_init(&entry->canvas);
+	if (pd_canvas_resample(image, &entry->canvas, width, height, quality) !=
+	    0) {
+		pd_image_cache_entry_destroy(entry);
+		return NULL;
+	}
+	entry->image = image;
+	entry->image_bytes = image->bytes;
+	entry->image_width = image->width;
+	entry->image_height = image->height;
+	entry->quality = quality;
+	entry->refs = 1;
+	entry->node.data = entry;
+	thread_mutex_lock(&cache->mutex);
+	/* Another thread may have cached the same image in the meantime */
+	found = pd_image_cache_find(cache, image, width, height, quality);
+	if (found) {
+		found->refs++;
+		thread_mutex_unlock(&cache->mutex);
+		pd_image_cache_entry_destroy(entry);
+		return &found->canvas;
+	}
+	list_insert_node(&cache->entries, 0, &entry->node);
+	cache->stats.memory += entry->canvas.mem_size;
+	cache->stats.entries++;
+	pd_image_cache_evict(cache, cache->stats.max_memory);
+	thread_mutex_unlock(&cache->mutex);
+	return &entry->canvas;
+}
+
+void pd_image_cache_release(pd_image_cache_t *cache, pd_canvas_t *scaled)
+{
+	pd_image_cache_entry_t *entry = (pd_image_cache_entry_t *)scaled;
+
+	thread_mutex_lock(&cache->mutex);
+	entry->refs--;
+	if (entry->refs == 0) {
+		if (entry->detached) {
+			pd_image_cache_entry_destroy(entry);
+		} else if (cache->stats.memory > cache->stats.max_memory) {
+			pd_image_cache_evict(cache, cache->stats.max_memory);
+		}
+	}
+	thread_mutex_unlock(&cache->mutex);
+}
+
+void pd_image_cache_remove(pd_image_cache_t *cache, const pd_canvas_t *image)
+{
+	list_node_t *node, *next;
+	pd_image_cache_entry_t *entry;
+
+	thread_mutex_lock(&cache->mutex);
+	for (node = list_get_first_node(&cache->entries); node; node = next) {
+		next = node->next;
+		entry = node->data;
+		if (entry->image == image) {
+			pd_image_cache_unlink(cache, entry);
+		}
+	}
+	thread_mutex_unlock(&cache->mutex);
+}
+
+void pd_image_cache_set_max_memory(pd_image_cache_t *cache, size_t max_memory)
+{
+	thread_mutex_lock(&cache->mutex);
+	if (max_memory == 0) {
+		max_memory = DEFAULT_MAX_MEMORY;
+	}
+	cache->stats.max_memory = max_memory;
+	pd_image_cache_evict(cache, max_memory);
+	thread_mutex_unlock(&cache->mutex);
+}
+
+void pd_image_cache_get_stats(pd_image_cache_t *cache,
+			      pd_image_cache_stats_t *stats)
+{
+	thread_mutex_lock(&cache->mutex);
+	*stats = cache->stats;
+	thread_mutex_unlock(&cache->mutex);
+}
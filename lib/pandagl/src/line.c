@@ -39,7 +39,7 @@ void pd_canvas_draw_horizontal_line(pd_canvas_t *canvas, pd_color_t color,
 	}
 	if (des->color_type == PD_COLOR_TYPE_ARGB) {
 		pd_color_t *pPixel, *pRowPixel;
-		pRowPixel = des->argb + start.y * des->width + start.x;
+		pRowPixel = pd_canvas_pixel_at(des, start.x, start.y);
 		for (y = 0; y < size; ++y) {
 			pPixel = pRowPixel;
 			for (x = 0; x < len; ++x) {
@@ -49,7 +49,8 @@ void pd_canvas_draw_horizontal_line(pd_canvas_t *canvas, pd_color_t color,
 				pPixel->a = 255;
 				++pPixel;
 			}
-			pRowPixel += des->width;
+			pRowPixel = (pd_color_t *)((uint8_t *)pRowPixel +
+						   des->bytes_per_row);
 		}
 	} else {
 		uint8_t *pByte, *pRowByte;
@@ -97,7 +98,7 @@ void pd_canvas_draw_vertical_line(pd_canvas_t *canvas, pd_color_t color,
 
 	if (des->color_type == PD_COLOR_TYPE_ARGB) {
 		pd_color_t *pPixel, *pRowPixel;
-		pRowPixel = des->argb + start.y * des->width + start.x;
+		pRowPixel = pd_canvas_pixel_at(des, start.x, start.y);
 		for (y = 0; y < len; ++y) {
 			pPixel = pRowPixel;
 			for (x = 0; x < size; ++x) {
@@ -107,7 +108,8 @@ void pd_canvas_draw_vertical_line(pd_canvas_t *canvas, pd_color_t color,
 				pPixel->a = 255;
 				++pPixel;
 			}
-			pRowPixel += des->width;
+			pRowPixel = (pd_color_t *)((uint8_t *)pRowPixel +
+						   des->bytes_per_row);
 		}
 	} else {
 		uint8_t *pByte, *pRowByte;
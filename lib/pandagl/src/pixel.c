@@ -12,12 +12,14 @@
 #include <math.h>
 #include <memory.h>
 #include <pandagl/pixel.h>
+#include "blend.h"
 
 unsigned pd_get_pixel_size(pd_color_type_t color_type)
 {
 	switch (color_type) {
 	case PD_COLOR_TYPE_INDEX8:
 	case PD_COLOR_TYPE_GRAY8:
+	case PD_COLOR_TYPE_A8:
 	case PD_COLOR_TYPE_RGB323:
 	case PD_COLOR_TYPE_ARGB2222:
 		return 1;
@@ -27,6 +29,7 @@ unsigned pd_get_pixel_size(pd_color_type_t color_type)
 	case PD_COLOR_TYPE_RGB888:
 		return 3;
 	case PD_COLOR_TYPE_ARGB8888:
+	case PD_COLOR_TYPE_PARGB8888:
 	default:
 		break;
 	}
@@ -38,13 +41,16 @@ unsigned pd_get_pixel_row_size(pd_color_type_t color_type, size_t len)
 	return (unsigned)(ceil(pd_get_pixel_size(color_type) * len / 4.0)) * 4;
 }
 
-static void pd_format_pixels_argb2rgb(const pd_color_t *in_pixels,
-				      uint8_t *out_pixels, size_t count)
+void pd_format_pixels_argb2rgb(const uint8_t *in_pixels, uint8_t *out_pixels,
+			       size_t count)
 {
 	const pd_color_t *p_px, *p_end_px;
 	uint8_t *p_out_byte;
 
-	p_px = in_pixels;
+	if (count < 1) {
+		return;
+	}
+	p_px = (const pd_color_t *)in_pixels;
 	p_out_byte = out_pixels;
 	/* 遍历到倒数第二个像素为止 */
 	p_end_px = p_px + count - 1;
@@ -58,8 +64,8 @@ static void pd_format_pixels_argb2rgb(const pd_color_t *in_pixels,
 	*p_out_byte++ = p_px->red;
 }
 
-static void pd_format_pixels_rgb2argb(const uint8_t *in_bytes,
-				      pd_color_t *out_pixels, size_t count)
+void pd_format_pixels_rgb2argb(const uint8_t *in_bytes, uint8_t *out_pixels,
+			       size_t count)
 {
 	pd_color_t *p_px, *p_end_px;
 	const uint8_t *p_in_byte;
@@ -76,24 +82,141 @@ static void pd_format_pixels_rgb2argb(const uint8_t *in_bytes,
 	}
 }
 
+void pd_format_pixels_argb2pargb(const uint8_t *in_pixels, uint8_t *out_pixels,
+				 size_t count)
+{
+	size_t i;
+	const pd_color_t *in = (const pd_color_t *)in_pixels;
+	pd_color_t *out = (pd_color_t *)out_pixels;
+
+	for (i = 0; i < count; ++i) {
+		out[i] = in[i];
+		pd_premultiply_pixel(&out[i]);
+	}
+}
+
+static void pd_format_pixels_pargb2argb(const pd_color_t *in_pixels,
+					pd_color_t *out_pixels, size_t count)
+{
+	size_t i;
+
+	for (i = 0; i < count; ++i) {
+		out_pixels[i] = in_pixels[i];
+		pd_unpremultiply_pixel(&out_pixels[i]);
+	}
+}
+
+void pd_format_pixels_argb2rgb565(const uint8_t *in_pixels,
+				  uint8_t *out_pixels, size_t count)
+{
+	size_t i;
+	const pd_color_t *in = (const pd_color_t *)in_pixels;
+	uint16_t *out = (uint16_t *)out_pixels;
+
+	for (i = 0; i < count; ++i) {
+		out[i] = pd_color_to_rgb565(in[i]);
+	}
+}
+
+static void pd_format_pixels_rgb2rgb565(const uint8_t *in_bytes,
+				       uint16_t *out_pixels, size_t count)
+{
+	size_t i;
+	pd_color_t color;
+
+	for (i = 0; i < count; ++i, in_bytes += 3) {
+		color.b = in_bytes[0];
+		color.g = in_bytes[1];
+		color.r = in_bytes[2];
+		out_pixels[i] = pd_color_to_rgb565(color);
+	}
+}
+
+void pd_format_pixels_rgb5652argb(const uint8_t *in_pixels,
+				  uint8_t *out_pixels, size_t count)
+{
+	size_t i;
+	const uint16_t *in = (const uint16_t *)in_pixels;
+	pd_color_t *out = (pd_color_t *)out_pixels;
+
+	for (i = 0; i < count; ++i) {
+		out[i] = pd_rgb565_to_color(in[i]);
+	}
+}
+
+static void pd_format_pixels_rgb5652rgb(const uint16_t *in_pixels,
+				       uint8_t *out_bytes, size_t count)
+{
+	size_t i;
+	pd_color_t color;
+
+	for (i = 0; i < count; ++i, out_bytes += 3) {
+		color = pd_rgb565_to_color(in_pixels[i]);
+		out_bytes[0] = color.b;
+		out_bytes[1] = color.g;
+		out_bytes[2] = color.r;
+	}
+}
+
 int pd_format_pixels(const uint8_t *in_pixels, pd_color_type_t in_color_type,
 		     uint8_t *out_pixels, pd_color_type_t out_color_type,
 		     size_t count)
 {
+	const pd_blend_kernels_t *kernels = pd_get_blend_kernels();
+
+	/* Only the pixels are copied, the padding at the end of the row may be
+	 * the next pixels of a larger canvas */
 	if (in_color_type == out_color_type) {
-		memcpy(out_pixels, in_pixels, pd_get_pixel_row_size(in_color_type, count));
+		memcpy(out_pixels, in_pixels,
+		       pd_get_pixel_size(in_color_type) * count);
 		return 0;
 	}
 	switch (in_color_type) {
 	case PD_COLOR_TYPE_ARGB8888:
 		if (out_color_type == PD_COLOR_TYPE_RGB888) {
-			pd_format_pixels_argb2rgb((pd_color_t*)in_pixels, out_pixels, count);
+			kernels->argb2rgb(in_pixels, out_pixels, count);
+			return 0;
+		}
+		if (out_color_type == PD_COLOR_TYPE_PARGB8888) {
+			kernels->argb2pargb(in_pixels, out_pixels, count);
+			return 0;
+		}
+		/* The alpha is dropped like the conversion to RGB888 */
+		if (out_color_type == PD_COLOR_TYPE_RGB565) {
+			kernels->argb2rgb565(in_pixels, out_pixels, count);
 			return 0;
 		}
 		break;
-	case PD_COLOR_TYPE_RGB888:
+	case PD_COLOR_TYPE_PARGB8888:
 		if (out_color_type == PD_COLOR_TYPE_ARGB8888) {
-			pd_format_pixels_rgb2argb(in_pixels, (pd_color_t*)out_pixels, count);
+			pd_format_pixels_pargb2argb((pd_color_t *)in_pixels,
+						    (pd_color_t *)out_pixels,
+						    count);
+			return 0;
+		}
+		break;
+	case PD_COLOR_TYPE_RGB888:
+		/* The opaque pixels are the same in both ARGB formats */
+		if (out_color_type == PD_COLOR_TYPE_ARGB8888 ||
+		    out_color_type == PD_COLOR_TYPE_PARGB8888) {
+			kernels->rgb2argb(in_pixels, out_pixels, count);
+			return 0;
+		}
+		if (out_color_type == PD_COLOR_TYPE_RGB565) {
+			pd_format_pixels_rgb2rgb565(in_pixels,
+						    (uint16_t *)out_pixels, count);
+			return 0;
+		}
+		break;
+	case PD_COLOR_TYPE_RGB565:
+		if (out_color_type == PD_COLOR_TYPE_ARGB8888 ||
+		    out_color_type == PD_COLOR_TYPE_PARGB8888) {
+			kernels->rgb5652argb(in_pixels, out_pixels, count);
+			return 0;
+		}
+		if (out_color_type == PD_COLOR_TYPE_RGB888) {
+			pd_format_pixels_rgb5652rgb((const uint16_t *)in_pixels,
+						    out_pixels, count);
 			return 0;
 		}
 		break;
@@ -0,0 +1,611 @@
+﻿/*
+ * lib/pandagl/src/region.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pandagl.h>
+
+typedef enum pd_region_op {
+	PD_REGION_OP_UNION,
+	PD_REGION_OP_INTERSECT,
+	PD_REGION_OP_SUBTRACT
+} pd_region_op_t;
+
+typedef struct pd_region_band {
+	unsigned start;
+	unsigned end;
+} pd_region_band_t;
+
+void pd_region_init(pd_region_t *region)
+{
+	region->extents.x = 0;
+	region->extents.y = 0;
+	region->extents.width = 0;
+	region->extents.height = 0;
+	region->rects = NULL;
+	region->length = 0;
+	region->capacity = 0;
+}
+
+void pd_region_destroy(pd_region_t *region)
+{
+	free(region->rects);
+	pd_region_init(region);
+}
+
+void pd_region_clear(pd_region_t *region)
+{
+	region->length = 0;
+	region->extents.width = 0;
+	region->extents.height = 0;
+}
+
+static int pd_region_reserve(pd_region_t *region, unsigned length)
+{
+	unsigned capacity;
+	pd_rect_t *rects;
+
+	if (length <= region->capacity) {
+		return 0;
+	}
+	capacity = region->capacity > 0 ? region->capacity : 8;
+	while (capacity < length) {
+		capacity *= 2;
+	}
+	rects = realloc(region->rects, sizeof(pd_rect_t) * capacity);
+	if (!rects) {
+		return -1;
+	}
+	region->rects = rects;
+	region->capacity = capacity;
+	return 0;
+}
+
+static void pd_region_update_extents(pd_region_t *region)
+{
+	unsigned i;
+	int left, right;
+	pd_rect_t *first, *last;
+
+	if (region->length < 1) {
+		pd_region_clear(region);
+		return;
+	}
+	first = &region->rects[0];
+	last = &region->rects[region->length - 1];
+	left = first->x;
+	right = first->x + first->width;
+	for (i = 1; i < region->length; ++i) {
+		left = y_min(left, region->rects[i].x);
+		right = y_max(right,
+			      region->rects[i].x + region->rects[i].width);
+	}
+	region->extents.x = left;
+	region->extents.y = first->y;
+	region->extents.width = right - left;
+	region->extents.height = last->y + last->height - first->y;
+}
+
+int pd_region_copy(pd_region_t *dest, const pd_region_t *src)
+{
+	if (dest == src) {
+		return 0;
+	}
+	if (pd_region_reserve(dest, src->length) != 0) {
+		return -1;
+	}
+	if (src->length > 0) {
+		memcpy(dest->rects, src->rects, sizeof(pd_rect_t) * src->length);
+	}
+	dest->length = src->length;
+	dest->extents = src->extents;
+	return 0;
+}
+
+int pd_region_set_rect(pd_region_t *region, const pd_rect_t *rect)
+{
+	pd_region_clear(region);
+	if (rect->width < 1 || rect->height < 1) {
+		return 0;
+	}
+	if (pd_region_reserve(region, 1) != 0) {
+		return -1;
+	}
+	region->rects[0] = *rect;
+	region->extents = *rect;
+	region->length = 1;
+	return 0;
+}
+
+size_t pd_region_get_area(const pd_region_t *region)
+{
+	unsigned i;
+	size_t area = 0;
+
+	for (i = 0; i < region->length; ++i) {
+		area += (size_t)region->rects[i].width * region->rects[i].height;
+	}
+	return area;
+}
+
+void pd_region_translate(pd_region_t *region, int x, int y)
+{
+	unsigned i;
+
+	for (i = 0; i < region->length; ++i) {
+		region->rects[i].x += x;
+		region->rects[i].y += y;
+	}
+	region->extents.x += x;
+	region->extents.y += y;
+}
+
+/** Get the end index of the band which starts at the index */
+static unsigned pd_region_band_end(const pd_region_t *region, unsigned start)
+{
+	unsigned end = start + 1;
+
+	while (end < region->length &&
+	       region->rects[end].y == region->rects[start].y) {
+		++end;
+	}
+	return end;
+}
+
+/**
+ * Apply the operation to two sorted span lists of a band
+ * @param[out] spans pairs of left and right of the output spans
+ * @returns number of the output spans
+ */
+static unsigned pd_region_op_spans(pd_region_op_t op, const pd_rect_t *a,
+				   unsigned a_length, const pd_rect_t *b,
+				   unsigned b_length, int *spans)
+{
+	bool inside;
+	bool in_a = false, in_b = false;
+	unsigned i = 0, j = 0, n = 0;
+	int x = INT_MIN, next, next_a, next_b;
+
+	while (1) {
+		next_a = INT_MAX;
+		next_b = INT_MAX;
+		if (i < a_length) {
+			next_a = in_a ? a[i].x + a[i].width : a[i].x;
+		}
+		if (j < b_length) {
+			next_b = in_b ? b[j].x + b[j].width : b[j].x;
+		}
+		next = y_min(next_a, next_b);
+		if (next == INT_MAX) {
+			break;
+		}
+		switch (op) {
+		case PD_REGION_OP_UNION:
+			inside = in_a || in_b;
+			break;
+		case PD_REGION_OP_INTERSECT:
+			inside = in_a && in_b;
+			break;
+		default:
+			inside = in_a && !in_b;
+			break;
+		}
+		if (inside && x < next) {
+			if (n > 0 && spans[n * 2 - 1] == x) {
+				spans[n * 2 - 1] = next;
+			} else {
+				spans[n * 2] = x;
+				spans[n * 2 + 1] = next;
+				++n;
+			}
+		}
+		x = next;
+		if (next_a == next) {
+			if (in_a) {
+				++i;
+			}
+			in_a = !in_a;
+		}
+		if (next_b == next) {
+			if (in_b) {
+				++j;
+			}
+			in_b = !in_b;
+		}
+	}
+	return n;
+}
+
+static bool pd_region_band_equals(const pd_region_t *region, unsigned start,
+				  const int *spans, unsigned n)
+{
+	unsigned i;
+	const pd_rect_t *rect;
+
+	if (region->length - start != n) {
+		return false;
+	}
+	for (i = 0; i < n; ++i) {
+		rect = &region->rects[start + i];
+		if (rect->x != spans[i * 2] ||
+		    rect->x + rect->width != spans[i * 2 + 1]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Append a band to the end of the region, it will be merged with the last
+ * band if they are adjacent and have the same spans
+ * @param[in,out] last_band start index of the last band
+ */
+static int pd_region_append_band(pd_region_t *region, unsigned *last_band,
+				 int top, int bottom, const int *spans,
+				 unsigned n)
+{
+	unsigned i;
+	pd_rect_t *rect;
+
+	if (*last_band < region->length &&
+	    region->rects[*last_band].y + region->rects[*last_band].height ==
+		top &&
+	    pd_region_band_equals(region, *last_band, spans, n)) {
+		for (i = *last_band; i < region->length; ++i) {
+			region->rects[i].height += bottom - top;
+		}
+		return 0;
+	}
+	if (pd_region_reserve(region, region->length + n) != 0) {
+		return -1;
+	}
+	*last_band = region->length;
+	for (i = 0; i < n; ++i) {
+		rect = &region->rects[region->length++];
+		rect->x = spans[i * 2];
+		rect->y = top;
+		rect->width = spans[i * 2 + 1] - spans[i * 2];
+		rect->height = bottom - top;
+	}
+	return 0;
+}
+
+static int pd_region_op(pd_region_t *out, const pd_region_t *a,
+			const pd_region_t *b, pd_region_op_t op)
+{
+	int y = INT_MIN;
+	int top, bottom;
+	int a_top, a_bottom, b_top, b_bottom;
+	unsigned i = 0, j = 0, i_end = 0, j_end = 0;
+	unsigned n, last_band = 0;
+	bool a_active, b_active;
+	int *spans;
+	pd_region_t result;
+
+	spans = malloc(sizeof(int) * 2 * (a->length + b->length + 1));
+	if (!spans) {
+		return -1;
+	}
+	pd_region_init(&result);
+	while (i < a->length || j < b->length) {
+		if (op == PD_REGION_OP_INTERSECT &&
+		    (i >= a->length || j >= b->length)) {
+			break;
+		}
+		if (op == PD_REGION_OP_SUBTRACT && i >= a->length) {
+			break;
+		}
+		a_top = a_bottom = INT_MAX;
+		b_top = b_bottom = INT_MAX;
+		if (i < a->length) {
+			i_end = pd_region_band_end(a, i);
+			a_top = y_max(a->rects[i].y, y);
+			a_bottom = a->rects[i].y + a->rects[i].height;
+		}
+		if (j < b->length) {
+			j_end = pd_region_band_end(b, j);
+			b_top = y_max(b->rects[j].y, y);
+			b_bottom = b->rects[j].y + b->rects[j].height;
+		}
+		/* Split the bands at the nearest edge */
+		top = y_min(a_top, b_top);
+		a_active = a_top == top;
+		b_active = b_top == top;
+		bottom = y_min(a_active ? a_bottom : a_top,
+			       b_active ? b_bottom : b_top);
+		n = pd_region_op_spans(op, a->rects + i, a_active ? i_end - i : 0,
+				       b->rects + j, b_active ? j_end - j : 0,
+				       spans);
+		if (n > 0 && pd_region_append_band(&result, &last_band, top,
+						   bottom, spans, n) != 0) {
+			free(spans);
+			pd_region_destroy(&result);
+			return -1;
+		}
+		y = bottom;
+		if (i < a->length && a_bottom <= y) {
+			i = i_end;
+		}
+		if (j < b->length && b_bottom <= y) {
+			j = j_end;
+		}
+	}
+	free(spans);
+	pd_region_update_extents(&result);
+	pd_region_destroy(out);
+	*out = result;
+	return 0;
+}
+
+static bool pd_region_extents_overlap(const pd_region_t *a,
+				      const pd_region_t *b)
+{
+	pd_rect_t rect;
+
+	return pd_rect_overlap(&a->extents, &b->extents, &rect);
+}
+
+int pd_region_union(pd_region_t *out, const pd_region_t *a,
+		    const pd_region_t *b)
+{
+	if (pd_region_is_empty(a)) {
+		return pd_region_copy(out, b);
+	}
+	if (pd_region_is_empty(b)) {
+		return pd_region_copy(out, a);
+	}
+	return pd_region_op(out, a, b, PD_REGION_OP_UNION);
+}
+
+int pd_region_intersect(pd_region_t *out, const pd_region_t *a,
+			const pd_region_t *b)
+{
+	if (pd_region_is_empty(a) || pd_region_is_empty(b) ||
+	    !pd_region_extents_overlap(a, b)) {
+		pd_region_clear(out);
+		return 0;
+	}
+	return pd_region_op(out, a, b, PD_REGION_OP_INTERSECT);
+}
+
+int pd_region_subtract(pd_region_t *out, const pd_region_t *a,
+		       const pd_region_t *b)
+{
+	if (pd_region_is_empty(a) || pd_region_is_empty(b) ||
+	    !pd_region_extents_overlap(a, b)) {
+		return pd_region_copy(out, a);
+	}
+	return pd_region_op(out, a, b, PD_REGION_OP_SUBTRACT);
+}
+
+/** Wrap a rectangle as a read-only region */
+static void pd_region_from_rect(pd_region_t *region, const pd_rect_t *rect)
+{
+	region->extents = *rect;
+	region->rects = (pd_rect_t *)rect;
+	region->length = rect->width > 0 && rect->height > 0 ? 1 : 0;
+	region->capacity = 0;
+}
+
+int pd_region_union_rect(pd_region_t *region, const pd_rect_t *rect)
+{
+	pd_region_t other;
+
+	pd_region_from_rect(&other, rect);
+	return pd_region_union(region, region, &other);
+}
+
+int pd_region_intersect_rect(pd_region_t *region, const pd_rect_t *rect)
+{
+	pd_region_t other;
+
+	pd_region_from_rect(&other, rect);
+	return pd_region_intersect(region, region, &other);
+}
+
+int pd_region_subtract_rect(pd_region_t *region, const pd_rect_t *rect)
+{
+	pd_region_t other;
+
+	pd_region_from_rect(&other, rect);
+	return pd_region_subtract(region, region, &other);
+}
+
+/** Merge adjacent bands that have the same spans */
+static void pd_region_coalesce(pd_region_t *region)
+{
+	unsigned i, k, end, n;
+	unsigned length = 0, last_band = 0;
+	int top, bottom;
+	pd_rect_t *last;
+
+	for (i = 0; i < region->length; i = end) {
+		end = pd_region_band_end(region, i);
+		n = end - i;
+		top = region->rects[i].y;
+		bottom = top + region->rects[i].height;
+		last = &region->rects[last_band];
+		if (length > 0 && length - last_band == n &&
+		    last->y + last->height == top) {
+			for (k = 0; k < n; ++k) {
+				if (last[k].x != region->rects[i + k].x ||
+				    last[k].width != region->rects[i + k].width) {
+					break;
+				}
+			}
+			if (k == n) {
+				for (k = 0; k < n; ++k) {
+					last[k].height += bottom - top;
+				}
+				continue;
+			}
+		}
+		memmove(region->rects + length, region->rects + i,
+			sizeof(pd_rect_t) * n);
+		last_band = length;
+		length += n;
+	}
+	region->length = length;
+}
+
+/** Replace rectangles in [start, end) with a band */
+static int pd_region_replace_band(pd_region_t *region, unsigned start,
+				  unsigned end, int top, int bottom,
+				  const int *spans, unsigned n)
+{
+	unsigned i;
+	pd_rect_t *rect;
+
+	if (n > end - start &&
+	    pd_region_reserve(region, region->length + n - (end - start)) != 0) {
+		return -1;
+	}
+	memmove(region->rects + start + n, region->rects + end,
+		sizeof(pd_rect_t) * (region->length - end));
+	region->length = region->length + n - (end - start);
+	for (i = 0; i < n; ++i) {
+		rect = &region->rects[start + i];
+		rect->x = spans[i * 2];
+		rect->y = top;
+		rect->width = spans[i * 2 + 1] - spans[i * 2];
+		rect->height = bottom - top;
+	}
+	return 0;
+}
+
+static size_t pd_region_get_band_area(const pd_region_t *region,
+				      const pd_region_band_t *band)
+{
+	unsigned i;
+	size_t width = 0;
+
+	for (i = band->start; i < band->end; ++i) {
+		width += region->rects[i].width;
+	}
+	return width * region->rects[band->start].height;
+}
+
+int pd_region_simplify(pd_region_t *region, unsigned max_rects,
+		       size_t rect_cost)
+{
+	unsigned i, j, n, saved;
+	unsigned bands_length;
+	unsigned best_saved, best_band;
+	unsigned best_rect;
+	int top, bottom, *spans;
+	double waste, best_waste;
+	const pd_rect_t *a, *b;
+	pd_region_band_t *bands;
+
+	if (region->length < 2) {
+		return 0;
+	}
+	bands = malloc(sizeof(pd_region_band_t) * region->length);
+	spans = malloc(sizeof(int) * 2 * region->length);
+	if (!bands || !spans) {
+		free(bands);
+		free(spans);
+		return -1;
+	}
+	while (region->length > 1) {
+		bands_length = 0;
+		for (i = 0; i < region->length; i = bands[bands_length++].end) {
+			bands[bands_length].start = i;
+			bands[bands_length].end = pd_region_band_end(region, i);
+		}
+		best_saved = 0;
+		best_waste = 0;
+		best_band = 0;
+		best_rect = 0;
+		/* Find the merge that wastes the fewest pixels per rectangle
+		 * saved, either filling the gap between two rectangles of a
+		 * band, or merging two adjacent bands into one band */
+		for (i = 0; i < bands_length; ++i) {
+			for (j = bands[i].start + 1; j < bands[i].end; ++j) {
+				a = &region->rects[j - 1];
+				b = &region->rects[j];
+				waste =
+				    (double)(b->x - a->x - a->width) * a->height;
+				if (best_saved == 0 ||
+				    waste * best_saved < best_waste) {
+					best_waste = waste;
+					best_saved = 1;
+					best_band = i;
+					best_rect = j;
+				}
+			}
+			if (i + 1 >= bands_length) {
+				continue;
+			}
+			n = pd_region_op_spans(
+			    PD_REGION_OP_UNION, region->rects + bands[i].start,
+			    bands[i].end - bands[i].start,
+			    region->rects + bands[i + 1].start,
+			    bands[i + 1].end - bands[i + 1].start, spans);
+			saved = bands[i + 1].end - bands[i].start - n;
+			if (saved == 0) {
+				continue;
+			}
+			a = &region->rects[bands[i].start];
+			b = &region->rects[bands[i + 1].start];
+			waste = 0;
+			for (j = 0; j < n; ++j) {
+				waste += spans[j * 2 + 1] - spans[j * 2];
+			}
+			waste *= b->y + b->height - a->y;
+			waste -= (double)pd_region_get_band_area(region,
+								 &bands[i]);
+			waste -= (double)pd_region_get_band_area(region,
+								 &bands[i + 1]);
+			if (best_saved == 0 ||
+			    waste * best_saved < best_waste * saved) {
+				best_waste = waste;
+				best_saved = saved;
+				best_band = i;
+				best_rect = 0;
+			}
+		}
+		if (best_saved == 0 ||
+		    (region->length <= max_rects &&
+		     best_waste > (double)rect_cost * best_saved)) {
+			break;
+		}
+		if (best_rect > 0) {
+			a = &region->rects[best_rect - 1];
+			b = &region->rects[best_rect];
+			spans[0] = a->x;
+			spans[1] = b->x + b->width;
+			top = a->y;
+			bottom = a->y + a->height;
+			pd_region_replace_band(region, best_rect - 1,
+					       best_rect + 1, top, bottom,
+					       spans, 1);
+		} else {
+			i = best_band;
+			n = pd_region_op_spans(
+			    PD_REGION_OP_UNION, region->rects + bands[i].start,
+			    bands[i].end - bands[i].start,
+			    region->rects + bands[i + 1].start,
+			    bands[i + 1].end - bands[i + 1].start, spans);
+			top = region->rects[bands[i].start].y;
+			bottom = region->rects[bands[i + 1].start].y +
+				 region->rects[bands[i + 1].start].height;
+			pd_region_replace_band(region, bands[i].start,
+					       bands[i + 1].end, top, bottom,
+					       spans, n);
+		}
+		pd_region_coalesce(region);
+	}
+	free(bands);
+	free(spans);
+	return 0;
+}
@@ -0,0 +1,588 @@
+﻿/*
+ * lib/pandagl/src/resample.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread.h>
+#include <worker.h>
+#include <pandagl.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PD_RESAMPLE_HAS_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+ * The image is resampled in two passes, horizontally into a temporary buffer
+ * and then vertically into the output canvas. The filter weights of each
+ * output pixel are computed once per axis and stored as fixed-point numbers.
+ */
+
+#define PRECISION_BITS 14
+#define PI 3.14159265358979323846
+
+/* Do not split the image into bands smaller than this */
+#define MIN_BAND_ROWS 32
+#define MIN_THREADED_PIXELS (256 * 256)
+#define MAX_THREADS 16
+
+typedef struct pd_resample_filter {
+	double (*func)(double x);
+	double support;
+} pd_resample_filter_t;
+
+/** The filter weights of an axis */
+typedef struct pd_resample_coeffs {
+	/** Maximum number of input pixels of an output pixel */
+	int size;
+
+	/** The first input pixel and the number of input pixels */
+	int *bounds;
+
+	int16_t *values;
+} pd_resample_coeffs_t;
+
+typedef struct pd_resample_context {
+	const pd_canvas_t *src;
+	pd_canvas_t *dst;
+	pd_rect_t rect;
+	int bpp;
+	bool need_horiz;
+	bool need_vert;
+	pd_resample_coeffs_t horiz;
+	pd_resample_coeffs_t vert;
+} pd_resample_context_t;
+
+typedef struct pd_resample_band {
+	pd_resample_context_t *ctx;
+	int y0;
+	int y1;
+	int result;
+} pd_resample_band_t;
+
+/** Workers owned by the resampler, they are shared by all resampling */
+static struct pd_resampler {
+	unsigned threads;
+	worker_pool_t *pool;
+
+	/** Locked while the pool is resampling an image */
+	thread_mutex_t mutex;
+} pd_resampler = { 1, NULL };
+
+static double box_filter(double x)
+{
+	if (x > -0.5 && x <= 0.5) {
+		return 1.0;
+	}
+	return 0.0;
+}
+
+static double bilinear_filter(double x)
+{
+	if (x < 0.0) {
+		x = -x;
+	}
+	if (x < 1.0) {
+		return 1.0 - x;
+	}
+	return 0.0;
+}
+
+static double sinc_filter(double x)
+{
+	if (x == 0.0) {
+		return 1.0;
+	}
+	x *= PI;
+	return sin(x) / x;
+}
+
+static double lanczos3_filter(double x)
+{
+	if (x > -3.0 && x < 3.0) {
+		return sinc_filter(x) * sinc_filter(x / 3.0);
+	}
+	return 0.0;
+}
+
+static const pd_resample_filter_t pd_resample_filters[] = {
+	{ box_filter, 0.5 }, { bilinear_filter, 1.0 }, { lanczos3_filter, 3.0 }
+};
+
+static uint8_t pd_clip8(int value)
+{
+	value >>= PRECISION_BITS;
+	if (value < 0) {
+		return 0;
+	}
+	if (value > 255) {
+		return 255;
+	}
+	return (uint8_t)value;
+}
+
+static void pd_resample_coeffs_destroy(pd_resample_coeffs_t *c)
+{
+	free(c->bounds);
+	free(c->values);
+	c->bounds = NULL;
+	c->values = NULL;
+}
+
+static int pd_resample_coeffs_init(pd_resample_coeffs_t *c, int in_size,
+				   int out_size,
+				   const pd_resample_filter_t *filter)
+{
+	int i, x, xmin, xmax, max_i, sum;
+	double center, total, scale, filter_scale, support;
+	double *weights;
+	int16_t *values;
+
+	scale = (double)in_size / out_size;
+	/* The filter is stretched when downscaling, so that all of the input
+	 * pixels are taken into account */
+	filter_scale = scale < 1.0 ? 1.0 : scale;
+	support = filter->support * filter_scale;
+	c->size = (int)ceil(support) * 2 + 1;
+	c->bounds = malloc(sizeof(int) * out_size * 2);
+	c->values = calloc((size_t)out_size * c->size, sizeof(int16_t));
+	weights = malloc(sizeof(double) * c->size);
+	if (!c->bounds || !c->values || !weights) {
+		pd_resample_coeffs_destroy(c);
+		free(weights);
+		return -1;
+	}
+	for (x = 0; x < out_size; ++x) {
+		center = (x + 0.5) * scale;
+		xmin = (int)(center - support + 0.5);
+		xmax = (int)(center + support + 0.5);
+		xmin = xmin < 0 ? 0 : xmin;
+		xmax = (xmax > in_size ? in_size : xmax) - xmin;
+		if (xmax > c->size) {
+			xmax = c->size;
+		}
+		total = 0;
+		for (i = 0; i < xmax; ++i) {
+			weights[i] =
+			    filter->func((i + xmin - center + 0.5) / filter_scale);
+			total += weights[i];
+		}
+		values = c->values + x * c->size;
+		for (i = 0, sum = 0, max_i = 0; i < xmax; ++i) {
+			if (total != 0.0) {
+				weights[i] /= total;
+			}
+			values[i] =
+			    (int16_t)floor(weights[i] * (1 << PRECISION_BITS) + 0.5);
+			sum += values[i];
+			if (values[i] > values[max_i]) {
+				max_i = i;
+			}
+		}
+		/* Let the weights sum up to 1 exactly to keep solid colors */
+		if (xmax > 0) {
+			values[max_i] += (1 << PRECISION_BITS) - sum;
+		}
+		c->bounds[x * 2] = xmin;
+		c->bounds[x * 2 + 1] = xmax;
+	}
+	free(weights);
+	return 0;
+}
+
+static void pd_resample_row_horiz(uint8_t *out, const uint8_t *in, int width,
+				  int bpp, const pd_resample_coeffs_t *c)
+{
+	int x, i, j, n;
+	int acc[4];
+	const uint8_t *p;
+	const int16_t *k;
+
+	for (x = 0; x < width; ++x, out += bpp) {
+		p = in + c->bounds[x * 2] * bpp;
+		n = c->bounds[x * 2 + 1];
+		k = c->values + x * c->size;
+		for (j = 0; j < bpp; ++j) {
+			acc[j] = 1 << (PRECISION_BITS - 1);
+		}
+		for (i = 0; i < n; ++i, p += bpp) {
+			for (j = 0; j < bpp; ++j) {
+				acc[j] += p[j] * k[i];
+			}
+		}
+		for (j = 0; j < bpp; ++j) {
+			out[j] = pd_clip8(acc[j]);
+		}
+	}
+}
+
+static void pd_resample_row_vert(uint8_t *out, const uint8_t *in,
+				 size_t stride, int n, const int16_t *k,
+				 int start, int end)
+{
+	int x, i, acc;
+
+	for (x = start; x < end; ++x) {
+		acc = 1 << (PRECISION_BITS - 1);
+		for (i = 0; i < n; ++i) {
+			acc += in[stride * i + x] * k[i];
+		}
+		out[x] = pd_clip8(acc);
+	}
+}
+
+#ifdef PD_RESAMPLE_HAS_SSE2
+
+/** Pack two weights into the 32-bit lanes used by _mm_madd_epi16() */
+static __m128i pd_resample_weights_sse2(int16_t k0, int16_t k1)
+{
+	return _mm_set1_epi32(
+	    (int)(((uint32_t)(uint16_t)k1 << 16) | (uint16_t)k0));
+}
+
+/**
+ * The channels of two input pixels are interleaved in 16-bit lanes, so that
+ * _mm_madd_epi16() multiplies and adds them in one instruction.
+ */
+static void pd_resample_row_horiz_sse2(pd_color_t *out, const pd_color_t *in,
+				       int width,
+				       const pd_resample_coeffs_t *c)
+{
+	int x, i, n;
+	const int16_t *k;
+	const pd_color_t *p;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1 << (PRECISION_BITS - 1));
+	__m128i acc, v;
+
+	for (x = 0; x < width; ++x) {
+		p = in + c->bounds[x * 2];
+		n = c->bounds[x * 2 + 1];
+		k = c->values + x * c->size;
+		acc = round;
+		for (i = 0; i + 2 <= n; i += 2) {
+			v = _mm_unpacklo_epi8(
+			    _mm_loadl_epi64((const __m128i *)(p + i)), zero);
+			v = _mm_unpacklo_epi16(v, _mm_srli_si128(v, 8));
+			acc = _mm_add_epi32(
+			    acc, _mm_madd_epi16(
+				     v, pd_resample_weights_sse2(k[i], k[i + 1])));
+		}
+		if (i < n) {
+			v = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)p[i].value),
+					      zero);
+			v = _mm_unpacklo_epi16(v, zero);
+			acc = _mm_add_epi32(
+			    acc,
+			    _mm_madd_epi16(v, pd_resample_weights_sse2(k[i], 0)));
+		}
+		acc = _mm_srai_epi32(acc, PRECISION_BITS);
+		acc = _mm_packs_epi32(acc, acc);
+		out[x].value = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(acc, acc));
+	}
+}
+
+/** Compute 16 bytes of the output row, the bytes of two rows are interleaved */
+static void pd_resample_row_vert_sse2(uint8_t *out, const uint8_t *in,
+				      size_t stride, int n, const int16_t *k,
+				      int bytes)
+{
+	int x, i;
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi32(1 << (PRECISION_BITS - 1));
+	__m128i acc0, acc1, acc2, acc3, a, b, w, lo, hi;
+
+	for (x = 0; x + 16 <= bytes; x += 16) {
+		acc0 = acc1 = acc2 = acc3 = round;
+		for (i = 0; i < n; i += 2) {
+			a = _mm_loadu_si128((const __m128i *)(in + stride * i + x));
+			if (i + 1 < n) {
+				b = _mm_loadu_si128(
+				    (const __m128i *)(in + stride * (i + 1) + x));
+				w = pd_resample_weights_sse2(k[i], k[i + 1]);
+			} else {
+				b = zero;
+				w = pd_resample_weights_sse2(k[i], 0);
+			}
+			lo = _mm_unpacklo_epi8(a, b);
+			hi = _mm_unpackhi_epi8(a, b);
+			acc0 = _mm_add_epi32(
+			    acc0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), w));
+			acc1 = _mm_add_epi32(
+			    acc1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), w));
+			acc2 = _mm_add_epi32(
+			    acc2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), w));
+			acc3 = _mm_add_epi32(
+			    acc3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), w));
+		}
+		lo = _mm_packs_epi32(_mm_srai_epi32(acc0, PRECISION_BITS),
+				     _mm_srai_epi32(acc1, PRECISION_BITS));
+		hi = _mm_packs_epi32(_mm_srai_epi32(acc2, PRECISION_BITS),
+				     _mm_srai_epi32(acc3, PRECISION_BITS));
+		_mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(lo, hi));
+	}
+	pd_resample_row_vert(out, in, stride, n, k, x, bytes);
+}
+
+#endif
+
+static void pd_resample_horiz(pd_resample_context_t *ctx, uint8_t *out,
+			      const uint8_t *in)
+{
+#ifdef PD_RESAMPLE_HAS_SSE2
+	if (ctx->bpp == 4) {
+		pd_resample_row_horiz_sse2((pd_color_t *)out,
+					   (const pd_color_t *)in,
+					   ctx->dst->width, &ctx->horiz);
+		return;
+	}
+#endif
+	pd_resample_row_horiz(out, in, ctx->dst->width, ctx->bpp, &ctx->horiz);
+}
+
+static void pd_resample_vert(pd_resample_context_t *ctx, uint8_t *out,
+			     const uint8_t *in, size_t stride, int y)
+{
+	int n = ctx->vert.bounds[y * 2 + 1];
+	int bytes = ctx->dst->width * ctx->bpp;
+	const int16_t *k = ctx->vert.values + y * ctx->vert.size;
+
+#ifdef PD_RESAMPLE_HAS_SSE2
+	pd_resample_row_vert_sse2(out, in, stride, n, k, bytes);
+#else
+	pd_resample_row_vert(out, in, stride, n, k, 0, bytes);
+#endif
+}
+
+static const uint8_t *pd_resample_src_row(pd_resample_context_t *ctx, int y)
+{
+	return pd_canvas_pixel_at(ctx->src, ctx->rect.x, ctx->rect.y + y);
+}
+
+/** Compute the output rows from y0 to y1 */
+static int pd_resample_band(pd_resample_context_t *ctx, int y0, int y1)
+{
+	int y, ymin, ymax;
+	uint8_t *tmp;
+	size_t stride;
+	size_t row_size = (size_t)ctx->dst->width * ctx->bpp;
+
+	if (!ctx->need_vert) {
+		for (y = y0; y < y1; ++y) {
+			if (ctx->need_horiz) {
+				pd_resample_horiz(
+				    ctx, pd_canvas_pixel_at(ctx->dst, 0, y),
+				    pd_resample_src_row(ctx, y));
+			} else {
+				memcpy(pd_canvas_pixel_at(ctx->dst, 0, y),
+				       pd_resample_src_row(ctx, y), row_size);
+			}
+		}
+		return 0;
+	}
+	if (!ctx->need_horiz) {
+		stride = ctx->src->bytes_per_row;
+		for (y = y0; y < y1; ++y) {
+			pd_resample_vert(
+			    ctx, pd_canvas_pixel_at(ctx->dst, 0, y),
+			    pd_resample_src_row(ctx, ctx->vert.bounds[y * 2]),
+			    stride, y);
+		}
+		return 0;
+	}
+	/* Only the input rows used by the band are resampled horizontally */
+	ymin = ctx->vert.bounds[y0 * 2];
+	ymax = ctx->vert.bounds[(y1 - 1) * 2] + ctx->vert.bounds[(y1 - 1) * 2 + 1];
+	tmp = malloc(row_size * (ymax - ymin));
+	if (!tmp) {
+		return -1;
+	}
+	for (y = ymin; y < ymax; ++y) {
+		pd_resample_horiz(ctx, tmp + row_size * (y - ymin),
+				  pd_resample_src_row(ctx, y));
+	}
+	for (y = y0; y < y1; ++y) {
+		pd_resample_vert(
+		    ctx, pd_canvas_pixel_at(ctx->dst, 0, y),
+		    tmp + row_size * (ctx->vert.bounds[y * 2] - ymin), row_size,
+		    y);
+	}
+	free(tmp);
+	return 0;
+}
+
+static void pd_resample_band_job(void *data, unsigned index,
+				 unsigned worker_id)
+{
+	pd_resample_band_t *band = (pd_resample_band_t *)data + index;
+
+	band->result = pd_resample_band(band->ctx, band->y0, band->y1);
+}
+
+static int pd_resample_run(pd_resample_context_t *ctx)
+{
+	int i, n, height = ctx->dst->height;
+	int result = 0;
+	pd_resample_band_t bands[MAX_THREADS];
+
+	n = (int)pd_resampler.threads;
+	if (n > height / MIN_BAND_ROWS) {
+		n = height / MIN_BAND_ROWS;
+	}
+	/* The threads of another pool are already busy, such as the
+	 * rendering workers, so more threads would only compete with them */
+	if (n < 2 || !pd_resampler.pool || worker_pool_in_job() ||
+	    (size_t)ctx->dst->width * height < MIN_THREADED_PIXELS) {
+		return pd_resample_band(ctx, 0, height);
+	}
+	/* Do not wait for the pool if another image is being resampled */
+	if (thread_mutex_trylock(&pd_resampler.mutex) != 0) {
+		return pd_resample_band(ctx, 0, height);
+	}
+	for (i = 0; i < n; ++i) {
+		bands[i].ctx = ctx;
+		bands[i].y0 = height * i / n;
+		bands[i].y1 = height * (i + 1) / n;
+		bands[i].result = 0;
+	}
+	worker_pool_run(pd_resampler.pool, n, pd_resample_band_job, bands);
+	thread_mutex_unlock(&pd_resampler.mutex);
+	for (i = 0; i < n; ++i) {
+		if (bands[i].result != 0) {
+			result = bands[i].result;
+		}
+	}
+	return result;
+}
+
+static int pd_resample_nearest(pd_resample_context_t *ctx)
+{
+	int x, y, j, bpp = ctx->bpp;
+	int width = ctx->dst->width, height = ctx->dst->height;
+	int *offsets = malloc(sizeof(int) * width);
+	const uint8_t *row, *p;
+	uint8_t *out;
+
+	if (!offsets) {
+		return -1;
+	}
+	/* The offsets of the input pixels are computed once per column */
+	for (x = 0; x < width; ++x) {
+		offsets[x] =
+		    (int)(((int64_t)x * 2 + 1) * ctx->rect.width / (width * 2)) *
+		    bpp;
+	}
+	for (y = 0; y < height; ++y) {
+		row = pd_resample_src_row(
+		    ctx, (int)(((int64_t)y * 2 + 1) * ctx->rect.height /
+			       (height * 2)));
+		out = pd_canvas_pixel_at(ctx->dst, 0, y);
+		if (bpp == 4) {
+			for (x = 0; x < width; ++x) {
+				((pd_color_t *)out)[x] =
+				    *(const pd_color_t *)(row + offsets[x]);
+			}
+			continue;
+		}
+		for (x = 0; x < width; ++x) {
+			p = row + offsets[x];
+			for (j = 0; j < bpp; ++j) {
+				*out++ = p[j];
+			}
+		}
+	}
+	free(offsets);
+	return 0;
+}
+
+void pd_set_resample_threads(unsigned n)
+{
+	if (n < 1) {
+		n = 1;
+	} else if (n > MAX_THREADS) {
+		n = MAX_THREADS;
+	}
+	if (n == pd_resampler.threads) {
+		return;
+	}
+	if (pd_resampler.pool) {
+		worker_pool_destroy(pd_resampler.pool);
+		thread_mutex_destroy(&pd_resampler.mutex);
+		pd_resampler.pool = NULL;
+	}
+	pd_resampler.threads = n;
+	if (n > 1) {
+		pd_resampler.pool = worker_pool_create(n);
+		if (pd_resampler.pool) {
+			thread_mutex_init(&pd_resampler.mutex);
+		}
+	}
+}
+
+int pd_canvas_resample(const pd_canvas_t *canvas, pd_canvas_t *buff,
+		       int width, int height, pd_resample_quality_t quality)
+{
+	int ret = 0;
+	const pd_resample_filter_t *filter;
+	pd_resample_context_t ctx = { 0 };
+
+	if (!pd_canvas_is_valid(canvas) || width < 1 || height < 1) {
+		return -1;
+	}
+	pd_canvas_get_quote_rect(canvas, &ctx.rect);
+	if (ctx.rect.width < 1 || ctx.rect.height < 1) {
+		return -1;
+	}
+	canvas = pd_canvas_get_quote_source_readonly(canvas);
+	if (canvas->color_type != PD_COLOR_TYPE_RGB &&
+	    canvas->color_type != PD_COLOR_TYPE_ARGB &&
+	    canvas->color_type != PD_COLOR_TYPE_PARGB) {
+		return -1;
+	}
+	buff->color_type = canvas->color_type;
+	if (pd_canvas_create(buff, width, height) != 0) {
+		return -2;
+	}
+	ctx.src = canvas;
+	ctx.dst = buff;
+	ctx.bpp = canvas->bytes_per_pixel;
+	ctx.need_horiz = ctx.rect.width != width;
+	ctx.need_vert = ctx.rect.height != height;
+	if (quality == PD_RESAMPLE_NEAREST) {
+		return pd_resample_nearest(&ctx) == 0 ? 0 : -2;
+	}
+	switch (quality) {
+	case PD_RESAMPLE_BOX:
+		filter = &pd_resample_filters[0];
+		break;
+	case PD_RESAMPLE_LANCZOS3:
+		filter = &pd_resample_filters[2];
+		break;
+	default:
+		filter = &pd_resample_filters[1];
+		break;
+	}
+	if ((ctx.need_horiz && pd_resample_coeffs_init(&ctx.horiz,
+						       ctx.rect.width, width,
+						       filter) != 0) ||
+	    (ctx.need_vert && pd_resample_coeffs_init(&ctx.vert,
+						      ctx.rect.height, height,
+						      filter) != 0)) {
+		ret = -2;
+	} else if (pd_resample_run(&ctx) != 0) {
+		ret = -2;
+	}
+	pd_resample_coeffs_destroy(&ctx.horiz);
+	pd_resample_coeffs_destroy(&ctx.vert);
+	return ret;
+}
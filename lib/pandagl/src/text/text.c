@@ -10,6 +10,7 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <wctype.h>
 #include <pandagl.h>
 #include <math.h>
@@ -24,21 +25,27 @@ static void pd_text_line_init(pd_text_line_t *line)
         line->width = 0;
         line->height = 0;
         line->length = 0;
+        line->capacity = 0;
         line->string = NULL;
         line->eol = PD_TEXT_EOL_NONE;
 }
 
-static void pd_text_line_destroy(pd_text_line_t *line)
+/** 释放文字 [start, end) 引用的字体位图 */
+static void pd_text_line_release_chars(pd_text_line_t *line, int start,
+                                       int end)
 {
-        int i;
-        for (i = 0; i < line->length; ++i) {
-                if (line->string[i]) {
-                        free(line->string[i]);
-                }
+        for (; start < end; ++start) {
+                pd_font_library_release_bitmap(line->string[start].bitmap);
         }
+}
+
+static void pd_text_line_destroy(pd_text_line_t *line)
+{
+        pd_text_line_release_chars(line, 0, line->length);
         line->width = 0;
         line->height = 0;
         line->length = 0;
+        line->capacity = 0;
         if (line->string) {
                 free(line->string);
         }
@@ -108,11 +115,11 @@ static void pd_text_update_line_size(pd_text_t *text, pd_text_line_t *line)
 
         line->width = 0;
         for (i = 0; i < line->length; ++i) {
-                ch = line->string[i];
+                ch = &line->string[i];
                 if (!ch->bitmap) {
                         continue;
                 }
-                line->width += ch->bitmap->metrics.hori_advance;
+                line->width += ch->advance;
                 if (text_height < ch->bitmap->metrics.vert_advance) {
                         text_height = ch->bitmap->metrics.vert_advance;
                 }
@@ -124,53 +131,52 @@ static void pd_text_update_line_size(pd_text_t *text, pd_text_line_t *line)
         }
 }
 
-static int pd_text_line_set_length(pd_text_line_t *line, int len)
+/** 确保文本行的容量足够存放 len 个文字，容量按倍数增长 */
+static int pd_text_line_reserve(pd_text_line_t *line, int len)
 {
-        pd_char_t **txtstr;
+        int capacity;
+        pd_char_t *txtstr;
 
-        if (len < 0) {
-                len = 0;
+        if (len <= line->capacity) {
+                return 0;
         }
-        txtstr = realloc(line->string, sizeof(pd_char_t *) * (len + 1));
+        capacity = y_max(line->capacity * 2, 16);
+        capacity = y_max(capacity, len);
+        txtstr = realloc(line->string, sizeof(pd_char_t) * capacity);
         if (!txtstr) {
                 return -1;
         }
-        txtstr[len] = NULL;
         line->string = txtstr;
-        line->length = len;
+        line->capacity = capacity;
         return 0;
 }
 
+/** 在指定位置插入 n 个文字，其后的文字整体后移 */
 static int pd_text_line_insert(pd_text_line_t *line, int offset,
-                               pd_char_t *txtchar)
+                               const pd_char_t *chars, int n)
 {
-        size_t i, insert_index;
-
-        if (offset < 0) {
-                insert_index = line->length + 1 + offset;
-                if (insert_index < 0) {
-                        insert_index = 0;
-                }
-        } else if (offset > line->length) {
-                insert_index = line->length;
-        } else {
-                insert_index = offset;
+        if (offset < 0 || offset > line->length) {
+                offset = line->length;
         }
-        pd_text_line_set_length(line, line->length + 1);
-        for (i = line->length - 1; i > insert_index; --i) {
-                line->string[i] = line->string[i - 1];
+        if (n < 1) {
+                return 0;
+        }
+        if (pd_text_line_reserve(line, line->length + n) != 0) {
+                return -1;
         }
-        line->string[insert_index] = txtchar;
+        memmove(line->string + offset + n, line->string + offset,
+                sizeof(pd_char_t) * (line->length - offset));
+        memcpy(line->string + offset, chars, sizeof(pd_char_t) * n);
+        line->length += n;
         return 0;
 }
 
-static int pd_text_line_insert_copy(pd_text_line_t *line, int ins_pos,
-                                    pd_char_t *txtchar)
+/** 移除文字 [start, end)，其后的文字整体前移，被移除文字的位图需先释放 */
+static void pd_text_line_remove(pd_text_line_t *line, int start, int end)
 {
-        pd_char_t *txtchar2;
-        txtchar2 = malloc(sizeof(pd_char_t));
-        *txtchar2 = *txtchar;
-        return pd_text_line_insert(line, ins_pos, txtchar2);
+        memmove(line->string + start, line->string + end,
+                sizeof(pd_char_t) * (line->length - end));
+        line->length -= end - start;
 }
 
 static void pd_char_update_bitmap(pd_char_t *ch, pd_text_style_t *style)
@@ -178,6 +184,7 @@ static void pd_char_update_bitmap(pd_char_t *ch, pd_text_style_t *style)
         int i = 0;
         int size = style->pixel_size;
         int *font_ids = style->font_ids;
+        const pd_font_bitmap_t *bitmap = NULL;
 
         if (ch->style) {
                 if (ch->style->has_family) {
@@ -187,15 +194,24 @@ static void pd_char_update_bitmap(pd_char_t *ch, pd_text_style_t *style)
                         size = ch->style->pixel_size;
                 }
         }
+        /* The old bitmap is released after the new one is referenced, so
+         * that an unchanged bitmap is not evicted in between */
         while (font_ids && font_ids[i] > 0) {
                 int ret = pd_font_library_get_bitmap(ch->code, font_ids[i],
-                                                     size, &ch->bitmap);
+                                                     size, &bitmap);
                 if (ret == 0) {
-                        return;
+                        break;
                 }
+                pd_font_library_release_bitmap(bitmap);
+                bitmap = NULL;
                 ++i;
         }
-        pd_font_library_get_bitmap(ch->code, -1, size, &ch->bitmap);
+        if (!bitmap) {
+                pd_font_library_get_bitmap(ch->code, -1, size, &bitmap);
+        }
+        pd_font_library_release_bitmap(ch->bitmap);
+        ch->bitmap = bitmap;
+        ch->advance = bitmap ? bitmap->metrics.hori_advance : 0;
 }
 
 pd_text_t *pd_text_create(void)
@@ -352,19 +368,11 @@ static int pd_text_get_line_rect(pd_text_t *text, int line_num, int start_col,
                 rect->width = line->width;
         } else {
                 for (i = 0; i < start_col; ++i) {
-                        if (!line->string[i]->bitmap) {
-                                continue;
-                        }
-                        rect->x +=
-                            line->string[i]->bitmap->metrics.hori_advance;
+                        rect->x += line->string[i].advance;
                 }
                 rect->width = 0;
                 for (i = start_col; i <= end_col && i < line->length; ++i) {
-                        if (!line->string[i]->bitmap) {
-                                continue;
-                        }
-                        rect->width +=
-                            line->string[i]->bitmap->metrics.hori_advance;
+                        rect->width += line->string[i].advance;
                 }
         }
         if (rect->width <= 0 || rect->height <= 0) {
@@ -460,15 +468,13 @@ int pd_text_set_insert_pixel_position(pd_text_t *text, int x, int y)
         pixel_pos = text->offset_x;
         pixel_pos += pd_text_get_line_start_x(text, line);
         for (i = 0; i < line->length; ++i) {
-                pd_char_t *txtchar;
-                txtchar = line->string[i];
+                pd_char_t *txtchar = &line->string[i];
                 if (!txtchar->bitmap) {
                         continue;
                 }
-                pixel_pos += txtchar->bitmap->metrics.hori_advance;
+                pixel_pos += txtchar->advance;
                 /* 如果在当前字中心点的前面 */
-                if (x <=
-                    pixel_pos - txtchar->bitmap->metrics.hori_advance / 2) {
+                if (x <= pixel_pos - txtchar->advance / 2) {
                         ins_x = i;
                         break;
                 }
@@ -499,11 +505,7 @@ int pd_text_get_char_pixel_position(pd_text_t *text, int line_num, int col,
         line = text->lines[line_num];
         pixel_x = pd_text_get_line_start_x(text, line);
         for (i = 0; i < col; ++i) {
-                pd_char_t *txtchar = line->string[i];
-                if (!txtchar || !txtchar->bitmap) {
-                        continue;
-                }
-                pixel_x += txtchar->bitmap->metrics.hori_advance;
+                pixel_x += line->string[i].advance;
         }
         pixel_pos->x = pixel_x;
         pixel_pos->y = pixel_y;
@@ -519,7 +521,6 @@ int pd_text_get_insert_pixel_position(pd_text_t *text, pd_pos_t *pixel_pos)
 static void pd_text_break_line(pd_text_t *text, int line_num, int col,
                                pd_text_eol_t eol)
 {
-        int n;
         pd_text_line_t *line, *next;
 
         line = pd_text_get_line(text, line_num);
@@ -527,18 +528,16 @@ static void pd_text_break_line(pd_text_t *text, int line_num, int col,
         /* 将本行原有的行尾符转移至下一行 */
         next->eol = line->eol;
         line->eol = eol;
-        for (n = line->length - 1; n >= col; --n) {
-                pd_text_line_insert(next, 0, line->string[n]);
-                line->string[n] = NULL;
+        if (pd_text_line_insert(next, 0, line->string + col,
+                                line->length - col) == 0) {
+                line->length = col;
         }
-        line->length = col;
         pd_text_update_line_size(text, line);
         pd_text_update_line_size(text, next);
 }
 
 static void pd_text_merge_line(pd_text_t *text, int line_num)
 {
-        int i, j;
         pd_text_line_t *line = pd_text_get_line(text, line_num);
         pd_text_line_t *next = pd_text_get_line(text, line_num + 1);
 
@@ -551,12 +550,11 @@ static void pd_text_merge_line(pd_text_t *text, int line_num)
                         text->insert_x += line->length;
                 }
         }
-        i = line->length;
-        pd_text_line_set_length(line, line->length + next->length);
-        for (j = 0; j < next->length; ++i, ++j) {
-                line->string[i] = next->string[j];
-                next->string[j] = NULL;
+        if (pd_text_line_insert(line, line->length, next->string,
+                                next->length) != 0) {
+                return;
         }
+        next->length = 0;
         line->eol = next->eol;
         pd_text_update_line_size(text, line);
         pd_text_delete_line(text, line_num + 1);
@@ -574,12 +572,12 @@ static void pd_text_typeset_line(pd_text_t *text, int line_num)
             max_width > 0 && text->autowrap_enabled && text->mulitiline_enabled;
 
         for (col = 0; col < line->length; ++col) {
-                txtchar = line->string[col];
+                txtchar = &line->string[col];
                 if (!txtchar->bitmap) {
                         continue;
                 }
                 /* 累加行宽度 */
-                line_width += txtchar->bitmap->metrics.hori_advance;
+                line_width += txtchar->advance;
                 /* 如果是当前行的第一个字符，或者行宽度没有超过宽度限制 */
                 if (!autowrap || col < 1 || line_width <= max_width) {
                         if (isalpha(txtchar->code)) {
@@ -662,9 +660,10 @@ static int pd_text_process(pd_text_t *text, const wchar_t *wstr,
         pd_text_eol_t eol;
         pd_text_line_t *line;
         pd_char_t txtchar;
+        pd_char_t *tail = NULL;
         list_t tmp_tags;
         const wchar_t *p;
-        int cur_col, cur_line, start_line, ins_x, ins_y;
+        int cur_col, cur_line, start_line, ins_x, ins_y, tail_length = 0;
         bool need_typeset, rect_has_added;
         pd_text_style_t *style = NULL;
 
@@ -700,6 +699,17 @@ static int pd_text_process(pd_text_t *text, const wchar_t *wstr,
         start_line = cur_line;
         ins_x = cur_col;
         ins_y = cur_line;
+        /* 先取出插入点后面的文字，插入完成后再接回来，避免每插入一个文字都
+         * 要移动它们 */
+        if (ins_x < line->length) {
+                tail_length = line->length - ins_x;
+                tail = malloc(sizeof(pd_char_t) * tail_length);
+                if (tail) {
+                        memcpy(tail, line->string + ins_x,
+                               sizeof(pd_char_t) * tail_length);
+                        line->length = ins_x;
+                }
+        }
         for (p = wstr; *p; ++p) {
                 if (text->style_tag_enabled) {
                         const wchar_t *pp;
@@ -738,11 +748,27 @@ static int pd_text_process(pd_text_t *text, const wchar_t *wstr,
                 }
                 txtchar.style = style;
                 txtchar.code = *p;
+                txtchar.bitmap = NULL;
                 pd_char_update_bitmap(&txtchar, &text->default_style);
-                pd_text_line_insert_copy(line, ins_x, &txtchar);
+                if (pd_text_line_insert(line, ins_x, &txtchar, 1) != 0) {
+                        pd_font_library_release_bitmap(txtchar.bitmap);
+                        continue;
+                }
                 ++text->length;
                 ++ins_x;
         }
+        if (tail) {
+                if (pd_text_line_insert(line, line->length, tail,
+                                        tail_length) != 0) {
+                        while (tail_length > 0) {
+                                --tail_length;
+                                --text->length;
+                                pd_font_library_release_bitmap(
+                                    tail[tail_length].bitmap);
+                        }
+                }
+                free(tail);
+        }
         /* 更新当前行的尺寸 */
         pd_text_update_line_size(text, line);
         text->width = y_max(text->width, line->width);
@@ -800,10 +826,11 @@ size_t pd_text_dump(pd_text_t *text, size_t start_pos, size_t max_len,
                 }
                 i += text->lines[line_num]->length;
         }
-        for (i = 0; line_num < text->lines_length && i < max_len; ++line_num) {
+        for (i = 0; line_num < text->lines_length && i < max_len;
+             ++line_num, col = 0) {
                 line = text->lines[line_num];
                 for (; col < line->length && i < max_len; ++col, ++i) {
-                        wstr_buff[i] = line->string[col]->code;
+                        wstr_buff[i] = line->string[col].code;
                 }
         }
         wstr_buff[i] = 0;
@@ -819,11 +846,11 @@ int pd_text_get_width(pd_text_t *text)
              ++line_num) {
                 line = text->lines[line_num];
                 for (i = 0, w = 0; i < line->length; ++i) {
-                        if (!line->string[i]->bitmap ||
-                            !line->string[i]->bitmap->buffer) {
+                        if (!line->string[i].bitmap ||
+                            !line->string[i].bitmap->buffer) {
                                 continue;
                         }
-                        w += line->string[i]->bitmap->metrics.hori_advance;
+                        w += line->string[i].advance;
                 }
                 if (w > max_w) {
                         max_w = w;
@@ -878,8 +905,8 @@ void pd_text_set_multiline(pd_text_t *text, bool enabled)
 static int pd_text_delete_ex(pd_text_t *text, int char_y, int char_x,
                              int n_char)
 {
-        int end_x, end_y, i, j, len;
-        pd_text_line_t *line, *end_line, *prev_line;
+        int end_x, end_y, i;
+        pd_text_line_t *line, *end_line;
 
         if (char_x < 0) {
                 char_x = 0;
@@ -931,73 +958,38 @@ static int pd_text_delete_ex(pd_text_t *text, int char_y, int char_x,
         if (end_x > end_line->length) {
                 end_x = end_line->length;
         }
+        line = text->lines[char_y];
         if (end_x == char_x && end_y == char_y) {
                 return 0;
         }
-        /* 获取上一行文本 */
-        prev_line = text->lines[char_y - 1];
-        // 计算起始行与结束行拼接后的长度
-        // 起始行：0 1 2 3 4 5，起点位置：2
-        // 结束行：0 1 2 3 4 5，终点位置：4
-        // 拼接后的长度：2 + 6 - 4 = 4
-        len = char_x + end_line->length - end_x;
-        if (len < 0) {
-                return -3;
-        }
+        /* 删除后的空行和未结束的行由排版合并，所以从上一行开始排版 */
+        pd_text_set_typeset_task(text, char_y > 0 ? char_y - 1 : 0);
         /* 如果是同一行 */
         if (line == end_line) {
-                if (end_x > end_line->length) {
-                        return -4;
-                }
                 pd_text_mark_line_dirty(text, char_y, char_x, -1);
-                pd_text_set_typeset_task(text, char_y);
-                for (i = char_x, j = end_x; j < line->length; ++i, ++j) {
-                        line->string[i] = line->string[j];
-                }
-                /* 如果当前行为空，也不是第一行，并且上一行没有结束符 */
-                if (len <= 0 && end_y > 0 &&
-                    prev_line->eol != PD_TEXT_EOL_NONE) {
-                        pd_text_delete_line(text, end_y);
-                }
-                /* 调整起始行的容量 */
-                pd_text_line_set_length(line, len);
-                /* 更新文本行的尺寸 */
+                pd_text_line_release_chars(line, char_x, end_x);
+                pd_text_line_remove(line, char_x, end_x);
                 pd_text_update_line_size(text, line);
                 return 0;
         }
-        /* 如果结束点在行尾，并且该行不是最后一行 */
-        if (end_x == end_line->length && end_y < text->lines_length - 1) {
-                ++end_y;
-                end_line = pd_text_get_line(text, end_y);
-                end_x = -1;
-                len = char_x + end_line->length;
-        }
-        pd_text_line_set_length(line, len);
-        /* 标记当前行后面的所有行的矩形需区域需要刷新 */
-        pd_text_mark_dirty(text, char_y + 1, -1);
+        /* 标记当前行及后面的所有行的矩形区域需要刷新 */
+        pd_text_mark_dirty(text, char_y, -1);
+        pd_text_line_release_chars(line, char_x, line->length);
+        line->length = char_x;
         /* 移除起始行与结束行之间的文本行 */
-        for (i = char_y + 1, j = i; j < end_y; ++j) {
-                pd_text_mark_line_dirty(text, i, 0, -1);
-                pd_text_delete_line(text, i);
-        }
-        i = char_x;
-        j = end_x + 1;
-        end_y = char_y + 1;
-        /* 将结束行的内容拼接至起始行 */
-        for (; i < len && j < end_line->length; ++i, ++j) {
-                line->string[i] = end_line->string[j];
-        }
+        for (i = char_y + 1; i < end_y; ++i) {
+                pd_text_delete_line(text, char_y + 1);
+        }
+        /* 将结束行中结束点之后的文字拼接至起始行，然后移除结束行 */
+        pd_text_line_release_chars(end_line, 0, end_x);
+        pd_text_line_remove(end_line, 0, end_x);
+        if (pd_text_line_insert(line, char_x, end_line->string,
+                                end_line->length) == 0) {
+                end_line->length = 0;
+        }
+        line->eol = end_line->eol;
+        pd_text_delete_line(text, char_y + 1);
         pd_text_update_line_size(text, line);
-        pd_text_mark_line_dirty(text, end_y, 0, -1);
-        /* 移除结束行 */
-        pd_text_delete_line(text, end_y);
-        /* 如果起始行无内容，并且上一行没有结束符（换行符），则
-         * 说明需要删除起始行 */
-        if (len <= 0 && char_y > 0 && prev_line->eol != PD_TEXT_EOL_NONE) {
-                pd_text_mark_line_dirty(text, char_y, 0, -1);
-                pd_text_delete_line(text, char_y);
-        }
-        pd_text_set_typeset_task(text, char_y);
         return 0;
 }
 
@@ -1096,8 +1088,8 @@ void pd_text_reload_bitmap(pd_text_t *text)
         for (line_num = 0; line_num < text->lines_length; ++line_num) {
                 pd_text_line_t *line = text->lines[line_num];
                 for (col = 0; col < line->length; ++col) {
-                        pd_char_t *txtchar = line->string[col];
-                        pd_char_update_bitmap(txtchar, &text->default_style);
+                        pd_char_update_bitmap(&line->string[col],
+                                              &text->default_style);
                 }
                 pd_text_update_line_size(text, line);
         }
@@ -1174,12 +1166,12 @@ static void pd_text_render_line(pd_text_t *text, pd_rect_t *area,
 
         x = pd_text_get_line_start_x(text, line) + text->offset_x;
         for (col = 0; col < line->length && x < area->x + area->width; ++col) {
-                ch = line->string[col];
+                ch = &line->string[col];
                 if (!ch->bitmap) {
                         continue;
                 }
-                if (x + ch->bitmap->metrics.hori_advance < area->x) {
-                        x += ch->bitmap->metrics.hori_advance;
+                if (x + ch->advance < area->x) {
+                        x += ch->advance;
                         continue;
                 }
                 pen.x = layer_pos.x + x;
@@ -1189,14 +1181,14 @@ static void pd_text_render_line(pd_text_t *text, pd_rect_t *area,
                         rect.x = pen.x;
                         rect.y = pen.y;
                         rect.height = line->height;
-                        rect.width = ch->bitmap->metrics.hori_advance;
+                        rect.width = ch->advance;
                         pd_canvas_fill_rect(graph, ch->style->back_color, rect);
                 }
                 pen.x += ch->bitmap->left;
                 pen.y += (line->height - ch->bitmap->metrics.bbox_height) / 2 +
                          ch->bitmap->metrics.ascender - ch->bitmap->top;
                 pd_text_render_char(text, ch, graph, pen);
-                x += ch->bitmap->metrics.hori_advance;
+                x += ch->advance;
         }
 }
 
@@ -23,10 +23,10 @@ int pd_canvas_tile(pd_canvas_t *buff, const pd_canvas_t *canvas,
 	for (y = 0; y < buff->height; y += canvas->height) {
 		for (x = 0; x < buff->width; x += canvas->width) {
 			if (replace) {
-				ret += pd_canvas_replace(buff, canvas, y, x);
+				ret += pd_canvas_replace(buff, canvas, x, y);
 				continue;
 			}
-			ret += pd_canvas_mix(buff, canvas, y, x, with_alpha);
+			ret += pd_canvas_mix(buff, canvas, x, y, with_alpha);
 		}
 	}
 	return ret;
@@ -11,18 +11,14 @@
 
 #include <pandagl.h>
 
-static uint8_t canvas_bilinear_resampling_core(uint8_t a, uint8_t b, uint8_t c,
-					       uint8_t d, float dx, float dy)
-{
-	return (uint8_t)(a * (1 - dx) * (1 - dy) + b * (dx) * (1 - dy) +
-			 c * (dy) * (1 - dx) + d * (dx * dy));
-}
-
 int pd_canvas_zoom(const pd_canvas_t *canvas, pd_canvas_t *buff,
 		   bool keep_scale, int width, int height)
 {
 	pd_rect_t rect;
-	int x, y, src_x, src_y;
+	int x, y, src_y;
+	int *offsets;
+	const uint8_t *byte_src, *byte_row_src;
+	uint8_t *byte_des;
 	double scale_x = 0.0, scale_y = 0.0;
 
 	if (!pd_canvas_is_valid(canvas) || (width <= 0 && height <= 0)) {
@@ -57,35 +53,32 @@ int pd_canvas_zoom(const pd_canvas_t *canvas, pd_canvas_t *buff,
 	if (pd_canvas_create(buff, width, height) < 0) {
 		return -2;
 	}
-	if (canvas->color_type == PD_COLOR_TYPE_ARGB) {
-		pd_color_t *px_src, *px_des, *px_row_src;
-		for (y = 0; y < height; ++y) {
-			src_y = (int)(y * scale_y);
-			px_row_src = canvas->argb;
-			px_row_src += (src_y + rect.y) * canvas->width + rect.x;
-			px_des = buff->argb + y * width;
+	/* The offsets of the source pixels are computed once per column */
+	offsets = malloc(sizeof(int) * width);
+	if (!offsets) {
+		return -2;
+	}
+	for (x = 0; x < width; ++x) {
+		offsets[x] = ((int)(x * scale_x) + rect.x) * canvas->bytes_per_pixel;
+	}
+	for (y = 0; y < height; ++y) {
+		src_y = (int)(y * scale_y) + rect.y;
+		byte_row_src = pd_canvas_pixel_at(canvas, 0, src_y);
+		byte_des = pd_canvas_pixel_at(buff, 0, y);
+		if (canvas->bytes_per_pixel == 4) {
 			for (x = 0; x < width; ++x) {
-				src_x = (int)(x * scale_x);
-				px_src = px_row_src + src_x;
-				*px_des++ = *px_src;
+				((pd_color_t *)byte_des)[x] =
+				    *(pd_color_t *)(byte_row_src + offsets[x]);
 			}
+			continue;
 		}
-	} else {
-		uint8_t *byte_src, *byte_des, *byte_row_src;
-		for (y = 0; y < height; ++y) {
-			byte_row_src = pd_canvas_pixel_at(
-			    canvas, rect.x, (int)(y * scale_y) + rect.y);
-			byte_des = pd_canvas_pixel_at(buff, 0, y);
-			for (x = 0; x < width; ++x) {
-				src_x = (int)(x * scale_x);
-				src_x *= canvas->bytes_per_pixel;
-				byte_src = byte_row_src + src_x;
-				*byte_des++ = *byte_src++;
-				*byte_des++ = *byte_src++;
-				*byte_des++ = *byte_src;
-			}
+		for (x = 0; x < width; ++x) {
+			byte_src = byte_row_src + offsets[x];
+			memcpy(byte_des, byte_src, canvas->bytes_per_pixel);
+			byte_des += canvas->bytes_per_pixel;
 		}
 	}
+	free(offsets);
 	return 0;
 }
 
@@ -93,14 +86,14 @@ int pd_canvas_zoom_bilinear(const pd_canvas_t *canvas, pd_canvas_t *buff,
 			    bool keep_scale, int width, int height)
 {
 	pd_rect_t rect;
-	pd_color_t a, b, c, d, t_color;
-
-	int x, y, i, j;
-	float x_diff, y_diff;
+	pd_canvas_t area;
 	double scale_x = 0.0, scale_y = 0.0;
 
+	/* The premultiplied pixels are interpolated as they are, which keeps
+	 * the color of the transparent pixels out of the result */
 	if (canvas->color_type != PD_COLOR_TYPE_RGB &&
-	    canvas->color_type != PD_COLOR_TYPE_ARGB) {
+	    canvas->color_type != PD_COLOR_TYPE_ARGB &&
+	    canvas->color_type != PD_COLOR_TYPE_PARGB) {
 		/* fall back to nearest scaling */
 		logger_debug("[canvas] unable to perform bilinear scaling, "
 			     "fallback...\n");
@@ -134,43 +127,10 @@ int pd_canvas_zoom_bilinear(const pd_canvas_t *canvas, pd_canvas_t *buff,
 			scale_x = scale_y;
 		}
 	}
-	buff->color_type = canvas->color_type;
-	if (pd_canvas_create(buff, width, height) < 0) {
-		return -2;
-	}
-	for (i = 0; i < height; i++) {
-		for (j = 0; j < width; j++) {
-			/*
-			 * Qmn = (m, n).
-			 * Qxy1 = (x2 - x) / (x2 - x1) * Q11 + (x - x1) / (x2
-			 * - x1) * Q21
-			 * Qxy2 = (x2 - x) / (x2 - x1) * Q12 + (x - x1) / (x2
-			 * - x1) * Q22
-			 * Qxy = (y2 - y) / (y2 - y1) * Qxy1 + (y - y1) / (y2 -
-			 * y1) * Qxy2
-			 */
-			x = (int)(scale_x * j);
-			y = (int)(scale_y * i);
-			x_diff = (float)((scale_x * j) - x);
-			y_diff = (float)((scale_y * i) - y);
-			a = pd_canvas_get_pixel(canvas, x + rect.x + 0,
-						y + rect.y + 0);
-			b = pd_canvas_get_pixel(canvas, x + rect.x + 1,
-						y + rect.y + 0);
-			c = pd_canvas_get_pixel(canvas, x + rect.x + 0,
-						y + rect.y + 1);
-			d = pd_canvas_get_pixel(canvas, x + rect.x + 1,
-						y + rect.y + 1);
-			t_color.b = canvas_bilinear_resampling_core(
-			    a.b, b.b, c.b, d.b, x_diff, y_diff);
-			t_color.g = canvas_bilinear_resampling_core(
-			    a.g, b.g, c.g, d.g, x_diff, y_diff);
-			t_color.r = canvas_bilinear_resampling_core(
-			    a.r, b.r, c.r, d.r, x_diff, y_diff);
-			t_color.a = canvas_bilinear_resampling_core(
-			    a.a, b.a, c.a, d.a, x_diff, y_diff);
-			pd_canvas_set_pixel(buff, j, i, t_color);
-		}
-	}
-	return 0;
+	/* Resample the source area covered by the scaled output */
+	rect.width = y_min(rect.width, (int)(width * scale_x + 0.5));
+	rect.height = y_min(rect.height, (int)(height * scale_y + 0.5));
+	pd_canvas_quote(&area, (pd_canvas_t *)canvas, &rect);
+	return pd_canvas_resample(&area, buff, width, height,
+				  PD_RESAMPLE_BILINEAR);
 }
@@ -11,9 +11,26 @@
 
 #include "test.h"
 #include "ctest.h"
+#include <pandagl.h>
 
 int main()
 {
+	pd_blend_init();
+	ctest_describe("test_blend", test_blend);
+	ctest_describe("test_border", test_border);
+	ctest_describe("test_boxshadow", test_boxshadow);
 	ctest_describe("test_canvas_mix", test_canvas_mix);
+	ctest_describe("test_canvas_mix_mask", test_canvas_mix_mask);
+	ctest_describe("test_canvas_mix_premultiplied",
+		       test_canvas_mix_premultiplied);
+	ctest_describe("test_canvas_pool", test_canvas_pool);
+	ctest_describe("test_canvas_rgb565", test_canvas_rgb565);
+	ctest_describe("test_canvas_scroll", test_canvas_scroll);
+	ctest_describe("test_canvas_stride", test_canvas_stride);
+	ctest_describe("test_font_cache", test_font_cache);
+	ctest_describe("test_image_cache", test_image_cache);
+	ctest_describe("test_region", test_region);
+	ctest_describe("test_resample", test_resample);
+	ctest_describe("test_text_edit", test_text_edit);
 	return ctest_finish();
 }
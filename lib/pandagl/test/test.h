@@ -9,4 +9,18 @@
  * LICENSE.TXT file in the root directory of this source tree.
  */
 
+void test_blend(void);
+void test_border(void);
+void test_boxshadow(void);
 void test_canvas_mix(void);
+void test_canvas_mix_mask(void);
+void test_canvas_mix_premultiplied(void);
+void test_canvas_rgb565(void);
+void test_canvas_pool(void);
+void test_canvas_scroll(void);
+void test_canvas_stride(void);
+void test_font_cache(void);
+void test_image_cache(void);
+void test_region(void);
+void test_resample(void);
+void test_text_edit(void);
@@ -0,0 +1,306 @@
+﻿/*
+ * lib/pandagl/test/test_blend.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+#define WIDTH 67
+#define HEIGHT 9
+
+static void fill_random(pd_canvas_t *canvas, unsigned seed)
+{
+	unsigned x, y;
+	pd_color_t *px;
+
+	for (y = 0; y < canvas->height; ++y) {
+		for (x = 0; x < canvas->width; ++x) {
+			seed = seed * 1103515245 + 12345;
+			if (canvas->bytes_per_pixel == 4) {
+				px = pd_canvas_pixel_at(canvas, x, y);
+				px->value = seed ^ (seed >> 13);
+				/* Cover fully transparent and opaque pixels */
+				if (x % 7 == 0) {
+					px->a = 0;
+				} else if (x % 7 == 1) {
+					px->a = 255;
+				}
+				if (canvas->color_type == PD_COLOR_TYPE_PARGB) {
+					pd_premultiply_pixel(px);
+				}
+			} else {
+				memcpy(pd_canvas_pixel_at(canvas, x, y), &seed,
+				       canvas->bytes_per_pixel);
+			}
+		}
+	}
+}
+
+/** Get the maximum difference of the channels */
+static int canvas_diff(pd_canvas_t *a, pd_canvas_t *b)
+{
+	size_t i;
+	int diff, max_diff = 0;
+
+	for (i = 0; i < a->mem_size; ++i) {
+		diff = abs(a->bytes[i] - b->bytes[i]);
+		if (diff > max_diff) {
+			max_diff = diff;
+		}
+	}
+	return max_diff;
+}
+
+/**
+ * Blend the same canvases with the implementation and the scalar reference,
+ * return the maximum difference
+ */
+static int blend_diff(pd_blend_impl_t impl, pd_color_type_t fore_color_type,
+		      pd_color_type_t color_type, bool with_alpha,
+		      float opacity)
+{
+	int diff;
+	pd_canvas_t fore, expected, actual;
+
+	pd_canvas_init(&fore);
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	fore.color_type = fore_color_type;
+	expected.color_type = color_type;
+	actual.color_type = color_type;
+	pd_canvas_create(&fore, WIDTH, HEIGHT);
+	pd_canvas_create(&expected, WIDTH + 3, HEIGHT);
+	pd_canvas_create(&actual, WIDTH + 3, HEIGHT);
+	fill_random(&fore, 1);
+	fill_random(&expected, 2);
+	fill_random(&actual, 2);
+	fore.opacity = opacity;
+
+	pd_set_blend_impl(PD_BLEND_IMPL_SCALAR);
+	pd_canvas_mix(&expected, &fore, 1, 0, with_alpha);
+	pd_set_blend_impl(impl);
+	pd_canvas_mix(&actual, &fore, 1, 0, with_alpha);
+	diff = canvas_diff(&expected, &actual);
+
+	pd_canvas_destroy(&fore);
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	return diff;
+}
+
+/** Same as blend_diff(), but paint a color through an A8 mask */
+static int mask_diff(pd_blend_impl_t impl, pd_color_type_t color_type)
+{
+	int diff;
+	unsigned x, y;
+	pd_canvas_t mask, expected, actual;
+	pd_color_t color = pd_argb(200, 30, 140, 250);
+	pd_color_t opaque_color = pd_rgb(30, 140, 250);
+
+	pd_canvas_init(&mask);
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	mask.color_type = PD_COLOR_TYPE_A8;
+	expected.color_type = color_type;
+	actual.color_type = color_type;
+	pd_canvas_create(&mask, WIDTH, HEIGHT);
+	pd_canvas_create(&expected, WIDTH + 3, HEIGHT);
+	pd_canvas_create(&actual, WIDTH + 3, HEIGHT);
+	for (y = 0; y < mask.height; ++y) {
+		for (x = 0; x < mask.width; ++x) {
+			/* Include spans without coverage and full spans */
+			if (x >= 8 && x < 16) {
+				*(uint8_t *)pd_canvas_pixel_at(&mask, x, y) = 0;
+			} else if (x >= 16 && x < 24) {
+				*(uint8_t *)pd_canvas_pixel_at(&mask, x, y) =
+				    255;
+			} else {
+				*(uint8_t *)pd_canvas_pixel_at(&mask, x, y) =
+				    (uint8_t)(x % 3 == 0 ? 255
+							 : x * 37 + y * 11);
+			}
+		}
+	}
+	fill_random(&expected, 2);
+	fill_random(&actual, 2);
+
+	pd_set_blend_impl(PD_BLEND_IMPL_SCALAR);
+	pd_canvas_mix_mask(&expected, &mask, color, 1, 0);
+	pd_canvas_mix_mask(&expected, &mask, opaque_color, 2, 0);
+	pd_set_blend_impl(impl);
+	pd_canvas_mix_mask(&actual, &mask, color, 1, 0);
+	pd_canvas_mix_mask(&actual, &mask, opaque_color, 2, 0);
+	diff = canvas_diff(&expected, &actual);
+
+	pd_canvas_destroy(&mask);
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	return diff;
+}
+
+/**
+ * Same as blend_diff(), but convert the pixels to another color type, into
+ * the whole canvas and into a part of it
+ */
+static int format_diff(pd_blend_impl_t impl, pd_color_type_t in_color_type,
+		       pd_color_type_t out_color_type, unsigned width)
+{
+	int diff;
+	pd_canvas_t in, expected, actual;
+
+	pd_canvas_init(&in);
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	in.color_type = in_color_type;
+	expected.color_type = out_color_type;
+	actual.color_type = out_color_type;
+	pd_canvas_create(&in, width, HEIGHT);
+	pd_canvas_create(&expected, width, HEIGHT * 2);
+	pd_canvas_create(&actual, width, HEIGHT * 2);
+	fill_random(&in, 3);
+
+	pd_set_blend_impl(PD_BLEND_IMPL_SCALAR);
+	pd_canvas_replace(&expected, &in, 0, 0);
+	pd_canvas_replace(&expected, &in, 3, HEIGHT);
+	pd_set_blend_impl(impl);
+	pd_canvas_replace(&actual, &in, 0, 0);
+	pd_canvas_replace(&actual, &in, 3, HEIGHT);
+	diff = canvas_diff(&expected, &actual);
+
+	pd_canvas_destroy(&in);
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	return diff;
+}
+
+/** Same as blend_diff(), but fill a part of the canvas with the color */
+static int fill_diff(pd_blend_impl_t impl, pd_color_type_t color_type)
+{
+	int diff;
+	pd_rect_t rect = { 1, 2, WIDTH - 3, HEIGHT - 3 };
+	pd_canvas_t expected, actual;
+	pd_color_t color = pd_argb(200, 30, 140, 250);
+
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	expected.color_type = color_type;
+	actual.color_type = color_type;
+	pd_canvas_create(&expected, WIDTH, HEIGHT);
+	pd_canvas_create(&actual, WIDTH, HEIGHT);
+
+	pd_set_blend_impl(PD_BLEND_IMPL_SCALAR);
+	pd_canvas_fill_rect(&expected, color, rect);
+	pd_set_blend_impl(impl);
+	pd_canvas_fill_rect(&actual, color, rect);
+	diff = canvas_diff(&expected, &actual);
+
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	return diff;
+}
+
+static void test_blend_impl(pd_blend_impl_t impl, const char *name)
+{
+	char str[128];
+	float opacity[] = { 1.0f, 0.37f };
+	size_t i;
+
+	if (!pd_blend_impl_is_supported(impl)) {
+		printf("%s is not supported, skipped\n", name);
+		return;
+	}
+	snprintf(str, sizeof(str), "%s: mask mix", name);
+	ctest_equal_int(str,
+			mask_diff(impl, PD_COLOR_TYPE_ARGB) +
+			    mask_diff(impl, PD_COLOR_TYPE_PARGB) +
+			    mask_diff(impl, PD_COLOR_TYPE_RGB),
+			0);
+	snprintf(str, sizeof(str), "%s: fill", name);
+	ctest_equal_int(str,
+			fill_diff(impl, PD_COLOR_TYPE_ARGB) +
+			    fill_diff(impl, PD_COLOR_TYPE_PARGB) +
+			    fill_diff(impl, PD_COLOR_TYPE_RGB) +
+			    fill_diff(impl, PD_COLOR_TYPE_RGB565),
+			0);
+	/* 64 pixels wide rows are contiguous in all color types */
+	for (i = 0; i < 2; ++i) {
+		snprintf(str, sizeof(str), "%s: pixel format conversion (%u)",
+			 name, i ? 64 : WIDTH);
+		ctest_equal_int(
+		    str,
+		    format_diff(impl, PD_COLOR_TYPE_ARGB, PD_COLOR_TYPE_RGB,
+				i ? 64 : WIDTH) +
+			format_diff(impl, PD_COLOR_TYPE_RGB, PD_COLOR_TYPE_ARGB,
+				    i ? 64 : WIDTH) +
+			format_diff(impl, PD_COLOR_TYPE_ARGB,
+				    PD_COLOR_TYPE_PARGB, i ? 64 : WIDTH) +
+			format_diff(impl, PD_COLOR_TYPE_ARGB,
+				    PD_COLOR_TYPE_RGB565, i ? 64 : WIDTH) +
+			format_diff(impl, PD_COLOR_TYPE_RGB565,
+				    PD_COLOR_TYPE_ARGB, i ? 64 : WIDTH),
+		    0);
+	}
+	for (i = 0; i < sizeof(opacity) / sizeof(opacity[0]); ++i) {
+		snprintf(str, sizeof(str), "%s: argb mix (opacity: %g)", name,
+			 opacity[i]);
+		ctest_equal_int(str,
+				blend_diff(impl, PD_COLOR_TYPE_ARGB,
+					   PD_COLOR_TYPE_ARGB, false,
+					   opacity[i]),
+				0);
+		snprintf(str, sizeof(str), "%s: argb to rgb mix (opacity: %g)",
+			 name, opacity[i]);
+		ctest_equal_int(str,
+				blend_diff(impl, PD_COLOR_TYPE_ARGB,
+					   PD_COLOR_TYPE_RGB, false,
+					   opacity[i]),
+				0);
+		snprintf(str, sizeof(str),
+			 "%s: premultiplied over operator (opacity: %g)", name,
+			 opacity[i]);
+		ctest_equal_int(str,
+				blend_diff(impl, PD_COLOR_TYPE_PARGB,
+					   PD_COLOR_TYPE_PARGB, true,
+					   opacity[i]),
+				0);
+		snprintf(str, sizeof(str),
+			 "%s: argb to premultiplied mix (opacity: %g)", name,
+			 opacity[i]);
+		ctest_equal_int(str,
+				blend_diff(impl, PD_COLOR_TYPE_ARGB,
+					   PD_COLOR_TYPE_PARGB, true,
+					   opacity[i]),
+				0);
+		/* The double precision results may differ by the last bit if
+		 * the compiler fuses the multiplications and additions */
+		snprintf(str, sizeof(str),
+			 "%s: argb over operator (opacity: %g)", name,
+			 opacity[i]);
+		ctest_equal_bool(str,
+				 blend_diff(impl, PD_COLOR_TYPE_ARGB,
+					    PD_COLOR_TYPE_ARGB, true,
+					    opacity[i]) <= 1,
+				 true);
+	}
+}
+
+void test_blend(void)
+{
+	pd_blend_impl_t impl = pd_get_blend_impl();
+
+	test_blend_impl(PD_BLEND_IMPL_SSE2, "sse2");
+	test_blend_impl(PD_BLEND_IMPL_AVX2, "avx2");
+	test_blend_impl(PD_BLEND_IMPL_NEON, "neon");
+	pd_set_blend_impl(impl);
+}
@@ -0,0 +1,199 @@
+﻿/*
+ * lib/pandagl/test/test_border.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+#define BOX_WIDTH 90
+#define BOX_HEIGHT 60
+
+static void init_border(pd_border_t *border)
+{
+	memset(border, 0, sizeof(pd_border_t));
+	border->top.width = 4;
+	border->right.width = 4;
+	border->bottom.width = 4;
+	border->left.width = 4;
+	border->top.color = pd_rgb(255, 0, 0);
+	border->right.color = pd_rgb(255, 0, 0);
+	border->bottom.color = pd_rgb(255, 0, 0);
+	border->left.color = pd_rgb(255, 0, 0);
+	border->top_left_radius = 20;
+	border->top_right_radius = 20;
+	border->bottom_left_radius = 20;
+	border->bottom_right_radius = 20;
+}
+
+static void init_canvas(pd_canvas_t *canvas, pd_color_type_t color_type)
+{
+	pd_canvas_init(canvas);
+	canvas->color_type = color_type;
+	pd_canvas_create(canvas, BOX_WIDTH, BOX_HEIGHT);
+	pd_canvas_fill(canvas, pd_rgb(255, 255, 255));
+}
+
+static void paint_border(pd_canvas_t *canvas, const pd_border_t *border,
+			 bool crop)
+{
+	pd_rect_t box = { 0, 0, BOX_WIDTH, BOX_HEIGHT };
+	pd_context_t ctx;
+
+	ctx.rect = box;
+	ctx.with_alpha = true;
+	pd_canvas_quote(&ctx.canvas, canvas, &box);
+	if (crop) {
+		pd_crop_border_content(&ctx, border, &box);
+	} else {
+		pd_paint_border(&ctx, border, &box);
+	}
+}
+
+static bool canvas_is_mirrored(pd_canvas_t *canvas)
+{
+	unsigned x, y;
+
+	for (y = 0; y < canvas->height; ++y) {
+		for (x = 0; x < canvas->width / 2; ++x) {
+			if (pd_canvas_get_pixel(canvas, x, y).value !=
+			    pd_canvas_get_pixel(canvas, canvas->width - 1 - x, y)
+				.value) {
+				return false;
+			}
+			if (pd_canvas_get_pixel(canvas, x, y).value !=
+			    pd_canvas_get_pixel(canvas, x, canvas->height - 1 - y)
+				.value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void test_border_paint(void)
+{
+	pd_border_t border;
+	pd_canvas_t expected, actual;
+
+	init_border(&border);
+	init_canvas(&expected, PD_COLOR_TYPE_ARGB);
+	paint_border(&expected, &border, false);
+	ctest_equal_int("the outer corner is transparent",
+			pd_canvas_get_pixel(&expected, 0, 0).a, 0);
+	ctest_equal_int("the top line has the border color",
+			pd_canvas_get_pixel(&expected, 45, 1).value,
+			pd_rgb(255, 0, 0).value);
+	ctest_equal_int("the padding box is not changed",
+			pd_canvas_get_pixel(&expected, 45, 30).value,
+			pd_rgb(255, 255, 255).value);
+	ctest_equal_bool("the corner edge is anti-aliased",
+			 pd_canvas_get_pixel(&expected, 5, 5).a > 0 &&
+			     pd_canvas_get_pixel(&expected, 5, 5).a < 255,
+			 true);
+	ctest_equal_bool("the corners are symmetric",
+			 canvas_is_mirrored(&expected), true);
+
+	pd_border_cache_init(0);
+	init_canvas(&actual, PD_COLOR_TYPE_ARGB);
+	paint_border(&actual, &border, false);
+	pd_canvas_destroy(&actual);
+	init_canvas(&actual, PD_COLOR_TYPE_ARGB);
+	paint_border(&actual, &border, false);
+	ctest_equal_bool("the cached mask gives the same result",
+			 memcmp(expected.bytes, actual.bytes,
+				expected.mem_size) == 0,
+			 true);
+	pd_canvas_destroy(&actual);
+	pd_border_cache_destroy();
+	pd_canvas_destroy(&expected);
+}
+
+static void test_border_crop(void)
+{
+	unsigned x, y;
+	bool ok = true;
+	pd_border_t border;
+	pd_canvas_t canvas;
+	pd_color_t c;
+
+	init_border(&border);
+	init_canvas(&canvas, PD_COLOR_TYPE_PARGB);
+	paint_border(&canvas, &border, true);
+	ctest_equal_int("the content outside the inner edge is cleared",
+			pd_canvas_get_pixel(&canvas, 5, 5).value, 0);
+	ctest_equal_int("the content inside the inner edge is kept",
+			pd_canvas_get_pixel(&canvas, 45, 30).value,
+			pd_rgb(255, 255, 255).value);
+	ctest_equal_bool("the cropped corners are symmetric",
+			 canvas_is_mirrored(&canvas), true);
+	for (y = 0; y < canvas.height; ++y) {
+		for (x = 0; x < canvas.width; ++x) {
+			c = pd_canvas_get_pixel(&canvas, x, y);
+			if (c.r != c.a || c.g != c.a || c.b != c.a) {
+				ok = false;
+			}
+		}
+	}
+	ctest_equal_bool("the cropped pixels stay premultiplied", ok, true);
+	pd_canvas_destroy(&canvas);
+}
+
+static void test_border_crop_impl(pd_blend_impl_t impl, const char *name)
+{
+	char str[128];
+	unsigned x, y;
+	pd_border_t border;
+	pd_canvas_t expected, actual;
+	pd_color_t c;
+
+	if (!pd_blend_impl_is_supported(impl)) {
+		return;
+	}
+	init_border(&border);
+	border.top_left_radius = 37;
+	border.left.width = 9;
+	border.bottom_right_radius = 15;
+	init_canvas(&expected, PD_COLOR_TYPE_PARGB);
+	init_canvas(&actual, PD_COLOR_TYPE_PARGB);
+	for (y = 0; y < expected.height; ++y) {
+		for (x = 0; x < expected.width; ++x) {
+			c.value = (x * 2654435761u) ^ (y * 40503u);
+			pd_premultiply_pixel(&c);
+			pd_canvas_set_pixel(&expected, x, y, c);
+			pd_canvas_set_pixel(&actual, x, y, c);
+		}
+	}
+	pd_set_blend_impl(PD_BLEND_IMPL_SCALAR);
+	paint_border(&expected, &border, true);
+	pd_set_blend_impl(impl);
+	paint_border(&actual, &border, true);
+	snprintf(str, sizeof(str), "%s: the cropped content is the same", name);
+	ctest_equal_bool(str,
+			 memcmp(expected.bytes, actual.bytes,
+				expected.mem_size) == 0,
+			 true);
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+}
+
+void test_border(void)
+{
+	pd_blend_impl_t impl = pd_get_blend_impl();
+
+	test_border_paint();
+	test_border_crop();
+	test_border_crop_impl(PD_BLEND_IMPL_SSE2, "sse2");
+	test_border_crop_impl(PD_BLEND_IMPL_AVX2, "avx2");
+	test_border_crop_impl(PD_BLEND_IMPL_NEON, "neon");
+	pd_set_blend_impl(impl);
+}
@@ -0,0 +1,134 @@
+﻿/*
+ * lib/pandagl/test/test_boxshadow.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+#define CONTENT_WIDTH 120
+#define CONTENT_HEIGHT 80
+
+static void init_shadow(pd_boxshadow_t *shadow)
+{
+	shadow->x = 0;
+	shadow->y = 0;
+	shadow->blur = 8;
+	shadow->spread = 2;
+	shadow->color = pd_argb(200, 0, 0, 0);
+	shadow->top_left_radius = 10;
+	shadow->top_right_radius = 10;
+	shadow->bottom_left_radius = 10;
+	shadow->bottom_right_radius = 10;
+}
+
+/** Paint the shadow into the canvas, split into tiles of the given size */
+static void paint_shadow(pd_canvas_t *canvas, const pd_boxshadow_t *shadow,
+			 int tile_size)
+{
+	pd_rect_t box = { 0, 0, CONTENT_WIDTH + 20, CONTENT_HEIGHT + 20 };
+	pd_context_t ctx;
+
+	pd_canvas_init(canvas);
+	canvas->color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(canvas, box.width, box.height);
+	ctx.with_alpha = true;
+	for (ctx.rect.y = 0; ctx.rect.y < box.height; ctx.rect.y += tile_size) {
+		for (ctx.rect.x = 0; ctx.rect.x < box.width;
+		     ctx.rect.x += tile_size) {
+			ctx.rect.width = tile_size;
+			ctx.rect.height = tile_size;
+			pd_rect_overlap(&ctx.rect, &box, &ctx.rect);
+			pd_canvas_quote(&ctx.canvas, canvas, &ctx.rect);
+			pd_paint_boxshadow(&ctx, shadow, &box, CONTENT_WIDTH,
+					   CONTENT_HEIGHT);
+		}
+	}
+}
+
+static bool canvas_is_mirrored(pd_canvas_t *canvas)
+{
+	unsigned x, y;
+
+	for (y = 0; y < canvas->height; ++y) {
+		for (x = 0; x < canvas->width / 2; ++x) {
+			if (pd_canvas_get_pixel(canvas, x, y).value !=
+			    pd_canvas_get_pixel(canvas, canvas->width - 1 - x, y)
+				.value) {
+				return false;
+			}
+			if (pd_canvas_get_pixel(canvas, x, y).value !=
+			    pd_canvas_get_pixel(canvas, x, canvas->height - 1 - y)
+				.value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void test_boxshadow(void)
+{
+	int x;
+	bool ok;
+	pd_boxshadow_t shadow;
+	pd_canvas_t expected, actual;
+
+	init_shadow(&shadow);
+	paint_shadow(&expected, &shadow, 1000);
+	ctest_equal_int("the outer corner is transparent",
+			pd_canvas_get_pixel(&expected, 0, 0).a, 0);
+	/* The content box starts at x = 10, the spread ends at x = 8 */
+	ctest_equal_bool("the shadow is half opaque at the edge of the spread",
+			 pd_canvas_get_pixel(&expected, 8, 50).a > 80 &&
+			     pd_canvas_get_pixel(&expected, 8, 50).a < 130,
+			 true);
+	ctest_equal_int("the content box is cleared",
+			pd_canvas_get_pixel(&expected, 70, 50).a, 0);
+	for (ok = true, x = 1; x < 10; ++x) {
+		if (pd_canvas_get_pixel(&expected, x, 50).a <
+		    pd_canvas_get_pixel(&expected, x - 1, 50).a) {
+			ok = false;
+		}
+	}
+	ctest_equal_bool("the edge fades out", ok, true);
+	ctest_equal_bool("the stretched shadow is symmetric",
+			 canvas_is_mirrored(&expected), true);
+
+	paint_shadow(&actual, &shadow, 32);
+	ctest_equal_bool("painting in tiles gives the same result",
+			 memcmp(expected.bytes, actual.bytes,
+				expected.mem_size) == 0,
+			 true);
+	pd_canvas_destroy(&actual);
+
+	pd_boxshadow_cache_init(0);
+	paint_shadow(&actual, &shadow, 1000);
+	pd_canvas_destroy(&actual);
+	paint_shadow(&actual, &shadow, 1000);
+	ctest_equal_bool("the cached mask gives the same result",
+			 memcmp(expected.bytes, actual.bytes,
+				expected.mem_size) == 0,
+			 true);
+	pd_canvas_destroy(&actual);
+	pd_boxshadow_cache_destroy();
+	pd_canvas_destroy(&expected);
+
+	/* Large radii do not leave room for a nine-patch */
+	shadow.top_left_radius = 40;
+	shadow.top_right_radius = 40;
+	shadow.bottom_left_radius = 40;
+	shadow.bottom_right_radius = 40;
+	paint_shadow(&expected, &shadow, 1000);
+	ctest_equal_bool("the small shadow is symmetric",
+			 canvas_is_mirrored(&expected), true);
+	pd_canvas_destroy(&expected);
+}
@@ -69,3 +69,216 @@ void test_canvas_mix(void)
 	pd_canvas_destroy(&red_layer);
 	pd_canvas_destroy(&blue_layer);
 }
+
+void test_canvas_mix_premultiplied(void)
+{
+	char rgba_str[64];
+	pd_color_t *pixel;
+	pd_color_t color = pd_argb(128, 255, 0, 0);
+	pd_color_t white = pd_rgb(255, 255, 255);
+	pd_color_t blue = pd_argb(204, 0, 0, 255);
+	pd_canvas_t white_layer;
+	pd_canvas_t layer;
+	pd_canvas_t blue_layer;
+
+	pd_canvas_init(&white_layer);
+	white_layer.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&white_layer, 100, 100);
+	pd_canvas_fill(&white_layer, white);
+
+	pd_canvas_init(&layer);
+	layer.color_type = PD_COLOR_TYPE_PARGB;
+	layer.opacity = 0.5;
+	pd_canvas_create(&layer, 80, 80);
+
+	pd_canvas_init(&blue_layer);
+	blue_layer.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&blue_layer, 60, 60);
+	pd_canvas_fill(&blue_layer, blue);
+
+	pd_canvas_mix(&layer, &blue_layer, 10, 10, true);
+	pixel = pd_canvas_pixel_at(&layer, 15, 15);
+	color2str(rgba_str, pixel);
+	ctest_equal_str("layer(15, 15)", rgba_str, "rgba(0, 0, 204, 0.8)");
+
+	pd_canvas_mix(&white_layer, &layer, 10, 10, true);
+	pixel = pd_canvas_pixel_at(&white_layer, 15, 15);
+	color2str(rgba_str, pixel);
+	ctest_equal_str("white_layer(15, 15)", rgba_str,
+			"rgba(255, 255, 255, 1)");
+
+	pixel = pd_canvas_pixel_at(&white_layer, 25, 25);
+	color2str(rgba_str, pixel);
+	ctest_equal_str("white_layer(25, 25)", rgba_str,
+			"rgba(153, 153, 255, 1)");
+
+	pd_canvas_fill(&layer, color);
+	pixel = pd_canvas_pixel_at(&layer, 0, 0);
+	color2str(rgba_str, pixel);
+	ctest_equal_str("fill the premultiplied layer", rgba_str,
+			"rgba(128, 0, 0, 0.501961)");
+
+	pd_canvas_set_color_type(&layer, PD_COLOR_TYPE_ARGB);
+	pixel = pd_canvas_pixel_at(&layer, 0, 0);
+	color2str(rgba_str, pixel);
+	ctest_equal_str("convert to straight alpha", rgba_str,
+			"rgba(255, 0, 0, 0.501961)");
+
+	pd_canvas_destroy(&white_layer);
+	pd_canvas_destroy(&layer);
+	pd_canvas_destroy(&blue_layer);
+}
+
+void test_canvas_mix_mask(void)
+{
+	int i;
+	char rgba_str[64];
+	pd_color_t pixel;
+	pd_color_t red = pd_rgb(255, 0, 0);
+	pd_canvas_t mask, canvas;
+
+	pd_canvas_init(&mask);
+	mask.color_type = PD_COLOR_TYPE_A8;
+	pd_canvas_create(&mask, 40, 10);
+	pd_canvas_fill(&mask, pd_argb(128, 0, 0, 0));
+	ctest_equal_int("the A8 canvas has one byte per pixel",
+			mask.bytes_per_pixel, 1);
+
+	pd_canvas_init(&canvas);
+	canvas.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&canvas, 50, 20);
+	pd_canvas_fill(&canvas, pd_rgb(255, 255, 255));
+	pd_canvas_mix_mask(&canvas, &mask, red, 5, 5);
+	pixel = pd_canvas_get_pixel(&canvas, 10, 10);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("mix the mask into the argb canvas", rgba_str,
+			"rgba(255, 127, 127, 1)");
+	pixel = pd_canvas_get_pixel(&canvas, 2, 2);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("the pixels outside the mask are not changed",
+			rgba_str, "rgba(255, 255, 255, 1)");
+	pd_canvas_destroy(&canvas);
+
+	canvas.color_type = PD_COLOR_TYPE_PARGB;
+	pd_canvas_create(&canvas, 50, 20);
+	pd_canvas_mix_mask(&canvas, &mask, red, 5, 5);
+	pixel = pd_canvas_get_pixel(&canvas, 10, 10);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("mix the mask into the premultiplied canvas", rgba_str,
+			"rgba(128, 0, 0, 0.501961)");
+	pd_canvas_destroy(&canvas);
+
+	canvas.color_type = PD_COLOR_TYPE_RGB;
+	pd_canvas_create(&canvas, 50, 20);
+	pd_canvas_fill(&canvas, pd_rgb(255, 255, 255));
+	pd_canvas_mix_mask(&canvas, &mask, red, -5, 15);
+	pixel = pd_canvas_get_pixel(&canvas, 0, 19);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("mix the mask into the rgb canvas", rgba_str,
+			"rgba(255, 127, 127, 1)");
+	pd_canvas_destroy(&canvas);
+
+	canvas.color_type = PD_COLOR_TYPE_A8;
+	pd_canvas_create(&canvas, 50, 20);
+	pd_canvas_fill(&canvas, pd_argb(128, 0, 0, 0));
+	mask.opacity = 0.5;
+	pd_canvas_mix_mask(&canvas, &mask, red, 0, 0);
+	ctest_equal_int("mix the mask into the A8 canvas",
+			pd_canvas_get_pixel(&canvas, 0, 0).a, 160);
+	ctest_equal_int("mix a canvas into the A8 canvas is not supported",
+			pd_canvas_mix(&canvas, &mask, 0, 0, true), -3);
+	pd_canvas_destroy(&canvas);
+	pd_canvas_destroy(&mask);
+
+	pd_canvas_init(&mask);
+	mask.color_type = PD_COLOR_TYPE_A8;
+	pd_canvas_create(&mask, 4, 4);
+	for (i = 0; i < 16; ++i) {
+		mask.bytes[i] = (uint8_t)(i * 16);
+	}
+	canvas.color_type = PD_COLOR_TYPE_A8;
+	pd_canvas_create(&canvas, 10, 10);
+	pd_canvas_fill(&canvas, pd_argb(0, 0, 0, 0));
+	pd_canvas_mix_mask(&canvas, &mask, red, -1, -2);
+	ctest_equal_int("the mask cropped at the top left is not shifted",
+			pd_canvas_get_pixel(&canvas, 0, 0).a, 9 * 16);
+	ctest_equal_int("the mask cropped at the top left is not shifted",
+			pd_canvas_get_pixel(&canvas, 2, 1).a, 15 * 16);
+	pd_canvas_destroy(&canvas);
+	pd_canvas_destroy(&mask);
+}
+
+void test_canvas_rgb565(void)
+{
+	char rgba_str[64];
+	pd_color_t pixel;
+	pd_canvas_t canvas, fore, mask, argb;
+
+	pd_canvas_init(&canvas);
+	canvas.color_type = PD_COLOR_TYPE_RGB565;
+	pd_canvas_create(&canvas, 50, 20);
+	ctest_equal_int("the RGB565 canvas has two bytes per pixel",
+			canvas.bytes_per_pixel, 2);
+	pd_canvas_fill(&canvas, pd_rgb(255, 128, 0));
+	pixel = pd_canvas_get_pixel(&canvas, 49, 19);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("fill the RGB565 canvas", rgba_str,
+			"rgba(255, 130, 0, 1)");
+
+	pd_canvas_init(&argb);
+	argb.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&argb, 50, 20);
+	pd_canvas_replace(&argb, &canvas, 0, 0);
+	pixel = pd_canvas_get_pixel(&argb, 49, 19);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("convert the RGB565 canvas to argb", rgba_str,
+			"rgba(255, 130, 0, 1)");
+	pd_canvas_fill(&argb, pd_rgb(255, 255, 255));
+	pd_canvas_replace(&canvas, &argb, 0, 0);
+	pixel = pd_canvas_get_pixel(&canvas, 0, 0);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("convert the argb canvas to RGB565", rgba_str,
+			"rgba(255, 255, 255, 1)");
+	pd_canvas_destroy(&argb);
+
+	/* 255, 127, 127 is rounded to 31, 31, 15 in RGB565 */
+	pd_canvas_init(&fore);
+	fore.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&fore, 10, 10);
+	pd_canvas_fill(&fore, pd_argb(128, 255, 0, 0));
+	pd_canvas_mix(&canvas, &fore, 0, 0, false);
+	pixel = pd_canvas_get_pixel(&canvas, 5, 5);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("mix the argb canvas into the RGB565 canvas", rgba_str,
+			"rgba(255, 125, 123, 1)");
+	pixel = pd_canvas_get_pixel(&canvas, 15, 5);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("the pixels outside the argb canvas are not changed",
+			rgba_str, "rgba(255, 255, 255, 1)");
+
+	pd_canvas_premultiply(&fore);
+	pd_canvas_mix(&canvas, &fore, 10, 0, true);
+	pixel = pd_canvas_get_pixel(&canvas, 15, 5);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("mix the premultiplied canvas into the RGB565 canvas",
+			rgba_str, "rgba(255, 125, 123, 1)");
+	pd_canvas_destroy(&fore);
+
+	pd_canvas_init(&mask);
+	mask.color_type = PD_COLOR_TYPE_A8;
+	pd_canvas_create(&mask, 10, 10);
+	pd_canvas_fill(&mask, pd_argb(128, 0, 0, 0));
+	pd_canvas_mix_mask(&canvas, &mask, pd_rgb(255, 0, 0), 20, 0);
+	pixel = pd_canvas_get_pixel(&canvas, 25, 5);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("mix the mask into the RGB565 canvas", rgba_str,
+			"rgba(255, 125, 123, 1)");
+	pd_canvas_fill(&mask, pd_argb(255, 0, 0, 0));
+	pd_canvas_mix_mask(&canvas, &mask, pd_rgb(0, 0, 255), 30, 0);
+	pixel = pd_canvas_get_pixel(&canvas, 35, 5);
+	color2str(rgba_str, &pixel);
+	ctest_equal_str("the full coverage gives the color", rgba_str,
+			"rgba(0, 0, 255, 1)");
+	pd_canvas_destroy(&mask);
+	pd_canvas_destroy(&canvas);
+}
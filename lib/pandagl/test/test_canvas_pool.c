@@ -0,0 +1,64 @@
+﻿/*
+ * lib/pandagl/test/test_canvas_pool.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+void test_canvas_pool(void)
+{
+	uint8_t *bytes;
+	pd_color_t *pixel;
+	pd_canvas_t a, b;
+	pd_canvas_pool_t *pool;
+	pd_canvas_pool_stats_t stats;
+
+	pool = pd_canvas_pool_create(0);
+	pd_canvas_init(&a);
+	pd_canvas_init(&b);
+	a.color_type = PD_COLOR_TYPE_ARGB;
+	b.color_type = PD_COLOR_TYPE_ARGB;
+
+	ctest_equal_int("alloc 100x100", pd_canvas_pool_alloc(pool, &a, 100, 100),
+			0);
+	ctest_equal_bool("mem_size >= size", a.mem_size >= 100 * 100 * 4, true);
+	pd_canvas_fill(&a, pd_rgb(255, 0, 0));
+	bytes = a.bytes;
+	pd_canvas_pool_free(pool, &a);
+	ctest_equal_bool("freed canvas is empty", a.bytes == NULL, true);
+
+	pd_canvas_pool_alloc(pool, &b, 90, 110);
+	ctest_equal_bool("reuse the buffer of the same size class",
+			 b.bytes == bytes, true);
+	pixel = pd_canvas_pixel_at(&b, 89, 109);
+	ctest_equal_uint("reused buffer is cleared", pixel->value, 0);
+	pd_canvas_pool_get_stats(pool, &stats);
+	ctest_equal_uint("stats.allocs", (unsigned)stats.allocs, 2);
+	ctest_equal_uint("stats.reuses", (unsigned)stats.reuses, 1);
+	ctest_equal_bool("stats.peak_memory",
+			 stats.peak_memory == b.mem_size, true);
+
+	pd_canvas_pool_alloc(pool, &a, 200, 200);
+	pd_canvas_pool_get_stats(pool, &stats);
+	ctest_equal_bool("stats.peak_memory == stats.memory",
+			 stats.peak_memory == stats.memory, true);
+	ctest_equal_bool("stats.used_memory == stats.memory",
+			 stats.used_memory == stats.memory, true);
+	pd_canvas_pool_free(pool, &a);
+	pd_canvas_pool_free(pool, &b);
+	pd_canvas_pool_get_stats(pool, &stats);
+	ctest_equal_uint("stats.used_memory", (unsigned)stats.used_memory, 0);
+
+	pd_canvas_pool_trim(pool);
+	pd_canvas_pool_get_stats(pool, &stats);
+	ctest_equal_uint("stats.memory after trim", (unsigned)stats.memory, 0);
+	pd_canvas_pool_destroy(pool);
+}
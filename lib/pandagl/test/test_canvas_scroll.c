@@ -0,0 +1,98 @@
+﻿/*
+ * lib/pandagl/test/test_canvas_scroll.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+/* Fill each pixel with a value computed from its position */
+static void fill_pattern(pd_canvas_t *canvas)
+{
+	unsigned x, y;
+	pd_color_t *pixel;
+
+	for (y = 0; y < canvas->height; ++y) {
+		for (x = 0; x < canvas->width; ++x) {
+			pixel = pd_canvas_pixel_at(canvas, x, y);
+			pixel->value = 0xff000000 | (y << 8) | x;
+		}
+	}
+}
+
+static uint32_t pixel_at(pd_canvas_t *canvas, int x, int y)
+{
+	pd_color_t *pixel = pd_canvas_pixel_at(canvas, x, y);
+
+	return pixel->value;
+}
+
+static uint32_t pattern_at(int x, int y)
+{
+	return 0xff000000 | (y << 8) | x;
+}
+
+void test_canvas_scroll(void)
+{
+	pd_canvas_t canvas, quote;
+	pd_rect_t rect = { 10, 10, 40, 30 };
+	pd_rect_t quote_rect = { 20, 20, 20, 20 };
+
+	pd_canvas_init(&canvas);
+	canvas.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&canvas, 64, 64);
+
+	fill_pattern(&canvas);
+	ctest_equal_uint("scroll up 5px", pd_canvas_scroll(&canvas, &rect, 0, -5),
+			 40 * 25 * 4);
+	ctest_equal_uint("(10, 10) is moved from (10, 15)",
+			 pixel_at(&canvas, 10, 10),
+			 pattern_at(10, 15));
+	ctest_equal_uint("(49, 34) is moved from (49, 39)",
+			 pixel_at(&canvas, 49, 34),
+			 pattern_at(49, 39));
+	ctest_equal_uint("the exposed area is not changed",
+			 pixel_at(&canvas, 10, 35),
+			 pattern_at(10, 35));
+	ctest_equal_uint("pixels outside the rectangle are not changed",
+			 pixel_at(&canvas, 10, 9),
+			 pattern_at(10, 9));
+
+	fill_pattern(&canvas);
+	ctest_equal_uint("scroll down 5px and right 3px",
+			 pd_canvas_scroll(&canvas, &rect, 3, 5), 37 * 25 * 4);
+	ctest_equal_uint("(13, 15) is moved from (10, 10)",
+			 pixel_at(&canvas, 13, 15),
+			 pattern_at(10, 10));
+	ctest_equal_uint("(49, 39) is moved from (46, 34)",
+			 pixel_at(&canvas, 49, 39),
+			 pattern_at(46, 34));
+	ctest_equal_uint("pixels outside the rectangle are not changed",
+			 pixel_at(&canvas, 50, 40),
+			 pattern_at(50, 40));
+
+	fill_pattern(&canvas);
+	pd_canvas_quote(&quote, &canvas, &quote_rect);
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = 20;
+	rect.height = 20;
+	ctest_equal_uint("scroll the quoted canvas",
+			 pd_canvas_scroll(&quote, &rect, -2, 0), 18 * 20 * 4);
+	ctest_equal_uint("(20, 20) is moved from (22, 20)",
+			 pixel_at(&canvas, 20, 20),
+			 pattern_at(22, 20));
+	ctest_equal_uint("pixels outside the quoted canvas are not changed",
+			 pixel_at(&canvas, 19, 20),
+			 pattern_at(19, 20));
+	ctest_equal_uint("scroll out of the rectangle",
+			 pd_canvas_scroll(&quote, &rect, 0, 20), 0);
+	pd_canvas_destroy(&canvas);
+}
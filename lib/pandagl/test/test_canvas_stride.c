@@ -0,0 +1,183 @@
+﻿/*
+ * lib/pandagl/test/test_canvas_stride.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+#define WIDTH 37
+#define HEIGHT 23
+
+static void create_canvas(pd_canvas_t *canvas, pd_color_type_t color_type,
+			  unsigned alignment)
+{
+	unsigned x, y;
+	pd_color_t color;
+
+	pd_canvas_init(canvas);
+	canvas->color_type = color_type;
+	pd_canvas_create_aligned(canvas, WIDTH, HEIGHT, alignment);
+	for (y = 0; y < HEIGHT; ++y) {
+		for (x = 0; x < WIDTH; ++x) {
+			color.r = (uint8_t)(x * 7 + y);
+			color.g = (uint8_t)(x ^ y);
+			color.b = (uint8_t)(y * 3);
+			color.a = (uint8_t)(x % 5 == 0 ? 0 : 255 - y);
+			pd_canvas_set_pixel(canvas, x, y, color);
+		}
+	}
+}
+
+static bool canvas_equal(const pd_canvas_t *a, const pd_canvas_t *b)
+{
+	unsigned x, y;
+
+	if (a->width != b->width || a->height != b->height) {
+		return false;
+	}
+	for (y = 0; y < a->height; ++y) {
+		for (x = 0; x < a->width; ++x) {
+			if (pd_canvas_get_pixel(a, x, y).value !=
+			    pd_canvas_get_pixel(b, x, y).value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/** Run the routines on packed and padded canvases, the results must match */
+static void test_canvas_stride_routines(pd_color_type_t color_type,
+					const char *name)
+{
+	char str[128];
+	pd_rect_t rect = { 3, 2, 20, 15 };
+	pd_canvas_t packed, padded, fore, a, b;
+
+	create_canvas(&packed, color_type, 0);
+	create_canvas(&padded, color_type, 64);
+	create_canvas(&fore, PD_COLOR_TYPE_ARGB, 32);
+
+	pd_canvas_fill_rect(&packed, pd_argb(200, 30, 140, 250), rect);
+	pd_canvas_fill_rect(&padded, pd_argb(200, 30, 140, 250), rect);
+	pd_canvas_mix(&packed, &fore, 5, 4, true);
+	pd_canvas_mix(&padded, &fore, 5, 4, true);
+	snprintf(str, sizeof(str), "%s: fill and mix", name);
+	ctest_equal_bool(str, canvas_equal(&packed, &padded), true);
+
+	pd_canvas_init(&a);
+	pd_canvas_init(&b);
+	pd_canvas_zoom(&packed, &a, false, 50, 31);
+	pd_canvas_zoom(&padded, &b, false, 50, 31);
+	snprintf(str, sizeof(str), "%s: zoom", name);
+	ctest_equal_bool(str, canvas_equal(&a, &b), true);
+	pd_canvas_destroy(&a);
+	pd_canvas_destroy(&b);
+
+	pd_canvas_init(&a);
+	pd_canvas_init(&b);
+	pd_canvas_horiz_flip(&packed, &a);
+	pd_canvas_horiz_flip(&padded, &b);
+	snprintf(str, sizeof(str), "%s: horizontal flip", name);
+	ctest_equal_bool(str,
+			 canvas_equal(&a, &b) &&
+			     pd_canvas_get_pixel(&a, 0, 5).value ==
+				 pd_canvas_get_pixel(&packed, WIDTH - 1, 5)
+				     .value,
+			 true);
+	pd_canvas_destroy(&a);
+	pd_canvas_destroy(&b);
+
+	pd_canvas_init(&a);
+	pd_canvas_init(&b);
+	pd_canvas_veri_flip(&packed, &a);
+	pd_canvas_veri_flip(&padded, &b);
+	snprintf(str, sizeof(str), "%s: vertical flip", name);
+	ctest_equal_bool(str,
+			 canvas_equal(&a, &b) &&
+			     pd_canvas_get_pixel(&a, 5, 0).value ==
+				 pd_canvas_get_pixel(&packed, 5, HEIGHT - 1)
+				     .value,
+			 true);
+	pd_canvas_destroy(&a);
+	pd_canvas_destroy(&b);
+
+	pd_canvas_init(&a);
+	pd_canvas_init(&b);
+	pd_canvas_cut(&packed, rect, &a);
+	pd_canvas_cut(&padded, rect, &b);
+	snprintf(str, sizeof(str), "%s: cut", name);
+	ctest_equal_bool(str, canvas_equal(&a, &b), true);
+	pd_canvas_destroy(&a);
+	pd_canvas_destroy(&b);
+
+	pd_canvas_destroy(&packed);
+	pd_canvas_destroy(&padded);
+	pd_canvas_destroy(&fore);
+}
+
+static void test_canvas_tile(void)
+{
+	unsigned x, y;
+	bool ok = true;
+	pd_canvas_t tile, canvas;
+
+	create_canvas(&tile, PD_COLOR_TYPE_ARGB, 0);
+	pd_canvas_init(&canvas);
+	canvas.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create_aligned(&canvas, WIDTH * 3, HEIGHT * 2, 64);
+	pd_canvas_tile(&canvas, &tile, true, false);
+	for (y = 0; y < canvas.height; ++y) {
+		for (x = 0; x < canvas.width; ++x) {
+			if (pd_canvas_get_pixel(&canvas, x, y).value !=
+			    pd_canvas_get_pixel(&tile, x % WIDTH, y % HEIGHT)
+				.value) {
+				ok = false;
+			}
+		}
+	}
+	ctest_equal_bool("the tiles are placed in rows and columns", ok, true);
+	pd_canvas_destroy(&tile);
+	pd_canvas_destroy(&canvas);
+}
+
+void test_canvas_stride(void)
+{
+	pd_canvas_t canvas;
+
+	pd_canvas_init(&canvas);
+	canvas.color_type = PD_COLOR_TYPE_ARGB;
+	ctest_equal_int("the alignment must be a power of two",
+			pd_canvas_create_aligned(&canvas, WIDTH, HEIGHT, 48), -1);
+	ctest_equal_int("create an aligned canvas",
+			pd_canvas_create_aligned(&canvas, WIDTH, HEIGHT, 64), 0);
+	ctest_equal_int("the row is padded to 64 bytes", canvas.bytes_per_row,
+			192);
+	ctest_equal_bool("the pixels start on a 64-byte boundary",
+			 (uintptr_t)canvas.bytes % 64 == 0, true);
+	pd_canvas_destroy(&canvas);
+
+	/* Window-sized buffers are allocated in another way */
+	canvas.color_type = PD_COLOR_TYPE_ARGB;
+	ctest_equal_int("create a large canvas",
+			pd_canvas_create_aligned(&canvas, 1920, 1080, 64), 0);
+	pd_canvas_fill(&canvas, pd_rgb(255, 0, 0));
+	ctest_equal_int("the large canvas is writable",
+			pd_canvas_get_pixel(&canvas, 1919, 1079).value,
+			pd_rgb(255, 0, 0).value);
+	pd_canvas_destroy(&canvas);
+
+	test_canvas_stride_routines(PD_COLOR_TYPE_ARGB, "argb");
+	test_canvas_stride_routines(PD_COLOR_TYPE_RGB, "rgb");
+	test_canvas_stride_routines(PD_COLOR_TYPE_RGB565, "rgb565");
+	test_canvas_tile();
+}
@@ -0,0 +1,278 @@
+﻿/*
+ * lib/pandagl/test/test_font_cache.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <thread.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+/* The in-core font has bitmaps of printable ASCII chars from 12px to 18px */
+#define MIN_SIZE 12
+#define MAX_SIZE 18
+#define NUM_GLYPHS (('~' - ' ' + 1) * (MAX_SIZE - MIN_SIZE + 1))
+
+#define NUM_THREADS 8
+#define NUM_ROUNDS 40
+
+static const wchar_t *test_string =
+    L"The quick brown fox jumps over the lazy dog.\n"
+    L"PACK MY BOX WITH FIVE DOZEN LIQUOR JUGS! 0123456789 {[(~)]}";
+
+typedef struct text_worker {
+	thread_t tid;
+	int id;
+	int errors;
+	pd_canvas_t *expected;
+} text_worker_t;
+
+static bool get_all_glyphs(const pd_font_bitmap_t **bitmaps)
+{
+	int size, n = 0;
+	unsigned ch;
+	bool ok = true;
+
+	for (size = MIN_SIZE; size <= MAX_SIZE; ++size) {
+		for (ch = ' '; ch <= '~'; ++ch, ++n) {
+			if (pd_font_library_get_bitmap(ch, -1, size,
+						       &bitmaps[n]) != 0 ||
+			    bitmaps[n]->metrics.vert_advance != size) {
+				ok = false;
+			}
+		}
+	}
+	return ok;
+}
+
+/** Compare the packed pixels of the cached glyph with a newly rendered one */
+static bool glyph_is_packed(const pd_font_bitmap_t *bmp, unsigned ch, int size)
+{
+	int y;
+	bool ok;
+	pd_font_bitmap_t expected = { 0 };
+
+	if (pd_font_library_render_bitmap(&expected, ch, -1, size) != 0) {
+		return false;
+	}
+	ok = bmp->width == expected.width && bmp->rows == expected.rows &&
+	     bmp->pitch >= bmp->width;
+	for (y = 0; ok && y < bmp->rows; ++y) {
+		ok = memcmp(bmp->buffer + y * bmp->pitch,
+			    expected.buffer + y * expected.pitch,
+			    bmp->width) == 0;
+	}
+	free(expected.buffer);
+	return ok;
+}
+
+/** Paint the cached glyph and a newly rendered one, they must be the same */
+static bool glyph_is_painted(const pd_font_bitmap_t *bmp, unsigned ch,
+			     int size)
+{
+	bool ok;
+	pd_pos_t pos = { 2, 2 };
+	pd_canvas_t expected, actual;
+	pd_font_bitmap_t rendered = { 0 };
+
+	pd_font_library_render_bitmap(&rendered, ch, -1, size);
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	expected.color_type = PD_COLOR_TYPE_ARGB;
+	actual.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&expected, 32, 32);
+	pd_canvas_create(&actual, 32, 32);
+	pd_canvas_fill(&expected, pd_rgb(255, 255, 255));
+	pd_canvas_fill(&actual, pd_rgb(255, 255, 255));
+	pd_canvas_mix_font_bitmap(&expected, pos, &rendered, pd_rgb(0, 0, 0));
+	pd_canvas_mix_font_bitmap(&actual, pos, bmp, pd_rgb(0, 0, 0));
+	ok = memcmp(expected.bytes, actual.bytes, expected.mem_size) == 0;
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	free(rendered.buffer);
+	return ok;
+}
+
+static int render_string(pd_canvas_t *canvas, int size)
+{
+	int ret;
+	pd_text_t *text;
+	pd_text_style_t style;
+	pd_rect_t area = { 0, 0, 0, 0 };
+	pd_pos_t pos = { 0, 0 };
+
+	text = pd_text_create();
+	pd_text_style_init(&style);
+	pd_text_style_set_size(&style, size);
+	pd_text_set_style(text, &style);
+	pd_text_style_destroy(&style);
+	pd_text_set_multiline(text, true);
+	pd_text_write(text, test_string, NULL);
+	pd_text_update(text, NULL);
+	area.width = pd_text_get_width(text);
+	area.height = pd_text_get_height(text);
+	pd_canvas_init(canvas);
+	canvas->color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(canvas, area.width, area.height);
+	pd_canvas_fill(canvas, pd_rgb(255, 255, 255));
+	ret = pd_text_render_to(text, area, pos, canvas);
+	pd_text_destroy(text);
+	return ret;
+}
+
+/** Render the strings in all sizes again and again and compare them */
+static void text_worker_run(void *arg)
+{
+	int i, size;
+	pd_canvas_t *expected, actual;
+	text_worker_t *worker = arg;
+
+	for (i = 0; i < NUM_ROUNDS; ++i) {
+		size = MIN_SIZE + (worker->id + i) % (MAX_SIZE - MIN_SIZE + 1);
+		expected = &worker->expected[size - MIN_SIZE];
+		if (render_string(&actual, size) != 0 ||
+		    actual.mem_size != expected->mem_size ||
+		    memcmp(actual.bytes, expected->bytes, actual.mem_size) != 0) {
+			worker->errors++;
+		}
+		pd_canvas_destroy(&actual);
+	}
+	thread_exit(NULL);
+}
+
+static void test_font_cache_threads(void)
+{
+	int i, errors = 0;
+	pd_font_cache_stats_t stats;
+	pd_canvas_t expected[MAX_SIZE - MIN_SIZE + 1];
+	text_worker_t workers[NUM_THREADS];
+
+	for (i = 0; i <= MAX_SIZE - MIN_SIZE; ++i) {
+		render_string(&expected[i], MIN_SIZE + i);
+	}
+	/* Keep the budget small so that the threads also evict pages */
+	pd_font_library_set_cache_max_memory(1);
+	for (i = 0; i < NUM_THREADS; ++i) {
+		workers[i].id = i;
+		workers[i].errors = 0;
+		workers[i].expected = expected;
+		thread_create(&workers[i].tid, text_worker_run, &workers[i]);
+	}
+	for (i = 0; i < NUM_THREADS; ++i) {
+		thread_join(workers[i].tid, NULL);
+		errors += workers[i].errors;
+	}
+	ctest_equal_int("the strings rendered by many threads are the same",
+			errors, 0);
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_bool("the pages are evicted when no thread uses them",
+			 stats.entries == 0 && stats.pages == 0 &&
+			     stats.memory == 0 && stats.evictions > 0,
+			 true);
+	pd_font_library_set_cache_max_memory(0);
+	for (i = 0; i <= MAX_SIZE - MIN_SIZE; ++i) {
+		pd_canvas_destroy(&expected[i]);
+	}
+}
+
+static void release_all_glyphs(const pd_font_bitmap_t **bitmaps)
+{
+	int i;
+
+	for (i = 0; i < NUM_GLYPHS; ++i) {
+		pd_font_library_release_bitmap(bitmaps[i]);
+	}
+}
+
+void test_font_cache(void)
+{
+	int i, size;
+	unsigned ch;
+	bool ok;
+	const pd_font_bitmap_t *a, *b;
+	const pd_font_bitmap_t *bitmaps[NUM_GLYPHS];
+	const pd_font_bitmap_t *again[NUM_GLYPHS];
+	pd_font_cache_stats_t stats;
+
+	pd_font_library_init();
+	pd_font_library_get_bitmap('A', -1, 14, &a);
+	pd_font_library_get_bitmap('A', -1, 14, &b);
+	ctest_equal_bool("the same glyph is cached once", a && a == b, true);
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_bool("the second lookup is a hit",
+			 stats.hits == 1 && stats.entries == 1 &&
+			     stats.memory > (size_t)a->width * a->rows,
+			 true);
+	pd_font_library_release_bitmap(b);
+	pd_font_library_get_bitmap('A', -1, 16, &b);
+	ctest_equal_bool("another size is cached separately",
+			 b && b != a && b->metrics.vert_advance == 16, true);
+	pd_font_library_release_bitmap(b);
+
+	pd_font_library_set_cache_max_memory(1);
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_bool("glyphs in use are not evicted",
+			 stats.entries == 1 && stats.evictions == 1, true);
+	pd_font_library_release_bitmap(a);
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_bool("released glyphs are evicted when over budget",
+			 stats.entries == 0 && stats.memory == 0, true);
+
+	pd_font_library_set_cache_max_memory(0);
+	ctest_equal_bool("all glyphs are rendered", get_all_glyphs(bitmaps),
+			 true);
+	ok = get_all_glyphs(again);
+	for (i = 0; i < NUM_GLYPHS; ++i) {
+		if (bitmaps[i] != again[i]) {
+			ok = false;
+		}
+	}
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_bool("all glyphs are found in the grown table",
+			 ok && stats.entries == NUM_GLYPHS, true);
+	ctest_equal_int("the glyphs of a size share an atlas page",
+			(int)stats.pages, MAX_SIZE - MIN_SIZE + 1);
+	for (ok = true, i = 0, size = MIN_SIZE; size <= MAX_SIZE; ++size) {
+		for (ch = ' '; ch <= '~'; ++ch, ++i) {
+			if (!glyph_is_packed(bitmaps[i], ch, size)) {
+				ok = false;
+			}
+		}
+	}
+	ctest_equal_bool("the packed pixels match the rendered glyphs", ok,
+			 true);
+	ctest_equal_bool("the packed glyph is painted with the page pitch",
+			 glyph_is_painted(bitmaps['g' - ' '], 'g', MIN_SIZE),
+			 true);
+	release_all_glyphs(again);
+	release_all_glyphs(bitmaps);
+
+	/* Evicting a part of the entries moves the others in the table */
+	pd_font_library_set_cache_max_memory(stats.memory / 2);
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_bool("the memory fits the budget after eviction",
+			 stats.entries < NUM_GLYPHS &&
+			     stats.memory <= stats.max_memory,
+			 true);
+	ctest_equal_bool("pages are evicted as a whole",
+			 stats.pages < MAX_SIZE - MIN_SIZE + 1 &&
+			     stats.entries % ('~' - ' ' + 1) == 0,
+			 true);
+	pd_font_library_set_cache_max_memory(0);
+	get_all_glyphs(bitmaps);
+	i = (int)stats.entries;
+	pd_font_library_get_cache_stats(&stats);
+	ctest_equal_int("the glyphs left in the cache are still found",
+			(int)stats.hits - 1 - NUM_GLYPHS, i);
+	release_all_glyphs(bitmaps);
+	test_font_cache_threads();
+	pd_font_library_destroy();
+}
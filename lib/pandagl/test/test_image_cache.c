@@ -0,0 +1,90 @@
+﻿/*
+ * lib/pandagl/test/test_image_cache.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+void test_image_cache(void)
+{
+	pd_canvas_t image, other;
+	pd_canvas_t *a, *b, *c;
+	pd_image_cache_t *cache;
+	pd_image_cache_stats_t stats;
+
+	pd_canvas_init(&image);
+	pd_canvas_init(&other);
+	image.color_type = PD_COLOR_TYPE_ARGB;
+	other.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&image, 64, 64);
+	pd_canvas_create(&other, 64, 64);
+	pd_canvas_fill(&image, pd_rgb(255, 0, 0));
+	pd_canvas_fill(&other, pd_rgb(0, 0, 255));
+	/* Room for two 100x100 ARGB images */
+	cache = pd_image_cache_create(100 * 100 * 4 * 2);
+
+	a = pd_image_cache_get(cache, &image, 100, 100, PD_RESAMPLE_BILINEAR);
+	ctest_equal_bool("the scaled image has the requested size",
+			 a && a->width == 100 && a->height == 100, true);
+	ctest_equal_int("the scaled image has the source color",
+			a ? pd_canvas_get_pixel(a, 50, 50).value : 0,
+			pd_rgb(255, 0, 0).value);
+	b = pd_image_cache_get(cache, &image, 100, 100, PD_RESAMPLE_BILINEAR);
+	ctest_equal_bool("the same size reuses the cached image", a == b, true);
+	pd_image_cache_release(cache, b);
+	b = pd_image_cache_get(cache, &image, 100, 100, PD_RESAMPLE_LANCZOS3);
+	ctest_equal_bool("another quality is cached separately", a != b, true);
+	pd_image_cache_get_stats(cache, &stats);
+	ctest_equal_int("stats.hits", (int)stats.hits, 1);
+	ctest_equal_int("stats.misses", (int)stats.misses, 2);
+	ctest_equal_int("stats.entries", (int)stats.entries, 2);
+
+	c = pd_image_cache_get(cache, &other, 100, 100, PD_RESAMPLE_BILINEAR);
+	pd_image_cache_get_stats(cache, &stats);
+	ctest_equal_bool("images in use are not evicted",
+			 stats.entries == 3 && stats.evictions == 0, true);
+	ctest_equal_int("the image of another source has its own color",
+			c ? pd_canvas_get_pixel(c, 0, 0).value : 0,
+			pd_rgb(0, 0, 255).value);
+	pd_image_cache_release(cache, a);
+	pd_image_cache_release(cache, b);
+	pd_image_cache_get_stats(cache, &stats);
+	ctest_equal_bool("released images are evicted when over budget",
+			 stats.entries == 2 && stats.evictions == 1 &&
+			     stats.memory <= stats.max_memory,
+			 true);
+	a = pd_image_cache_get(cache, &image, 100, 100, PD_RESAMPLE_BILINEAR);
+	pd_image_cache_get_stats(cache, &stats);
+	ctest_equal_bool("the least recently used image was evicted",
+			 stats.hits == 1 && stats.misses == 4, true);
+
+	pd_image_cache_remove(cache, &other);
+	pd_image_cache_get_stats(cache, &stats);
+	ctest_equal_int("removed images are dropped", (int)stats.entries, 1);
+	ctest_equal_int("an image in use stays readable after it is removed",
+			pd_canvas_get_pixel(c, 0, 0).value,
+			pd_rgb(0, 0, 255).value);
+	pd_image_cache_release(cache, c);
+	pd_image_cache_release(cache, a);
+
+	ctest_equal_bool("images larger than the budget are not cached",
+			 pd_image_cache_get(cache, &image, 1000, 1000,
+					    PD_RESAMPLE_BILINEAR) == NULL,
+			 true);
+	pd_image_cache_set_max_memory(cache, 1);
+	pd_image_cache_get_stats(cache, &stats);
+	ctest_equal_bool("lowering the budget drops cached images",
+			 stats.entries == 0 && stats.memory == 0, true);
+
+	pd_image_cache_destroy(cache);
+	pd_canvas_destroy(&image);
+	pd_canvas_destroy(&other);
+}
@@ -0,0 +1,162 @@
+﻿/*
+ * lib/pandagl/test/test_region.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <string.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+#define MAP_SIZE 64
+
+static unsigned test_seed = 1;
+
+static int test_rand(int max)
+{
+	test_seed = test_seed * 1103515245 + 12345;
+	return (int)((test_seed >> 16) % max);
+}
+
+static void random_rect(pd_rect_t *rect)
+{
+	rect->x = test_rand(MAP_SIZE);
+	rect->y = test_rand(MAP_SIZE);
+	rect->width = 1 + test_rand(MAP_SIZE - rect->x);
+	rect->height = 1 + test_rand(MAP_SIZE - rect->y);
+}
+
+/** Draw the region into the map, returns false if rectangles overlap */
+static bool region_to_map(const pd_region_t *region, char *map)
+{
+	unsigned i;
+	int x, y;
+	const pd_rect_t *rect;
+
+	memset(map, 0, MAP_SIZE * MAP_SIZE);
+	for (i = 0; i < region->length; ++i) {
+		rect = &region->rects[i];
+		for (y = rect->y; y < rect->y + rect->height; ++y) {
+			for (x = rect->x; x < rect->x + rect->width; ++x) {
+				if (map[y * MAP_SIZE + x]) {
+					return false;
+				}
+				map[y * MAP_SIZE + x] = 1;
+			}
+		}
+	}
+	return true;
+}
+
+static bool region_is_sorted(const pd_region_t *region)
+{
+	unsigned i;
+	const pd_rect_t *a, *b;
+
+	for (i = 1; i < region->length; ++i) {
+		a = &region->rects[i - 1];
+		b = &region->rects[i];
+		if (a->y == b->y) {
+			if (a->height != b->height || a->x + a->width >= b->x) {
+				return false;
+			}
+		} else if (a->y + a->height > b->y) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void test_region(void)
+{
+	int i, k, n;
+	bool ok = true;
+	pd_rect_t rect;
+	pd_region_t a, b, out;
+	char map_a[MAP_SIZE * MAP_SIZE];
+	char map_b[MAP_SIZE * MAP_SIZE];
+	char map_out[MAP_SIZE * MAP_SIZE];
+
+	pd_region_init(&a);
+	pd_region_init(&b);
+	pd_region_init(&out);
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = 10;
+	rect.height = 10;
+	pd_region_union_rect(&a, &rect);
+	rect.x = 5;
+	rect.y = 5;
+	pd_region_union_rect(&a, &rect);
+	ctest_equal_int("union of two overlapping rects has 3 bands",
+			(int)a.length, 3);
+	ctest_equal_int("union area", (int)pd_region_get_area(&a), 175);
+	pd_region_subtract_rect(&a, &rect);
+	ctest_equal_int("subtract area", (int)pd_region_get_area(&a), 75);
+	pd_region_intersect_rect(&a, &rect);
+	ctest_equal_bool("intersect with the subtracted rect is empty",
+			 pd_region_is_empty(&a), true);
+
+	for (k = 0; k < 200 && ok; ++k) {
+		pd_region_clear(&a);
+		pd_region_clear(&b);
+		n = 1 + test_rand(8);
+		for (i = 0; i < n; ++i) {
+			random_rect(&rect);
+			pd_region_union_rect(&a, &rect);
+			random_rect(&rect);
+			pd_region_union_rect(&b, &rect);
+		}
+		ok = region_to_map(&a, map_a) && region_to_map(&b, map_b) &&
+		     region_is_sorted(&a);
+		pd_region_union(&out, &a, &b);
+		ok = ok && region_to_map(&out, map_out) &&
+		     region_is_sorted(&out);
+		for (i = 0; ok && i < MAP_SIZE * MAP_SIZE; ++i) {
+			ok = map_out[i] == (map_a[i] || map_b[i]);
+		}
+		pd_region_intersect(&out, &a, &b);
+		ok = ok && region_to_map(&out, map_out) &&
+		     region_is_sorted(&out);
+		for (i = 0; ok && i < MAP_SIZE * MAP_SIZE; ++i) {
+			ok = map_out[i] == (map_a[i] && map_b[i]);
+		}
+		pd_region_subtract(&out, &a, &b);
+		ok = ok && region_to_map(&out, map_out) &&
+		     region_is_sorted(&out);
+		for (i = 0; ok && i < MAP_SIZE * MAP_SIZE; ++i) {
+			ok = map_out[i] == (map_a[i] && !map_b[i]);
+		}
+		pd_region_copy(&out, &a);
+		pd_region_simplify(&out, 4, 0);
+		ok = ok && out.length <= 4 && region_to_map(&out, map_out) &&
+		     region_is_sorted(&out);
+		for (i = 0; ok && i < MAP_SIZE * MAP_SIZE; ++i) {
+			ok = !map_a[i] || map_out[i];
+		}
+	}
+	ctest_equal_bool("random region operations match the pixel map", ok,
+			 true);
+
+	pd_region_clear(&a);
+	for (i = 0; i < 8; ++i) {
+		rect.x = i * 8;
+		rect.y = 0;
+		rect.width = 7;
+		rect.height = 7;
+		pd_region_union_rect(&a, &rect);
+	}
+	pd_region_simplify(&a, 100, 16);
+	ctest_equal_int("cheap gaps are merged", (int)a.length, 1);
+
+	pd_region_destroy(&a);
+	pd_region_destroy(&b);
+	pd_region_destroy(&out);
+}
@@ -0,0 +1,195 @@
+﻿/*
+ * lib/pandagl/test/test_resample.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+static const char *quality_names[] = { "nearest", "box", "bilinear",
+				       "lanczos3" };
+
+static void fill_pattern(pd_canvas_t *canvas)
+{
+	unsigned x, y;
+	pd_color_t color;
+
+	for (y = 0; y < canvas->height; ++y) {
+		for (x = 0; x < canvas->width; ++x) {
+			color.r = (uint8_t)(x * 7 + y);
+			color.g = (uint8_t)(x ^ y);
+			color.b = (uint8_t)(y * 3);
+			color.a = (uint8_t)(x % 5 == 0 ? 0 : 255 - y);
+			pd_canvas_set_pixel(canvas, x, y, color);
+		}
+	}
+}
+
+static bool canvas_is_filled_with(pd_canvas_t *canvas, pd_color_t color)
+{
+	unsigned x, y;
+
+	for (y = 0; y < canvas->height; ++y) {
+		for (x = 0; x < canvas->width; ++x) {
+			if (pd_canvas_get_pixel(canvas, x, y).value !=
+			    color.value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static void test_resample_solid_color(void)
+{
+	int i, j;
+	char str[128];
+	int sizes[][2] = { { 37, 23 }, { 400, 10 }, { 7, 300 } };
+	pd_color_t color = pd_argb(200, 10, 128, 250);
+	pd_canvas_t src, dst;
+
+	pd_canvas_init(&src);
+	src.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&src, 120, 90);
+	pd_canvas_fill(&src, color);
+	for (i = PD_RESAMPLE_NEAREST; i <= PD_RESAMPLE_LANCZOS3; ++i) {
+		for (j = 0; j < 3; ++j) {
+			pd_canvas_init(&dst);
+			snprintf(str, sizeof(str),
+				 "%s: the solid color is kept at %dx%d",
+				 quality_names[i], sizes[j][0], sizes[j][1]);
+			ctest_equal_bool(
+			    str,
+			    pd_canvas_resample(&src, &dst, sizes[j][0],
+					       sizes[j][1], i) == 0 &&
+				canvas_is_filled_with(&dst, color),
+			    true);
+			pd_canvas_destroy(&dst);
+		}
+	}
+	pd_canvas_destroy(&src);
+}
+
+static void test_resample_box(void)
+{
+	unsigned x, y;
+	bool ok = true;
+	pd_color_t c;
+	pd_canvas_t src, dst;
+
+	pd_canvas_init(&src);
+	pd_canvas_init(&dst);
+	src.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&src, 64, 64);
+	for (y = 0; y < src.height; ++y) {
+		for (x = 0; x < src.width; ++x) {
+			c.value = (x + y) % 2 ? 0xff000000 : 0xffc864ff;
+			pd_canvas_set_pixel(&src, x, y, c);
+		}
+	}
+	pd_canvas_resample(&src, &dst, 16, 16, PD_RESAMPLE_BOX);
+	for (y = 0; y < dst.height; ++y) {
+		for (x = 0; x < dst.width; ++x) {
+			c = pd_canvas_get_pixel(&dst, x, y);
+			if (c.r != 100 || c.g != 50 || c.b != 128 ||
+			    c.a != 255) {
+				ok = false;
+			}
+		}
+	}
+	ctest_equal_bool("box filter averages the checkerboard", ok, true);
+	pd_canvas_destroy(&src);
+	pd_canvas_destroy(&dst);
+}
+
+static void test_resample_rgb(void)
+{
+	int i;
+	unsigned x, y;
+	char str[128];
+	bool ok;
+	pd_color_t a, b;
+	pd_canvas_t argb, rgb, argb_out, rgb_out;
+
+	pd_canvas_init(&argb);
+	pd_canvas_init(&rgb);
+	argb.color_type = PD_COLOR_TYPE_ARGB;
+	rgb.color_type = PD_COLOR_TYPE_RGB;
+	pd_canvas_create(&argb, 91, 67);
+	pd_canvas_create(&rgb, 91, 67);
+	fill_pattern(&argb);
+	fill_pattern(&rgb);
+	for (i = PD_RESAMPLE_NEAREST; i <= PD_RESAMPLE_LANCZOS3; ++i) {
+		pd_canvas_init(&argb_out);
+		pd_canvas_init(&rgb_out);
+		pd_canvas_resample(&argb, &argb_out, 150, 40, i);
+		pd_canvas_resample(&rgb, &rgb_out, 150, 40, i);
+		ok = true;
+		for (y = 0; y < rgb_out.height; ++y) {
+			for (x = 0; x < rgb_out.width; ++x) {
+				a = pd_canvas_get_pixel(&argb_out, x, y);
+				b = pd_canvas_get_pixel(&rgb_out, x, y);
+				if (a.r != b.r || a.g != b.g || a.b != b.b) {
+					ok = false;
+				}
+			}
+		}
+		snprintf(str, sizeof(str),
+			 "%s: rgb and argb canvases have the same colors",
+			 quality_names[i]);
+		ctest_equal_bool(str, ok, true);
+		pd_canvas_destroy(&argb_out);
+		pd_canvas_destroy(&rgb_out);
+	}
+	pd_canvas_destroy(&argb);
+	pd_canvas_destroy(&rgb);
+}
+
+static void test_resample_threads(void)
+{
+	int i;
+	char str[128];
+	pd_rect_t rect = { 13, 7, 500, 400 };
+	pd_canvas_t src, quote, expected, actual;
+
+	pd_canvas_init(&src);
+	src.color_type = PD_COLOR_TYPE_ARGB;
+	pd_canvas_create(&src, 530, 420);
+	fill_pattern(&src);
+	pd_canvas_quote(&quote, &src, &rect);
+	for (i = PD_RESAMPLE_BOX; i <= PD_RESAMPLE_LANCZOS3; ++i) {
+		pd_canvas_init(&expected);
+		pd_canvas_init(&actual);
+		pd_set_resample_threads(1);
+		pd_canvas_resample(&quote, &expected, 333, 720, i);
+		pd_set_resample_threads(4);
+		pd_canvas_resample(&quote, &actual, 333, 720, i);
+		snprintf(str, sizeof(str),
+			 "%s: the threaded result is the same", quality_names[i]);
+		ctest_equal_bool(str,
+				 memcmp(expected.bytes, actual.bytes,
+					expected.mem_size) == 0,
+				 true);
+		pd_canvas_destroy(&expected);
+		pd_canvas_destroy(&actual);
+	}
+	pd_set_resample_threads(1);
+	pd_canvas_destroy(&src);
+}
+
+void test_resample(void)
+{
+	test_resample_solid_color();
+	test_resample_box();
+	test_resample_rgb();
+	test_resample_threads();
+}
@@ -0,0 +1,97 @@
+﻿/*
+ * lib/pandagl/test/test_text_edit.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include "test.h"
+#include "ctest.h"
+#include <pandagl.h>
+
+#define BUFFER_SIZE 256
+
+static void check_text(pd_text_t *text, const wchar_t *expected_text,
+		       int expected_length, const char *expected_lines)
+{
+	int i;
+	char lines[BUFFER_SIZE] = "";
+	wchar_t buffer[BUFFER_SIZE];
+	size_t n = 0;
+
+	pd_text_update(text, NULL);
+	pd_text_dump(text, 0, BUFFER_SIZE - 1, buffer);
+	for (i = 0; i < text->lines_length && n < sizeof(lines); ++i) {
+		n += snprintf(lines + n, sizeof(lines) - n, i ? ",%d" : "%d",
+			      text->lines[i]->length);
+	}
+	ctest_equal_wcs("text", buffer, expected_text);
+	ctest_equal_int("length", text->length, expected_length);
+	ctest_equal_str("line lengths", lines, expected_lines);
+}
+
+void test_text_edit(void)
+{
+	pd_text_t *text;
+
+	pd_font_library_init();
+	text = pd_text_create();
+	pd_text_set_multiline(text, true);
+
+	ctest_group_begin();
+	ctest_printf("insert multi-line text in the middle of a line\n");
+	pd_text_write(text, L"abc\ndef", NULL);
+	pd_text_set_insert_position(text, 0, 2);
+	pd_text_insert(text, L"XY\nZ", NULL);
+	check_text(text, L"abXYZcdef", 11, "4,2,3");
+	ctest_group_end();
+
+	ctest_group_begin();
+	ctest_printf("delete text within a line\n");
+	pd_text_write(text, L"hello world\nsecond line\nthird", NULL);
+	pd_text_set_insert_position(text, 0, 3);
+	pd_text_delete(text, 2);
+	check_text(text, L"hel worldsecond linethird", 27, "9,11,5");
+	ctest_group_end();
+
+	ctest_group_begin();
+	ctest_printf("delete text across 2 lines\n");
+	pd_text_delete(text, 15);
+	check_text(text, L"helinethird", 12, "6,5");
+	ctest_group_end();
+
+	ctest_group_begin();
+	ctest_printf("delete text across 3 lines\n");
+	pd_text_write(text, L"ab\ncd\nef", NULL);
+	pd_text_set_insert_position(text, 0, 1);
+	pd_text_delete(text, 5);
+	check_text(text, L"aef", 3, "3");
+	ctest_group_end();
+
+	ctest_group_begin();
+	ctest_printf("delete the trailing newline of a line\n");
+	pd_text_write(text, L"abc\ndef", NULL);
+	pd_text_set_insert_position(text, 0, 3);
+	pd_text_delete(text, 1);
+	check_text(text, L"abcdef", 6, "6");
+	ctest_group_end();
+
+	ctest_group_begin();
+	ctest_printf("backspace at the start of a line\n");
+	pd_text_write(text, L"ab\ncd\nef", NULL);
+	pd_text_set_insert_position(text, 2, 0);
+	pd_text_backspace(text, 1);
+	check_text(text, L"abcdef", 7, "2,4");
+	pd_text_set_insert_position(text, 1, 0);
+	pd_text_backspace(text, 3);
+	check_text(text, L"cdef", 4, "4");
+	ctest_group_end();
+
+	pd_text_destroy(text);
+	pd_font_library_destroy();
+}
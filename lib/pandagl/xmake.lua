@@ -25,7 +25,7 @@ option("with-pandagl-text")
 target("pandagl")
     set_kind("$(kind)")
     add_files("src/*.c")
-    add_deps("yutil")
+    add_deps("yutil", "libthread", "libworker")
     add_includedirs("include")
     set_configdir("include/pandagl")
     add_configfiles("src/config.h.in")
@@ -293,6 +293,7 @@ typedef struct ptk_window_driver {
 	void (*set_max_height)(ptk_window_t *, int);
 	ptk_window_paint_t *(*begin_paint)(ptk_window_t *, pd_rect_t *);
 	void (*end_paint)(ptk_window_t *, ptk_window_paint_t *);
+	size_t (*scroll)(ptk_window_t *, pd_rect_t *, int, int);
 	void (*present)(ptk_window_t *);
 } ptk_window_driver_t;
 
@@ -48,6 +48,14 @@ PTK_PUBLIC ptk_window_paint_t *ptk_window_begin_paint(ptk_window_t *wnd,
 						    pd_rect_t *rect);
 PTK_PUBLIC void ptk_window_end_paint(ptk_window_t *wnd,
 				   ptk_window_paint_t *paint);
+
+/**
+ * Move the pixels in the rectangle of the window by the offset, the exposed
+ * area keeps its old pixels and should be painted by the caller.
+ * @returns number of bytes moved
+ */
+PTK_PUBLIC size_t ptk_window_scroll(ptk_window_t *wnd, pd_rect_t *rect, int dx,
+				    int dy);
 PTK_PUBLIC void ptk_window_present(ptk_window_t *wnd);
 
 PTK_END_DECLS
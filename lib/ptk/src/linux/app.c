@@ -155,6 +155,11 @@ void ptk_window_end_paint(ptk_window_t *wnd, ptk_window_paint_t *paint)
         linux_app.window.end_paint(wnd, paint);
 }
 
+size_t ptk_window_scroll(ptk_window_t *wnd, pd_rect_t *rect, int dx, int dy)
+{
+        return linux_app.window.scroll(wnd, rect, dx, dy);
+}
+
 void ptk_window_present(ptk_window_t *wnd)
 {
         linux_app.window.present(wnd);
@@ -148,7 +148,13 @@ static void ptk_fbapp_init_root_window(void)
         pd_canvas_init(&wnd->canvas);
         list_create(&wnd->rects);
         fbapp.window_count = 0;
-        wnd->canvas.color_type = PD_COLOR_TYPE_ARGB;
+        /* Render straight into 16-bit pixels so that presenting the window
+         * is a plain copy and half of the memory is touched */
+        if (fbapp.canvas.color_type == PD_COLOR_TYPE_RGB565) {
+                wnd->canvas.color_type = PD_COLOR_TYPE_RGB565;
+        } else {
+                wnd->canvas.color_type = PD_COLOR_TYPE_ARGB;
+        }
         ptk_fb_window_set_size(&fbapp.window, fbapp.screen_width,
                                fbapp.screen_height);
 }
@@ -160,8 +166,19 @@ static void ptk_fbapp_destroy_root_window(void)
         list_destroy(&wnd->rects, free);
 }
 
+/** Whether the 16-bit pixels are laid out as RGB565, not BGR565 or others */
+static bool ptk_fbapp_is_rgb565(void)
+{
+        struct fb_var_screeninfo *info = &fbapp.fb.var_info;
+
+        return info->red.offset == 11 && info->red.length == 5 &&
+               info->green.offset == 5 && info->green.length == 6 &&
+               info->blue.offset == 0 && info->blue.length == 5;
+}
+
 static void ptk_fbapp_init_canvas(void)
 {
+        pd_canvas_init(&fbapp.canvas);
         fbapp.canvas.width = fbapp.screen_width;
         fbapp.canvas.height = fbapp.screen_height;
         fbapp.canvas.bytes = fbapp.fb.mem;
@@ -174,11 +191,19 @@ static void ptk_fbapp_init_canvas(void)
         case 24:
                 fbapp.canvas.color_type = PD_COLOR_TYPE_RGB888;
                 break;
+        case 16:
+                /* The other layouts are converted when presenting */
+                if (ptk_fbapp_is_rgb565()) {
+                        fbapp.canvas.color_type = PD_COLOR_TYPE_RGB565;
+                }
+                break;
         case 8:
                 ioctl(fbapp.fb.dev_fd, FBIOGETCMAP, &fbapp.fb.cmap);
         default:
                 break;
         }
+        fbapp.canvas.bytes_per_pixel =
+            pd_get_pixel_size(fbapp.canvas.color_type);
         memset(fbapp.canvas.bytes, 0, fbapp.canvas.mem_size);
 }
 
@@ -237,7 +262,7 @@ static void ptk_fb_window_set_size(ptk_window_t *wnd, int width, int height)
         wnd->actual_rect = wnd->rect;
         pd_rect_correct(&wnd->actual_rect, fbapp.screen_width,
                         fbapp.screen_height);
-        pd_canvas_create(&wnd->canvas, wnd->width, wnd->height);
+        pd_canvas_create_aligned(&wnd->canvas, wnd->width, wnd->height, 64);
 }
 
 static void ptk_fb_window_set_position(ptk_window_t *wnd, int x, int y)
@@ -284,24 +309,41 @@ static void *ptk_fb_window_get_handle(ptk_window_t *wnd)
         return NULL;
 }
 
+/**
+ * The window canvas is already in RGB565 if the framebuffer uses it, the
+ * rows are copied as they are. Otherwise the ARGB pixels are packed by the
+ * bitfields of the framebuffer, such as BGR565.
+ */
 static void ptk_fb_window_sync_rect16(pd_canvas_t *canvas, int x, int y)
 {
-        uint32_t iy, ix;
+        uint32_t ix, iy;
         pd_rect_t rect;
-        pd_color_t *pixel, *pixel_row;
-        unsigned char *dst, *dst_row;
-
+        pd_color_t *pixel;
+        uint16_t *dst;
+        unsigned char *dst_row, *pixel_row;
+        struct fb_var_screeninfo *info = &fbapp.fb.var_info;
+
+        if (fbapp.canvas.color_type == PD_COLOR_TYPE_RGB565) {
+                pd_canvas_replace(&fbapp.canvas, canvas, x, y);
+                return;
+        }
         pd_canvas_get_quote_rect(canvas, &rect);
-        pixel_row = canvas->argb + rect.y * canvas->width + rect.x;
+        pixel_row = pd_canvas_pixel_at(pd_canvas_get_quote_source(canvas),
+                                       rect.x, rect.y);
         dst_row = fbapp.fb.mem + y * fbapp.canvas.bytes_per_row + x * 2;
-        for (iy = 0; iy < rect.width; ++iy) {
-                dst = dst_row;
-                pixel = pixel_row;
-                for (ix = 0; ix < rect.width; ++ix) {
-                        dst[0] = (pixel->r & 0xF8) | (pixel->b >> 5);
-                        dst[1] = ((pixel->g & 0x1C) << 3) | (pixel->b >> 3);
+        for (iy = 0; iy < rect.height; ++iy) {
+                dst = (uint16_t *)dst_row;
+                pixel = (pd_color_t *)pixel_row;
+                for (ix = 0; ix < rect.width; ++ix, ++dst, ++pixel) {
+                        *dst = (uint16_t)(
+                            ((pixel->r >> (8 - info->red.length))
+                             << info->red.offset) |
+                            ((pixel->g >> (8 - info->green.length))
+                             << info->green.offset) |
+                            ((pixel->b >> (8 - info->blue.length))
+                             << info->blue.offset));
                 }
-                pixel_row += canvas->width;
+                pixel_row += pd_canvas_get_quote_source(canvas)->bytes_per_row;
                 dst_row += fbapp.canvas.bytes_per_row;
         }
 }
@@ -310,8 +352,8 @@ static void ptk_fb_window_sync_rect8(pd_canvas_t *canvas, int x, int y)
 {
         uint32_t ix, iy;
         pd_rect_t rect;
-        pd_color_t *pixel, *pixel_row;
-        unsigned char *dst, *dst_row;
+        pd_color_t *pixel;
+        unsigned char *dst, *dst_row, *pixel_row;
         unsigned int r, g, b, i;
         struct fb_cmap cmap;
         __u16 cmap_buf[256 * 3] = { 0 };
@@ -324,12 +366,13 @@ static void ptk_fb_window_sync_rect8(pd_canvas_t *canvas, int x, int y)
         cmap.blue = cmap_buf + 512;
 
         pd_canvas_get_quote_rect(canvas, &rect);
-        pixel_row = canvas->argb + rect.y * canvas->width + rect.x;
+        pixel_row = pd_canvas_pixel_at(pd_canvas_get_quote_source(canvas),
+                                       rect.x, rect.y);
         dst_row = fbapp.fb.mem + y * fbapp.canvas.bytes_per_row + x;
         for (iy = 0; iy < rect.height; ++iy) {
                 dst = dst_row;
-                pixel = pixel_row;
-                for (ix = 0; ix < rect.width; ++ix, ++dst) {
+                pixel = (pd_color_t *)pixel_row;
+                for (ix = 0; ix < rect.width; ++ix, ++dst, ++pixel) {
                         r = pixel->r * 0.92;
                         g = pixel->g * 0.92;
                         b = pixel->b * 0.92;
@@ -343,7 +386,7 @@ static void ptk_fb_window_sync_rect8(pd_canvas_t *canvas, int x, int y)
                         *dst = (((r & 0xc0)) + ((g & 0xf0) >> 2) +
                                 ((b & 0xc0) >> 6));
                 }
-                pixel_row += canvas->width;
+                pixel_row += pd_canvas_get_quote_source(canvas)->bytes_per_row;
                 dst_row += fbapp.canvas.bytes_per_row;
         }
         ioctl(fbapp.fb.dev_fd, FBIOPUTCMAP, &cmap);
@@ -422,6 +465,18 @@ static void ptk_fb_window_end_paint(ptk_window_t *wnd,
         pd_context_destroy(paint);
 }
 
+static size_t ptk_fb_window_scroll(ptk_window_t *wnd, pd_rect_t *rect, int dx,
+                                   int dy)
+{
+        size_t size;
+
+        size = pd_canvas_scroll(&wnd->canvas, rect, dx, dy);
+        if (size > 0) {
+                pd_rects_add(&wnd->rects, rect);
+        }
+        return size;
+}
+
 static void ptk_fb_window_present(ptk_window_t *wnd)
 {
         list_node_t *node;
@@ -576,6 +631,7 @@ void ptk_fbwindow_driver_init(ptk_window_driver_t *driver)
         driver->set_min_height = ptk_fb_window_set_min_height;
         driver->begin_paint = ptk_fb_window_begin_paint;
         driver->end_paint = ptk_fb_window_end_paint;
+        driver->scroll = ptk_fb_window_scroll;
         driver->present = ptk_fb_window_present;
 }
 
@@ -161,8 +161,11 @@ static void ptk_x11window__on_destroy(ptk_window_t *wnd)
 	list_unlink(&x11_app.windows, &wnd->node);
 	list_destroy(&wnd->rects, free);
 	if (wnd->ximage) {
+		/* The pixels are owned by the canvas, not by the XImage */
+		wnd->ximage->data = NULL;
 		XDestroyImage(wnd->ximage);
 		wnd->ximage = NULL;
+		pd_canvas_destroy(&wnd->fb);
 	}
 	if (wnd->gc) {
 		XFreeGC(x11_app.display, wnd->gc);
@@ -196,8 +199,11 @@ static void ptk_x11window__on_size(ptk_window_t *wnd, int width, int height)
 		return;
 	}
 	if (wnd->ximage) {
+		/* The pixels are owned by the canvas, not by the XImage */
+		wnd->ximage->data = NULL;
 		XDestroyImage(wnd->ximage);
 		wnd->ximage = NULL;
+		pd_canvas_destroy(&wnd->fb);
 	}
 	if (wnd->gc) {
 		XFreeGC(x11_app.display, wnd->gc);
@@ -216,11 +222,13 @@ static void ptk_x11window__on_size(ptk_window_t *wnd, int width, int height)
 		logger_error("[x11_app] unsupport depth: %d.\n", depth);
 		break;
 	}
-	pd_canvas_create(&wnd->fb, width, height);
+	/* The rows are aligned for the SIMD blending kernels, the XImage uses
+	 * the same stride */
+	pd_canvas_create_aligned(&wnd->fb, width, height, 64);
 	visual = DefaultVisual(x11_app.display, x11_app.screen);
-	wnd->ximage =
-	    XCreateImage(x11_app.display, visual, depth, ZPixmap, 0,
-			 (char *)(wnd->fb.bytes), width, height, 32, 0);
+	wnd->ximage = XCreateImage(x11_app.display, visual, depth, ZPixmap, 0,
+				   (char *)(wnd->fb.bytes), width, height, 32,
+				   wnd->fb.bytes_per_row);
 	if (!wnd->ximage) {
 		pd_canvas_destroy(&wnd->fb);
 		logger_error("[x11_app] create XImage faild.\n");
@@ -580,6 +588,22 @@ static void ptk_x11window__end_paint(ptk_window_t *wnd,
 	free(paint);
 }
 
+static size_t ptk_x11window__scroll(ptk_window_t *wnd, pd_rect_t *rect,
+				    int dx, int dy)
+{
+	size_t size;
+	pd_rect_t *dirty_rect;
+
+	size = pd_canvas_scroll(&wnd->fb, rect, dx, dy);
+	if (size > 0) {
+		dirty_rect = malloc(sizeof(pd_rect_t));
+		*dirty_rect = *rect;
+		pd_rect_correct(dirty_rect, wnd->width, wnd->height);
+		list_append(&wnd->rects, dirty_rect);
+	}
+	return size;
+}
+
 static void ptk_x11window__present(ptk_window_t *wnd)
 {
 	list_node_t *node;
@@ -693,6 +717,7 @@ void ptk_x11window_driver_init(ptk_window_driver_t *driver)
 	driver->set_min_height = ptk_x11window__set_min_height;
 	driver->begin_paint = ptk_x11window__begin_paint;
 	driver->end_paint = ptk_x11window__end_paint;
+	driver->scroll = ptk_x11window__scroll;
 	driver->present = ptk_x11window__present;
 }
 
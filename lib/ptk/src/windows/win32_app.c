@@ -667,6 +667,11 @@ void ptk_window_end_paint(ptk_window_t *wnd, ptk_window_paint_t *paint)
         pd_context_destroy(paint);
 }
 
+size_t ptk_window_scroll(ptk_window_t *wnd, pd_rect_t *rect, int dx, int dy)
+{
+        return pd_canvas_scroll(&wnd->fb, rect, dx, dy);
+}
+
 void ptk_window_present(ptk_window_t *wnd)
 {
         RECT client_rect;
@@ -209,15 +209,18 @@ int thread_create(thread_t *tid, void (*func)(void *), void *arg)
 	thread->arg = arg;
 	thread->func = func;
 	thread->node.data = thread;
+	/* The thread info must be linked before the thread exits and unlinks
+	 * it, so the new thread waits for the mutex */
+	thread_mutex_lock(&thread_manager.mutex);
 	ret = pthread_create(&thread->tid, NULL, run_thread, thread);
 	if (ret != 0) {
+		thread_mutex_unlock(&thread_manager.mutex);
 		free(thread);
 		return ret;
 	}
-	thread_mutex_lock(&thread_manager.mutex);
+	*tid = thread->tid;
 	list_append_node(&thread_manager.threads, &thread->node);
 	thread_mutex_unlock(&thread_manager.mutex);
-	*tid = thread->tid;
 	return ret;
 }
 
@@ -15,9 +15,26 @@
 #include "ui_server/common.h"
 #include <ui.h>
 #include <ptk.h>
+#include <worker.h>
 
 LIBUI_SERVER_BEGIN_DECLS
 
+typedef struct ui_server_tile_stats {
+        /** Number of tiles rendered into the back buffer */
+        size_t rendered;
+
+        /** Number of tiles copied from the back buffer to repaint windows */
+        size_t reused;
+} ui_server_tile_stats_t;
+
+typedef struct ui_server_paint_stats {
+        /** Bytes of pixels moved in windows instead of being repainted */
+        size_t blitted_bytes;
+
+        /** Bytes of pixels painted by widgets */
+        size_t painted_bytes;
+} ui_server_paint_stats_t;
+
 LIBUI_SERVER_PUBLIC ui_widget_t *ui_server_get_widget(ptk_window_t *window);
 LIBUI_SERVER_PUBLIC ptk_window_t *ui_server_get_window(ui_widget_t *widget);
 LIBUI_SERVER_PUBLIC float ui_server_get_window_scale(ptk_window_t *window);
@@ -28,6 +45,18 @@ LIBUI_SERVER_PUBLIC void ui_server_present(void);
 LIBUI_SERVER_PUBLIC void ui_server_update(void);
 LIBUI_SERVER_PUBLIC void ui_server_init(void);
 LIBUI_SERVER_PUBLIC void ui_server_set_threads(int threads);
+LIBUI_SERVER_PUBLIC int ui_server_get_threads(void);
+LIBUI_SERVER_PUBLIC int ui_server_get_render_thread_stats(int id, worker_pool_stats_t *stats);
+LIBUI_SERVER_PUBLIC void ui_server_reset_render_thread_stats(void);
+LIBUI_SERVER_PUBLIC void ui_server_set_pipelined_rendering_enabled(bool enabled);
+LIBUI_SERVER_PUBLIC bool ui_server_is_pipelined_rendering_enabled(void);
+LIBUI_SERVER_PUBLIC void ui_server_set_tiled_rendering_enabled(bool enabled);
+LIBUI_SERVER_PUBLIC bool ui_server_is_tiled_rendering_enabled(void);
+LIBUI_SERVER_PUBLIC void ui_server_set_render_tile_size(int size);
+LIBUI_SERVER_PUBLIC void ui_server_get_tile_stats(ui_server_tile_stats_t *stats);
+LIBUI_SERVER_PUBLIC void ui_server_reset_tile_stats(void);
+LIBUI_SERVER_PUBLIC void ui_server_get_paint_stats(ui_server_paint_stats_t *stats);
+LIBUI_SERVER_PUBLIC void ui_server_reset_paint_stats(void);
 LIBUI_SERVER_PUBLIC void ui_server_set_paint_flashing_enabled(bool enabled);
 LIBUI_SERVER_PUBLIC void ui_server_destroy(void);
 
@@ -16,13 +16,25 @@
 #include <ui_cursor.h>
 #include <ui_server.h>
 #include <css/computed.h>
-
-#ifdef LIBUI_SERVER_HAS_OPENMP
-#include <omp.h>
-#endif
+#include <thread.h>
+#include <worker.h>
+#include "tile_cache.h"
 
 #define TITLE_MAX_SIZE 256
 
+/* Size of the tiles into which the dirty region is split for rendering */
+#define RENDER_TILE_SIZE 256
+
+/* Maximum number of rectangles painted in a tile */
+#define MAX_TILE_RECTS 16
+
+/* Fixed cost of a paint call, in pixels, used to decide whether to merge
+ * dirty rectangles */
+#define PAINT_RECT_COST (64 * 64)
+
+/* Default size of the tiles of the window back buffer in tiled mode */
+#define CACHE_TILE_SIZE 128
+
 typedef struct window_mutation_record {
         ptk_window_t *window;
         bool update_size;
@@ -42,16 +54,35 @@ typedef struct ui_flash_rect {
         pd_rect_t rect;
 } ui_flash_rect_t;
 
-typedef struct ui_dirty_layer {
-        list_t rects;
-        pd_rect_t rect;
-        int dirty;
-} ui_dirty_layer_t;
+typedef enum ui_server_frame_state {
+        UI_SERVER_FRAME_STATE_NONE,
+        UI_SERVER_FRAME_STATE_RENDERING,
+        UI_SERVER_FRAME_STATE_READY
+} ui_server_frame_state_t;
+
+/** A frame rendered by the render thread in pipelined mode */
+typedef struct ui_server_frame {
+        ui_server_frame_state_t state;
+        ui_frame_t *snapshot;
+        pd_rect_t *rects;
+        unsigned length;
+
+        /** Number of rendered widgets */
+        size_t count;
+
+        /** Back buffer, the frame is copied to the window when it is ready */
+        pd_canvas_t canvas;
+} ui_server_frame_t;
 
 typedef struct ui_connection {
         /** whether new content has been rendered */
         bool rendered;
 
+        ui_server_frame_t frame;
+
+        /** Back buffer of the window in tiled mode */
+        ui_tile_cache_t tiles;
+
         /** flashing rect list */
         list_t flash_rects;
 
@@ -66,9 +97,45 @@ static struct ui_server {
         list_t connections;
         ui_mutation_observer_t *observer;
         bool paint_flashing_enabled;
-        int num_rendering_threads;
+
+        /** Workers for rendering tiles in parallel */
+        worker_pool_t *render_pool;
+
+        /** Canvas pool of each rendering worker */
+        pd_canvas_pool_t **canvas_pools;
+
+        /** Serializes the window painting calls of rendering workers */
+        thread_mutex_t paint_mutex;
+
+        /**
+         * Render thread of the pipelined mode. The main thread publishes
+         * a snapshot of the widgets and goes on processing events, while
+         * this thread renders the snapshot into the back buffer.
+         */
+        worker_t *render_worker;
+
+        /** Protects the state of frames */
+        thread_mutex_t frame_mutex;
+        thread_cond_t frame_cond;
+
+        /**
+         * Whether to render the window into a tiled back buffer, only the
+         * dirty tiles are rendered and the others are reused
+         */
+        bool tiled_rendering_enabled;
+        int tile_size;
+        ui_server_tile_stats_t tile_stats;
+        ui_server_paint_stats_t paint_stats;
 } ui_server;
 
+typedef struct ui_render_job {
+        ui_connection_t *conn;
+        const pd_rect_t *rects;
+
+        /** Number of rendered widgets of each worker */
+        size_t *counts;
+} ui_render_job_t;
+
 static inline int is_rect_equals(const pd_rect_t *a, const pd_rect_t *b)
 {
         return a->x == b->x && a->y == b->y && a->width == b->width &&
@@ -110,10 +177,36 @@ ptk_window_t *ui_server_get_window(ui_widget_t *widget)
         return conn ? conn->window : NULL;
 }
 
+static void ui_server_wait_frame(ui_connection_t *conn)
+{
+        thread_mutex_lock(&ui_server.frame_mutex);
+        while (conn->frame.state == UI_SERVER_FRAME_STATE_RENDERING) {
+                thread_cond_wait(&ui_server.frame_cond, &ui_server.frame_mutex);
+        }
+        thread_mutex_unlock(&ui_server.frame_mutex);
+}
+
+static void ui_server_frame_reset(ui_server_frame_t *frame)
+{
+        if (frame->snapshot) {
+                ui_frame_destroy(frame->snapshot);
+        }
+        free(frame->rects);
+        frame->snapshot = NULL;
+        frame->rects = NULL;
+        frame->length = 0;
+        frame->count = 0;
+        frame->state = UI_SERVER_FRAME_STATE_NONE;
+}
+
 static void ui_connection_destroy(void *arg)
 {
         ui_connection_t *conn = arg;
 
+        ui_server_wait_frame(conn);
+        ui_server_frame_reset(&conn->frame);
+        pd_canvas_destroy(&conn->frame.canvas);
+        ui_tile_cache_destroy(&conn->tiles);
         list_destroy(&conn->flash_rects, free);
         ui_updater_destroy(conn->updater);
         free(conn);
@@ -183,25 +276,6 @@ static void ui_server_on_window_visibility_change(ptk_event_t *e, void *arg)
         }
 }
 
-static void ui_server_on_window_paint(ptk_event_t *e, void *arg)
-{
-        ui_rect_t rect;
-        list_node_t *node;
-        ui_connection_t *conn;
-
-        for (list_each(node, &ui_server.connections)) {
-                conn = node->data;
-                if (conn && conn->window != e->window) {
-                        continue;
-                }
-                ui_rect_from_pd_rect(
-                    &rect, &e->paint.rect,
-                    css_metrics_actual_scale(&conn->updater->metrics));
-                ui_widget_mark_dirty_rect(conn->widget, &rect,
-                                          UI_BOX_TYPE_GRAPH_BOX);
-        }
-}
-
 static void ui_server_on_window_resize(ptk_event_t *e, void *arg)
 {
         ui_connection_t *conn;
@@ -338,6 +412,14 @@ void ui_server_connect(ui_widget_t *widget, ptk_window_t *window)
         conn->widget = widget;
         conn->rendered = false;
         conn->window_visible = false;
+        conn->frame.state = UI_SERVER_FRAME_STATE_NONE;
+        conn->frame.snapshot = NULL;
+        conn->frame.rects = NULL;
+        conn->frame.length = 0;
+        conn->frame.count = 0;
+        pd_canvas_init(&conn->frame.canvas);
+        conn->frame.canvas.color_type = PD_COLOR_TYPE_ARGB;
+        ui_tile_cache_init(&conn->tiles);
         conn->updater = ui_updater_create();
         conn->updater->metrics.dpi = 1.f * ptk_window_get_dpi(window);
         options.properties = true;
@@ -356,80 +438,86 @@ void ui_server_connect(ui_widget_t *widget, ptk_window_t *window)
                      widget, widget->type);
 }
 
-static void get_rendering_layer_size(int *width, int *height)
+static void ui_server_append_region_rects(pd_rect_t **rects,
+                                         unsigned *length, unsigned *capacity,
+                                         const pd_region_t *region)
 {
-        *width = (int)ptk_screen_get_width();
-        *height =
-            (int)ptk_screen_get_height() / ui_server.num_rendering_threads + 1;
-        if (*height < 200) {
-                *height = 200;
+        unsigned n;
+        pd_rect_t *new_rects;
+
+        n = *length + region->length;
+        if (n > *capacity) {
+                *capacity = n > *capacity * 2 ? n : *capacity * 2;
+                new_rects = realloc(*rects, sizeof(pd_rect_t) * *capacity);
+                if (!new_rects) {
+                        return;
+                }
+                *rects = new_rects;
         }
+        memcpy(*rects + *length, region->rects,
+               sizeof(pd_rect_t) * region->length);
+        *length = n;
 }
 
-static void ui_server_dump_rects(ui_connection_t *conn, list_t *out_rects)
+/**
+ * Split the dirty region of the window into a fixed grid of tiles. The
+ * output rectangles do not overlap, so each pixel is painted at most once,
+ * and they only depend on the dirty region, so the rendered result is the
+ * same regardless of how many threads paint them.
+ */
+static unsigned ui_server_dump_rects(ui_connection_t *conn,
+                                     const pd_region_t *exposed,
+                                     pd_rect_t **rects)
 {
-        int i;
-        int max_dirty;
-        int layer_width;
-        int layer_height;
-
-        pd_rect_t rect;
-        pd_rect_t *sub_rect;
-        ui_dirty_layer_t *layer;
-        ui_dirty_layer_t *layers;
-        list_node_t *node;
-        list_t rects;
-
-        list_create(&rects);
-        ui_widget_get_dirty_rects(conn->widget, &rects);
-        get_rendering_layer_size(&layer_width, &layer_height);
-        max_dirty = (int)(0.8 * layer_width * layer_height);
-        layers =
-            malloc(sizeof(ui_dirty_layer_t) * ui_server.num_rendering_threads);
-        for (i = 0; i < ui_server.num_rendering_threads; ++i) {
-                layer = &layers[i];
-                layer->dirty = 0;
-                layer->rect.y = i * layer_height;
-                layer->rect.x = 0;
-                layer->rect.width = layer_width;
-                layer->rect.height = layer_height;
-                list_create(&layer->rects);
-        }
-        sub_rect = malloc(sizeof(pd_rect_t));
-        for (list_each(node, &rects)) {
-                rect = *(pd_rect_t *)node->data;
-                for (i = 0; i < ui_server.num_rendering_threads; ++i) {
-                        layer = &layers[i];
-                        if (layer->dirty >= max_dirty) {
-                                continue;
-                        }
-                        if (!pd_rect_overlap(&layer->rect, &rect, sub_rect)) {
+        int x, y;
+        unsigned length = 0;
+        unsigned capacity = 0;
+        size_t max_dirty;
+
+        pd_rect_t tile;
+        pd_region_t region;
+        pd_region_t tile_region;
+
+        *rects = NULL;
+        pd_region_init(&region);
+        pd_region_init(&tile_region);
+        ui_widget_get_dirty_region(conn->widget, &region);
+        if (exposed) {
+                pd_region_union(&region, &region, exposed);
+        }
+        max_dirty = (size_t)(0.8 * RENDER_TILE_SIZE * RENDER_TILE_SIZE);
+        tile.width = RENDER_TILE_SIZE;
+        tile.height = RENDER_TILE_SIZE;
+        for (y = region.extents.y / RENDER_TILE_SIZE * RENDER_TILE_SIZE;
+             !pd_region_is_empty(&region) &&
+             y < region.extents.y + region.extents.height;
+             y += RENDER_TILE_SIZE) {
+                for (x = region.extents.x / RENDER_TILE_SIZE *
+                         RENDER_TILE_SIZE;
+                     x < region.extents.x + region.extents.width;
+                     x += RENDER_TILE_SIZE) {
+                        tile.x = x;
+                        tile.y = y;
+                        pd_region_copy(&tile_region, &region);
+                        pd_region_intersect_rect(&tile_region, &tile);
+                        if (pd_region_is_empty(&tile_region)) {
                                 continue;
                         }
-                        list_append(&layer->rects, sub_rect);
-                        rect.y += sub_rect->height;
-                        rect.height -= sub_rect->height;
-                        layer->dirty += sub_rect->width * sub_rect->height;
-                        sub_rect = malloc(sizeof(pd_rect_t));
-                        if (rect.height < 1) {
-                                break;
+                        /* Paint the whole tile if most of it is dirty */
+                        if (pd_region_get_area(&tile_region) >= max_dirty) {
+                                pd_region_set_rect(&tile_region, &tile);
+                        } else {
+                                pd_region_simplify(&tile_region,
+                                                   MAX_TILE_RECTS,
+                                                   PAINT_RECT_COST);
                         }
+                        ui_server_append_region_rects(rects, &length,
+                                                      &capacity, &tile_region);
                 }
         }
-        free(sub_rect);
-        for (i = 0; i < ui_server.num_rendering_threads; ++i) {
-                layer = &layers[i];
-                if (layer->dirty >= max_dirty) {
-                        sub_rect = malloc(sizeof(pd_rect_t));
-                        *sub_rect = layer->rect;
-                        list_append(out_rects, sub_rect);
-                        list_destroy(&layer->rects, free);
-                } else {
-                        list_concat(out_rects, &layer->rects);
-                }
-        }
-        list_destroy(&rects, free);
-        free(layers);
+        pd_region_destroy(&tile_region);
+        pd_region_destroy(&region);
+        return length;
 }
 
 static size_t ui_server_render_flash_rect(ui_connection_t *conn,
@@ -517,7 +605,96 @@ static void ui_server_add_flash_rect(ui_connection_t *conn, pd_rect_t *rect)
         list_append(&conn->flash_rects, flash_rect);
 }
 
-static size_t ui_server_render_rect(ui_connection_t *conn, pd_rect_t *rect)
+static void ui_server_copy_rect(ui_connection_t *conn, pd_canvas_t *src,
+                                pd_rect_t *rect)
+{
+        pd_canvas_t canvas;
+        pd_context_t *paint;
+
+        paint = ptk_window_begin_paint(conn->window, rect);
+        if (!paint) {
+                return;
+        }
+        pd_canvas_quote(&canvas, src, &paint->rect);
+        pd_canvas_mix(&paint->canvas, &canvas, 0, 0, false);
+        if (ui_server.paint_flashing_enabled) {
+                ui_server_add_flash_rect(conn, &paint->rect);
+        }
+        ptk_window_end_paint(conn->window, paint);
+}
+
+static void ui_server_mark_dirty_rect(ui_connection_t *conn, pd_rect_t *rect)
+{
+        ui_rect_t dirty_rect;
+
+        ui_rect_from_pd_rect(&dirty_rect, rect,
+                             css_metrics_actual_scale(&conn->updater->metrics));
+        ui_widget_mark_dirty_rect(conn->widget, &dirty_rect,
+                                  UI_BOX_TYPE_GRAPH_BOX);
+}
+
+/**
+ * Repaint the window with the tiles in the back buffer, only the area of the
+ * tiles that are not ready is marked as dirty.
+ */
+static void ui_server_repaint_window(ui_connection_t *conn, pd_rect_t *rect)
+{
+        int x, y;
+        pd_rect_t tile_rect, paint_rect;
+        ui_tile_cache_t *tiles = &conn->tiles;
+
+        if (tiles->tile_size < 1 ||
+            tiles->canvas.width !=
+                (unsigned)ptk_window_get_width(conn->window) ||
+            tiles->canvas.height !=
+                (unsigned)ptk_window_get_height(conn->window)) {
+                ui_server_mark_dirty_rect(conn, rect);
+                return;
+        }
+        for (y = y_max(0, rect->y / tiles->tile_size * tiles->tile_size);
+             y < rect->y + rect->height && y < (int)tiles->canvas.height;
+             y += tiles->tile_size) {
+                for (x = y_max(0, rect->x / tiles->tile_size *
+                                      tiles->tile_size);
+                     x < rect->x + rect->width &&
+                     x < (int)tiles->canvas.width;
+                     x += tiles->tile_size) {
+                        ui_tile_cache_get_tile_rect(tiles, x, y, &tile_rect);
+                        if (!pd_rect_overlap(&tile_rect, rect, &paint_rect)) {
+                                continue;
+                        }
+                        if (ui_tile_cache_is_tile_ready(tiles, x, y)) {
+                                ui_server_copy_rect(conn, &tiles->canvas,
+                                                    &paint_rect);
+                                ui_server.tile_stats.reused++;
+                        } else {
+                                ui_server_mark_dirty_rect(conn, &paint_rect);
+                        }
+                }
+        }
+}
+
+static void ui_server_on_window_paint(ptk_event_t *e, void *arg)
+{
+        list_node_t *node;
+        ui_connection_t *conn;
+
+        for (list_each(node, &ui_server.connections)) {
+                conn = node->data;
+                if (conn && conn->window != e->window) {
+                        continue;
+                }
+                if (ui_server.tiled_rendering_enabled &&
+                    !ui_server.render_worker) {
+                        ui_server_repaint_window(conn, &e->paint.rect);
+                } else {
+                        ui_server_mark_dirty_rect(conn, &e->paint.rect);
+                }
+        }
+}
+
+static size_t ui_server_render_rect(ui_connection_t *conn, pd_rect_t *rect,
+                                    pd_canvas_pool_t *pool)
 {
         size_t count;
         pd_context_t *paint;
@@ -525,65 +702,371 @@ static size_t ui_server_render_rect(ui_connection_t *conn, pd_rect_t *rect)
         if (!conn->widget || !conn->window) {
                 return 0;
         }
+        thread_mutex_lock(&ui_server.paint_mutex);
         paint = ptk_window_begin_paint(conn->window, rect);
+        thread_mutex_unlock(&ui_server.paint_mutex);
         if (!paint) {
                 return 0;
         }
-        DEBUG_MSG("[thread %d/%d] rect: (%d,%d,%d,%d)\n", omp_get_thread_num(),
-                  omp_get_num_threads(), paint->rect.x, paint->rect.y,
+        DEBUG_MSG("rect: (%d,%d,%d,%d)\n", paint->rect.x, paint->rect.y,
                   paint->rect.width, paint->rect.height);
-        count = ui_widget_render(conn->widget, paint);
+        count = ui_widget_render_with_pool(conn->widget, paint, pool);
+        thread_mutex_lock(&ui_server.paint_mutex);
+        ui_server.paint_stats.painted_bytes += (size_t)paint->rect.width *
+                                               paint->rect.height *
+                                               paint->canvas.bytes_per_pixel;
         if (ui_server.paint_flashing_enabled) {
                 ui_server_add_flash_rect(conn, &paint->rect);
         }
         ptk_window_end_paint(conn->window, paint);
+        thread_mutex_unlock(&ui_server.paint_mutex);
         return count;
 }
 
-static size_t ui_server_render_window(ui_connection_t *conn)
+static void ui_server_render_window_job(void *data, unsigned index,
+                                        unsigned worker_id)
+{
+        ui_render_job_t *job = data;
+        pd_rect_t rect = job->rects[index];
+
+        job->counts[worker_id] += ui_server_render_rect(
+            job->conn, &rect, ui_server.canvas_pools[worker_id]);
+}
+
+static void ui_server_render_frame_job(void *data, unsigned index,
+                                       unsigned worker_id)
+{
+        ui_render_job_t *job = data;
+        pd_context_t paint;
+        ui_server_frame_t *frame = &job->conn->frame;
+
+        paint.rect = job->rects[index];
+        paint.with_alpha = false;
+        pd_rect_correct(&paint.rect, frame->canvas.width,
+                        frame->canvas.height);
+        if (paint.rect.width < 1 || paint.rect.height < 1) {
+                return;
+        }
+        /* Fill the background in the same way as the window */
+        pd_canvas_quote(&paint.canvas, &frame->canvas, &paint.rect);
+        pd_canvas_fill(&paint.canvas, pd_rgb(255, 255, 255));
+        job->counts[worker_id] += ui_frame_render(
+            frame->snapshot, &paint, ui_server.canvas_pools[worker_id]);
+}
+
+static void ui_server_render_tile_job(void *data, unsigned index,
+                                      unsigned worker_id)
+{
+        ui_render_job_t *job = data;
+        pd_context_t paint;
+        ui_tile_cache_t *tiles = &job->conn->tiles;
+
+        /* Each job renders into a different tile of the back buffer, so
+         * the jobs do not need to be serialized */
+        paint.rect = job->rects[index];
+        paint.with_alpha = false;
+        pd_canvas_quote(&paint.canvas, &tiles->canvas, &paint.rect);
+        pd_canvas_fill(&paint.canvas, pd_rgb(255, 255, 255));
+        job->counts[worker_id] += ui_widget_render_with_pool(
+            job->conn->widget, &paint, ui_server.canvas_pools[worker_id]);
+}
+
+/**
+ * Run the render job for each rectangle, on the rendering workers if the
+ * render area is large enough.
+ */
+static size_t ui_server_run_render_job(ui_render_job_t *job, unsigned length,
+                                       worker_pool_job_cb job_cb)
 {
-        int i = 0;
-        int dirty = 0;
-        int layer_width;
-        int layer_height;
+        unsigned i;
+        unsigned num_workers = 1;
+        size_t dirty = 0;
         size_t count = 0;
-        pd_rect_t **rect_array;
+
+        for (i = 0; i < length; ++i) {
+                dirty += (size_t)job->rects[i].width * job->rects[i].height;
+        }
+        /* Use the rendering workers only if the render area is larger than
+         * two tiles */
+        if (dirty >= 2 * RENDER_TILE_SIZE * RENDER_TILE_SIZE) {
+                num_workers = worker_pool_get_size(ui_server.render_pool);
+        }
+        job->counts = calloc(num_workers, sizeof(size_t));
+        if (!job->counts) {
+                return 0;
+        }
+        if (num_workers > 1) {
+                worker_pool_run(ui_server.render_pool, length, job_cb, job);
+        } else {
+                for (i = 0; i < length; ++i) {
+                        job_cb(job, i, 0);
+                }
+        }
+        for (i = 0; i < num_workers; ++i) {
+                count += job->counts[i];
+        }
+        free(job->counts);
+        return count;
+}
+
+/**
+ * Move the pixels of the scrolled areas, in the canvas or in the window if
+ * the canvas is NULL, and add the areas that need to be repainted to the
+ * region. It should be called before the dirty region is collected.
+ * @param[out] moved_region areas whose pixels have been moved, can be NULL
+ */
+static void ui_server_scroll_window(ui_connection_t *conn, pd_canvas_t *canvas,
+                                    pd_region_t *region,
+                                    pd_region_t *moved_region)
+{
+        size_t size;
         list_t rects;
         list_node_t *node;
+        pd_rect_t dest_rect;
+        pd_region_t moved;
+        ui_scroll_rect_t *scroll_rect;
 
         list_create(&rects);
-        get_rendering_layer_size(&layer_width, &layer_height);
-        ui_server_dump_rects(conn, &rects);
-        if (rects.length < 1) {
-                return 0;
-        }
-        rect_array = (pd_rect_t **)malloc(sizeof(pd_rect_t *) * rects.length);
+        pd_region_init(&moved);
+        ui_widget_get_scroll_rects(conn->widget, &rects);
         for (list_each(node, &rects)) {
-                rect_array[i] = node->data;
-                dirty += rect_array[i]->width * rect_array[i]->height;
-                i++;
-        }
-        // Use OPENMP if the render area is larger than two render layers
-        if (dirty >= layer_width * layer_height * 2) {
-#ifdef ENABLE_OPENMP
-#pragma omp parallel for default(none) shared(ui_server, rects, rect_array) \
-    firstprivate(conn) reduction(+ : count)
-#endif
-                for (i = 0; i < (int)rects.length; ++i) {
-                        count += ui_server_render_rect(conn, rect_array[i]);
+                scroll_rect = node->data;
+                pd_rect_correct(&scroll_rect->blit_rect,
+                                ptk_window_get_width(conn->window),
+                                ptk_window_get_height(conn->window));
+                if (canvas) {
+                        size = pd_canvas_scroll(canvas, &scroll_rect->blit_rect,
+                                                scroll_rect->dx,
+                                                scroll_rect->dy);
+                } else {
+                        size = ptk_window_scroll(conn->window,
+                                                 &scroll_rect->blit_rect,
+                                                 scroll_rect->dx,
+                                                 scroll_rect->dy);
                 }
-        } else {
-                for (i = 0; i < (int)rects.length; ++i) {
-                        count += ui_server_render_rect(conn, rect_array[i]);
+                ui_server.paint_stats.blitted_bytes += size;
+                dest_rect = scroll_rect->blit_rect;
+                dest_rect.x += scroll_rect->dx;
+                dest_rect.y += scroll_rect->dy;
+                if (size < 1 || !pd_rect_overlap(&scroll_rect->blit_rect,
+                                                 &dest_rect, &dest_rect)) {
+                        dest_rect.width = 0;
+                        dest_rect.height = 0;
+                }
+                /* The pixels to be repainted are moved too */
+                pd_region_copy(&moved, region);
+                pd_region_intersect_rect(&moved, &scroll_rect->blit_rect);
+                pd_region_translate(&moved, scroll_rect->dx, scroll_rect->dy);
+                pd_region_intersect_rect(&moved, &dest_rect);
+                pd_region_union(region, region, &moved);
+                /* Repaint the area which is not covered by the moved pixels */
+                pd_region_set_rect(&moved, &scroll_rect->rect);
+                pd_region_subtract_rect(&moved, &dest_rect);
+                pd_region_union(region, region, &moved);
+                if (moved_region && dest_rect.width > 0) {
+                        pd_region_union_rect(moved_region, &dest_rect);
                 }
         }
-        free(rect_array);
-        pd_rects_clear(&rects);
+        pd_region_destroy(&moved);
+        list_destroy(&rects, free);
+}
+
+static size_t ui_server_render_window(ui_connection_t *conn)
+{
+        unsigned n;
+        size_t count = 0;
+        pd_rect_t *rects;
+        pd_region_t exposed;
+        ui_render_job_t job;
+
+        pd_region_init(&exposed);
+        if (conn->widget && conn->window) {
+                ui_server_scroll_window(conn, NULL, &exposed, NULL);
+        }
+        n = ui_server_dump_rects(conn, &exposed, &rects);
+        pd_region_destroy(&exposed);
+        if (n > 0) {
+                if (conn->widget) {
+                        count = ui_widget_update_layers(
+                            conn->widget, rects, n, ui_server.canvas_pools[0]);
+                }
+                job.conn = conn;
+                job.rects = rects;
+                count += ui_server_run_render_job(&job, n,
+                                                  ui_server_render_window_job);
+        }
+        free(rects);
+        if (n < 1) {
+                return 0;
+        }
         conn->rendered = count > 0;
         count += ui_server_update_flash_rects(conn);
         return count;
 }
 
+/**
+ * Render the dirty tiles of the window into the back buffer, then copy them
+ * to the window. The tiles that are not changed are kept in the back buffer,
+ * and each tile is a render job of bounded size.
+ */
+static size_t ui_server_render_window_tiled(ui_connection_t *conn)
+{
+        unsigned i, n, moved_count;
+        size_t count = 0;
+        pd_rect_t *rects;
+        pd_region_t region, exposed, moved;
+        ui_render_job_t job;
+
+        if (!conn->widget || !conn->window ||
+            ui_tile_cache_resize(&conn->tiles, ui_server.tile_size,
+                                 ptk_window_get_width(conn->window),
+                                 ptk_window_get_height(conn->window)) != 0) {
+                return 0;
+        }
+        pd_region_init(&region);
+        pd_region_init(&exposed);
+        pd_region_init(&moved);
+        ui_server_scroll_window(conn, &conn->tiles.canvas, &exposed, &moved);
+        ui_widget_get_dirty_region(conn->widget, &region);
+        pd_region_union(&region, &region, &exposed);
+        for (i = 0; i < region.length; ++i) {
+                ui_tile_cache_add_dirty_rect(&conn->tiles, &region.rects[i]);
+        }
+        n = ui_tile_cache_get_dirty_rects(&conn->tiles, &rects);
+        if (n > 0) {
+                /* The layers are updated before the tiles are rendered, so
+                 * the rendering workers only need to composite them */
+                count = ui_widget_update_layers(conn->widget, rects, n,
+                                                ui_server.canvas_pools[0]);
+                job.conn = conn;
+                job.rects = rects;
+                count += ui_server_run_render_job(&job, n,
+                                                  ui_server_render_tile_job);
+                for (i = 0; i < n; ++i) {
+                        ui_server_copy_rect(conn, &conn->tiles.canvas,
+                                            &rects[i]);
+                        ui_server.paint_stats.painted_bytes +=
+                            (size_t)rects[i].width * rects[i].height *
+                            conn->tiles.canvas.bytes_per_pixel;
+                }
+                ui_server.tile_stats.rendered += n;
+        }
+        /* Copy the moved pixels of the scrolled areas to the window */
+        for (i = 0; i < moved.length; ++i) {
+                ui_server_copy_rect(conn, &conn->tiles.canvas,
+                                    &moved.rects[i]);
+        }
+        moved_count = moved.length;
+        free(rects);
+        pd_region_destroy(&region);
+        pd_region_destroy(&exposed);
+        pd_region_destroy(&moved);
+        if (n < 1 && moved_count < 1) {
+                return 0;
+        }
+        conn->rendered = count > 0;
+        return count;
+}
+
+/** Render the frame on the render thread */
+static void ui_server_render_frame(void *arg)
+{
+        size_t count;
+        ui_render_job_t job;
+        ui_connection_t *conn = arg;
+
+        job.conn = conn;
+        job.rects = conn->frame.rects;
+        count = ui_server_run_render_job(&job, conn->frame.length,
+                                         ui_server_render_frame_job);
+        thread_mutex_lock(&ui_server.frame_mutex);
+        conn->frame.count = count;
+        conn->frame.state = UI_SERVER_FRAME_STATE_READY;
+        thread_cond_broadcast(&ui_server.frame_cond);
+        thread_mutex_unlock(&ui_server.frame_mutex);
+}
+
+/** Copy the rendered frame to the window */
+static size_t ui_server_present_frame(ui_connection_t *conn)
+{
+        unsigned i;
+        size_t count;
+        ui_server_frame_t *frame = &conn->frame;
+
+        for (i = 0; i < frame->length && conn->window; ++i) {
+                ui_server_copy_rect(conn, &frame->canvas, &frame->rects[i]);
+                ui_server.paint_stats.painted_bytes +=
+                    (size_t)frame->rects[i].width * frame->rects[i].height *
+                    frame->canvas.bytes_per_pixel;
+        }
+        count = frame->count;
+        conn->rendered = count > 0;
+        ui_server_frame_reset(frame);
+        return count;
+}
+
+/**
+ * Present the frame rendered by the render thread and publish a snapshot of
+ * the widgets as the next frame. If the render thread is still busy, the
+ * dirty rectangles are kept for the next call.
+ */
+static size_t ui_server_render_window_pipelined(ui_connection_t *conn)
+{
+        int width, height;
+        size_t count = 0;
+        ui_server_frame_t *frame = &conn->frame;
+        ui_server_frame_state_t state;
+
+        thread_mutex_lock(&ui_server.frame_mutex);
+        state = frame->state;
+        thread_mutex_unlock(&ui_server.frame_mutex);
+        if (state == UI_SERVER_FRAME_STATE_RENDERING) {
+                return 0;
+        }
+        if (state == UI_SERVER_FRAME_STATE_READY) {
+                count = ui_server_present_frame(conn);
+        }
+        if (!conn->widget || !conn->window) {
+                return count;
+        }
+        frame->length = ui_server_dump_rects(conn, NULL, &frame->rects);
+        if (frame->length < 1) {
+                ui_server_frame_reset(frame);
+                return count;
+        }
+        width = ptk_window_get_width(conn->window);
+        height = ptk_window_get_height(conn->window);
+        if (frame->canvas.width != (unsigned)width ||
+            frame->canvas.height != (unsigned)height) {
+                pd_canvas_create(&frame->canvas, width, height);
+        }
+        frame->snapshot =
+            ui_frame_create(conn->widget, frame->rects, frame->length);
+        if (!frame->snapshot) {
+                ui_server_frame_reset(frame);
+                return count;
+        }
+        frame->state = UI_SERVER_FRAME_STATE_RENDERING;
+        worker_post_task(ui_server.render_worker, conn, ui_server_render_frame,
+                         NULL);
+        return count;
+}
+
+/** Wait for the render thread and present the frames it has rendered */
+static void ui_server_flush_frames(void)
+{
+        list_node_t *node;
+        ui_connection_t *conn;
+
+        for (list_each(node, &ui_server.connections)) {
+                conn = node->data;
+                ui_server_wait_frame(conn);
+                if (conn->frame.state == UI_SERVER_FRAME_STATE_READY) {
+                        ui_server_present_frame(conn);
+                }
+        }
+}
+
 size_t ui_server_render(void)
 {
         size_t count = 0;
@@ -591,13 +1074,21 @@ size_t ui_server_render(void)
         ui_connection_t *conn;
         float dpi = 1.f * ui_metrics.dpi;
 
+        /* Render statistics are collected per frame */
+        ui_reset_render_stats();
         for (list_each(node, &ui_server.connections)) {
                 conn = node->data;
                 if (!conn->window_visible) {
                         continue;
                 }
                 ui_metrics.dpi = 1.f * ptk_window_get_dpi(conn->window);
-                count += ui_server_render_window(conn);
+                if (ui_server.render_worker) {
+                        count += ui_server_render_window_pipelined(conn);
+                } else if (ui_server.tiled_rendering_enabled) {
+                        count += ui_server_render_window_tiled(conn);
+                } else {
+                        count += ui_server_render_window(conn);
+                }
                 count += ui_server_update_flash_rects(conn);
         }
         ui_metrics.dpi = dpi;
@@ -735,7 +1226,15 @@ void ui_server_update(void)
 void ui_server_init(void)
 {
         ui_cursor_init();
-        ui_server.num_rendering_threads = 4;
+        thread_mutex_init(&ui_server.paint_mutex);
+        thread_mutex_init(&ui_server.frame_mutex);
+        thread_cond_init(&ui_server.frame_cond);
+        if (!ui_server.render_pool) {
+                ui_server_set_threads(4);
+        }
+        if (ui_server.tile_size < 1) {
+                ui_server.tile_size = CACHE_TILE_SIZE;
+        }
         ui_server.observer =
             ui_mutation_observer_create(ui_server_on_widget_mutation, NULL);
         ptk_on_event(PTK_EVENT_VISIBILITY_CHANGE,
@@ -759,12 +1258,158 @@ void ui_server_init(void)
         }
 }
 
+static void ui_server_destroy_render_pool(void)
+{
+        unsigned i;
+
+        if (!ui_server.render_pool) {
+                return;
+        }
+        for (i = 0; i < worker_pool_get_size(ui_server.render_pool); ++i) {
+                pd_canvas_pool_destroy(ui_server.canvas_pools[i]);
+        }
+        free(ui_server.canvas_pools);
+        worker_pool_destroy(ui_server.render_pool);
+        ui_server.canvas_pools = NULL;
+        ui_server.render_pool = NULL;
+}
+
 void ui_server_set_threads(int threads)
 {
+        unsigned i;
+        worker_pool_t *pool;
+        pd_canvas_pool_t **canvas_pools;
+
         if (threads < 1) {
                 return;
         }
-        ui_server.num_rendering_threads = threads;
+        /* The render thread may be using the workers */
+        if (ui_server.render_worker) {
+                ui_server_flush_frames();
+        }
+        if (ui_server.render_pool &&
+            worker_pool_get_size(ui_server.render_pool) == (unsigned)threads) {
+                return;
+        }
+        pool = worker_pool_create(threads);
+        canvas_pools = NULL;
+        if (pool) {
+                canvas_pools = calloc(worker_pool_get_size(pool),
+                                      sizeof(pd_canvas_pool_t *));
+        }
+        if (!pool || !canvas_pools) {
+                if (pool) {
+                        worker_pool_destroy(pool);
+                }
+                free(canvas_pools);
+                logger_error("[ui-server] failed to create %d rendering "
+                             "threads\n",
+                             threads);
+                return;
+        }
+        /* Some threads may have failed to start */
+        for (i = 0; i < worker_pool_get_size(pool); ++i) {
+                canvas_pools[i] = pd_canvas_pool_create(0);
+        }
+        ui_server_destroy_render_pool();
+        ui_server.render_pool = pool;
+        ui_server.canvas_pools = canvas_pools;
+}
+
+int ui_server_get_threads(void)
+{
+        return ui_server.render_pool
+                   ? (int)worker_pool_get_size(ui_server.render_pool)
+                   : 0;
+}
+
+int ui_server_get_render_thread_stats(int id, worker_pool_stats_t *stats)
+{
+        if (!ui_server.render_pool || id < 0 ||
+            (unsigned)id >= worker_pool_get_size(ui_server.render_pool)) {
+                return -1;
+        }
+        worker_pool_get_stats(ui_server.render_pool, id, stats);
+        return 0;
+}
+
+void ui_server_reset_render_thread_stats(void)
+{
+        if (ui_server.render_pool) {
+                worker_pool_reset_stats(ui_server.render_pool);
+        }
+}
+
+void ui_server_set_pipelined_rendering_enabled(bool enabled)
+{
+        if (enabled == (ui_server.render_worker != NULL)) {
+                return;
+        }
+        if (enabled) {
+                ui_server.render_worker = worker_create();
+                worker_run_async(ui_server.render_worker);
+                return;
+        }
+        ui_server_flush_frames();
+        worker_destroy(ui_server.render_worker);
+        ui_server.render_worker = NULL;
+}
+
+bool ui_server_is_pipelined_rendering_enabled(void)
+{
+        return ui_server.render_worker != NULL;
+}
+
+void ui_server_set_tiled_rendering_enabled(bool enabled)
+{
+        list_node_t *node;
+        ui_connection_t *conn;
+
+        if (enabled == ui_server.tiled_rendering_enabled) {
+                return;
+        }
+        ui_server.tiled_rendering_enabled = enabled;
+        if (enabled) {
+                return;
+        }
+        for (list_each(node, &ui_server.connections)) {
+                conn = node->data;
+                ui_tile_cache_destroy(&conn->tiles);
+        }
+}
+
+bool ui_server_is_tiled_rendering_enabled(void)
+{
+        return ui_server.tiled_rendering_enabled;
+}
+
+void ui_server_set_render_tile_size(int size)
+{
+        if (size > 0) {
+                ui_server.tile_size = size;
+        }
+}
+
+void ui_server_get_tile_stats(ui_server_tile_stats_t *stats)
+{
+        *stats = ui_server.tile_stats;
+}
+
+void ui_server_reset_tile_stats(void)
+{
+        ui_server.tile_stats.rendered = 0;
+        ui_server.tile_stats.reused = 0;
+}
+
+void ui_server_get_paint_stats(ui_server_paint_stats_t *stats)
+{
+        *stats = ui_server.paint_stats;
+}
+
+void ui_server_reset_paint_stats(void)
+{
+        ui_server.paint_stats.blitted_bytes = 0;
+        ui_server.paint_stats.painted_bytes = 0;
 }
 
 void ui_server_set_paint_flashing_enabled(bool enabled)
@@ -781,7 +1426,12 @@ void ui_server_destroy(void)
         ptk_off_event(PTK_EVENT_VISIBILITY_CHANGE,
                       ui_server_on_window_visibility_change);
         ptk_off_event(PTK_EVENT_DPICHANGED, ui_server_on_window_dpi_changed);
+        ui_server_set_pipelined_rendering_enabled(false);
         list_destroy(&ui_server.connections, ui_connection_destroy);
         ui_mutation_observer_destroy(ui_server.observer);
         ui_server.observer = NULL;
+        ui_server_destroy_render_pool();
+        thread_mutex_destroy(&ui_server.paint_mutex);
+        thread_mutex_destroy(&ui_server.frame_mutex);
+        thread_cond_destroy(&ui_server.frame_cond);
 }
@@ -0,0 +1,181 @@
+﻿/*
+ * lib/ui-server/src/tile_cache.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tile_cache.h"
+
+#define BITSET_SIZE(n) (((n) + 31) / 32)
+#define BITSET_GET(bits, i) ((bits)[(i) / 32] & (1u << ((i) % 32)))
+#define BITSET_SET(bits, i) ((bits)[(i) / 32] |= (1u << ((i) % 32)))
+#define BITSET_CLEAR(bits, i) ((bits)[(i) / 32] &= ~(1u << ((i) % 32)))
+
+void ui_tile_cache_init(ui_tile_cache_t *cache)
+{
+        cache->tile_size = 0;
+        cache->cols = 0;
+        cache->rows = 0;
+        cache->dirty_bits = NULL;
+        cache->valid_bits = NULL;
+        cache->dirty_rects = NULL;
+        pd_canvas_init(&cache->canvas);
+        cache->canvas.color_type = PD_COLOR_TYPE_ARGB;
+}
+
+void ui_tile_cache_destroy(ui_tile_cache_t *cache)
+{
+        free(cache->dirty_bits);
+        free(cache->valid_bits);
+        free(cache->dirty_rects);
+        pd_canvas_destroy(&cache->canvas);
+        ui_tile_cache_init(cache);
+}
+
+int ui_tile_cache_resize(ui_tile_cache_t *cache, int tile_size, int width,
+                         int height)
+{
+        int cols, rows;
+        size_t i, n;
+
+        if (tile_size < 1 || width < 1 || height < 1) {
+                return -1;
+        }
+        if (cache->tile_size == tile_size &&
+            cache->canvas.width == (unsigned)width &&
+            cache->canvas.height == (unsigned)height) {
+                return 0;
+        }
+        ui_tile_cache_destroy(cache);
+        cols = (width + tile_size - 1) / tile_size;
+        rows = (height + tile_size - 1) / tile_size;
+        n = (size_t)cols * rows;
+        cache->dirty_bits = calloc(BITSET_SIZE(n), sizeof(uint32_t));
+        cache->valid_bits = calloc(BITSET_SIZE(n), sizeof(uint32_t));
+        cache->dirty_rects = calloc(n, sizeof(pd_rect_t));
+        if (!cache->dirty_bits || !cache->valid_bits || !cache->dirty_rects ||
+            pd_canvas_create(&cache->canvas, width, height) != 0) {
+                ui_tile_cache_destroy(cache);
+                return -ENOMEM;
+        }
+        cache->tile_size = tile_size;
+        cache->cols = cols;
+        cache->rows = rows;
+        memset(cache->dirty_bits, 0xff, BITSET_SIZE(n) * sizeof(uint32_t));
+        for (i = 0; i < n; ++i) {
+                ui_tile_cache_get_tile_rect(
+                    cache, (int)(i % cols) * tile_size,
+                    (int)(i / cols) * tile_size, &cache->dirty_rects[i]);
+        }
+        return 0;
+}
+
+void ui_tile_cache_get_tile_rect(ui_tile_cache_t *cache, int x, int y,
+                                 pd_rect_t *rect)
+{
+        rect->x = x / cache->tile_size * cache->tile_size;
+        rect->y = y / cache->tile_size * cache->tile_size;
+        rect->width = cache->tile_size;
+        rect->height = cache->tile_size;
+        pd_rect_correct(rect, cache->canvas.width, cache->canvas.height);
+}
+
+static void ui_tile_cache_merge_rect(pd_rect_t *base, const pd_rect_t *rect)
+{
+        int right = y_max(base->x + base->width, rect->x + rect->width);
+        int bottom = y_max(base->y + base->height, rect->y + rect->height);
+
+        base->x = y_min(base->x, rect->x);
+        base->y = y_min(base->y, rect->y);
+        base->width = right - base->x;
+        base->height = bottom - base->y;
+}
+
+void ui_tile_cache_add_dirty_rect(ui_tile_cache_t *cache,
+                                  const pd_rect_t *rect)
+{
+        int i, col, row;
+        pd_rect_t tile_rect, dirty_rect;
+
+        if (cache->tile_size < 1) {
+                return;
+        }
+        for (row = y_max(0, rect->y / cache->tile_size);
+             row < cache->rows &&
+             row * cache->tile_size < rect->y + rect->height;
+             ++row) {
+                for (col = y_max(0, rect->x / cache->tile_size);
+                     col < cache->cols &&
+                     col * cache->tile_size < rect->x + rect->width;
+                     ++col) {
+                        ui_tile_cache_get_tile_rect(
+                            cache, col * cache->tile_size,
+                            row * cache->tile_size, &tile_rect);
+                        if (!pd_rect_overlap(&tile_rect, rect, &dirty_rect)) {
+                                continue;
+                        }
+                        i = row * cache->cols + col;
+                        if (BITSET_GET(cache->dirty_bits, i)) {
+                                ui_tile_cache_merge_rect(&cache->dirty_rects[i],
+                                                         &dirty_rect);
+                        } else {
+                                cache->dirty_rects[i] = dirty_rect;
+                                BITSET_SET(cache->dirty_bits, i);
+                        }
+                }
+        }
+}
+
+unsigned ui_tile_cache_get_dirty_rects(ui_tile_cache_t *cache,
+                                       pd_rect_t **rects)
+{
+        int i, n;
+        unsigned length = 0;
+
+        n = cache->cols * cache->rows;
+        *rects = malloc(sizeof(pd_rect_t) * (n > 0 ? n : 1));
+        if (!*rects) {
+                return 0;
+        }
+        for (i = 0; i < n; ++i) {
+                if (!BITSET_GET(cache->dirty_bits, i)) {
+                        continue;
+                }
+                (*rects)[length++] = cache->dirty_rects[i];
+                BITSET_CLEAR(cache->dirty_bits, i);
+                /* Only the dirty area is rendered, so the tile is valid if
+                 * it has been rendered before or is rendered as a whole */
+                if (cache->dirty_rects[i].width ==
+                        y_min(cache->tile_size,
+                              (int)cache->canvas.width -
+                                  i % cache->cols * cache->tile_size) &&
+                    cache->dirty_rects[i].height ==
+                        y_min(cache->tile_size,
+                              (int)cache->canvas.height -
+                                  i / cache->cols * cache->tile_size)) {
+                        BITSET_SET(cache->valid_bits, i);
+                }
+        }
+        return length;
+}
+
+bool ui_tile_cache_is_tile_ready(ui_tile_cache_t *cache, int x, int y)
+{
+        int i;
+
+        if (x < 0 || y < 0 || cache->tile_size < 1 ||
+            x >= (int)cache->canvas.width || y >= (int)cache->canvas.height) {
+                return false;
+        }
+        i = y / cache->tile_size * cache->cols + x / cache->tile_size;
+        return BITSET_GET(cache->valid_bits, i) &&
+               !BITSET_GET(cache->dirty_bits, i);
+}
@@ -0,0 +1,69 @@
+﻿/*
+ * lib/ui-server/src/tile_cache.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdint.h>
+#include <pandagl.h>
+
+/**
+ * Back buffer of a window divided into square tiles. Each tile has a dirty
+ * bit, so only the tiles whose content changed are rendered again, and the
+ * other tiles can be copied to the window when it needs to be repainted.
+ */
+typedef struct ui_tile_cache {
+        int tile_size;
+        int cols;
+        int rows;
+
+        /** It has the size of the window */
+        pd_canvas_t canvas;
+
+        /** One bit for each tile whose content is out of date */
+        uint32_t *dirty_bits;
+
+        /** One bit for each tile whose content has been rendered */
+        uint32_t *valid_bits;
+
+        /** Dirty area of each tile, it relative to the canvas */
+        pd_rect_t *dirty_rects;
+} ui_tile_cache_t;
+
+void ui_tile_cache_init(ui_tile_cache_t *cache);
+
+void ui_tile_cache_destroy(ui_tile_cache_t *cache);
+
+/**
+ * Resize the cache, all tiles are marked as dirty if the size is changed
+ */
+int ui_tile_cache_resize(ui_tile_cache_t *cache, int tile_size, int width,
+                         int height);
+
+void ui_tile_cache_add_dirty_rect(ui_tile_cache_t *cache,
+                                  const pd_rect_t *rect);
+
+/**
+ * Get the dirty area of each dirty tile and clear the dirty bits. The tiles
+ * are considered valid after the rectangles are rendered.
+ * @param[out] rects the array should be freed by the caller
+ * @returns number of rectangles
+ */
+unsigned ui_tile_cache_get_dirty_rects(ui_tile_cache_t *cache,
+                                       pd_rect_t **rects);
+
+/**
+ * Whether the content of the tile at the point is valid and up to date
+ */
+bool ui_tile_cache_is_tile_ready(ui_tile_cache_t *cache, int x, int y);
+
+/**
+ * Get the rectangle of the tile at the point
+ */
+void ui_tile_cache_get_tile_rect(ui_tile_cache_t *cache, int x, int y,
+                                 pd_rect_t *rect);
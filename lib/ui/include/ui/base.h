@@ -31,6 +31,7 @@ LIBUI_PUBLIC void ui_widget_set_text(ui_widget_t *w, const char *text);
 LIBUI_PUBLIC void ui_widget_get_offset(ui_widget_t *w, ui_widget_t *parent,
                                        float *offset_x, float *offset_y);
 LIBUI_PUBLIC bool ui_widget_in_viewport(ui_widget_t *w);
+LIBUI_PUBLIC void ui_widget_scroll_to(ui_widget_t *w, float left, float top);
 
 // Root
 
@@ -136,8 +137,45 @@ LIBUI_PUBLIC void ui_widget_reflow(ui_widget_t *w);
 LIBUI_PUBLIC void ui_widget_expose_dirty_rect(ui_widget_t *w);
 LIBUI_PUBLIC bool ui_widget_mark_dirty_rect(ui_widget_t *w, ui_rect_t *in_rect,
                                             ui_box_type_t box_type);
+LIBUI_PUBLIC size_t ui_widget_get_dirty_region(ui_widget_t *w,
+                                               pd_region_t *region);
 LIBUI_PUBLIC size_t ui_widget_get_dirty_rects(ui_widget_t *w, list_t *rects);
+LIBUI_PUBLIC void ui_widget_mark_scrolled(ui_widget_t *w, float dx, float dy);
+LIBUI_PUBLIC size_t ui_widget_get_scroll_rects(ui_widget_t *w, list_t *rects);
+LIBUI_PUBLIC size_t ui_widget_update_layers(ui_widget_t *w,
+                                            const pd_rect_t *rects,
+                                            size_t length,
+                                            pd_canvas_pool_t *pool);
 LIBUI_PUBLIC size_t ui_widget_render(ui_widget_t *w, pd_context_t *paint);
+LIBUI_PUBLIC size_t ui_widget_render_with_pool(ui_widget_t *w,
+                                               pd_context_t *paint,
+                                               pd_canvas_pool_t *pool);
+LIBUI_PUBLIC void ui_get_canvas_pool_stats(pd_canvas_pool_stats_t *stats);
+LIBUI_PUBLIC void ui_set_occlusion_culling_enabled(bool enabled);
+LIBUI_PUBLIC void ui_set_opacity_folding_enabled(bool enabled);
+LIBUI_PUBLIC void ui_get_render_stats(ui_render_stats_t *stats);
+LIBUI_PUBLIC void ui_reset_render_stats(void);
+LIBUI_PUBLIC void ui_widget_destroy_layer(ui_widget_t *w);
+LIBUI_PUBLIC void ui_set_layer_cache_mode(ui_layer_cache_mode_t mode);
+LIBUI_PUBLIC void ui_set_layer_cache_max_memory(size_t max_memory);
+LIBUI_PUBLIC void ui_get_layer_cache_stats(ui_layer_cache_stats_t *stats);
+LIBUI_PUBLIC void ui_reset_layer_cache_stats(void);
+
+/**
+ * Create a snapshot of the widget tree for painting the rectangles on
+ * another thread. The snapshot does not refer to the widgets, so they can
+ * be updated while the frame is rendered. Widgets whose paint depends on
+ * their private data, such as text and images, are painted into the
+ * snapshot when it is created.
+ * @param rects rectangles that will be passed to ui_frame_render(), it
+ * relative to the root widget canvas
+ */
+LIBUI_PUBLIC ui_frame_t *ui_frame_create(ui_widget_t *root,
+                                         const pd_rect_t *rects,
+                                         unsigned length);
+LIBUI_PUBLIC void ui_frame_destroy(ui_frame_t *frame);
+LIBUI_PUBLIC size_t ui_frame_render(ui_frame_t *frame, pd_context_t *paint,
+                                    pd_canvas_pool_t *pool);
 
 // Updater
 
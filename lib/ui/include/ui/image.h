@@ -62,6 +62,22 @@ LIBUI_INLINE bool ui_image_valid(ui_image_t *image)
 }
 
 LIBUI_PUBLIC void ui_image_destroy(ui_image_t *image);
+
+/**
+ * 获取缩放到指定尺寸的图像，缩放结果会被缓存，再次获取时直接复用
+ * 注意：返回的图像是只读的，用完后需调用 ui_image_release_scaled() 释放
+ * @return 图像未加载完成或缓存容量不足时返回 NULL
+ */
+LIBUI_PUBLIC pd_canvas_t *ui_image_get_scaled(ui_image_t *image,
+                                              unsigned width, unsigned height);
+
+LIBUI_PUBLIC void ui_image_release_scaled(pd_canvas_t *scaled);
+
+/**
+ * 设置缩放图像缓存的最大内存占用
+ * @param max_memory 最大内存占用，为 0 时使用默认值
+ */
+LIBUI_PUBLIC void ui_set_scaled_image_cache_size(size_t max_memory);
 LIBUI_PUBLIC int ui_image_add_event_listener(ui_image_t *image,
                                              ui_image_event_type_t type,
                                              ui_image_event_handler_t handler,
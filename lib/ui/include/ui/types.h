@@ -145,6 +145,14 @@ typedef struct ui_widget_rules {
         /** Limit the number of children rendered  */
         unsigned max_render_children_count;
 
+        /**
+         * Keep the rendered pixels of the widget and its children in a
+         * retained layer. The layer is only repainted when the widget
+         * subtree has dirty rectangles, otherwise it is composited directly.
+         * We recommend enabling this rule for large, mostly static panels.
+         */
+        bool cache_layer;
+
         /** A callback function on update progress */
         void (*on_update_progress)(ui_widget_t *, size_t);
 } ui_widget_rules_t;
@@ -163,8 +171,89 @@ typedef struct ui_widget_rendering {
         ui_rect_t dirty_rect;
         ui_dirty_rect_type_t dirty_rect_type;
         bool has_child_dirty_rect;
+
+        /** Retained layer of the widget subtree, see rules.cache_layer */
+        pd_canvas_t *layer;
+
+        /** Area of the layer that needs to be repainted, it relative to
+         * widget canvas box */
+        ui_rect_t layer_dirty_rect;
+        ui_dirty_rect_type_t layer_dirty_rect_type;
+
+        /** Number of consecutive repaints of the layer */
+        unsigned layer_miss_count;
+
+        /** Number of paints since the widget subtree was last changed */
+        unsigned stable_count;
+
+        /**
+         * Distance the children have been scrolled since the widget was
+         * last rendered, see ui_widget_mark_scrolled()
+         */
+        float scroll_x, scroll_y;
+
+        /** Whether the widget has been moved by the scrolling of its parent */
+        bool scrolled;
 } ui_widget_rendering_t;
 
+typedef enum ui_layer_cache_mode_t {
+        /** Do not cache any layers */
+        UI_LAYER_CACHE_MODE_NONE,
+
+        /** Only cache layers of widgets with rules.cache_layer */
+        UI_LAYER_CACHE_MODE_EXPLICIT,
+
+        /**
+         * Also cache layers of widgets whose subtree is repainted many
+         * times without being changed
+         */
+        UI_LAYER_CACHE_MODE_AUTO
+} ui_layer_cache_mode_t;
+
+typedef struct ui_layer_cache_stats {
+        /** Number of paints served by compositing a retained layer */
+        size_t hits;
+
+        /** Number of paints that had to repaint a retained layer */
+        size_t misses;
+
+        /** Number of retained layers */
+        size_t layers;
+
+        /** Memory used by retained layers, in bytes */
+        size_t memory;
+} ui_layer_cache_stats_t;
+
+typedef struct ui_render_stats {
+        /** Number of widgets skipped because opaque siblings hide them */
+        size_t culled_count;
+
+        /**
+         * Number of translucent widgets rendered without layer canvases,
+         * their opacity is applied to the painted descendants directly
+         */
+        size_t folded_opacity_count;
+} ui_render_stats_t;
+
+/**
+ * Area of a scrolled widget whose pixels can be moved by the scroll distance
+ * instead of being repainted, see ui_widget_get_scroll_rects()
+ */
+typedef struct ui_scroll_rect {
+        /** Area of the widget, the part not covered by the moved pixels
+         * must be repainted */
+        pd_rect_t rect;
+
+        /** Area whose pixels are moved, it is inside the rect */
+        pd_rect_t blit_rect;
+
+        /** Scroll distance in actual pixels */
+        int dx, dy;
+} ui_scroll_rect_t;
+
+/** Immutable snapshot of a widget tree, see ui_frame_create() */
+typedef struct ui_frame ui_frame_t;
+
 typedef struct ui_profile {
         long time;
         size_t update_count;
@@ -352,6 +441,12 @@ struct ui_widget {
          */
         float layout_x, layout_y;
 
+        /**
+         * Scroll offset of the children, it is applied to their positions
+         * without updating their layout, see ui_widget_scroll_to()
+         */
+        float scroll_left, scroll_top;
+
         /**
          * A box’s “ideal” size in a given axis when given infinite available
          * space. See more: https://drafts.csswg.org/css-sizing-3/#max-content
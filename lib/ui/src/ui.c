@@ -12,6 +12,7 @@
 #include <pandagl.h>
 #include <ui/types.h>
 #include "ui/base.h"
+#include "ui/metrics.h"
 #include "ui_root.h"
 #include "ui_events.h"
 #include "ui_image.h"
@@ -19,13 +20,19 @@
 #include "ui_widget_prototype.h"
 #include "ui_css.h"
 #include "ui_updater.h"
+#include "ui_renderer.h"
 
 void ui_init(void)
 {
+	pd_blend_init();
 	pd_font_library_init();
+	pd_boxshadow_cache_init(0);
+	pd_border_cache_init(0);
+	pd_set_resample_threads(4);
 	ui_init_widget_id();
 	ui_init_widget_prototype();
 	ui_init_updater();
+	ui_init_renderer();
 	ui_init_root();
 	ui_init_events();
 	ui_init_css();
@@ -43,4 +50,8 @@ void ui_destroy(void)
 	ui_destroy_widget_prototype();
 	ui_destroy_css();
 	ui_destroy_updater();
+	ui_destroy_renderer();
+	pd_boxshadow_cache_destroy();
+	pd_border_cache_destroy();
+	pd_set_resample_threads(1);
 }
@@ -0,0 +1,244 @@
+﻿/*
+ * lib/ui/src/ui_frame.c
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <yutil.h>
+#include <pandagl.h>
+#include <ui/base.h>
+#include <ui/metrics.h>
+#include <ui/prototype.h>
+#include "ui_frame.h"
+#include "ui_renderer.h"
+
+typedef struct ui_frame_widget {
+        /* copy of the widget, it must be the first member */
+        ui_widget_t base;
+
+        /* copy of the widget extra data, only the rules are used */
+        ui_widget_extra_data_t extra;
+
+        /* self canvas painted by the widget when the frame was created */
+        pd_canvas_t canvas;
+
+        /* rectangle of the self canvas, it relative to widget canvas box */
+        pd_rect_t canvas_rect;
+} ui_frame_widget_t;
+
+struct ui_frame {
+        ui_frame_widget_t *root;
+
+        /* area to be rendered, it relative to root widget canvas */
+        pd_region_t region;
+};
+
+static void ui_frame_widget_on_paint(ui_widget_t *w, pd_context_t *paint,
+                                     ui_widget_actual_style_t *style)
+{
+        pd_rect_t rect, read_rect, write_rect;
+        pd_canvas_t src, dest;
+        ui_frame_widget_t *fw = (ui_frame_widget_t *)w;
+
+        if (!pd_rect_overlap(&fw->canvas_rect, &paint->rect, &rect)) {
+                return;
+        }
+        read_rect = rect;
+        read_rect.x -= fw->canvas_rect.x;
+        read_rect.y -= fw->canvas_rect.y;
+        write_rect = rect;
+        write_rect.x -= paint->rect.x;
+        write_rect.y -= paint->rect.y;
+        pd_canvas_quote(&src, &fw->canvas, &read_rect);
+        pd_canvas_quote(&dest, &paint->canvas, &write_rect);
+        pd_canvas_replace(&dest, &src, 0, 0);
+}
+
+static ui_widget_prototype_t ui_frame_widget_proto = {
+        .name = NULL,
+        .paint = ui_frame_widget_on_paint
+};
+
+bool ui_frame_widget_has_snapshot(ui_widget_t *w)
+{
+        return w->proto == &ui_frame_widget_proto;
+}
+
+/**
+ * Whether the paint of the widget depends on the data that is not in the
+ * computed style, so it can only be done on the thread that owns the widget
+ */
+static bool ui_widget_needs_snapshot(ui_widget_t *w)
+{
+        return w->computed_style.background_image ||
+               (w->proto &&
+                w->proto->paint != ui_get_widget_prototype(NULL)->paint);
+}
+
+static void ui_frame_widget_paint(ui_frame_t *frame, ui_frame_widget_t *fw,
+                                  ui_widget_t *w,
+                                  ui_widget_actual_style_t *style)
+{
+        pd_context_t paint;
+        pd_region_t region;
+
+        pd_region_init(&region);
+        pd_region_copy(&region, &frame->region);
+        pd_region_intersect_rect(&region, &style->canvas_box);
+        if (pd_region_is_empty(&region)) {
+                pd_region_destroy(&region);
+                return;
+        }
+        fw->canvas.color_type = PD_COLOR_TYPE_ARGB;
+        if (pd_canvas_create(&fw->canvas, region.extents.width,
+                             region.extents.height) == 0) {
+                fw->canvas_rect = region.extents;
+                fw->canvas_rect.x -= style->canvas_box.x;
+                fw->canvas_rect.y -= style->canvas_box.y;
+                paint.rect = fw->canvas_rect;
+                paint.with_alpha = true;
+                paint.canvas = fw->canvas;
+                ui_widget_paint(w, &paint, style);
+        }
+        pd_region_destroy(&region);
+}
+
+static ui_frame_widget_t *ui_frame_widget_create(ui_frame_t *frame,
+                                                 ui_widget_t *w,
+                                                 ui_frame_widget_t *parent,
+                                                 ui_widget_actual_style_t *style)
+{
+        ui_frame_widget_t *fw;
+
+        fw = malloc(sizeof(ui_frame_widget_t));
+        if (!fw) {
+                return NULL;
+        }
+        fw->base = *w;
+        fw->base.id = NULL;
+        fw->base.type = NULL;
+        fw->base.parent = parent ? &parent->base : NULL;
+        fw->base.data.length = 0;
+        fw->base.data.list = NULL;
+        fw->base.extra = NULL;
+        memset(&fw->base.rendering, 0, sizeof(ui_widget_rendering_t));
+        list_create(&fw->base.children);
+        list_create(&fw->base.stacking_context);
+        if (w->extra) {
+                fw->extra = *w->extra;
+                list_create(&fw->extra.listeners);
+                list_create(&fw->extra.observer_connections);
+                fw->base.extra = &fw->extra;
+        }
+        pd_canvas_init(&fw->canvas);
+        fw->canvas_rect.x = fw->canvas_rect.y = 0;
+        fw->canvas_rect.width = fw->canvas_rect.height = 0;
+        if (ui_widget_needs_snapshot(w)) {
+                fw->base.proto = &ui_frame_widget_proto;
+                fw->base.computed_style.background_image = NULL;
+                ui_frame_widget_paint(frame, fw, w, style);
+        }
+        return fw;
+}
+
+static void ui_frame_widget_destroy(ui_frame_widget_t *fw)
+{
+        list_node_t *node;
+
+        for (list_each(node, &fw->base.stacking_context)) {
+                ui_frame_widget_destroy(node->data);
+        }
+        list_destroy(&fw->base.stacking_context, NULL);
+        pd_canvas_destroy(&fw->canvas);
+        free(fw);
+}
+
+/**
+ * Copy the children that may be painted. The positions are computed in the
+ * same way as the renderer, so the snapshots are painted at the same place.
+ * @param x, y position of the widget renderer, it relative to root canvas
+ */
+static void ui_frame_add_children(ui_frame_t *frame, ui_frame_widget_t *fw,
+                                  ui_widget_t *w, float x, float y)
+{
+        float content_left = w->padding_box.x - w->canvas_box.x;
+        float content_top = w->padding_box.y - w->canvas_box.y;
+
+        pd_rect_t rect;
+        ui_widget_t *child;
+        list_node_t *node;
+        ui_frame_widget_t *child_fw;
+        ui_widget_actual_style_t style;
+
+        for (list_each(node, &w->stacking_context)) {
+                child = node->data;
+                if (!ui_widget_is_visible(child) ||
+                    child->state != UI_WIDGET_STATE_NORMAL) {
+                        continue;
+                }
+                style.x = x + content_left;
+                style.y = y + content_top;
+                ui_widget_compute_box(child, &style);
+                if (!pd_rect_overlap(&frame->region.extents,
+                                     &style.canvas_box, &rect)) {
+                        continue;
+                }
+                child_fw = ui_frame_widget_create(frame, child, fw, &style);
+                if (!child_fw) {
+                        continue;
+                }
+                list_append(&fw->base.stacking_context, child_fw);
+                ui_frame_add_children(frame, child_fw, child,
+                                      x + content_left + child->canvas_box.x,
+                                      y + content_top + child->canvas_box.y);
+        }
+}
+
+ui_frame_t *ui_frame_create(ui_widget_t *root, const pd_rect_t *rects,
+                            unsigned length)
+{
+        unsigned i;
+        ui_frame_t *frame;
+        ui_widget_actual_style_t style;
+
+        frame = malloc(sizeof(ui_frame_t));
+        if (!frame) {
+                return NULL;
+        }
+        pd_region_init(&frame->region);
+        for (i = 0; i < length; ++i) {
+                pd_region_union_rect(&frame->region, &rects[i]);
+        }
+        style.x = -1.f * ui_compute(root->canvas_box.x);
+        style.y = -1.f * ui_compute(root->canvas_box.y);
+        ui_widget_compute_box(root, &style);
+        frame->root = ui_frame_widget_create(frame, root, NULL, &style);
+        if (!frame->root) {
+                pd_region_destroy(&frame->region);
+                free(frame);
+                return NULL;
+        }
+        ui_frame_add_children(frame, frame->root, root, 0, 0);
+        return frame;
+}
+
+void ui_frame_destroy(ui_frame_t *frame)
+{
+        ui_frame_widget_destroy(frame->root);
+        pd_region_destroy(&frame->region);
+        free(frame);
+}
+
+size_t ui_frame_render(ui_frame_t *frame, pd_context_t *paint,
+                       pd_canvas_pool_t *pool)
+{
+        return ui_widget_render_without_layers(&frame->root->base, paint,
+                                               pool);
+}
@@ -0,0 +1,13 @@
+﻿/*
+ * lib/ui/src/ui_frame.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+/** Whether the widget is a snapshot whose self canvas was painted in advance */
+bool ui_frame_widget_has_snapshot(ui_widget_t *w);
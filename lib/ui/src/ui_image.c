@@ -53,6 +53,9 @@ typedef struct ui_image_loader {
         /** list_t<ui_image_source_t*> */
         list_t images;
 
+        /** Scaled copies of loaded images, such as backgrounds */
+        pd_image_cache_t *scaled_images;
+
         bool changed;
 } ui_image_loader_t;
 
@@ -60,6 +63,10 @@ static ui_image_loader_t ui_image_loader;
 
 static void ui_image_force_destroy(ui_image_source_t *src)
 {
+        if (ui_image_loader.scaled_images) {
+                pd_image_cache_remove(ui_image_loader.scaled_images,
+                                      &src->image.data);
+        }
         list_destroy_without_node(&src->listeners, free);
         pd_image_reader_destroy(src->reader);
         pd_canvas_destroy(&src->image.data);
@@ -137,6 +144,27 @@ ui_image_t *ui_image_create(const char *path)
         return &src->image;
 }
 
+pd_canvas_t *ui_image_get_scaled(ui_image_t *image, unsigned width,
+                                 unsigned height)
+{
+        if (!ui_image_valid(image) || !ui_image_loader.scaled_images) {
+                return NULL;
+        }
+        return pd_image_cache_get(ui_image_loader.scaled_images, &image->data,
+                                  width, height, PD_RESAMPLE_BILINEAR);
+}
+
+void ui_image_release_scaled(pd_canvas_t *scaled)
+{
+        pd_image_cache_release(ui_image_loader.scaled_images, scaled);
+}
+
+void ui_set_scaled_image_cache_size(size_t max_memory)
+{
+        pd_image_cache_set_max_memory(ui_image_loader.scaled_images,
+                                      max_memory);
+}
+
 void ui_image_destroy(ui_image_t *image)
 {
         assert(((ui_image_source_t *)image)->refs_count > 0);
@@ -321,6 +349,7 @@ void ui_init_image_loader(void)
         ui_image_loader.cache = dict_create(&ui_image_loader.dict_type, NULL);
         ui_image_loader.progress_tick_time = get_time_ms();
         list_create(&ui_image_loader.images);
+        ui_image_loader.scaled_images = pd_image_cache_create(0);
 }
 
 void ui_destroy_image_loader(void)
@@ -328,6 +357,8 @@ void ui_destroy_image_loader(void)
         list_destroy_without_node(
             &ui_image_loader.images,
             (list_item_destructor_t)ui_image_force_destroy);
+        pd_image_cache_destroy(ui_image_loader.scaled_images);
+        ui_image_loader.scaled_images = NULL;
         dict_destroy(ui_image_loader.cache);
         ui_image_loader.cache = NULL;
 }
@@ -9,9 +9,11 @@
  * LICENSE.TXT file in the root directory of this source tree.
  */
 
+#include <math.h>
 #include <stdio.h>
 #include <yutil.h>
 #include <pandagl.h>
+#include <thread.h>
 #include <css/style_value.h>
 #include <ui/base.h>
 #include <ui/metrics.h>
@@ -21,14 +23,43 @@
 #include "ui_widget_background.h"
 #include "ui_widget_box_shadow.h"
 #include "ui_widget_prototype.h"
+#include "ui_frame.h"
+#include "ui_renderer.h"
 
 // #define DEBUG_FRAME_RENDER
 #define MAX_VISIBLE_WIDTH 20000
 #define MAX_VISIBLE_HEIGHT 20000
 
+/* Number of unchanged repaints before a widget gets an automatic layer */
+#define LAYER_PROMOTE_STABLE_COUNT 3
+
+/* Number of consecutive repaints before an automatic layer is dropped */
+#define LAYER_DEMOTE_MISS_COUNT 3
+
+/* Minimum widget canvas area, in pixels, for an automatic layer */
+#define LAYER_MIN_AUTO_AREA (128 * 128)
+
+/* Maximum number of opaque siblings used for occlusion culling */
+#define MAX_OCCLUDERS 8
+
+/* Maximum number of descendants checked for opacity folding */
+#define MAX_OPACITY_FOLDING_NODES 16
+
 #ifdef DEBUG_FRAME_RENDER
 #endif
 
+/** Shared by the renderers of a ui_widget_render_with_pool() call */
+typedef struct ui_render_context {
+        /* pool of the temporary canvases */
+        pd_canvas_pool_t *pool;
+
+        /* whether the retained layers of the widgets can be used */
+        bool use_layers;
+
+        /* statistics, they are added to the global statistics at the end */
+        ui_render_stats_t stats;
+} ui_render_context_t;
+
 typedef struct ui_renderer {
         /* target widget position, it relative to root canvas */
         float x, y;
@@ -51,16 +82,24 @@ typedef struct ui_renderer {
         /* root paint context */
         pd_context_t *root_paint;
 
-        /* content canvas */
+        ui_render_context_t *context;
+
+        /* canvas of a rounded corner of the content area, the children
+         * in the corner are painted on it and then cropped */
         pd_canvas_t content_graph;
 
-        /* target widget canvas */
+        /* target widget canvas, it is not used if the widget is painted on
+         * the layer canvas */
         pd_canvas_t self_graph;
 
-        /* layer canvas, used to mix content and self canvas with widget
-         * opacity */
+        /* layer canvas, the widget and its children are painted on it and
+         * then it is mixed with the widget opacity */
         pd_canvas_t layer_graph;
 
+        /* opacity of the ancestors, it is applied to the painted content
+         * directly instead of using the layer canvas */
+        float opacity;
+
         /* actual paint rectangle in widget canvas rectangle, it relative to
          * root canvas */
         pd_rect_t actual_paint_rect;
@@ -74,12 +113,64 @@ typedef struct ui_renderer {
         ui_rect_t content_rect;
 
         bool has_content_graph;
-        bool has_self_graph;
+        bool has_round_border;
         bool has_layer_graph;
         bool can_render_self;
         bool can_render_content;
 } ui_renderer_t;
 
+/** An opaque child widget that hides the siblings below it */
+typedef struct ui_occluder {
+        /* node of the widget in the stacking context */
+        list_node_t *node;
+
+        /* opaque rectangle, it relative to root canvas */
+        pd_rect_t rect;
+} ui_occluder_t;
+
+static struct ui_layer_cache {
+        ui_layer_cache_mode_t mode;
+        size_t max_memory;
+        ui_layer_cache_stats_t stats;
+} ui_layer_cache = { UI_LAYER_CACHE_MODE_EXPLICIT, 64 * 1024 * 1024 };
+
+/* Default canvas pool, used by ui_widget_render() */
+static pd_canvas_pool_t *ui_canvas_pool;
+
+static struct ui_render_options {
+        bool occlusion_culling_enabled;
+        bool opacity_folding_enabled;
+} ui_render_options = { true, true };
+
+static ui_render_stats_t ui_render_stats;
+
+/*
+ * Widgets can be rendered by several threads at the same time. The retained
+ * layers are only changed by ui_widget_update_layers() before that, the
+ * render threads just read them. This mutex protects the layer cache and
+ * the global statistics.
+ */
+static thread_mutex_t ui_renderer_mutex;
+static bool ui_renderer_active;
+
+/*
+ * The layer cache statistics can still be read after the renderer has been
+ * destroyed, e.g. to check that all layers have been released.
+ */
+static void ui_layer_cache_lock(void)
+{
+        if (ui_renderer_active) {
+                thread_mutex_lock(&ui_renderer_mutex);
+        }
+}
+
+static void ui_layer_cache_unlock(void)
+{
+        if (ui_renderer_active) {
+                thread_mutex_unlock(&ui_renderer_mutex);
+        }
+}
+
 /** 判断部件是否有可绘制内容 */
 static bool ui_widget_is_paintable(ui_widget_t *w)
 {
@@ -104,8 +195,10 @@ static bool ui_widget_has_round_border(ui_widget_t *w)
 
 void ui_widget_expose_dirty_rect(ui_widget_t *w)
 {
+        w->rendering.stable_count = 0;
         while (w->parent) {
                 w->parent->rendering.has_child_dirty_rect = true;
+                w->parent->rendering.stable_count = 0;
                 w = w->parent;
         }
 }
@@ -161,13 +254,88 @@ bool ui_widget_mark_dirty_rect(ui_widget_t *w, ui_rect_t *in_rect,
         return true;
 }
 
-static void ui_widget_collect_dirty_rect(ui_widget_t *w, list_t *rects, float x,
-                                         float y, ui_rect_t visible_area)
+static void ui_widget_add_layer_dirty_rect(ui_widget_t *w, ui_rect_t *rect)
+{
+        ui_widget_rendering_t *r = &w->rendering;
+
+        ui_rect_correct(rect, w->canvas_box.width, w->canvas_box.height);
+        if (rect->width <= 0 || rect->height <= 0) {
+                return;
+        }
+        if (r->layer_dirty_rect_type == UI_DIRTY_RECT_TYPE_CUSTOM) {
+                ui_rect_merge(&r->layer_dirty_rect, &r->layer_dirty_rect, rect);
+        } else if (r->layer_dirty_rect_type == UI_DIRTY_RECT_TYPE_NONE) {
+                r->layer_dirty_rect = *rect;
+                r->layer_dirty_rect_type = UI_DIRTY_RECT_TYPE_CUSTOM;
+        }
+}
+
+/**
+ * Mark the area of the retained layers that were affected by the dirty
+ * rectangle of the widget
+ * @param rect dirty rectangle, it relative to the parent padding box
+ */
+static void ui_widget_invalidate_layers(ui_widget_t *w, const ui_rect_t *rect)
+{
+        ui_rect_t layer_rect;
+        ui_rect_t parent_rect = *rect;
+
+        for (; w; w = w->parent) {
+                if (w->rendering.layer) {
+                        layer_rect = parent_rect;
+                        layer_rect.x -= w->canvas_box.x;
+                        layer_rect.y -= w->canvas_box.y;
+                        ui_widget_add_layer_dirty_rect(w, &layer_rect);
+                }
+                if (w->parent) {
+                        parent_rect.x += w->parent->padding_box.x;
+                        parent_rect.y += w->parent->padding_box.y;
+                }
+        }
+}
+
+static void ui_widget_reset_scroll(ui_widget_t *w)
+{
+        ui_widget_t *child;
+        list_node_t *node;
+
+        w->rendering.scroll_x = 0;
+        w->rendering.scroll_y = 0;
+        for (list_each(node, &w->children)) {
+                child = node->data;
+                child->rendering.scrolled = false;
+        }
+}
+
+/** Repaint the scrolled area since its pixels are not moved */
+static void ui_widget_cancel_scroll(ui_widget_t *w)
+{
+        ui_rect_t rect = { 0, 0, w->padding_box.width, w->padding_box.height };
+
+        ui_widget_reset_scroll(w);
+        ui_widget_mark_dirty_rect(w, &rect, UI_BOX_TYPE_PADDING_BOX);
+}
+
+static void ui_widget_collect_dirty_rect(ui_widget_t *w, pd_region_t *region,
+                                         float x, float y,
+                                         ui_rect_t visible_area)
 {
         ui_rect_t rect;
-        pd_rect_t *actual_rect;
+        pd_rect_t actual_rect;
         list_node_t *node;
 
+        /* The scroll is not handled by ui_widget_get_scroll_rects() */
+        if (w->rendering.scroll_x != 0 || w->rendering.scroll_y != 0) {
+                ui_widget_cancel_scroll(w);
+        }
+        if (w->rendering.dirty_rect_type == UI_DIRTY_RECT_TYPE_FULL) {
+                ui_widget_invalidate_layers(w, &w->canvas_box);
+        } else if (w->rendering.dirty_rect_type == UI_DIRTY_RECT_TYPE_CUSTOM) {
+                rect = w->rendering.dirty_rect;
+                rect.x += w->canvas_box.x;
+                rect.y += w->canvas_box.y;
+                ui_widget_invalidate_layers(w, &rect);
+        }
         do {
                 if (w->parent && w->parent->rendering.dirty_rect_type ==
                                      UI_DIRTY_RECT_TYPE_FULL) {
@@ -188,9 +356,8 @@ static void ui_widget_collect_dirty_rect(ui_widget_t *w, list_t *rects, float x,
                 rect.y += y;
                 ui_rect_overlap(&rect, &visible_area, &rect);
                 if (rect.width > 0 && rect.height > 0) {
-                        actual_rect = malloc(sizeof(pd_rect_t));
-                        ui_compute_rect(actual_rect, &rect);
-                        list_append(rects, actual_rect);
+                        ui_compute_rect(&actual_rect, &rect);
+                        pd_region_union_rect(region, &actual_rect);
                 }
         } while (0);
         if (w->rendering.has_child_dirty_rect) {
@@ -201,7 +368,7 @@ static void ui_widget_collect_dirty_rect(ui_widget_t *w, list_t *rects, float x,
                 visible_area.y += y;
                 for (list_each(node, &w->stacking_context)) {
                         ui_widget_collect_dirty_rect(
-                            node->data, rects, x + w->padding_box.x,
+                            node->data, region, x + w->padding_box.x,
                             y + w->padding_box.y, visible_area);
                 }
         }
@@ -209,30 +376,245 @@ static void ui_widget_collect_dirty_rect(ui_widget_t *w, list_t *rects, float x,
         w->rendering.has_child_dirty_rect = false;
 }
 
+/**
+ * Collect dirty rectangles of the widget and its children into a region.
+ * Overlapping rectangles are merged, so each dirty pixel is included once.
+ * @param[out] region the region is cleared before collecting
+ * @returns number of rectangles in the region
+ */
+size_t ui_widget_get_dirty_region(ui_widget_t *w, pd_region_t *region)
+{
+        int x = ui_compute(w->padding_box.x);
+        int y = ui_compute(w->padding_box.y);
+
+        pd_region_clear(region);
+        ui_widget_collect_dirty_rect(w, region, 0, 0, w->padding_box);
+        pd_region_translate(region, -x, -y);
+        return region->length;
+}
+
 /**
  * @param rects list_t<pd_rect_t*>
  */
 size_t ui_widget_get_dirty_rects(ui_widget_t *w, list_t *rects)
 {
+        unsigned i;
         pd_rect_t *rect;
+        pd_region_t region;
+
+        pd_region_init(&region);
+        ui_widget_get_dirty_region(w, &region);
+        for (i = 0; i < region.length; ++i) {
+                rect = malloc(sizeof(pd_rect_t));
+                *rect = region.rects[i];
+                list_append(rects, rect);
+        }
+        pd_region_destroy(&region);
+        return rects->length;
+}
+
+void ui_widget_mark_scrolled(ui_widget_t *w, float dx, float dy)
+{
+        if (dx == 0 && dy == 0) {
+                return;
+        }
+        w->rendering.scroll_x += dx;
+        w->rendering.scroll_y += dy;
+        ui_widget_expose_dirty_rect(w);
+}
+
+/** Convert the distance to actual pixels if it is a whole number of pixels */
+static bool ui_compute_exact(float value, int *actual_value)
+{
+        float v = value * ui_get_actual_scale();
+
+        *actual_value = (int)(v < 0 ? v - 0.5f : v + 0.5f);
+        return fabsf(v - (float)*actual_value) < 0.001f;
+}
+
+/** Shrink the rectangle to its largest part not covered by the obstacle */
+static void ui_rect_exclude(ui_rect_t *rect, const ui_rect_t *obstacle)
+{
+        int i;
+        float area, max_area = 0;
+        ui_rect_t parts[4];
+
+        if (!ui_rect_is_cover(rect, obstacle)) {
+                return;
+        }
+        parts[0] = parts[1] = parts[2] = parts[3] = *rect;
+        parts[0].width = obstacle->x - rect->x;
+        parts[1].x = obstacle->x + obstacle->width;
+        parts[1].width = rect->x + rect->width - parts[1].x;
+        parts[2].height = obstacle->y - rect->y;
+        parts[3].y = obstacle->y + obstacle->height;
+        parts[3].height = rect->y + rect->height - parts[3].y;
+        rect->width = 0;
+        rect->height = 0;
+        for (i = 0; i < 4; ++i) {
+                if (parts[i].width <= 0 || parts[i].height <= 0) {
+                        continue;
+                }
+                area = parts[i].width * parts[i].height;
+                if (area > max_area) {
+                        max_area = area;
+                        *rect = parts[i];
+                }
+        }
+}
+
+/**
+ * Find the part of the scrolled area whose pixels can be moved. The pixels
+ * of the widgets that do not move with the content, such as scroll bars and
+ * the widgets above the scrolled widget, are not included.
+ * @param x, y position of the parent padding box, relative to the root
+ * @param[in,out] rect scrolled area, relative to the root
+ */
+static bool ui_widget_get_blit_rect(ui_widget_t *w, float x, float y,
+                                    ui_rect_t *rect)
+{
+        int actual_x, actual_y;
+        float child_x = x + w->padding_box.x;
+        float child_y = y + w->padding_box.y;
+        ui_widget_t *child, *parent;
+        ui_rect_t child_rect;
         list_node_t *node;
+        const css_computed_style_t *s = &w->computed_style;
 
+        /* The background must be the same in all pixels of the area */
+        if (w->rendering.dirty_rect_type != UI_DIRTY_RECT_TYPE_NONE ||
+            s->background_image || css_color_alpha(s->background_color) < 255 ||
+            ui_widget_has_round_border(w)) {
+                return false;
+        }
+        for (list_each(node, &w->children)) {
+                child = node->data;
+                if (!ui_widget_is_visible(child)) {
+                        continue;
+                }
+                child_rect = child->canvas_box;
+                child_rect.x += child_x;
+                child_rect.y += child_y;
+                if (!child->rendering.scrolled) {
+                        ui_rect_exclude(rect, &child_rect);
+                        continue;
+                }
+                /* The moved pixels must be aligned to the pixel grid */
+                if (!ui_compute_exact(child_rect.x, &actual_x) ||
+                    !ui_compute_exact(child_rect.y, &actual_y)) {
+                        return false;
+                }
+        }
+        for (; w->parent; w = parent) {
+                parent = w->parent;
+                if (w->computed_style.opacity < 1.f) {
+                        return false;
+                }
+                /* The widgets before it in the stacking context are above */
+                for (list_each(node, &parent->stacking_context)) {
+                        child = node->data;
+                        if (child == w) {
+                                break;
+                        }
+                        if (!ui_widget_is_visible(child) ||
+                            child->state != UI_WIDGET_STATE_NORMAL) {
+                                continue;
+                        }
+                        child_rect = child->canvas_box;
+                        child_rect.x += x;
+                        child_rect.y += y;
+                        ui_rect_exclude(rect, &child_rect);
+                }
+                x -= parent->padding_box.x;
+                y -= parent->padding_box.y;
+        }
+        return rect->width > 0 && rect->height > 0;
+}
+
+static void ui_widget_collect_scroll_rect(ui_widget_t *w, list_t *rects,
+                                          float x, float y,
+                                          ui_rect_t visible_area)
+{
+        int dx, dy;
+        ui_rect_t rect, blit_rect;
+        list_node_t *node;
+        ui_scroll_rect_t *scroll_rect;
+
+        if (w->rendering.scroll_x != 0 || w->rendering.scroll_y != 0) {
+                rect = w->padding_box;
+                rect.x += x;
+                rect.y += y;
+                ui_rect_overlap(&rect, &visible_area, &rect);
+                blit_rect = rect;
+                if (!ui_widget_is_visible(w) || rect.width <= 0 ||
+                    rect.height <= 0 ||
+                    !ui_compute_exact(w->rendering.scroll_x, &dx) ||
+                    !ui_compute_exact(w->rendering.scroll_y, &dy) ||
+                    !ui_widget_get_blit_rect(w, x, y, &blit_rect)) {
+                        ui_widget_cancel_scroll(w);
+                } else {
+                        scroll_rect = malloc(sizeof(ui_scroll_rect_t));
+                        ui_compute_rect(&scroll_rect->rect, &rect);
+                        ui_compute_rect(&scroll_rect->blit_rect, &blit_rect);
+                        scroll_rect->dx = dx;
+                        scroll_rect->dy = dy;
+                        list_append(rects, scroll_rect);
+                        /* The retained layers still have the old content */
+                        ui_widget_invalidate_layers(w, &w->padding_box);
+                        ui_widget_reset_scroll(w);
+                }
+        }
+        if (!w->rendering.has_child_dirty_rect) {
+                return;
+        }
+        visible_area.x -= x;
+        visible_area.y -= y;
+        ui_rect_overlap(&visible_area, &w->padding_box, &visible_area);
+        visible_area.x += x;
+        visible_area.y += y;
+        for (list_each(node, &w->stacking_context)) {
+                ui_widget_collect_scroll_rect(node->data, rects,
+                                              x + w->padding_box.x,
+                                              y + w->padding_box.y,
+                                              visible_area);
+        }
+}
+
+/**
+ * Collect the areas of the scrolled widgets whose pixels can be moved
+ * instead of being repainted. It should be called before
+ * ui_widget_get_dirty_region(), which repaints the scrolled areas that have
+ * not been collected.
+ * @param rects list_t<ui_scroll_rect_t*>, in the order they should be moved
+ * @returns number of rectangles
+ */
+size_t ui_widget_get_scroll_rects(ui_widget_t *w, list_t *rects)
+{
         int x = ui_compute(w->padding_box.x);
         int y = ui_compute(w->padding_box.y);
-        
-        ui_widget_collect_dirty_rect(w, rects, 0, 0, w->padding_box);
+        list_node_t *node;
+        ui_scroll_rect_t *scroll_rect;
+
+        ui_widget_collect_scroll_rect(w, rects, 0, 0, w->padding_box);
         for (list_each(node, rects)) {
-                rect = node->data;
-                rect->x -= x;
-                rect->y -= y;
+                scroll_rect = node->data;
+                scroll_rect->rect.x -= x;
+                scroll_rect->rect.y -= y;
+                scroll_rect->blit_rect.x -= x;
+                scroll_rect->blit_rect.y -= y;
         }
         return rects->length;
 }
 
 /** 当前部件的绘制函数 */
-static void ui_widget_on_paint(ui_widget_t *w, pd_context_t *paint,
-                               ui_widget_actual_style_t *style)
+void ui_widget_paint(ui_widget_t *w, pd_context_t *paint,
+                     ui_widget_actual_style_t *style)
 {
+        /* The snapshot already contains the background, border and shadow */
+        if (ui_frame_widget_has_snapshot(w)) {
+                w->proto->paint(w, paint, style);
+                return;
+        }
         ui_widget_paint_background(w, paint, style);
         ui_widget_paint_border(w, paint, style);
         ui_widget_paint_box_shadow(w, paint, style);
@@ -241,10 +623,51 @@ static void ui_widget_on_paint(ui_widget_t *w, pd_context_t *paint,
         }
 }
 
+/**
+ * Check whether the painted widgets of the subtree do not overlap each other.
+ * If so, the opacity of the subtree can be applied to each of them, which
+ * gives the same result as compositing the subtree on a layer canvas first.
+ */
+static bool ui_widget_can_fold_opacity(ui_widget_t *w, size_t *count)
+{
+        size_t i, n = 0;
+        list_node_t *node;
+        ui_widget_t *child;
+        ui_rect_t rects[MAX_OPACITY_FOLDING_NODES];
+
+        if (ui_widget_has_round_border(w)) {
+                return false;
+        }
+        for (list_each(node, &w->stacking_context)) {
+                child = node->data;
+                if (!ui_widget_is_visible(child) ||
+                    child->state != UI_WIDGET_STATE_NORMAL) {
+                        continue;
+                }
+                /* The child would be painted over the widget itself */
+                if (ui_widget_is_paintable(w) ||
+                    ++*count > MAX_OPACITY_FOLDING_NODES) {
+                        return false;
+                }
+                for (i = 0; i < n; ++i) {
+                        if (ui_rect_is_cover(&rects[i], &child->canvas_box)) {
+                                return false;
+                        }
+                }
+                rects[n++] = child->canvas_box;
+                if (!ui_widget_can_fold_opacity(child, count)) {
+                        return false;
+                }
+        }
+        return true;
+}
+
 static ui_renderer_t *ui_renderer_create(ui_widget_t *w, pd_context_t *paint,
                                          ui_widget_actual_style_t *style,
-                                         ui_renderer_t *parent)
+                                         ui_renderer_t *parent,
+                                         ui_render_context_t *context)
 {
+        size_t count = 0;
         ui_renderer_t *that = malloc(sizeof(ui_renderer_t));
 
         if (!that) {
@@ -253,33 +676,52 @@ static ui_renderer_t *ui_renderer_create(ui_widget_t *w, pd_context_t *paint,
         that->target = w;
         that->style = style;
         that->paint = paint;
-        that->has_self_graph = false;
         that->has_layer_graph = false;
         that->has_content_graph = false;
+        that->has_round_border = ui_widget_has_round_border(w);
         if (parent) {
+                that->context = parent->context;
                 that->root_paint = parent->root_paint;
                 that->x = parent->x + parent->content_left + w->canvas_box.x;
                 that->y = parent->y + parent->content_top + w->canvas_box.y;
+                that->opacity = parent->opacity;
         } else {
                 that->x = that->y = 0;
+                that->context = context;
                 that->root_paint = that->paint;
+                that->opacity = 1.f;
         }
         if (w->computed_style.opacity < 1.0) {
-                that->has_self_graph = true;
-                that->has_content_graph = true;
-                that->has_layer_graph = true;
-        } else if (ui_widget_has_round_border(w)) {
-                that->has_content_graph = true;
+                if (ui_render_options.opacity_folding_enabled &&
+                    ui_widget_can_fold_opacity(w, &count)) {
+                        that->opacity *= w->computed_style.opacity;
+                        that->context->stats.folded_opacity_count++;
+                } else {
+                        that->has_layer_graph = true;
+                }
         }
         pd_canvas_init(&that->self_graph);
         pd_canvas_init(&that->layer_graph);
         pd_canvas_init(&that->content_graph);
-        that->layer_graph.color_type = PD_COLOR_TYPE_ARGB;
         that->can_render_self = ui_widget_is_paintable(w);
-        if (that->can_render_self) {
+        /* The intermediate canvases keep premultiplied pixels, except that
+         * the widget paints itself in straight alpha, the layer canvas is
+         * converted after that. */
+        that->layer_graph.color_type = that->can_render_self
+                                           ? PD_COLOR_TYPE_ARGB
+                                           : PD_COLOR_TYPE_PARGB;
+        /* The widget and its children are painted on the layer canvas
+         * directly, so no other canvas of this size is needed */
+        if (that->has_layer_graph) {
+                pd_canvas_pool_alloc(that->context->pool, &that->layer_graph,
+                                     that->paint->rect.width,
+                                     that->paint->rect.height);
+                pd_canvas_fill(&that->layer_graph, pd_argb(0, 0, 0, 0));
+        } else if (that->can_render_self) {
                 that->self_graph.color_type = PD_COLOR_TYPE_ARGB;
-                pd_canvas_create(&that->self_graph, that->paint->rect.width,
-                                 that->paint->rect.height);
+                pd_canvas_pool_alloc(that->context->pool, &that->self_graph,
+                                     that->paint->rect.width,
+                                     that->paint->rect.height);
         }
         /* get content rectangle left spacing and top */
         that->content_left = w->padding_box.x - w->canvas_box.x;
@@ -320,51 +762,374 @@ static ui_renderer_t *ui_renderer_create(ui_widget_t *w, pd_context_t *paint,
             that->actual_content_rect.width, that->actual_content_rect.height,
             that->paint->canvas.quote.left, that->paint->canvas.quote.top,
             that->paint->canvas.width, that->paint->canvas.height);
-        if (!that->can_render_content) {
-                return that;
-        }
-        if (that->has_content_graph) {
-                that->content_graph.color_type = PD_COLOR_TYPE_ARGB;
-                pd_canvas_create(&that->content_graph,
-                                 that->actual_content_rect.width,
-                                 that->actual_content_rect.height);
-        }
         return that;
 }
 
 static void ui_renderer_destroy(ui_renderer_t *renderer)
 {
-        pd_canvas_destroy(&renderer->layer_graph);
-        pd_canvas_destroy(&renderer->self_graph);
-        pd_canvas_destroy(&renderer->content_graph);
+        pd_canvas_pool_free(renderer->context->pool, &renderer->layer_graph);
+        pd_canvas_pool_free(renderer->context->pool, &renderer->self_graph);
+        pd_canvas_pool_free(renderer->context->pool, &renderer->content_graph);
         free(renderer);
 }
 
-LIBUI_INLINE void ui_widget_compute_box(ui_widget_t *w,
-                                        ui_widget_actual_style_t *s)
+static size_t ui_renderer_render(ui_renderer_t *renderer);
+
+static void ui_compute_rect_outward(pd_rect_t *actual_rect,
+                                    const ui_rect_t *rect)
 {
-        s->content_box.x = ui_compute(s->x + w->content_box.x);
-        s->content_box.y = ui_compute(s->y + w->content_box.y);
-        s->content_box.width = ui_compute(w->content_box.width);
-        s->content_box.height = ui_compute(w->content_box.height);
+        float scale = ui_get_actual_scale();
 
-        s->padding_box.x = ui_compute(s->x + w->padding_box.x);
-        s->padding_box.y = ui_compute(s->y + w->padding_box.y);
-        s->padding_box.width = ui_compute(w->padding_box.width);
-        s->padding_box.height = ui_compute(w->padding_box.height);
+        actual_rect->x = (int)floorf(rect->x * scale);
+        actual_rect->y = (int)floorf(rect->y * scale);
+        actual_rect->width =
+            (int)ceilf((rect->x + rect->width) * scale) - actual_rect->x;
+        actual_rect->height =
+            (int)ceilf((rect->y + rect->height) * scale) - actual_rect->y;
+}
 
-        s->border_box.x = ui_compute(s->x + w->border_box.x);
-        s->border_box.y = ui_compute(s->y + w->border_box.y);
-        s->border_box.width = ui_compute(w->border_box.width);
-        s->border_box.height = ui_compute(w->border_box.height);
+void ui_widget_destroy_layer(ui_widget_t *w)
+{
+        ui_widget_rendering_t *r = &w->rendering;
 
-        s->canvas_box.x = ui_compute(s->x + w->canvas_box.x);
-        s->canvas_box.y = ui_compute(s->y + w->canvas_box.y);
-        s->canvas_box.width = ui_compute(w->canvas_box.width);
-        s->canvas_box.height = ui_compute(w->canvas_box.height);
+        if (!r->layer) {
+                return;
+        }
+        ui_layer_cache_lock();
+        ui_layer_cache.stats.layers--;
+        ui_layer_cache.stats.memory -= r->layer->mem_size;
+        ui_layer_cache_unlock();
+        pd_canvas_destroy(r->layer);
+        free(r->layer);
+        r->layer = NULL;
+        r->layer_dirty_rect_type = UI_DIRTY_RECT_TYPE_NONE;
+        r->layer_miss_count = 0;
 }
 
-static size_t ui_renderer_render(ui_renderer_t *renderer);
+static bool ui_widget_is_auto_layer(ui_widget_t *w)
+{
+        return !w->extra || !w->extra->rules.cache_layer;
+}
+
+static bool ui_widget_should_use_layer(ui_widget_t *w,
+                                       const ui_widget_actual_style_t *style)
+{
+        size_t size;
+
+        if (style->canvas_box.width < 1 || style->canvas_box.height < 1 ||
+            ui_layer_cache.mode == UI_LAYER_CACHE_MODE_NONE) {
+                ui_widget_destroy_layer(w);
+                return false;
+        }
+        if (!ui_widget_is_auto_layer(w)) {
+                return true;
+        }
+        if (ui_layer_cache.mode != UI_LAYER_CACHE_MODE_AUTO) {
+                ui_widget_destroy_layer(w);
+                return false;
+        }
+        if (w->rendering.layer) {
+                return true;
+        }
+        if (w->rendering.stable_count < LAYER_PROMOTE_STABLE_COUNT ||
+            w->stacking_context.length < 1) {
+                return false;
+        }
+        size = (size_t)style->canvas_box.width * style->canvas_box.height;
+        return size >= LAYER_MIN_AUTO_AREA &&
+               ui_layer_cache.stats.memory + size * 4 <=
+                   ui_layer_cache.max_memory;
+}
+
+/** Check whether the retained layer can be composited without changes */
+static bool ui_widget_has_valid_layer(ui_widget_t *w,
+                                      const ui_widget_actual_style_t *style)
+{
+        const pd_canvas_t *layer = w->rendering.layer;
+
+        return layer && ui_layer_cache.mode != UI_LAYER_CACHE_MODE_NONE &&
+               w->rendering.layer_dirty_rect_type == UI_DIRTY_RECT_TYPE_NONE &&
+               layer->width == (unsigned)style->canvas_box.width &&
+               layer->height == (unsigned)style->canvas_box.height;
+}
+
+static size_t ui_widget_update_child_layers(ui_widget_t *w,
+                                            ui_widget_actual_style_t *style,
+                                            const pd_rect_t *clip,
+                                            const pd_rect_t *rects,
+                                            size_t length,
+                                            ui_render_context_t *context);
+
+/** Repaint the dirty area of the retained layer */
+static size_t ui_widget_update_layer(ui_widget_t *w,
+                                     ui_render_context_t *context)
+{
+        size_t count;
+        pd_rect_t rect, clip;
+        pd_context_t paint;
+        ui_renderer_t *renderer;
+        ui_widget_actual_style_t style;
+        ui_widget_rendering_t *r = &w->rendering;
+
+        rect.x = 0;
+        rect.y = 0;
+        rect.width = r->layer->width;
+        rect.height = r->layer->height;
+        if (r->layer_dirty_rect_type == UI_DIRTY_RECT_TYPE_CUSTOM) {
+                ui_compute_rect_outward(&rect, &r->layer_dirty_rect);
+                pd_rect_correct(&rect, r->layer->width, r->layer->height);
+        }
+        r->layer_dirty_rect_type = UI_DIRTY_RECT_TYPE_NONE;
+        if (rect.width < 1 || rect.height < 1) {
+                return 0;
+        }
+        /* The layer uses the widget canvas box as its coordinate system */
+        style.x = -w->canvas_box.x;
+        style.y = -w->canvas_box.y;
+        ui_widget_compute_box(w, &style);
+        /* The nested layers are composited on this layer */
+        count = 0;
+        if (pd_rect_overlap(&rect, &style.padding_box, &clip)) {
+                count = ui_widget_update_child_layers(w, &style, &clip, &rect,
+                                                      1, context);
+        }
+        paint.rect = rect;
+        paint.with_alpha = true;
+        pd_canvas_quote(&paint.canvas, r->layer, &rect);
+        pd_canvas_fill(&paint.canvas, pd_argb(0, 0, 0, 0));
+        renderer = ui_renderer_create(w, &paint, &style, NULL, context);
+        count += ui_renderer_render(renderer);
+        ui_renderer_destroy(renderer);
+        return count;
+}
+
+/**
+ * Create or resize the retained layer and repaint its dirty area, so that
+ * the render threads can composite it
+ * @returns number of widgets painted on the layer
+ */
+static size_t ui_widget_validate_layer(ui_widget_t *w,
+                                       ui_widget_actual_style_t *style,
+                                       ui_render_context_t *context)
+{
+        ui_widget_rendering_t *r = &w->rendering;
+        unsigned width = style->canvas_box.width;
+        unsigned height = style->canvas_box.height;
+
+        if (!r->layer) {
+                r->layer = malloc(sizeof(pd_canvas_t));
+                if (!r->layer) {
+                        return 0;
+                }
+                pd_canvas_init(r->layer);
+                r->layer->color_type = PD_COLOR_TYPE_PARGB;
+                r->layer_miss_count = 0;
+                ui_layer_cache.stats.layers++;
+        }
+        if (r->layer->width != width || r->layer->height != height) {
+                ui_layer_cache.stats.memory -= r->layer->mem_size;
+                if (pd_canvas_create(r->layer, width, height) != 0) {
+                        ui_widget_destroy_layer(w);
+                        return 0;
+                }
+                ui_layer_cache.stats.memory += r->layer->mem_size;
+                r->layer_dirty_rect_type = UI_DIRTY_RECT_TYPE_FULL;
+        }
+        if (r->layer_dirty_rect_type == UI_DIRTY_RECT_TYPE_NONE) {
+                r->layer_miss_count = 0;
+                ui_layer_cache.stats.hits++;
+                return 0;
+        }
+        r->layer_miss_count++;
+        ui_layer_cache.stats.misses++;
+        /* Drop the automatic layer instead of repainting it once more */
+        if (ui_widget_is_auto_layer(w) &&
+            r->layer_miss_count >= LAYER_DEMOTE_MISS_COUNT) {
+                ui_widget_destroy_layer(w);
+                r->stable_count = 0;
+                return 0;
+        }
+        return ui_widget_update_layer(w, context);
+}
+
+/**
+ * Decide whether the children painted in the rectangles use retained
+ * layers, and update the layers they use
+ * @param clip visible area of the children, it relative to root canvas
+ * @returns number of widgets painted on the layers
+ */
+static size_t ui_widget_update_child_layers(ui_widget_t *w,
+                                            ui_widget_actual_style_t *style,
+                                            const pd_rect_t *clip,
+                                            const pd_rect_t *rects,
+                                            size_t length,
+                                            ui_render_context_t *context)
+{
+        size_t i, count = 0;
+        pd_rect_t rect, child_clip;
+        list_node_t *node;
+        ui_widget_t *child;
+        ui_widget_actual_style_t child_style;
+
+        for (list_each(node, &w->stacking_context)) {
+                child = node->data;
+                if (!ui_widget_is_visible(child) ||
+                    child->state != UI_WIDGET_STATE_NORMAL) {
+                        continue;
+                }
+                child_style.x = style->x + w->padding_box.x;
+                child_style.y = style->y + w->padding_box.y;
+                ui_widget_compute_box(child, &child_style);
+                if (!pd_rect_overlap(clip, &child_style.canvas_box, &rect)) {
+                        continue;
+                }
+                for (i = 0; i < length; ++i) {
+                        if (pd_rect_overlap(&rects[i], &rect, &child_clip)) {
+                                break;
+                        }
+                }
+                if (i >= length) {
+                        continue;
+                }
+                if (ui_widget_should_use_layer(child, &child_style)) {
+                        count += ui_widget_validate_layer(child, &child_style,
+                                                          context);
+                        continue;
+                }
+                child->rendering.stable_count++;
+                if (pd_rect_overlap(&rect, &child_style.padding_box,
+                                    &child_clip)) {
+                        count += ui_widget_update_child_layers(
+                            child, &child_style, &child_clip, rects, length,
+                            context);
+                }
+        }
+        return count;
+}
+
+/**
+ * Render the widget by compositing its retained layer. pd_canvas_mix() reads
+ * the opacity of the quoted source, so the folded opacity is applied to a
+ * copy of the layer, which leaves the shared layer untouched for the other
+ * workers compositing it.
+ */
+static size_t ui_renderer_render_layer(ui_widget_t *w, pd_context_t *paint,
+                                       float opacity)
+{
+        pd_canvas_t source, layer;
+
+        source = *w->rendering.layer;
+        source.opacity *= opacity;
+        pd_canvas_quote(&layer, &source, &paint->rect);
+        pd_canvas_mix(&paint->canvas, &layer, 0, 0, paint->with_alpha);
+        return 1;
+}
+
+/**
+ * Get the rectangle in which the widget paints fully opaque pixels. Only the
+ * background color is considered, because it is painted first and covers
+ * the whole background box.
+ */
+static bool ui_widget_get_opaque_rect(ui_widget_t *w,
+                                      ui_widget_actual_style_t *style,
+                                      pd_rect_t *rect)
+{
+        int radius;
+        css_computed_style_t *s = &w->computed_style;
+
+        if (s->opacity < 1.f || css_color_alpha(s->background_color) < 255) {
+                return false;
+        }
+        switch (s->type_bits.background_clip) {
+        case CSS_BACKGROUND_CLIP_PADDING_BOX:
+                *rect = style->padding_box;
+                break;
+        case CSS_BACKGROUND_CLIP_CONTENT_BOX:
+                *rect = style->content_box;
+                break;
+        default:
+                *rect = style->border_box;
+                break;
+        }
+        if (ui_widget_has_round_border(w)) {
+                /* Keep the larger one of the two rectangles that do not
+                 * intersect the rounded corners */
+                radius = ui_compute(y_max(
+                    y_max(s->border_top_left_radius, s->border_top_right_radius),
+                    y_max(s->border_bottom_left_radius,
+                          s->border_bottom_right_radius)));
+                radius += 1;
+                if (rect->width >= rect->height) {
+                        rect->x += radius;
+                        rect->width -= radius * 2;
+                } else {
+                        rect->y += radius;
+                        rect->height -= radius * 2;
+                }
+        }
+        return rect->width > 0 && rect->height > 0;
+}
+
+static bool ui_occluders_contains(ui_occluder_t *occluders, size_t length,
+                                  pd_rect_t *rect)
+{
+        size_t i;
+
+        for (i = 0; i < length; ++i) {
+                if (pd_rect_is_include(&occluders[i].rect, rect)) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+/**
+ * Walk the children from top to bottom and collect the opaque children that
+ * are not hidden by other opaque children. The result is sorted from top to
+ * bottom.
+ */
+static size_t ui_renderer_collect_occluders(ui_renderer_t *that,
+                                            ui_occluder_t *occluders)
+{
+        size_t length = 0;
+        ui_widget_t *child;
+        pd_rect_t rect;
+        ui_rect_t child_rect;
+        list_node_t *node;
+        ui_widget_actual_style_t style;
+
+        for (list_each(node, &that->target->stacking_context)) {
+                child = node->data;
+                if (length >= MAX_OCCLUDERS) {
+                        break;
+                }
+                if (!ui_widget_is_visible(child) ||
+                    child->state != UI_WIDGET_STATE_NORMAL) {
+                        continue;
+                }
+                style.x = that->x + that->content_left;
+                style.y = that->y + that->content_top;
+                child_rect.x = style.x + child->canvas_box.x;
+                child_rect.y = style.y + child->canvas_box.y;
+                child_rect.width = child->canvas_box.width;
+                child_rect.height = child->canvas_box.height;
+                if (!ui_rect_overlap(&that->content_rect, &child_rect,
+                                     &child_rect)) {
+                        continue;
+                }
+                ui_widget_compute_box(child, &style);
+                if (!ui_widget_get_opaque_rect(child, &style, &rect) ||
+                    !pd_rect_overlap(&that->actual_content_rect, &rect,
+                                     &rect) ||
+                    ui_occluders_contains(occluders, length, &rect)) {
+                        continue;
+                }
+                occluders[length].node = node;
+                occluders[length].rect = rect;
+                ++length;
+        }
+        return length;
+}
 
 static size_t ui_renderer_render_children(ui_renderer_t *that)
 {
@@ -376,10 +1141,25 @@ static size_t ui_renderer_render_children(ui_renderer_t *that)
         pd_context_t child_paint;
         ui_renderer_t *renderer;
         ui_widget_actual_style_t style;
+        ui_occluder_t occluders[MAX_OCCLUDERS];
+        size_t occluders_length = 0;
 
+        /* Skipping the top children would break the occlusion culling */
+        if (ui_render_options.occlusion_culling_enabled &&
+            that->target->stacking_context.length > 1 &&
+            !(that->target->extra &&
+              that->target->extra->rules.max_render_children_count)) {
+                occluders_length =
+                    ui_renderer_collect_occluders(that, occluders);
+        }
         /* Render the child widgets from bottom to top in stack order */
         for (list_each_reverse(node, &that->target->stacking_context)) {
                 child = node->data;
+                /* Only the occluders above the current child can hide it */
+                if (occluders_length > 0 &&
+                    occluders[occluders_length - 1].node == node) {
+                        --occluders_length;
+                }
                 if (!ui_widget_is_visible(child) ||
                     child->state != UI_WIDGET_STATE_NORMAL) {
                         continue;
@@ -420,6 +1200,11 @@ static size_t ui_renderer_render_children(ui_renderer_t *that)
                                      &style.canvas_box, &paint_rect)) {
                         continue;
                 }
+                if (ui_occluders_contains(occluders, occluders_length,
+                                          &paint_rect)) {
+                        that->context->stats.culled_count++;
+                        continue;
+                }
                 ++count;
                 child_paint.rect = paint_rect;
                 child_paint.rect.x -= style.canvas_box.x;
@@ -430,6 +1215,12 @@ static size_t ui_renderer_render_children(ui_renderer_t *that)
                         paint_rect.y -= that->actual_content_rect.y;
                         pd_canvas_quote(&child_paint.canvas,
                                         &that->content_graph, &paint_rect);
+                } else if (that->has_layer_graph) {
+                        child_paint.with_alpha = true;
+                        paint_rect.x -= that->actual_paint_rect.x;
+                        paint_rect.y -= that->actual_paint_rect.y;
+                        pd_canvas_quote(&child_paint.canvas,
+                                        &that->layer_graph, &paint_rect);
                 } else {
                         child_paint.with_alpha = that->paint->with_alpha;
                         paint_rect.x -= that->actual_paint_rect.x;
@@ -439,23 +1230,90 @@ static size_t ui_renderer_render_children(ui_renderer_t *that)
                 }
                 DEBUG_MSG("child paint rect: (%d, %d, %d, %d)\n", paint_rect.x,
                           paint_rect.y, paint_rect.width, paint_rect.height);
+                if (that->context->use_layers &&
+                    ui_widget_has_valid_layer(child, &style)) {
+                        total += ui_renderer_render_layer(child, &child_paint,
+                                                          that->opacity);
+                        continue;
+                }
                 renderer =
-                    ui_renderer_create(child, &child_paint, &style, that);
+                    ui_renderer_create(child, &child_paint, &style, that, NULL);
                 total += ui_renderer_render(renderer);
                 ui_renderer_destroy(renderer);
         }
         return total;
 }
 
+static void ui_renderer_set_content_rect(ui_renderer_t *that,
+                                         const pd_rect_t *rect)
+{
+        that->actual_content_rect = *rect;
+        ui_rect_from_pd_rect(&that->content_rect, &that->actual_content_rect,
+                             ui_get_actual_scale());
+}
+
+/**
+ * Render the children that are cropped by the rounded border. Only the
+ * corners need to be cropped, so the rest of the content area is painted
+ * directly and each corner is painted on a small canvas.
+ */
+static size_t ui_renderer_render_round_children(ui_renderer_t *that)
+{
+        size_t i, n, count = 0;
+        pd_rect_t rect;
+        pd_rect_t corners[4];
+        pd_rect_t content_rect = that->actual_content_rect;
+        pd_region_t region;
+        pd_context_t corner_paint;
+        pd_canvas_t *canvas = that->has_layer_graph ? &that->layer_graph
+                                                    : &that->paint->canvas;
+
+        n = ui_widget_get_content_corners(that->target, that->style, corners);
+        pd_region_init(&region);
+        pd_region_set_rect(&region, &content_rect);
+        for (i = 0; i < n; ++i) {
+                pd_region_subtract_rect(&region, &corners[i]);
+        }
+        for (i = 0; i < region.length; ++i) {
+                ui_renderer_set_content_rect(that, &region.rects[i]);
+                count += ui_renderer_render_children(that);
+        }
+        pd_region_destroy(&region);
+        that->has_content_graph = true;
+        for (i = 0; i < n; ++i) {
+                if (!pd_rect_overlap(&content_rect, &corners[i], &rect)) {
+                        continue;
+                }
+                that->content_graph.color_type = PD_COLOR_TYPE_PARGB;
+                if (pd_canvas_pool_alloc(that->context->pool,
+                                         &that->content_graph, rect.width,
+                                         rect.height) != 0) {
+                        continue;
+                }
+                ui_renderer_set_content_rect(that, &rect);
+                count += ui_renderer_render_children(that);
+                corner_paint.rect = rect;
+                corner_paint.rect.x -= that->style->canvas_box.x;
+                corner_paint.rect.y -= that->style->canvas_box.y;
+                corner_paint.canvas = that->content_graph;
+                ui_widget_crop_content(that->target, &corner_paint,
+                                       that->style);
+                pd_canvas_mix(canvas, &that->content_graph,
+                              rect.x - that->actual_paint_rect.x,
+                              rect.y - that->actual_paint_rect.y, true);
+                pd_canvas_pool_free(that->context->pool, &that->content_graph);
+        }
+        that->has_content_graph = false;
+        ui_renderer_set_content_rect(that, &content_rect);
+        return count;
+}
+
 static size_t ui_renderer_render(ui_renderer_t *renderer)
 {
         size_t count = 0;
         pd_context_t self_paint;
         ui_renderer_t *that = renderer;
 
-        int content_x = that->actual_content_rect.x - that->actual_paint_rect.x;
-        int content_y = that->actual_content_rect.y - that->actual_paint_rect.y;
-
 #ifdef DEBUG_FRAME_RENDER
         char filename[256];
         static size_t frame = 0;
@@ -467,8 +1325,12 @@ static size_t ui_renderer_render(ui_renderer_t *renderer)
                 count += 1;
                 self_paint = *that->paint;
                 self_paint.with_alpha = true;
-                self_paint.canvas = that->self_graph;
-                ui_widget_on_paint(that->target, &self_paint, that->style);
+                if (that->has_layer_graph) {
+                        self_paint.canvas = that->layer_graph;
+                } else {
+                        self_paint.canvas = that->self_graph;
+                }
+                ui_widget_paint(that->target, &self_paint, that->style);
 #ifdef DEBUG_FRAME_RENDER
                 sprintf(filename,
                         "frame-%zd-L%d-%s-self-paint-(%d,%d,%d,%d).png",
@@ -477,8 +1339,12 @@ static size_t ui_renderer_render(ui_renderer_t *renderer)
                         self_paint.rect.width, self_paint.rect.height);
                 pd_write_png_file(filename, &self_paint.canvas);
 #endif
+                if (that->has_layer_graph) {
+                        pd_canvas_premultiply(&that->layer_graph);
+                }
                 /* 若不需要缓存自身位图则直接绘制到画布上 */
-                if (!that->has_self_graph) {
+                if (!that->has_layer_graph) {
+                        that->self_graph.opacity = that->opacity;
                         pd_canvas_mix(&that->paint->canvas, &that->self_graph,
                                       0, 0, that->paint->with_alpha);
 #ifdef DEBUG_FRAME_RENDER
@@ -489,22 +1355,13 @@ static size_t ui_renderer_render(ui_renderer_t *renderer)
                 }
         }
         if (that->can_render_content) {
-                count += ui_renderer_render_children(that);
-        }
-        if (that->has_content_graph &&
-            ui_widget_has_round_border(that->target)) {
-                self_paint.rect = that->actual_content_rect;
-                self_paint.rect.x -= that->style->canvas_box.x;
-                self_paint.rect.y -= that->style->canvas_box.y;
-                self_paint.canvas = that->content_graph;
-                ui_widget_crop_content(that->target, &self_paint, that->style);
+                if (that->has_round_border) {
+                        count += ui_renderer_render_round_children(that);
+                } else {
+                        count += ui_renderer_render_children(that);
+                }
         }
         if (!that->has_layer_graph) {
-                if (that->has_content_graph) {
-                        pd_canvas_mix(&that->paint->canvas,
-                                      &that->content_graph, content_x,
-                                      content_y, true);
-                }
 #ifdef DEBUG_FRAME_RENDER
                 sprintf(filename, "frame-%zd-L%d-%s-canvas.png", frame++,
                         __LINE__, renderer->target->id);
@@ -517,29 +1374,10 @@ static size_t ui_renderer_render(ui_renderer_t *renderer)
                           that->target->index, that->target->type, count);
                 return count;
         }
-        /* 若需要绘制的是当前部件图层，则先混合部件自身位图和内容位图，得出当
-         * 前部件的图层，然后将该图层混合到输出的位图中
-         */
-        if (that->can_render_self) {
-                pd_canvas_copy(&that->layer_graph, &that->self_graph);
-                pd_canvas_mix(&that->layer_graph, &that->content_graph,
-                              content_x, content_y, true);
-#ifdef DEBUG_FRAME_RENDER
-                sprintf(filename, "frame-%zd-L%d-%s-content-graph-%d-%d.png",
-                        frame++, __LINE__, renderer->target->id, content_x,
-                        content_y);
-                pd_write_png_file(filename, &that->content_graph);
-                sprintf(filename, "frame-%zd-L%d-%s-self-graph.png", frame++,
-                        __LINE__, renderer->target->id);
-                pd_write_png_file(filename, &that->layer_graph);
-#endif
-        } else {
-                pd_canvas_create(&that->layer_graph, that->paint->rect.width,
-                                 that->paint->rect.height);
-                pd_canvas_replace(&that->layer_graph, &that->content_graph,
-                                  content_x, content_y);
-        }
-        that->layer_graph.opacity = that->target->computed_style.opacity;
+        /* 部件自身和子部件都已绘制在图层上，按部件的不透明度将图层混合到输
+         * 出的位图中 */
+        that->layer_graph.opacity =
+            that->opacity * that->target->computed_style.opacity;
         pd_canvas_mix(&that->paint->canvas, &that->layer_graph, 0, 0,
                       that->paint->with_alpha);
 #ifdef DEBUG_FRAME_RENDER
@@ -555,7 +1393,8 @@ static size_t ui_renderer_render(ui_renderer_t *renderer)
         return count;
 }
 
-size_t ui_widget_render(ui_widget_t *w, pd_context_t *paint)
+static size_t ui_widget_render_in_context(ui_widget_t *w, pd_context_t *paint,
+                                          ui_render_context_t *context)
 {
         size_t count;
         ui_renderer_t *ctx;
@@ -565,12 +1404,150 @@ size_t ui_widget_render(ui_widget_t *w, pd_context_t *paint)
         style.x = -1.f * ui_compute(w->canvas_box.x);
         style.y = -1.f * ui_compute(w->canvas_box.y);
         ui_widget_compute_box(w, &style);
-        ctx = ui_renderer_create(w, paint, &style, NULL);
+        ctx = ui_renderer_create(w, paint, &style, NULL, context);
         DEBUG_MSG("[%d] %s: start render\n", ctx->target->index,
                   ctx->target->type);
         count = ui_renderer_render(ctx);
         DEBUG_MSG("[%d] %s: end render, count: %lu\n", ctx->target->index,
                   ctx->target->type, count);
         ui_renderer_destroy(ctx);
+        thread_mutex_lock(&ui_renderer_mutex);
+        ui_render_stats.culled_count += context->stats.culled_count;
+        ui_render_stats.folded_opacity_count +=
+            context->stats.folded_opacity_count;
+        thread_mutex_unlock(&ui_renderer_mutex);
+        return count;
+}
+
+/**
+ * Decide which widgets painted in the rectangles use retained layers and
+ * repaint the dirty area of these layers. ui_widget_render_with_pool() only
+ * composites the layers that are up to date, so this should be called on
+ * one thread before the rectangles are rendered by several threads.
+ * @param rects rectangles to be rendered, they relative to the widget canvas
+ * @returns number of widgets painted on the layers
+ */
+size_t ui_widget_update_layers(ui_widget_t *w, const pd_rect_t *rects,
+                               size_t length, pd_canvas_pool_t *pool)
+{
+        size_t count;
+        ui_render_context_t context = { 0 };
+        ui_widget_actual_style_t style;
+
+        context.pool = pool;
+        context.use_layers = true;
+        style.x = -1.f * ui_compute(w->canvas_box.x);
+        style.y = -1.f * ui_compute(w->canvas_box.y);
+        ui_widget_compute_box(w, &style);
+        thread_mutex_lock(&ui_renderer_mutex);
+        if (ui_layer_cache.mode == UI_LAYER_CACHE_MODE_NONE &&
+            ui_layer_cache.stats.layers < 1) {
+                thread_mutex_unlock(&ui_renderer_mutex);
+                return 0;
+        }
+        count = ui_widget_update_child_layers(w, &style, &style.padding_box,
+                                              rects, length, &context);
+        ui_render_stats.culled_count += context.stats.culled_count;
+        ui_render_stats.folded_opacity_count +=
+            context.stats.folded_opacity_count;
+        thread_mutex_unlock(&ui_renderer_mutex);
         return count;
 }
+
+size_t ui_widget_render_with_pool(ui_widget_t *w, pd_context_t *paint,
+                                  pd_canvas_pool_t *pool)
+{
+        ui_render_context_t context = { 0 };
+
+        context.pool = pool;
+        context.use_layers = true;
+        return ui_widget_render_in_context(w, paint, &context);
+}
+
+size_t ui_widget_render_without_layers(ui_widget_t *w, pd_context_t *paint,
+                                       pd_canvas_pool_t *pool)
+{
+        ui_render_context_t context = { 0 };
+
+        context.pool = pool;
+        context.use_layers = false;
+        return ui_widget_render_in_context(w, paint, &context);
+}
+
+size_t ui_widget_render(ui_widget_t *w, pd_context_t *paint)
+{
+        size_t count;
+
+        count = ui_widget_update_layers(w, &paint->rect, 1, ui_canvas_pool);
+        return count + ui_widget_render_with_pool(w, paint, ui_canvas_pool);
+}
+
+void ui_get_canvas_pool_stats(pd_canvas_pool_stats_t *stats)
+{
+        pd_canvas_pool_get_stats(ui_canvas_pool, stats);
+}
+
+void ui_set_occlusion_culling_enabled(bool enabled)
+{
+        ui_render_options.occlusion_culling_enabled = enabled;
+}
+
+void ui_set_opacity_folding_enabled(bool enabled)
+{
+        ui_render_options.opacity_folding_enabled = enabled;
+}
+
+void ui_get_render_stats(ui_render_stats_t *stats)
+{
+        thread_mutex_lock(&ui_renderer_mutex);
+        *stats = ui_render_stats;
+        thread_mutex_unlock(&ui_renderer_mutex);
+}
+
+void ui_reset_render_stats(void)
+{
+        thread_mutex_lock(&ui_renderer_mutex);
+        ui_render_stats.culled_count = 0;
+        ui_render_stats.folded_opacity_count = 0;
+        thread_mutex_unlock(&ui_renderer_mutex);
+}
+
+void ui_set_layer_cache_mode(ui_layer_cache_mode_t mode)
+{
+        ui_layer_cache.mode = mode;
+}
+
+void ui_set_layer_cache_max_memory(size_t max_memory)
+{
+        ui_layer_cache.max_memory = max_memory;
+}
+
+void ui_get_layer_cache_stats(ui_layer_cache_stats_t *stats)
+{
+        ui_layer_cache_lock();
+        *stats = ui_layer_cache.stats;
+        ui_layer_cache_unlock();
+}
+
+void ui_reset_layer_cache_stats(void)
+{
+        ui_layer_cache_lock();
+        ui_layer_cache.stats.hits = 0;
+        ui_layer_cache.stats.misses = 0;
+        ui_layer_cache_unlock();
+}
+
+void ui_init_renderer(void)
+{
+        ui_canvas_pool = pd_canvas_pool_create(0);
+        thread_mutex_init(&ui_renderer_mutex);
+        ui_renderer_active = true;
+}
+
+void ui_destroy_renderer(void)
+{
+        pd_canvas_pool_destroy(ui_canvas_pool);
+        ui_canvas_pool = NULL;
+        ui_renderer_active = false;
+        thread_mutex_destroy(&ui_renderer_mutex);
+}
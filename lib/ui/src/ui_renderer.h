@@ -0,0 +1,47 @@
+﻿/*
+ * lib/ui/src/ui_renderer.h
+ *
+ * Copyright (c) 2023-2025, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+LIBUI_INLINE void ui_widget_compute_box(ui_widget_t *w,
+                                        ui_widget_actual_style_t *s)
+{
+        s->content_box.x = ui_compute(s->x + w->content_box.x);
+        s->content_box.y = ui_compute(s->y + w->content_box.y);
+        s->content_box.width = ui_compute(w->content_box.width);
+        s->content_box.height = ui_compute(w->content_box.height);
+
+        s->padding_box.x = ui_compute(s->x + w->padding_box.x);
+        s->padding_box.y = ui_compute(s->y + w->padding_box.y);
+        s->padding_box.width = ui_compute(w->padding_box.width);
+        s->padding_box.height = ui_compute(w->padding_box.height);
+
+        s->border_box.x = ui_compute(s->x + w->border_box.x);
+        s->border_box.y = ui_compute(s->y + w->border_box.y);
+        s->border_box.width = ui_compute(w->border_box.width);
+        s->border_box.height = ui_compute(w->border_box.height);
+
+        s->canvas_box.x = ui_compute(s->x + w->canvas_box.x);
+        s->canvas_box.y = ui_compute(s->y + w->canvas_box.y);
+        s->canvas_box.width = ui_compute(w->canvas_box.width);
+        s->canvas_box.height = ui_compute(w->canvas_box.height);
+}
+
+void ui_widget_paint(ui_widget_t *w, pd_context_t *paint,
+                     ui_widget_actual_style_t *style);
+
+/**
+ * Render the widget without reading or updating the retained layers. It is
+ * used for the widget snapshots of a frame, which are not retained.
+ */
+size_t ui_widget_render_without_layers(ui_widget_t *w, pd_context_t *paint,
+                                       pd_canvas_pool_t *pool);
+
+void ui_init_renderer(void);
+void ui_destroy_renderer(void);
@@ -10,6 +10,7 @@
  */
 
 // #define UI_DEBUG_ENABLED
+#include <math.h>
 #include <string.h>
 #include <time.h>
 #include <css.h>
@@ -451,6 +452,25 @@ size_t ui_updater_update_widget(ui_updater_t *updater, ui_widget_t *w)
         return count;
 }
 
+/**
+ * Whether the widget is only moved by the scrolling of its parent, its
+ * pixels can be moved instead of being repainted.
+ */
+static bool ui_widget_is_scrolled(ui_widget_t *w)
+{
+        ui_widget_rendering_t *r = &w->parent->rendering;
+
+        return (r->scroll_x != 0 || r->scroll_y != 0) &&
+               w->canvas_box.width == w->update.canvas_box_backup.width &&
+               w->canvas_box.height == w->update.canvas_box_backup.height &&
+               w->border_box.width == w->update.border_box_backup.width &&
+               w->border_box.height == w->update.border_box_backup.height &&
+               fabsf(w->canvas_box.x - w->update.canvas_box_backup.x -
+                     r->scroll_x) < 0.001f &&
+               fabsf(w->canvas_box.y - w->update.canvas_box_backup.y -
+                     r->scroll_y) < 0.001f;
+}
+
 static void ui_process_mutations(ui_widget_t *w)
 {
         ui_mutation_record_t *record;
@@ -463,11 +483,16 @@ static void ui_process_mutations(ui_widget_t *w)
                                        &w->update.border_box_backup) ||
                      !ui_rect_is_equal(&w->canvas_box,
                                        &w->update.canvas_box_backup))) {
-                        w->rendering.dirty_rect_type = UI_DIRTY_RECT_TYPE_FULL;
-                        ui_widget_expose_dirty_rect(w);
-                        ui_widget_mark_dirty_rect(w->parent,
-                                                  &w->update.canvas_box_backup,
-                                                  UI_BOX_TYPE_PADDING_BOX);
+                        if (ui_widget_is_scrolled(w)) {
+                                w->rendering.scrolled = true;
+                        } else {
+                                w->rendering.dirty_rect_type =
+                                    UI_DIRTY_RECT_TYPE_FULL;
+                                ui_widget_expose_dirty_rect(w);
+                                ui_widget_mark_dirty_rect(
+                                    w->parent, &w->update.canvas_box_backup,
+                                    UI_BOX_TYPE_PADDING_BOX);
+                        }
                 }
         } else if (w->rendering.dirty_rect_type != UI_DIRTY_RECT_TYPE_FULL &&
                    (!ui_rect_is_equal(&w->border_box,
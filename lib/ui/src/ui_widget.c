@@ -61,6 +61,7 @@ void ui_widget_destroy(ui_widget_t *w)
         ui_widget_destroy_attrs(w);
         ui_widget_destroy_classes(w);
         ui_widget_destroy_status(w);
+        ui_widget_destroy_layer(w);
         free(w->extra);
         free(w);
 }
@@ -277,12 +278,25 @@ static void ui_widget_update_canvas_box_y(ui_widget_t *w)
             w->border_box.y - y_max(0, SHADOW_WIDTH(s) - s->box_shadow_y);
 }
 
+/** Check whether the widget moves with the scrolling of its parent */
+static bool ui_widget_is_scrollable(ui_widget_t *w)
+{
+        unsigned position = w->computed_style.type_bits.position;
+
+        return w->parent && position != CSS_POSITION_ABSOLUTE &&
+               position != CSS_POSITION_FIXED;
+}
+
 void ui_widget_update_box_position(ui_widget_t *w)
 {
         float x = w->layout_x;
         float y = w->layout_y;
         const css_computed_style_t *s = &w->computed_style;
 
+        if (ui_widget_is_scrollable(w)) {
+                x -= w->parent->scroll_left;
+                y -= w->parent->scroll_top;
+        }
         switch (s->type_bits.position) {
         case CSS_POSITION_ABSOLUTE:
         case CSS_POSITION_FIXED:
@@ -337,6 +351,52 @@ void ui_widget_update_box_position(ui_widget_t *w)
         ui_widget_update_canvas_box_y(w);
 }
 
+static void ui_rect_translate(ui_rect_t *rect, float dx, float dy)
+{
+        rect->x += dx;
+        rect->y += dy;
+}
+
+/** Move the widget without updating its layout */
+static void ui_widget_translate(ui_widget_t *w, float dx, float dy)
+{
+        ui_rect_translate(&w->outer_box, dx, dy);
+        ui_rect_translate(&w->border_box, dx, dy);
+        ui_rect_translate(&w->padding_box, dx, dy);
+        ui_rect_translate(&w->content_box, dx, dy);
+        ui_rect_translate(&w->canvas_box, dx, dy);
+        /* The updater should not take it as a change of the layout */
+        ui_rect_translate(&w->update.border_box_backup, dx, dy);
+        ui_rect_translate(&w->update.canvas_box_backup, dx, dy);
+}
+
+/**
+ * Scroll the children of the widget. Only the positions of the children are
+ * changed, their styles and layouts are not updated, and the renderer moves
+ * their pixels instead of repainting them if possible.
+ */
+void ui_widget_scroll_to(ui_widget_t *w, float left, float top)
+{
+        list_node_t *node;
+        ui_widget_t *child;
+        float dx = w->scroll_left - left;
+        float dy = w->scroll_top - top;
+
+        if (dx == 0 && dy == 0) {
+                return;
+        }
+        w->scroll_left = left;
+        w->scroll_top = top;
+        for (list_each(node, &w->children)) {
+                child = node->data;
+                if (ui_widget_is_scrollable(child)) {
+                        ui_widget_translate(child, dx, dy);
+                        child->rendering.scrolled = true;
+                }
+        }
+        ui_widget_mark_scrolled(w, dx, dy);
+}
+
 void ui_widget_update_box_width(ui_widget_t *w)
 {
         css_computed_style_t *s = &w->computed_style;
@@ -21,6 +21,8 @@ void ui_widget_paint_background(ui_widget_t *w, pd_context_t *ctx,
 {
         pd_rect_t box;
         pd_background_t bg;
+        pd_canvas_t *scaled = NULL;
+        ui_image_t *image = NULL;
         css_computed_style_t *s = &w->computed_style;
 
         if (!s->background_image && css_color_alpha(s->background_color) < 1) {
@@ -28,14 +30,22 @@ void ui_widget_paint_background(ui_widget_t *w, pd_context_t *ctx,
         }
         bg.color.value = s->background_color;
         if (s->background_image) {
-                bg.image = (pd_canvas_t *)ui_get_image(s->background_image);
-        } else {
-                bg.image = NULL;
+                image = ui_get_image(s->background_image);
         }
+        bg.image = image ? &image->data : NULL;
         bg.x = ui_compute(s->background_position_x);
         bg.y = ui_compute(s->background_position_y);
         bg.width = ui_compute(s->background_width);
         bg.height = ui_compute(s->background_height);
+        /* 使用缓存的缩放图像，避免每次绘制时都重新缩放 */
+        if (image && bg.width > 0 && bg.height > 0 &&
+            ((unsigned)bg.width != image->data.width ||
+             (unsigned)bg.height != image->data.height)) {
+                scaled = ui_image_get_scaled(image, bg.width, bg.height);
+                if (scaled) {
+                        bg.image = scaled;
+                }
+        }
         bg.repeat_x =
             s->type_bits.background_repeat == CSS_BACKGROUND_REPEAT_REPEAT ||
             s->type_bits.background_repeat == CSS_BACKGROUND_REPEAT_REPEAT_X;
@@ -64,4 +74,7 @@ void ui_widget_paint_background(ui_widget_t *w, pd_context_t *ctx,
                 break;
         }
         pd_paint_background(ctx, &bg, &box);
+        if (scaled) {
+                ui_image_release_scaled(scaled);
+        }
 }
@@ -66,3 +66,38 @@ void ui_widget_crop_content(ui_widget_t* w, pd_context_t* ctx,
 	ui_widget_compute_border(w, &border);
 	pd_crop_border_content(ctx, &border, &box);
 }
+
+size_t ui_widget_get_content_corners(ui_widget_t* w,
+				     ui_widget_actual_style_t* style,
+				     pd_rect_t* rects)
+{
+	size_t i, n = 0;
+	pd_rect_t box = style->border_box;
+	pd_border_t b;
+	pd_rect_t corners[4];
+
+	ui_widget_compute_border(w, &b);
+	/* Same as the areas cropped by pd_crop_border_content() */
+	corners[0].x = box.x + b.left.width;
+	corners[0].y = box.y + b.top.width;
+	corners[0].width = b.top_left_radius - b.left.width;
+	corners[0].height = b.top_left_radius - b.top.width;
+	corners[1].x = box.x + box.width - b.top_right_radius;
+	corners[1].y = box.y + b.top.width;
+	corners[1].width = b.top_right_radius - b.right.width;
+	corners[1].height = b.top_right_radius - b.top.width;
+	corners[2].x = box.x + b.left.width;
+	corners[2].y = box.y + box.height - b.bottom_left_radius;
+	corners[2].width = b.bottom_left_radius - b.left.width;
+	corners[2].height = b.bottom_left_radius - b.bottom.width;
+	corners[3].x = box.x + box.width - b.bottom_right_radius;
+	corners[3].y = box.y + box.height - b.bottom_right_radius;
+	corners[3].width = b.bottom_right_radius - b.right.width;
+	corners[3].height = b.bottom_right_radius - b.bottom.width;
+	for (i = 0; i < 4; ++i) {
+		if (corners[i].width > 0 && corners[i].height > 0) {
+			rects[n++] = corners[i];
+		}
+	}
+	return n;
+}
@@ -13,3 +13,13 @@ void ui_widget_paint_border(ui_widget_t *w, pd_context_t *paint,
 			    ui_widget_actual_style_t *style);
 void ui_widget_crop_content(ui_widget_t *w, pd_context_t *paint,
 			    ui_widget_actual_style_t *style);
+
+/**
+ * Get the areas of the content that are cropped by the rounded corners, they
+ * relative to the same canvas as the style
+ * @param rects an array of 4 rectangles
+ * @returns the number of the areas
+ */
+size_t ui_widget_get_content_corners(ui_widget_t *w,
+				     ui_widget_actual_style_t *style,
+				     pd_rect_t *rects);
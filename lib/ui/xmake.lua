@@ -4,7 +4,7 @@ set_version("0.1.0-a")
 target("libui")
     set_kind("$(kind)")
     add_files("src/**.c")
-    add_deps("yutil", "pandagl", "libcss")
+    add_deps("yutil", "pandagl", "libcss", "libthread")
     set_configdir("include/ui")
     add_configfiles("src/config.h.in")
     add_headerfiles("include/ui.h", "include/(ui/*.h)")
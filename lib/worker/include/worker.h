@@ -12,6 +12,8 @@
 #ifndef LIB_WORKER_INCLULDE_WORKER_H
 #define LIB_WORKER_INCLULDE_WORKER_H
 
+#include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include "worker/common.h"
 
@@ -20,6 +22,27 @@ LIBWORKER_BEGIN_DECLS
 typedef void (*worker_task_cb)(void *);
 typedef struct worker worker_t;
 typedef struct worker_task worker_task_t;
+typedef struct worker_pool worker_pool_t;
+
+/**
+ * @param data user data passed to worker_pool_run()
+ * @param index index of the job
+ * @param worker_id id of the worker that runs the job, the thread calling
+ * worker_pool_run() is the worker 0
+ */
+typedef void (*worker_pool_job_cb)(void *data, unsigned index,
+                                   unsigned worker_id);
+
+typedef struct worker_pool_stats {
+        /** Number of jobs done by the worker */
+        size_t jobs;
+
+        /** Number of jobs stolen from other workers */
+        size_t steals;
+
+        /** Time spent on running jobs, in microseconds */
+        int64_t busy_time;
+} worker_pool_stats_t;
 
 LIBWORKER_PUBLIC worker_t *worker_create(void);
 
@@ -35,6 +58,38 @@ LIBWORKER_PUBLIC int worker_run_async(worker_t *worker);
 
 LIBWORKER_PUBLIC void worker_destroy(worker_t *worker);
 
+/**
+ * Create a pool of workers for parallel jobs. It runs num_workers - 1
+ * threads, and the thread calling worker_pool_run() works as well.
+ * The threads that fail to start are left out, worker_pool_get_size()
+ * returns the number of workers actually used.
+ */
+LIBWORKER_PUBLIC worker_pool_t *worker_pool_create(unsigned num_workers);
+
+LIBWORKER_PUBLIC void worker_pool_destroy(worker_pool_t *pool);
+
+LIBWORKER_PUBLIC unsigned worker_pool_get_size(worker_pool_t *pool);
+
+/**
+ * Run jobs [0, num_jobs) and wait for them to finish. Each worker starts
+ * with a contiguous range of jobs, and steals jobs from the end of the
+ * other workers' ranges when its own range is done.
+ */
+LIBWORKER_PUBLIC void worker_pool_run(worker_pool_t *pool, unsigned num_jobs,
+                                      worker_pool_job_cb job_cb, void *data);
+
+LIBWORKER_PUBLIC void worker_pool_get_stats(worker_pool_t *pool,
+                                            unsigned worker_id,
+                                            worker_pool_stats_t *stats);
+
+LIBWORKER_PUBLIC void worker_pool_reset_stats(worker_pool_t *pool);
+
+/**
+ * Whether the calling thread is running a job of a worker pool. A job can
+ * check it to avoid spreading its own work to more threads.
+ */
+LIBWORKER_PUBLIC bool worker_pool_in_job(void);
+
 LIBWORKER_END_DECLS
 
 #endif
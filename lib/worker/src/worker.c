@@ -146,8 +146,12 @@ static void worker_thread(void *arg)
 
         while (worker->active) {
                 thread_mutex_lock(&worker->mutex);
-                thread_cond_wait(&worker->cond, &worker->mutex);
+                /* The task may have been posted before the worker waits */
                 task = worker_get_task(worker);
+                if (!task && worker->active) {
+                        thread_cond_wait(&worker->cond, &worker->mutex);
+                        task = worker_get_task(worker);
+                }
                 thread_mutex_unlock(&worker->mutex);
                 if (task) {
                         worker_task_run(task);
@@ -0,0 +1,274 @@
+﻿/*
+ * lib/worker/src/worker_pool.c: -- work-stealing pool for parallel jobs
+ *
+ * Copyright (c) 2018-2025, Liu chao <lc-soft@live.cn> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <worker.h>
+#include <yutil.h>
+#include <thread.h>
+
+#ifdef _MSC_VER
+#define WORKER_THREAD_LOCAL __declspec(thread)
+#else
+#define WORKER_THREAD_LOCAL __thread
+#endif
+
+/** Jobs owned by a worker, the range [head, tail) is not done yet */
+typedef struct worker_pool_queue {
+        thread_mutex_t mutex;
+        unsigned head;
+        unsigned tail;
+
+        /** Only changed by the owner of the queue */
+        worker_pool_stats_t stats;
+} worker_pool_queue_t;
+
+typedef struct worker_pool_thread {
+        unsigned id;
+        thread_t thread;
+        worker_pool_t *pool;
+} worker_pool_thread_t;
+
+struct worker_pool {
+        bool active;
+        unsigned num_workers;
+
+        /** Number of threads that are running the current jobs */
+        unsigned running;
+
+        /** Increased each time new jobs are posted */
+        unsigned generation;
+
+        worker_pool_job_cb job_cb;
+        void *job_data;
+
+        worker_pool_queue_t *queues;
+        worker_pool_thread_t *threads;
+        thread_mutex_t mutex;
+        thread_cond_t cond;
+        thread_cond_t done_cond;
+};
+
+/** Number of jobs the current thread is running, the jobs may be nested */
+static WORKER_THREAD_LOCAL unsigned worker_pool_job_depth;
+
+static bool worker_pool_pop(worker_pool_t *pool, unsigned id, unsigned *index)
+{
+        bool found = false;
+        worker_pool_queue_t *queue = &pool->queues[id];
+
+        thread_mutex_lock(&queue->mutex);
+        if (queue->head < queue->tail) {
+                *index = queue->head++;
+                found = true;
+        }
+        thread_mutex_unlock(&queue->mutex);
+        return found;
+}
+
+static bool worker_pool_steal(worker_pool_t *pool, unsigned id,
+                              unsigned *index)
+{
+        unsigned i;
+        bool found = false;
+        worker_pool_queue_t *queue;
+
+        for (i = 1; i < pool->num_workers && !found; ++i) {
+                queue = &pool->queues[(id + i) % pool->num_workers];
+                thread_mutex_lock(&queue->mutex);
+                if (queue->head < queue->tail) {
+                        *index = --queue->tail;
+                        found = true;
+                }
+                thread_mutex_unlock(&queue->mutex);
+        }
+        return found;
+}
+
+static void worker_pool_work(worker_pool_t *pool, unsigned id)
+{
+        int64_t start;
+        unsigned index;
+        bool stolen;
+        worker_pool_stats_t *stats = &pool->queues[id].stats;
+
+        while (1) {
+                if (worker_pool_pop(pool, id, &index)) {
+                        stolen = false;
+                } else if (worker_pool_steal(pool, id, &index)) {
+                        stolen = true;
+                } else {
+                        break;
+                }
+                start = get_time_us();
+                worker_pool_job_depth++;
+                pool->job_cb(pool->job_data, index, id);
+                worker_pool_job_depth--;
+                stats->busy_time += get_time_delta_us(start);
+                stats->jobs++;
+                if (stolen) {
+                        stats->steals++;
+                }
+        }
+}
+
+static void worker_pool_thread(void *arg)
+{
+        unsigned generation = 0;
+        worker_pool_thread_t *t = arg;
+        worker_pool_t *pool = t->pool;
+
+        thread_mutex_lock(&pool->mutex);
+        while (1) {
+                while (pool->active && pool->generation == generation) {
+                        thread_cond_wait(&pool->cond, &pool->mutex);
+                }
+                if (!pool->active) {
+                        break;
+                }
+                generation = pool->generation;
+                thread_mutex_unlock(&pool->mutex);
+                worker_pool_work(pool, t->id);
+                thread_mutex_lock(&pool->mutex);
+                if (--pool->running == 0) {
+                        thread_cond_signal(&pool->done_cond);
+                }
+        }
+        thread_mutex_unlock(&pool->mutex);
+        thread_exit(NULL);
+}
+
+worker_pool_t *worker_pool_create(unsigned num_workers)
+{
+        unsigned i;
+        worker_pool_t *pool;
+
+        if (num_workers < 1) {
+                num_workers = 1;
+        }
+        pool = calloc(1, sizeof(worker_pool_t));
+        if (!pool) {
+                return NULL;
+        }
+        pool->queues = calloc(num_workers, sizeof(worker_pool_queue_t));
+        pool->threads = calloc(num_workers, sizeof(worker_pool_thread_t));
+        if (!pool->queues || !pool->threads) {
+                free(pool->queues);
+                free(pool->threads);
+                free(pool);
+                return NULL;
+        }
+        pool->active = true;
+        thread_mutex_init(&pool->mutex);
+        thread_cond_init(&pool->cond);
+        thread_cond_init(&pool->done_cond);
+        thread_mutex_init(&pool->queues[0].mutex);
+        /* The calling thread is the first worker, the pool keeps working
+         * with fewer workers if some threads can not be started */
+        for (i = 1; i < num_workers; ++i) {
+                thread_mutex_init(&pool->queues[i].mutex);
+                pool->threads[i].id = i;
+                pool->threads[i].pool = pool;
+                if (thread_create(&pool->threads[i].thread,
+                                  worker_pool_thread, &pool->threads[i]) != 0) {
+                        thread_mutex_destroy(&pool->queues[i].mutex);
+                        break;
+                }
+        }
+        pool->num_workers = i;
+        return pool;
+}
+
+void worker_pool_destroy(worker_pool_t *pool)
+{
+        unsigned i;
+
+        thread_mutex_lock(&pool->mutex);
+        pool->active = false;
+        thread_cond_broadcast(&pool->cond);
+        thread_mutex_unlock(&pool->mutex);
+        for (i = 1; i < pool->num_workers; ++i) {
+                thread_join(pool->threads[i].thread, NULL);
+        }
+        for (i = 0; i < pool->num_workers; ++i) {
+                thread_mutex_destroy(&pool->queues[i].mutex);
+        }
+        thread_cond_destroy(&pool->done_cond);
+        thread_cond_destroy(&pool->cond);
+        thread_mutex_destroy(&pool->mutex);
+        free(pool->threads);
+        free(pool->queues);
+        free(pool);
+}
+
+unsigned worker_pool_get_size(worker_pool_t *pool)
+{
+        return pool->num_workers;
+}
+
+void worker_pool_run(worker_pool_t *pool, unsigned num_jobs,
+                     worker_pool_job_cb job_cb, void *data)
+{
+        unsigned i;
+        worker_pool_queue_t *queue;
+
+        if (num_jobs < 1) {
+                return;
+        }
+        for (i = 0; i < pool->num_workers; ++i) {
+                queue = &pool->queues[i];
+                thread_mutex_lock(&queue->mutex);
+                queue->head = (unsigned)((size_t)num_jobs * i /
+                                         pool->num_workers);
+                queue->tail = (unsigned)((size_t)num_jobs * (i + 1) /
+                                         pool->num_workers);
+                thread_mutex_unlock(&queue->mutex);
+        }
+        pool->job_cb = job_cb;
+        pool->job_data = data;
+        if (pool->num_workers > 1) {
+                thread_mutex_lock(&pool->mutex);
+                pool->running = pool->num_workers - 1;
+                pool->generation++;
+                thread_cond_broadcast(&pool->cond);
+                thread_mutex_unlock(&pool->mutex);
+        }
+        worker_pool_work(pool, 0);
+        thread_mutex_lock(&pool->mutex);
+        while (pool->running > 0) {
+                thread_cond_wait(&pool->done_cond, &pool->mutex);
+        }
+        thread_mutex_unlock(&pool->mutex);
+}
+
+void worker_pool_get_stats(worker_pool_t *pool, unsigned worker_id,
+                           worker_pool_stats_t *stats)
+{
+        if (worker_id >= pool->num_workers) {
+                memset(stats, 0, sizeof(worker_pool_stats_t));
+                return;
+        }
+        *stats = pool->queues[worker_id].stats;
+}
+
+void worker_pool_reset_stats(worker_pool_t *pool)
+{
+        unsigned i;
+
+        for (i = 0; i < pool->num_workers; ++i) {
+                memset(&pool->queues[i].stats, 0, sizeof(worker_pool_stats_t));
+        }
+}
+
+bool worker_pool_in_job(void)
+{
+        return worker_pool_job_depth > 0;
+}
@@ -33,6 +33,9 @@ void lcui_apply_settings(lcui_settings_t *settings)
 	    y_max(lcui_settings.parallel_rendering_threads, 1);
 	ui_server_set_threads(lcui_settings.parallel_rendering_threads);
 	ui_server_set_paint_flashing_enabled(lcui_settings.paint_flashing);
+	ui_server_set_pipelined_rendering_enabled(
+	    lcui_settings.pipelined_rendering);
+	ui_server_set_tiled_rendering_enabled(lcui_settings.tiled_rendering);
 	lcui_app_set_frame_rate_cap(lcui_settings.frame_rate_cap);
 }
 
@@ -42,7 +45,9 @@ void lcui_reset_settings(void)
 	lcui_settings_t settings = {
 		.frame_rate_cap = LCUI_MAX_FRAMES_PER_SEC,
 		.parallel_rendering_threads = 4,
-		.paint_flashing = false
+		.paint_flashing = false,
+		.pipelined_rendering = false,
+		.tiled_rendering = false
 	};
 	lcui_apply_settings(&settings);
 }
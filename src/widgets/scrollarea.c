@@ -144,13 +144,9 @@ void ui_scrollarea_update(ui_widget_t *w)
                   "scroll_top=%g, scroll_left=%g\n",
                   that->scroll_width, that->scroll_height, that->scroll_top,
                   that->scroll_left);
-        ui_widget_set_style_keyword_value(content, css_prop_position,
-                                          CSS_KEYWORD_RELATIVE);
-        ui_widget_set_style_unit_value(content, css_prop_top, -that->scroll_top,
-                                       CSS_UNIT_PX);
-        ui_widget_set_style_unit_value(content, css_prop_left,
-                                       -that->scroll_left, CSS_UNIT_PX);
-        ui_widget_request_reflow(w);
+        /* Move the content without restyling and reflowing it, the renderer
+         * moves its pixels instead of repainting the whole viewport */
+        ui_widget_scroll_to(w, that->scroll_left, that->scroll_top);
 }
 
 static void ui_scrollarea_on_mutation(ui_mutation_list_t *list,
@@ -215,7 +215,7 @@ static void ui_text_on_sizehint(ui_widget_t *w, ui_sizehint_t *hint)
                 // 严谨点的做法是根据 word-break
                 // 属性值来决定取单词或一个字的宽度
                 if (line->length > 4) {
-                        hint->min_width = 4.f * line->string[0]->bitmap->width;
+                        hint->min_width = 4.f * line->string[0].bitmap->width;
                 } else {
                         hint->min_width = 1.f * line->width;
                 }
@@ -0,0 +1,114 @@
+﻿/*
+ * tests/cases/test_frame.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <string.h>
+#include <LCUI.h>
+#include <ui.h>
+#include <ctest-custom.h>
+
+static void init_paint(pd_context_t *paint, pd_canvas_t *canvas,
+		       pd_rect_t *rect)
+{
+	paint->rect = *rect;
+	paint->with_alpha = false;
+	pd_canvas_quote(&paint->canvas, canvas, &paint->rect);
+	pd_canvas_fill(&paint->canvas, pd_rgb(255, 255, 255));
+}
+
+static bool canvas_equals(pd_canvas_t *a, pd_canvas_t *b, pd_rect_t *rect)
+{
+	int x, y;
+
+	for (y = rect->y; y < rect->y + rect->height; ++y) {
+		for (x = rect->x; x < rect->x + rect->width; ++x) {
+			if (pd_canvas_get_pixel(a, x, y).value !=
+			    pd_canvas_get_pixel(b, x, y).value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void test_frame(void)
+{
+	ui_widget_t *root, *box, *text, *shadow;
+	ui_frame_t *frame;
+	pd_canvas_t expected, actual;
+	pd_canvas_pool_t *pool;
+	pd_context_t paint;
+	pd_rect_t rects[2] = { { 0, 0, 200, 200 }, { 40, 30, 100, 80 } };
+
+	lcui_init();
+	ui_metrics.dpi = 96;
+	root = ui_root();
+	box = ui_create_widget(NULL);
+	text = ui_create_widget("text");
+	shadow = ui_create_widget(NULL);
+	ui_widget_resize(root, 200, 200);
+	ui_widget_set_style_string(root, "background-color", "#eee");
+	ui_widget_resize(box, 120, 80);
+	ui_widget_set_style_string(box, "background-color", "#f00");
+	ui_widget_set_style_string(box, "border-top-width", "2px");
+	ui_widget_set_style_string(box, "border-top-style", "solid");
+	ui_widget_set_style_string(box, "border-top-color", "#00f");
+	ui_widget_set_style_string(box, "border-top-left-radius", "8px");
+	ui_widget_set_style_string(box, "opacity", "0.6");
+	ui_text_set_content(text, "Hello, World!");
+	ui_widget_set_style_string(text, "color", "#000");
+	ui_widget_set_style_string(text, "background-color", "#ff0");
+	ui_widget_resize(shadow, 60, 60);
+	ui_widget_set_style_string(shadow, "background-color", "#0f0");
+	ui_widget_set_style_string(shadow, "box-shadow", "2px 2px 4px #000");
+	ui_widget_append(box, text);
+	ui_widget_append(root, box);
+	ui_widget_append(root, shadow);
+	ui_update();
+
+	pool = pd_canvas_pool_create(0);
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	pd_canvas_create(&expected, 200, 200);
+	pd_canvas_create(&actual, 200, 200);
+	init_paint(&paint, &expected, &rects[0]);
+	ui_widget_render(root, &paint);
+
+	frame = ui_frame_create(root, rects, 1);
+	ctest_equal_bool("create a frame", frame != NULL, true);
+	init_paint(&paint, &actual, &rects[0]);
+	ui_frame_render(frame, &paint, pool);
+	ctest_equal_bool("the frame is rendered as the widgets",
+			 canvas_equals(&expected, &actual, &rects[0]), true);
+
+	ui_text_set_content(text, "Changed");
+	ui_widget_set_style_string(box, "background-color", "#0f0");
+	ui_widget_remove(shadow);
+	ui_update();
+	init_paint(&paint, &actual, &rects[0]);
+	ui_frame_render(frame, &paint, pool);
+	ctest_equal_bool("the frame does not change with the widgets",
+			 canvas_equals(&expected, &actual, &rects[0]), true);
+	ui_frame_destroy(frame);
+
+	init_paint(&paint, &expected, &rects[1]);
+	ui_widget_render(root, &paint);
+	frame = ui_frame_create(root, &rects[1], 1);
+	init_paint(&paint, &actual, &rects[1]);
+	ui_frame_render(frame, &paint, pool);
+	ctest_equal_bool("the frame can be rendered partially",
+			 canvas_equals(&expected, &actual, &rects[1]), true);
+	ui_frame_destroy(frame);
+
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	pd_canvas_pool_destroy(pool);
+	lcui_destroy();
+}
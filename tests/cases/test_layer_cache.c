@@ -0,0 +1,109 @@
+﻿/*
+ * tests/cases/test_layer_cache.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <LCUI.h>
+#include <ui.h>
+#include <ctest-custom.h>
+
+static size_t render_dirty_rects(ui_widget_t *root, pd_canvas_t *canvas)
+{
+	size_t count = 0;
+	list_t rects;
+	list_node_t *node;
+	pd_context_t paint;
+
+	list_create(&rects);
+	ui_widget_get_dirty_rects(root, &rects);
+	for (list_each(node, &rects)) {
+		paint.rect = *(pd_rect_t *)node->data;
+		paint.with_alpha = false;
+		pd_canvas_quote(&paint.canvas, canvas, &paint.rect);
+		count += ui_widget_render(root, &paint);
+	}
+	list_destroy(&rects, free);
+	return count;
+}
+
+void test_layer_cache(void)
+{
+	ui_widget_t *root, *panel, *child, *caret;
+	ui_widget_rules_t rules = { 0 };
+	ui_layer_cache_stats_t stats;
+	pd_canvas_t canvas;
+	pd_color_t color;
+	ui_rect_t rect = { 0, 0, 200, 200 };
+
+	lcui_init();
+	ui_metrics.dpi = 96;
+	root = ui_root();
+	panel = ui_create_widget(NULL);
+	child = ui_create_widget(NULL);
+	caret = ui_create_widget(NULL);
+	ui_widget_resize(root, 200, 200);
+	ui_widget_resize(panel, 100, 100);
+	ui_widget_resize(child, 50, 50);
+	ui_widget_resize(caret, 10, 10);
+	ui_widget_set_style_string(panel, "background-color", "#f00");
+	ui_widget_set_style_string(child, "background-color", "#0f0");
+	ui_widget_set_style_string(caret, "background-color", "#00f");
+	ui_widget_set_style_string(caret, "position", "absolute");
+	ui_widget_set_style_string(caret, "left", "20px");
+	ui_widget_set_style_string(caret, "top", "20px");
+	ui_widget_append(panel, child);
+	ui_widget_append(root, panel);
+	ui_widget_append(root, caret);
+	rules.cache_layer = true;
+	ui_widget_set_rules(panel, &rules);
+	ui_update();
+
+	pd_canvas_init(&canvas);
+	pd_canvas_create(&canvas, 200, 200);
+	pd_canvas_fill(&canvas, pd_rgb(255, 255, 255));
+	ui_reset_layer_cache_stats();
+	ui_widget_mark_dirty_rect(root, &rect, UI_BOX_TYPE_GRAPH_BOX);
+	render_dirty_rects(root, &canvas);
+	ui_get_layer_cache_stats(&stats);
+	ctest_equal_int("first paint creates the layer", (int)stats.layers, 1);
+	ctest_equal_int("first paint is a cache miss", (int)stats.misses, 1);
+
+	ui_widget_hide(caret);
+	ui_update();
+	render_dirty_rects(root, &canvas);
+	ui_get_layer_cache_stats(&stats);
+	ctest_equal_int("changes outside the layer are cache hits",
+			(int)stats.hits, 1);
+	ctest_equal_int("changes outside the layer do not repaint it",
+			(int)stats.misses, 1);
+	color = pd_canvas_get_pixel(&canvas, 25, 25);
+	ctest_equal_int("composited layer keeps the child color", color.value,
+			pd_rgb(0, 255, 0).value);
+	color = pd_canvas_get_pixel(&canvas, 75, 75);
+	ctest_equal_int("composited layer keeps the panel color", color.value,
+			pd_rgb(255, 0, 0).value);
+
+	ui_widget_set_style_string(child, "background-color", "#000");
+	ui_update();
+	render_dirty_rects(root, &canvas);
+	ui_get_layer_cache_stats(&stats);
+	ctest_equal_int("changes inside the layer repaint it",
+			(int)stats.misses, 2);
+	color = pd_canvas_get_pixel(&canvas, 25, 25);
+	ctest_equal_int("repainted layer has the new child color",
+			color.value, pd_rgb(0, 0, 0).value);
+
+	pd_canvas_destroy(&canvas);
+	lcui_destroy();
+	ui_get_layer_cache_stats(&stats);
+	ctest_equal_int("layers are released with widgets", (int)stats.layers,
+			0);
+}
@@ -0,0 +1,76 @@
+﻿/*
+ * tests/cases/test_occlusion_culling.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <LCUI.h>
+#include <ui.h>
+#include <ctest-custom.h>
+
+void test_occlusion_culling(void)
+{
+	ui_widget_t *root, *list, *dialog;
+	ui_render_stats_t stats;
+	pd_canvas_t canvas;
+	pd_color_t color;
+
+	lcui_init();
+	ui_metrics.dpi = 96;
+	root = ui_root();
+	ui_widget_resize(root, 200, 200);
+	list = ctest_create_block(root, 100, 100, "#f00");
+	ctest_create_block(list, 50, 50, "#0f0");
+	dialog = ctest_create_block(root, 120, 120, "#00f");
+	ui_widget_set_style_string(dialog, "position", "absolute");
+	ui_widget_set_style_string(dialog, "left", "0");
+	ui_widget_set_style_string(dialog, "top", "0");
+	ui_update();
+
+	pd_canvas_init(&canvas);
+	pd_canvas_create(&canvas, 200, 200);
+	ctest_render_widget(root, &canvas);
+	ui_get_render_stats(&stats);
+	ctest_equal_int("widgets under an opaque sibling are culled",
+			(int)stats.culled_count, 1);
+	color = pd_canvas_get_pixel(&canvas, 25, 25);
+	ctest_equal_int("the opaque sibling is painted", color.value,
+			pd_rgb(0, 0, 255).value);
+
+	ui_widget_set_style_string(dialog, "opacity", "0.5");
+	ui_update();
+	ctest_render_widget(root, &canvas);
+	ui_get_render_stats(&stats);
+	ctest_equal_int("translucent siblings do not cull widgets",
+			(int)stats.culled_count, 0);
+
+	ui_widget_set_style_string(dialog, "opacity", "1");
+	ui_widget_set_style_string(dialog, "border-top-left-radius", "10px");
+	ui_update();
+	ctest_render_widget(root, &canvas);
+	ui_get_render_stats(&stats);
+	ctest_equal_int("rounded corners do not cover the widget",
+			(int)stats.culled_count, 0);
+
+	ui_widget_set_style_string(dialog, "border-top-left-radius", "0");
+	ui_set_occlusion_culling_enabled(false);
+	ui_update();
+	ctest_render_widget(root, &canvas);
+	ui_get_render_stats(&stats);
+	ctest_equal_int("occlusion culling can be disabled",
+			(int)stats.culled_count, 0);
+	/* The culled widgets are painted under the sibling now, which leaves
+	 * the rounding error of the blending in the output */
+	color = pd_canvas_get_pixel(&canvas, 25, 25);
+	ctest_equal_bool("the output is the same without culling",
+			 color.r == 0 && color.g == 0 && color.b >= 254, true);
+	ui_set_occlusion_culling_enabled(true);
+
+	pd_canvas_destroy(&canvas);
+	lcui_destroy();
+}
@@ -0,0 +1,127 @@
+﻿/*
+ * tests/cases/test_opacity_folding.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <LCUI.h>
+#include <ui.h>
+#include <ctest-custom.h>
+
+/** Compare the canvases, allowing the rounding error of the blending */
+static bool canvas_equals(pd_canvas_t *a, pd_canvas_t *b)
+{
+	unsigned x, y;
+	pd_color_t ca, cb;
+
+	for (y = 0; y < a->height; ++y) {
+		for (x = 0; x < a->width; ++x) {
+			ca = pd_canvas_get_pixel(a, x, y);
+			cb = pd_canvas_get_pixel(b, x, y);
+			if (abs(ca.r - cb.r) > 1 || abs(ca.g - cb.g) > 1 ||
+			    abs(ca.b - cb.b) > 1) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/** Render with and without opacity folding, return the folded count */
+static size_t render_and_compare(ui_widget_t *root, pd_canvas_t *expected,
+				 pd_canvas_t *actual, bool *equals)
+{
+	ui_render_stats_t stats;
+
+	ui_set_opacity_folding_enabled(false);
+	ctest_render_widget(root, expected);
+	ui_set_opacity_folding_enabled(true);
+	ctest_render_widget(root, actual);
+	ui_get_render_stats(&stats);
+	*equals = canvas_equals(expected, actual);
+	return stats.folded_opacity_count;
+}
+
+void test_opacity_folding(void)
+{
+	bool equals;
+	size_t count;
+	ui_widget_t *root, *panel, *a, *b;
+	ui_widget_rules_t rules = { 0 };
+	pd_canvas_t expected, actual;
+	pd_color_t color;
+
+	lcui_init();
+	ui_metrics.dpi = 96;
+	root = ui_root();
+	ui_widget_resize(root, 200, 200);
+	panel = ctest_create_block(root, 160, 160, "transparent");
+	a = ctest_create_block(panel, 100, 50, "#f00");
+	b = ctest_create_block(panel, 100, 50, "#00f");
+	ui_widget_set_style_string(panel, "opacity", "0.5");
+	ui_widget_set_style_string(b, "border-top-width", "2px");
+	ui_widget_set_style_string(b, "border-top-style", "solid");
+	ui_widget_set_style_string(b, "border-top-color", "#0f0");
+	ui_update();
+
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	pd_canvas_create(&expected, 200, 200);
+	pd_canvas_create(&actual, 200, 200);
+
+	count = render_and_compare(root, &expected, &actual, &equals);
+	ctest_equal_int("opacity is folded if the children do not overlap",
+			(int)count, 1);
+	ctest_equal_bool("the result is the same as using a layer", equals,
+			 true);
+
+	ui_widget_set_style_string(b, "margin-top", "-20px");
+	ui_update();
+	count = render_and_compare(root, &expected, &actual, &equals);
+	ctest_equal_int("opacity is not folded if the children overlap",
+			(int)count, 0);
+	ctest_equal_bool("the output is the same", equals, true);
+
+	ui_widget_set_style_string(b, "margin-top", "0");
+	ui_widget_set_style_string(panel, "background-color", "#ff0");
+	ui_update();
+	count = render_and_compare(root, &expected, &actual, &equals);
+	ctest_equal_int("opacity is not folded if the children cover the "
+			"painted widget",
+			(int)count, 0);
+	ctest_equal_bool("the output is the same", equals, true);
+
+	ui_widget_set_style_string(panel, "background-color", "transparent");
+	ui_widget_set_style_string(a, "opacity", "0.5");
+	ui_update();
+	count = render_and_compare(root, &expected, &actual, &equals);
+	ctest_equal_int("nested opacity is folded", (int)count, 2);
+	ctest_equal_bool("the result is the same as using layers", equals,
+			 true);
+
+	ui_widget_set_style_string(a, "opacity", "1");
+	ui_widget_hide(b);
+	rules.cache_layer = true;
+	ui_widget_set_rules(a, &rules);
+	ui_update();
+	count = render_and_compare(root, &expected, &actual, &equals);
+	ctest_equal_int("opacity is folded into a retained layer", (int)count,
+			1);
+	ctest_equal_bool("the result is the same as using layers", equals,
+			 true);
+	color = pd_canvas_get_pixel(&actual, 10, 10);
+	ctest_equal_bool("the retained layer is composited with the opacity",
+			 color.r == 255 && abs(color.g - 128) <= 1 &&
+			     abs(color.b - 128) <= 1,
+			 true);
+
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	lcui_destroy();
+}
@@ -0,0 +1,183 @@
+﻿/*
+ * tests/cases/test_scroll_blit.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdio.h>
+#include <LCUI.h>
+#include <ui.h>
+#include <ctest-custom.h>
+
+static void init_paint(pd_context_t *paint, pd_canvas_t *canvas,
+		       pd_rect_t *rect)
+{
+	paint->rect = *rect;
+	paint->with_alpha = false;
+	pd_canvas_quote(&paint->canvas, canvas, &paint->rect);
+	pd_canvas_fill(&paint->canvas, pd_rgb(255, 255, 255));
+}
+
+static bool canvas_equals(pd_canvas_t *a, pd_canvas_t *b, pd_rect_t *rect)
+{
+	int x, y;
+
+	for (y = rect->y; y < rect->y + rect->height; ++y) {
+		for (x = rect->x; x < rect->x + rect->width; ++x) {
+			if (pd_canvas_get_pixel(a, x, y).value !=
+			    pd_canvas_get_pixel(b, x, y).value) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+/**
+ * Update the canvas in the same way as the UI server: move the pixels of
+ * the scrolled areas, then repaint the dirty region.
+ * @returns number of repainted pixels
+ */
+static size_t render_scroll(ui_widget_t *root, pd_canvas_t *canvas,
+			    size_t *num_scroll_rects)
+{
+	unsigned i;
+	size_t area = 0;
+	list_t rects;
+	list_node_t *node;
+	pd_rect_t dest_rect;
+	pd_region_t region, exposed;
+	pd_context_t paint;
+	ui_scroll_rect_t *scroll_rect;
+
+	list_create(&rects);
+	pd_region_init(&region);
+	pd_region_init(&exposed);
+	*num_scroll_rects = ui_widget_get_scroll_rects(root, &rects);
+	for (list_each(node, &rects)) {
+		scroll_rect = node->data;
+		pd_canvas_scroll(canvas, &scroll_rect->blit_rect,
+				 scroll_rect->dx, scroll_rect->dy);
+		dest_rect = scroll_rect->blit_rect;
+		dest_rect.x += scroll_rect->dx;
+		dest_rect.y += scroll_rect->dy;
+		pd_rect_overlap(&scroll_rect->blit_rect, &dest_rect, &dest_rect);
+		pd_region_set_rect(&exposed, &scroll_rect->rect);
+		pd_region_subtract_rect(&exposed, &dest_rect);
+		pd_region_union(&region, &region, &exposed);
+	}
+	list_destroy(&rects, free);
+	ui_widget_get_dirty_region(root, &exposed);
+	pd_region_union(&region, &region, &exposed);
+	for (i = 0; i < region.length; ++i) {
+		init_paint(&paint, canvas, &region.rects[i]);
+		ui_widget_render(root, &paint);
+		area += (size_t)paint.rect.width * paint.rect.height;
+	}
+	pd_region_destroy(&region);
+	pd_region_destroy(&exposed);
+	return area;
+}
+
+void test_scroll_blit(void)
+{
+	int i;
+	char color[16];
+	size_t area, num_scroll_rects;
+	ui_widget_t *root, *scrollarea, *content, *item, *overlay;
+	pd_rect_t rect = { 0, 0, 200, 200 };
+	pd_canvas_t expected, actual;
+	pd_context_t paint;
+
+	lcui_init();
+	ui_metrics.dpi = 96;
+	root = ui_root();
+	scrollarea = ui_create_scrollarea();
+	content = ui_create_scrollarea_content();
+	ui_widget_resize(root, 200, 200);
+	ui_widget_set_style_string(root, "background-color", "#eee");
+	ui_widget_resize(scrollarea, 100, 100);
+	ui_widget_set_style_string(scrollarea, "background-color", "#fff");
+	for (i = 0; i < 20; ++i) {
+		item = ui_create_widget(NULL);
+		snprintf(color, sizeof(color), "#%02x%02x00", i * 12, 240 - i * 12);
+		ui_widget_set_style_string(item, "height", "20px");
+		ui_widget_set_style_string(item, "background-color", color);
+		ui_widget_append(content, item);
+	}
+	ui_widget_append(scrollarea, content);
+	ui_widget_append(root, scrollarea);
+	ui_update();
+	ui_update();
+
+	pd_canvas_init(&expected);
+	pd_canvas_init(&actual);
+	pd_canvas_create(&expected, 200, 200);
+	pd_canvas_create(&actual, 200, 200);
+	render_scroll(root, &actual, &num_scroll_rects);
+	init_paint(&paint, &actual, &rect);
+	ui_widget_render(root, &paint);
+
+	ui_scrollarea_set_scroll_top(scrollarea, 30);
+	ctest_equal_bool("the content is moved without updating its layout",
+			 content->border_box.y == -30 &&
+			     !content->update.should_update_self &&
+			     !scrollarea->update.should_reflow,
+			 true);
+	ui_update();
+	area = render_scroll(root, &actual, &num_scroll_rects);
+	ctest_equal_uint("the scrolled area can be moved",
+			 (unsigned)num_scroll_rects, 1);
+	ctest_equal_bool("only the exposed area is repainted",
+			 area < 100 * 100 / 2, true);
+	init_paint(&paint, &expected, &rect);
+	ui_widget_render(root, &paint);
+	ctest_equal_bool("the result is the same as repainting",
+			 canvas_equals(&expected, &actual, &rect), true);
+
+	/* The pixels of the overlay widget should not be moved */
+	overlay = ui_create_widget(NULL);
+	ui_widget_set_style_string(overlay, "position", "absolute");
+	ui_widget_set_style_string(overlay, "left", "20px");
+	ui_widget_set_style_string(overlay, "top", "80px");
+	ui_widget_resize(overlay, 100, 30);
+	ui_widget_set_style_string(overlay, "background-color", "#00f");
+	ui_widget_append(root, overlay);
+	ui_update();
+	render_scroll(root, &actual, &num_scroll_rects);
+
+	ui_scrollarea_set_scroll_top(scrollarea, 10);
+	ui_update();
+	area = render_scroll(root, &actual, &num_scroll_rects);
+	ctest_equal_uint("the area under the overlay is not moved",
+			 (unsigned)num_scroll_rects, 1);
+	ctest_equal_bool("only the exposed area is repainted",
+			 area < 100 * 100, true);
+	init_paint(&paint, &expected, &rect);
+	ui_widget_render(root, &paint);
+	ctest_equal_bool("the result is the same as repainting",
+			 canvas_equals(&expected, &actual, &rect), true);
+
+	ui_widget_set_style_string(scrollarea, "background-color",
+				   "transparent");
+	ui_update();
+	render_scroll(root, &actual, &num_scroll_rects);
+	ui_scrollarea_set_scroll_top(scrollarea, 40);
+	ui_update();
+	render_scroll(root, &actual, &num_scroll_rects);
+	ctest_equal_uint("the transparent area is repainted",
+			 (unsigned)num_scroll_rects, 0);
+	init_paint(&paint, &expected, &rect);
+	ui_widget_render(root, &paint);
+	ctest_equal_bool("the result is the same as repainting",
+			 canvas_equals(&expected, &actual, &rect), true);
+
+	pd_canvas_destroy(&expected);
+	pd_canvas_destroy(&actual);
+	lcui_destroy();
+}
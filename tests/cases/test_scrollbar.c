@@ -105,8 +105,8 @@ void test_scrollbar(void)
         lcui_ui_update();
 
         content = ui_get_widget("license_content");
-        left = content->computed_style.left;
-        top = content->computed_style.top;
+        left = content->border_box.x;
+        top = content->border_box.y;
 
         e.type = UI_EVENT_MOUSEMOVE;
         e.mouse.x = 300;
@@ -128,12 +128,12 @@ void test_scrollbar(void)
         lcui_ui_update();
 
         ctest_equal_bool("content should be moved to the left",
-                         content->computed_style.left < left &&
-                             top == content->computed_style.top,
+                         content->border_box.x < left &&
+                             top == content->border_box.y,
                          true);
 
-        left = content->computed_style.left;
-        top = content->computed_style.top;
+        left = content->border_box.x;
+        top = content->border_box.y;
 
         e.type = UI_EVENT_MOUSEMOVE;
         e.mouse.x = 400;
@@ -147,12 +147,12 @@ void test_scrollbar(void)
         lcui_ui_update();
 
         ctest_equal_bool("content should be moved to the right",
-                         content->computed_style.left > left &&
-                             top == content->computed_style.top,
+                         content->border_box.x > left &&
+                             top == content->border_box.y,
                          true);
 
-        left = content->computed_style.left;
-        top = content->computed_style.top;
+        left = content->border_box.x;
+        top = content->border_box.y;
 
         e.type = UI_EVENT_MOUSEMOVE;
         e.mouse.x = 555;
@@ -174,12 +174,12 @@ void test_scrollbar(void)
         lcui_ui_update();
 
         ctest_equal_bool("content should be moved to the top",
-                         content->computed_style.left == left &&
-                             top > content->computed_style.top,
+                         content->border_box.x == left &&
+                             top > content->border_box.y,
                          true);
 
-        left = content->computed_style.left;
-        top = content->computed_style.top;
+        left = content->border_box.x;
+        top = content->border_box.y;
 
         e.type = UI_EVENT_MOUSEMOVE;
         e.mouse.x = 555;
@@ -193,8 +193,8 @@ void test_scrollbar(void)
         lcui_ui_update();
 
         ctest_equal_bool("the content should have scrolled to the bottom",
-                         content->computed_style.left == left &&
-                             top < content->computed_style.top,
+                         content->border_box.x == left &&
+                             top < content->border_box.y,
                          true);
 
         lcui_quit();
@@ -37,6 +37,10 @@ static void test_default_settings(void)
 	ctest_equal_int("check default parallel rendering threads",
 	     settings.parallel_rendering_threads, 4);
 	ctest_equal_bool("check default paint flashing", settings.paint_flashing, false);
+	ctest_equal_bool("check default pipelined rendering",
+			 settings.pipelined_rendering, false);
+	ctest_equal_bool("check default tiled rendering",
+			 settings.tiled_rendering, false);
 	lcui_quit();
 	lcui_main();
 }
@@ -48,6 +52,8 @@ static void test_apply_settings(void)
 	settings.frame_rate_cap = 60;
 	settings.parallel_rendering_threads = 2;
 	settings.paint_flashing = true;
+	settings.pipelined_rendering = true;
+	settings.tiled_rendering = true;
 
 	lcui_init();
 	lcui_apply_settings(&settings);
@@ -56,6 +62,10 @@ static void test_apply_settings(void)
 	ctest_equal_int("check parallel rendering threads",
 	     settings.parallel_rendering_threads, 2);
 	ctest_equal_bool("check paint flashing", settings.paint_flashing, true);
+	ctest_equal_bool("check pipelined rendering",
+			 settings.pipelined_rendering, true);
+	ctest_equal_bool("check tiled rendering",
+			 settings.tiled_rendering, true);
 
 	settings.frame_rate_cap = -1;
 	settings.parallel_rendering_threads = -1;
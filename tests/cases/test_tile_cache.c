@@ -0,0 +1,92 @@
+﻿/*
+ * tests/cases/test_tile_cache.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <LCUI.h>
+#include <ctest-custom.h>
+#include "../../lib/ui-server/src/tile_cache.h"
+
+void test_tile_cache(void)
+{
+	unsigned n;
+	pd_rect_t *rects;
+	pd_rect_t rect;
+	pd_rect_t partial_rect = { 10, 10, 20, 20 };
+	pd_rect_t merged_rect = { 10, 10, 40, 30 };
+	pd_rect_t right_rect = { 128, 0, 22, 64 };
+	pd_rect_t corner_rect = { 128, 64, 22, 36 };
+	pd_rect_t clipped_rect = { 130, 70, 20, 30 };
+	ui_tile_cache_t cache;
+
+	/* 3 x 2 tiles, the tiles of the last column and row are smaller */
+	ui_tile_cache_init(&cache);
+	ctest_equal_int("ui_tile_cache_resize()",
+			ui_tile_cache_resize(&cache, 64, 150, 100), 0);
+	ctest_equal_bool("the tiles are not ready before they are rendered",
+			 ui_tile_cache_is_tile_ready(&cache, 70, 0), false);
+
+	/* Only a part of the first tile is rendered the first time */
+	cache.dirty_rects[0] = partial_rect;
+	n = ui_tile_cache_get_dirty_rects(&cache, &rects);
+	ctest_equal_int("all tiles are dirty after resizing", n, 6);
+	ctest_equal_pd_rect("the dirty rect of the first tile", &rects[0],
+			    &partial_rect);
+	ctest_equal_pd_rect("the tile at the right edge is clipped", &rects[2],
+			    &right_rect);
+	ctest_equal_pd_rect("the tile at the bottom right corner is clipped",
+			    &rects[5], &corner_rect);
+	free(rects);
+	ctest_equal_bool("the tiles rendered as a whole are ready",
+			 ui_tile_cache_is_tile_ready(&cache, 70, 0), true);
+	ctest_equal_bool("the clipped tiles rendered as a whole are ready",
+			 ui_tile_cache_is_tile_ready(&cache, 149, 99), true);
+	ctest_equal_bool("a partially rendered tile is not ready",
+			 ui_tile_cache_is_tile_ready(&cache, 40, 40), false);
+
+	rect.x = 10;
+	rect.y = 10;
+	rect.width = 10;
+	rect.height = 10;
+	ui_tile_cache_add_dirty_rect(&cache, &rect);
+	rect.x = 40;
+	rect.y = 30;
+	ui_tile_cache_add_dirty_rect(&cache, &rect);
+	rect.x = 130;
+	rect.y = 70;
+	rect.width = 40;
+	rect.height = 40;
+	ui_tile_cache_add_dirty_rect(&cache, &rect);
+	ctest_equal_bool("a dirty tile is not ready",
+			 ui_tile_cache_is_tile_ready(&cache, 149, 99), false);
+	n = ui_tile_cache_get_dirty_rects(&cache, &rects);
+	ctest_equal_int("only the dirty tiles are returned", n, 2);
+	ctest_equal_pd_rect("the dirty rects of a tile are merged", &rects[0],
+			    &merged_rect);
+	ctest_equal_pd_rect("the dirty rect is clipped at the edges",
+			    &rects[1], &clipped_rect);
+	free(rects);
+	ctest_equal_bool("a tile rendered before is ready after repainting",
+			 ui_tile_cache_is_tile_ready(&cache, 149, 99), true);
+	ctest_equal_bool("a partially repainted tile is still not ready",
+			 ui_tile_cache_is_tile_ready(&cache, 40, 40), false);
+
+	rect.x = 0;
+	rect.y = 0;
+	rect.width = 64;
+	rect.height = 64;
+	ui_tile_cache_add_dirty_rect(&cache, &rect);
+	n = ui_tile_cache_get_dirty_rects(&cache, &rects);
+	ctest_equal_int("the whole tile is dirty", n, 1);
+	free(rects);
+	ctest_equal_bool("the tile is ready after it is rendered as a whole",
+			 ui_tile_cache_is_tile_ready(&cache, 40, 40), true);
+	ui_tile_cache_destroy(&cache);
+}
@@ -0,0 +1,123 @@
+﻿/*
+ * tests/cases/test_worker_pool.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#ifdef __linux__
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <pthread.h>
+#endif
+#include <stdint.h>
+#include <LCUI.h>
+#include <ctest-custom.h>
+
+#define NUM_JOBS 1000
+
+static void test_job(void *data, unsigned index, unsigned worker_id)
+{
+	int *results = data;
+
+	results[index] += (int)index;
+}
+
+static void test_job_in_job(void *data, unsigned index, unsigned worker_id)
+{
+	bool *in_job = data;
+
+	in_job[index] = worker_pool_in_job();
+}
+
+#if defined(__GLIBC__) && SIZE_MAX > UINT32_MAX
+
+/** Create the pool while new threads ask for more stack than can be mapped */
+static worker_pool_t *create_pool_without_threads(unsigned num_workers)
+{
+	worker_pool_t *pool;
+	pthread_attr_t attr, default_attr;
+
+	pthread_getattr_default_np(&default_attr);
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, (size_t)1 << 60);
+	pthread_setattr_default_np(&attr);
+	pool = worker_pool_create(num_workers);
+	pthread_setattr_default_np(&default_attr);
+	pthread_attr_destroy(&attr);
+	pthread_attr_destroy(&default_attr);
+	return pool;
+}
+
+static void test_worker_pool_without_threads(void)
+{
+	int i;
+	bool ok = true;
+	int results[NUM_JOBS] = { 0 };
+	worker_pool_t *pool;
+
+	pool = create_pool_without_threads(4);
+	ctest_equal_int("the workers that failed to start are left out",
+			worker_pool_get_size(pool), 1);
+	worker_pool_run(pool, NUM_JOBS, test_job, results);
+	for (i = 0; i < NUM_JOBS; ++i) {
+		ok = ok && results[i] == i;
+	}
+	ctest_equal_bool("the jobs run without the threads", ok, true);
+	worker_pool_destroy(pool);
+}
+
+#endif
+
+void test_worker_pool(void)
+{
+	int i, k;
+	bool ok = true;
+	size_t jobs = 0;
+	unsigned id;
+	int results[NUM_JOBS] = { 0 };
+	bool in_job[4] = { false };
+	worker_pool_t *pool;
+	worker_pool_stats_t stats;
+
+	pool = worker_pool_create(4);
+	ctest_equal_int("worker_pool_get_size()", worker_pool_get_size(pool),
+			4);
+	for (k = 0; k < 10; ++k) {
+		worker_pool_run(pool, NUM_JOBS, test_job, results);
+	}
+	for (i = 0; i < NUM_JOBS; ++i) {
+		ok = ok && results[i] == i * 10;
+	}
+	ctest_equal_bool("each job runs once per run", ok, true);
+	for (id = 0; id < worker_pool_get_size(pool); ++id) {
+		worker_pool_get_stats(pool, id, &stats);
+		jobs += stats.jobs;
+	}
+	ctest_equal_int("stats of workers count all jobs", (int)jobs,
+			NUM_JOBS * 10);
+	worker_pool_reset_stats(pool);
+	worker_pool_get_stats(pool, 0, &stats);
+	ctest_equal_int("worker_pool_reset_stats()", (int)stats.jobs, 0);
+	worker_pool_run(pool, 4, test_job_in_job, in_job);
+	ctest_equal_bool("worker_pool_in_job() is true in the jobs",
+			 in_job[0] && in_job[1] && in_job[2] && in_job[3], true);
+	ctest_equal_bool("worker_pool_in_job() is false out of the jobs",
+			 worker_pool_in_job(), false);
+	worker_pool_destroy(pool);
+
+	pool = worker_pool_create(1);
+	worker_pool_run(pool, NUM_JOBS, test_job, results);
+	worker_pool_get_stats(pool, 0, &stats);
+	ctest_equal_int("a single worker runs jobs on the calling thread",
+			(int)stats.jobs, NUM_JOBS);
+	worker_pool_destroy(pool);
+#if defined(__GLIBC__) && SIZE_MAX > UINT32_MAX
+	test_worker_pool_without_threads();
+#endif
+}
@@ -10,8 +10,8 @@
  */
 
 #include <stdbool.h>
-#include <pandagl/rect.h>
-#include <ui/rect.h>
+#include <pandagl.h>
+#include <ui.h>
 #include <ctest.h>
 
 static inline bool ctest_equal_pd_rect(const char *name, pd_rect_t *actual,
@@ -25,3 +25,34 @@ static inline bool ctest_equal_ui_rect(const char *name, ui_rect_t *actual,
 {
 	return ctest_equal(name, (ctest_to_str_func_t)ui_rect_to_str, actual, expected);
 }
+
+/** Create a widget with the size and background color, then append it */
+static inline ui_widget_t *ctest_create_block(ui_widget_t *parent, float width,
+					      float height, const char *color)
+{
+	ui_widget_t *w = ui_create_widget(NULL);
+
+	ui_widget_resize(w, width, height);
+	ui_widget_set_style_string(w, "background-color", color);
+	ui_widget_append(parent, w);
+	return w;
+}
+
+/**
+ * Render the widget tree on the whole canvas over a white background. The
+ * render statistics are reset first, so they only count this render.
+ */
+static inline size_t ctest_render_widget(ui_widget_t *w, pd_canvas_t *canvas)
+{
+	pd_context_t paint;
+
+	paint.rect.x = 0;
+	paint.rect.y = 0;
+	paint.rect.width = canvas->width;
+	paint.rect.height = canvas->height;
+	paint.with_alpha = false;
+	pd_canvas_quote(&paint.canvas, canvas, &paint.rect);
+	pd_canvas_fill(&paint.canvas, pd_rgb(255, 255, 255));
+	ui_reset_render_stats();
+	return ui_widget_render(w, &paint);
+}
@@ -21,6 +21,7 @@ int main(int argc, char **argv)
 	logger_set_level(LOGGER_LEVEL_ERROR);
 	ctest_describe("test settings", test_settings);
 	ctest_describe("test thread", test_thread);
+	ctest_describe("test worker pool", test_worker_pool);
 	ctest_describe("test font load", test_font_load);
 	ctest_describe("test image reader", test_image_reader);
 	ctest_describe("test xml parser", test_xml_parser);
@@ -28,9 +29,15 @@ int main(int argc, char **argv)
 	ctest_describe("test clipboard", test_clipboard);
 	ctest_describe("test widget event", test_widget_event);
 	ctest_describe("test widget opacity", test_widget_opacity);
+	ctest_describe("test layer cache", test_layer_cache);
+	ctest_describe("test occlusion culling", test_occlusion_culling);
+	ctest_describe("test opacity folding", test_opacity_folding);
+	ctest_describe("test frame", test_frame);
+	ctest_describe("test tile cache", test_tile_cache);
 	ctest_describe("test text resize", test_text_resize);
 	ctest_describe("test textinput", test_textinput);
 	ctest_describe("test scrollbar", test_scrollbar);
+	ctest_describe("test scroll blit", test_scroll_blit);
         ctest_describe("test router components", test_router_components);
 	ctest_describe("test widget rect", test_widget_rect);
 	ctest_describe("test block layout", test_block_layout);
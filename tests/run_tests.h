@@ -25,3 +25,10 @@ void test_flex_layout(void);
 void test_widget_rect(void);
 void test_clipboard(void);
 void test_router_components(void);
+void test_layer_cache(void);
+void test_occlusion_culling(void);
+void test_opacity_folding(void);
+void test_worker_pool(void);
+void test_frame(void);
+void test_scroll_blit(void);
+void test_tile_cache(void);
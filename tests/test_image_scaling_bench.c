@@ -17,11 +17,14 @@
 #include <ui_xml.h>
 #include <pandagl.h>
 
+static const char *quality_names[] = { "NEAREST", "BOX", "BILINEAR",
+				       "LANCZOS3" };
+
 int main(int argc, char **argv)
 {
-	int i;
+	int i, q;
 	int64_t t0, t1, t2;
-	int resx[] = { 480, 960, 1280, 1366, 1920, 2560, 3840 }, resy;
+	int resx[] = { 240, 480, 960, 1280, 1366, 1920, 2560, 3840 }, resy;
 	char s_res[32], s_t0[32], s_t1[32];
 
 	pd_canvas_t g_src, g_dst;
@@ -48,10 +51,30 @@ int main(int argc, char **argv)
 		pd_canvas_destroy(&g_dst);
 		t2 = get_time_ms();
 		sprintf(s_res, "%dx%d", resx[i], resy);
-		sprintf(s_t0, "%ldms", (int)(t1 - t0));
-		sprintf(s_t1, "%ldms", (int)(t2 - t1));
+		sprintf(s_t0, "%dms", (int)(t1 - t0));
+		sprintf(s_t1, "%dms", (int)(t2 - t1));
 		logger_info("%-20s%-20s%-20s\n", s_res, s_t0, s_t1);
 	}
+	logger_info("\n%-20s", "pd_canvas_resample()");
+	for (q = PD_RESAMPLE_NEAREST; q <= PD_RESAMPLE_LANCZOS3; ++q) {
+		logger_info("%-12s", quality_names[q]);
+	}
+	logger_info("\n");
+	for (i = 0; i < sizeof(resx) / sizeof(int); i++) {
+		resy = resx[i] * 9 / 16;
+		sprintf(s_res, "%dx%d", resx[i], resy);
+		logger_info("%-20s", s_res);
+		for (q = PD_RESAMPLE_NEAREST; q <= PD_RESAMPLE_LANCZOS3; ++q) {
+			t0 = get_time_ms();
+			pd_canvas_init(&g_dst);
+			pd_canvas_resample(&g_src, &g_dst, resx[i], resy, q);
+			pd_canvas_destroy(&g_dst);
+			t1 = get_time_ms();
+			sprintf(s_t0, "%dms", (int)(t1 - t0));
+			logger_info("%-12s", s_t0);
+		}
+		logger_info("\n");
+	}
 	pd_canvas_destroy(&g_src);
 	return 0;
 }
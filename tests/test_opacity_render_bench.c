@@ -0,0 +1,119 @@
+﻿/*
+ * tests/test_opacity_render_bench.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <LCUI.h>
+#include <ui.h>
+#include <pandagl.h>
+
+#define PANEL_WIDTH 1280
+#define PANEL_HEIGHT 720
+#define ITEM_WIDTH 160
+#define ITEM_HEIGHT 90
+#define RENDER_TIMES 30
+
+static ui_widget_t *create_panel(void)
+{
+	int x, y;
+	char str[32];
+	ui_widget_t *panel, *item;
+
+	panel = ui_create_widget(NULL);
+	ui_widget_resize(panel, PANEL_WIDTH, PANEL_HEIGHT);
+	for (y = 0; y < PANEL_HEIGHT; y += ITEM_HEIGHT) {
+		for (x = 0; x < PANEL_WIDTH; x += ITEM_WIDTH) {
+			item = ui_create_widget(NULL);
+			ui_widget_resize(item, ITEM_WIDTH - 10, ITEM_HEIGHT - 10);
+			ui_widget_set_style_string(item, "position", "absolute");
+			sprintf(str, "%dpx", x);
+			ui_widget_set_style_string(item, "left", str);
+			sprintf(str, "%dpx", y);
+			ui_widget_set_style_string(item, "top", str);
+			sprintf(str, "#%02x%02x%02x", x * 255 / PANEL_WIDTH,
+				y * 255 / PANEL_HEIGHT, 128);
+			ui_widget_set_style_string(item, "background-color",
+						   str);
+			ui_widget_append(panel, item);
+		}
+	}
+	ui_widget_append(ui_root(), panel);
+	return panel;
+}
+
+static int64_t render_panel(ui_widget_t *panel, pd_canvas_t *canvas,
+			    bool folding)
+{
+	int i;
+	int64_t t;
+	pd_context_t paint;
+
+	paint.rect.x = 0;
+	paint.rect.y = 0;
+	paint.rect.width = canvas->width;
+	paint.rect.height = canvas->height;
+	paint.with_alpha = false;
+	pd_canvas_quote(&paint.canvas, canvas, &paint.rect);
+	ui_set_opacity_folding_enabled(folding);
+	t = get_time_ms();
+	for (i = 0; i < RENDER_TIMES; ++i) {
+		/* Fade the panel like an animation does */
+		ui_widget_set_style_numeric_value(
+		    panel, css_prop_opacity, 0.1f + 0.8f * i / RENDER_TIMES);
+		ui_update();
+		pd_canvas_fill(&paint.canvas, pd_rgb(255, 255, 255));
+		ui_widget_render(panel, &paint);
+	}
+	t = get_time_ms() - t;
+	ui_set_opacity_folding_enabled(true);
+	return t;
+}
+
+int main(int argc, char **argv)
+{
+	int64_t t0, t1;
+	ui_widget_t *panel;
+	pd_canvas_t canvas;
+	pd_canvas_pool_stats_t stats;
+
+	lcui_init();
+	ui_metrics.dpi = 96;
+	ui_widget_resize(ui_root(), PANEL_WIDTH, PANEL_HEIGHT);
+	panel = create_panel();
+	ui_update();
+	pd_canvas_init(&canvas);
+	if (pd_canvas_create(&canvas, PANEL_WIDTH, PANEL_HEIGHT) < 0) {
+		return -2;
+	}
+	logger_info("%-20s%-20s%-20s%s\n", "panel\\method", "layer canvas",
+		    "folded opacity", "peak pool memory");
+
+	t0 = render_panel(panel, &canvas, false);
+	t1 = render_panel(panel, &canvas, true);
+	ui_get_canvas_pool_stats(&stats);
+	logger_info("%-20s%-20ld%-20ld%zuKB\n", "no background", (long)t0,
+		    (long)t1, stats.peak_memory / 1024);
+
+	/* The children cover the background, so the layer canvas is needed,
+	 * but it is the only canvas of the panel size */
+	ui_widget_set_style_string(panel, "background-color", "#fff");
+	ui_update();
+	t0 = render_panel(panel, &canvas, false);
+	t1 = render_panel(panel, &canvas, true);
+	ui_get_canvas_pool_stats(&stats);
+	logger_info("%-20s%-20ld%-20ld%zuKB\n", "with background", (long)t0,
+		    (long)t1, stats.peak_memory / 1024);
+
+	pd_canvas_destroy(&canvas);
+	lcui_destroy();
+	return 0;
+}
@@ -0,0 +1,164 @@
+﻿/*
+ * tests/test_pixel_format_bench.c
+ *
+ * Copyright (c) 2023, Liu Chao <i@lc-soft.io> All rights reserved.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * This file is part of LCUI, distributed under the MIT License found in the
+ * LICENSE.TXT file in the root directory of this source tree.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <LCUI.h>
+#include <pandagl.h>
+
+#define IMAGE_WIDTH 1920
+#define IMAGE_HEIGHT 1080
+
+/** Run each routine for at least 200 ms */
+#define BENCH_TIME_US 200000
+
+typedef struct bench_canvases {
+	pd_canvas_t argb;
+	pd_canvas_t rgb;
+	pd_canvas_t rgb565;
+	pd_canvas_t out_argb;
+	pd_canvas_t out_pargb;
+	pd_canvas_t out_rgb;
+	pd_canvas_t out_rgb565;
+} bench_canvases_t;
+
+typedef enum bench_routine {
+	BENCH_FILL_ARGB,
+	BENCH_FILL_RGB,
+	BENCH_FILL_RGB565,
+	BENCH_CLEAR_ARGB,
+	BENCH_ARGB_TO_RGB,
+	BENCH_RGB_TO_ARGB,
+	BENCH_ARGB_TO_PARGB,
+	BENCH_ARGB_TO_RGB565,
+	BENCH_RGB565_TO_ARGB,
+	BENCH_ROUTINE_COUNT
+} bench_routine_t;
+
+static const char *routine_names[] = {
+	"fill argb",	"fill rgb",	  "fill rgb565",
+	"clear argb",	"argb to rgb",	  "rgb to argb",
+	"argb to pargb", "argb to rgb565", "rgb565 to argb"
+};
+
+static void create_canvas(pd_canvas_t *canvas, pd_color_type_t color_type)
+{
+	pd_canvas_init(canvas);
+	canvas->color_type = color_type;
+	if (pd_canvas_create(canvas, IMAGE_WIDTH, IMAGE_HEIGHT) != 0) {
+		logger_error("cannot create the canvas\n");
+		exit(-2);
+	}
+	pd_canvas_fill(canvas, pd_argb(200, 30, 140, 250));
+}
+
+/** @returns number of bytes read and written */
+static size_t run_routine(bench_canvases_t *c, bench_routine_t routine)
+{
+	size_t pixels = IMAGE_WIDTH * IMAGE_HEIGHT;
+	pd_color_t color = pd_argb(200, 30, 140, 250);
+
+	switch (routine) {
+	case BENCH_FILL_ARGB:
+		pd_canvas_fill(&c->out_argb, color);
+		return pixels * 4;
+	case BENCH_FILL_RGB:
+		pd_canvas_fill(&c->out_rgb, color);
+		return pixels * 3;
+	case BENCH_FILL_RGB565:
+		pd_canvas_fill(&c->out_rgb565, color);
+		return pixels * 2;
+	case BENCH_CLEAR_ARGB:
+		pd_canvas_fill(&c->out_argb, pd_argb(0, 0, 0, 0));
+		return pixels * 4;
+	case BENCH_ARGB_TO_RGB:
+		pd_canvas_replace(&c->out_rgb, &c->argb, 0, 0);
+		return pixels * (4 + 3);
+	case BENCH_RGB_TO_ARGB:
+		pd_canvas_replace(&c->out_argb, &c->rgb, 0, 0);
+		return pixels * (3 + 4);
+	case BENCH_ARGB_TO_PARGB:
+		pd_canvas_replace(&c->out_pargb, &c->argb, 0, 0);
+		return pixels * (4 + 4);
+	case BENCH_ARGB_TO_RGB565:
+		pd_canvas_replace(&c->out_rgb565, &c->argb, 0, 0);
+		return pixels * (4 + 2);
+	case BENCH_RGB565_TO_ARGB:
+		pd_canvas_replace(&c->out_argb, &c->rgb565, 0, 0);
+		return pixels * (2 + 4);
+	default:
+		break;
+	}
+	return 0;
+}
+
+/** @returns GB/s of the routine */
+static double bench_routine(bench_canvases_t *c, bench_routine_t routine)
+{
+	size_t bytes = 0;
+	int64_t start, elapsed;
+
+	run_routine(c, routine);
+	start = get_time_us();
+	do {
+		bytes += run_routine(c, routine);
+		elapsed = get_time_delta_us(start);
+	} while (elapsed < BENCH_TIME_US);
+	return bytes / (elapsed * 1000.0);
+}
+
+int main(int argc, char **argv)
+{
+	int r;
+	size_t i;
+	char str[32];
+	bench_canvases_t c;
+	pd_blend_impl_t impls[] = { PD_BLEND_IMPL_SCALAR, PD_BLEND_IMPL_SSE2,
+				    PD_BLEND_IMPL_AVX2, PD_BLEND_IMPL_NEON };
+	const char *impl_names[] = { "scalar", "sse2", "avx2", "neon" };
+
+	create_canvas(&c.argb, PD_COLOR_TYPE_ARGB);
+	create_canvas(&c.rgb, PD_COLOR_TYPE_RGB);
+	create_canvas(&c.rgb565, PD_COLOR_TYPE_RGB565);
+	create_canvas(&c.out_argb, PD_COLOR_TYPE_ARGB);
+	create_canvas(&c.out_pargb, PD_COLOR_TYPE_PARGB);
+	create_canvas(&c.out_rgb, PD_COLOR_TYPE_RGB);
+	create_canvas(&c.out_rgb565, PD_COLOR_TYPE_RGB565);
+	logger_info("%dx%d, GB/s of the bytes read and written\n", IMAGE_WIDTH,
+		    IMAGE_HEIGHT);
+	logger_info("%-20s", "routine\\impl");
+	for (i = 0; i < sizeof(impls) / sizeof(impls[0]); ++i) {
+		if (pd_blend_impl_is_supported(impls[i])) {
+			logger_info("%-12s", impl_names[i]);
+		}
+	}
+	logger_info("\n");
+	for (r = 0; r < BENCH_ROUTINE_COUNT; ++r) {
+		logger_info("%-20s", routine_names[r]);
+		for (i = 0; i < sizeof(impls) / sizeof(impls[0]); ++i) {
+			if (pd_set_blend_impl(impls[i]) != 0) {
+				continue;
+			}
+			sprintf(str, "%.2f", bench_routine(&c, r));
+			logger_info("%-12s", str);
+		}
+		logger_info("\n");
+	}
+	pd_canvas_destroy(&c.argb);
+	pd_canvas_destroy(&c.rgb);
+	pd_canvas_destroy(&c.rgb565);
+	pd_canvas_destroy(&c.out_argb);
+	pd_canvas_destroy(&c.out_pargb);
+	pd_canvas_destroy(&c.out_rgb);
+	pd_canvas_destroy(&c.out_rgb565);
+	return 0;
+}
@@ -29,6 +29,12 @@ target("test_flex_layout")
 target("test_image_scaling_bench")
     add_files("test_image_scaling_bench.c")
 
+target("test_opacity_render_bench")
+    add_files("test_opacity_render_bench.c")
+
+target("test_pixel_format_bench")
+    add_files("test_pixel_format_bench.c")
+
 target("test_mix_rect_with_opacity")
     add_files("test_mix_rect_with_opacity.c")
 